@@ -0,0 +1,86 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_BENCHMARK_HPP
+#define SMK_BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <smk/OpenGL.hpp>
+#include <smk/Window.hpp>
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+// A window never shown on screen. It only provides the OpenGL context; the
+// benchmarks draw into a smk::Framebuffer.
+inline smk::Window HiddenWindow() {
+  glfwInit();
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  return smk::Window(64, 64, "smk benchmark");
+}
+
+// Run |function| |iterations| times, after a few warm-up runs. The duration of
+// every run is measured, and their distribution is printed as one JSON line:
+//
+// {"name":"sprites/1000","iterations":200,"mean_ms":1.2,"p50_ms":1.1,...}
+//
+// When |gpu| is true, the CPU waits for the GPU to complete the work after
+// every run, so that the GPU time is included.
+//
+// When |items| isn't zero, it is the work done by one run, for instance the
+// number of pixels decoded. The mean throughput is printed too, as
+// "items_per_s".
+inline void Run(const std::string& name,
+                int iterations,
+                const std::function<void()>& function,
+                bool gpu = true,
+                double items = 0.0) {
+  using clock = std::chrono::steady_clock;
+
+  const int warmup = std::max(1, iterations / 10);
+  for (int i = 0; i < warmup; ++i)
+    function();
+  if (gpu)
+    glFinish();
+
+  std::vector<double> durations;
+  durations.reserve(iterations);
+  for (int i = 0; i < iterations; ++i) {
+    auto start = clock::now();
+    function();
+    if (gpu)
+      glFinish();
+    auto end = clock::now();
+    durations.push_back(
+        std::chrono::duration<double, std::milli>(end - start).count());
+  }
+
+  std::sort(durations.begin(), durations.end());
+  double sum = 0.0;
+  for (double duration : durations)
+    sum += duration;
+  auto percentile = [&](double p) {
+    size_t index = size_t(p * (durations.size() - 1) + 0.5);
+    return durations[index];
+  };
+
+  const double mean = sum / durations.size();
+  std::printf(
+      "{\"name\":\"%s\",\"iterations\":%d,\"mean_ms\":%.4f,\"p50_ms\":%.4f,"
+      "\"p90_ms\":%.4f,\"p99_ms\":%.4f,\"max_ms\":%.4f",
+      name.c_str(), iterations, mean, percentile(0.50), percentile(0.90),
+      percentile(0.99), durations.back());
+  if (items != 0.0)
+    std::printf(",\"items_per_s\":%.1f", items * 1000.0 / mean);
+  std::printf("}\n");
+  std::fflush(stdout);
+}
+
+}  // namespace benchmark
+
+#endif /* end of include guard: SMK_BENCHMARK_HPP */
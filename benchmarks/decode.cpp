@@ -0,0 +1,163 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <smk/AssetLoader.hpp>
+#include <smk/Audio.hpp>
+#include <smk/Font.hpp>
+#include <smk/ImageDecoder.hpp>
+#include <smk/SoundBuffer.hpp>
+#include <smk/Texture.hpp>
+#include <vector>
+
+#include "asset.hpp"
+#include "benchmark.hpp"
+
+namespace {
+
+std::vector<uint8_t> ReadFile(const char* filename) {
+  std::ifstream file(filename, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file),
+                              std::istreambuf_iterator<char>());
+}
+
+// Encode an RGB or RGBA image in the QOI format, to compare its decoder with
+// the PNG ones on the same image.
+// See https://qoiformat.org/qoi-specification.pdf
+std::vector<uint8_t> EncodeQoi(const smk::ImageDecoder::Image& image) {
+  struct Pixel {
+    uint8_t r, g, b, a;
+    bool operator==(const Pixel& o) const {
+      return r == o.r && g == o.g && b == o.b && a == o.a;
+    }
+  };
+
+  std::vector<uint8_t> out = {'q', 'o', 'i', 'f'};
+  for (uint32_t value : {uint32_t(image.width), uint32_t(image.height)}) {
+    for (int shift = 24; shift >= 0; shift -= 8)
+      out.push_back(uint8_t(value >> shift));
+  }
+  out.push_back(uint8_t(image.channels));
+  out.push_back(0);  // sRGB with linear alpha.
+
+  Pixel index[64] = {};
+  Pixel previous = {0, 0, 0, 255};
+  int run = 0;
+  const size_t count = size_t(image.width) * size_t(image.height);
+  for (size_t i = 0; i < count; ++i) {
+    const uint8_t* in = image.pixels.data() + i * image.channels;
+    const Pixel pixel = {in[0], in[1], in[2],
+                         uint8_t(image.channels == 4 ? in[3] : 255)};
+    if (pixel == previous) {
+      if (++run == 62 || i + 1 == count) {
+        out.push_back(uint8_t(0xC0 | (run - 1)));
+        run = 0;
+      }
+      continue;
+    }
+    if (run) {
+      out.push_back(uint8_t(0xC0 | (run - 1)));
+      run = 0;
+    }
+
+    const int hash = (pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + pixel.a * 11) %
+                     64;
+    if (index[hash] == pixel) {
+      out.push_back(uint8_t(hash));
+    } else if (pixel.a != previous.a) {
+      index[hash] = pixel;
+      out.insert(out.end(), {0xFF, pixel.r, pixel.g, pixel.b, pixel.a});
+    } else {
+      index[hash] = pixel;
+      const int dr = int8_t(pixel.r - previous.r);
+      const int dg = int8_t(pixel.g - previous.g);
+      const int db = int8_t(pixel.b - previous.b);
+      if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+        out.push_back(uint8_t(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+      } else if (dg >= -32 && dg <= 31 && dr - dg >= -8 && dr - dg <= 7 &&
+                 db - dg >= -8 && db - dg <= 7) {
+        out.push_back(uint8_t(0x80 | (dg + 32)));
+        out.push_back(uint8_t((dr - dg + 8) << 4 | (db - dg + 8)));
+      } else {
+        out.insert(out.end(), {0xFE, pixel.r, pixel.g, pixel.b});
+      }
+    }
+    previous = pixel;
+  }
+  out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+  return out;
+}
+
+// Decode |data| with every decoders accepting it. The throughput is reported
+// in pixels per second.
+void BenchmarkDecoders(const std::string& name,
+                       const std::vector<uint8_t>& data,
+                       double pixels) {
+  auto decoders = smk::ImageDecoder::decoders();
+  decoders.push_back(smk::ImageDecoder::Bundled());
+  for (const auto& decoder : decoders) {
+    if (!decoder->Accept(data.data(), data.size()))
+      continue;
+    benchmark::Run(
+        std::string("image_decode/") + decoder->name() + "/" + name, 50,
+        [&] {
+          smk::ImageDecoder::Image image;
+          decoder->Decode(data.data(), data.size(), &image);
+        },
+        false, pixels);
+  }
+}
+
+}  // namespace
+
+int main() {
+  auto window = benchmark::HiddenWindow();
+  smk::Audio audio;
+
+  benchmark::Run("texture_decode/hero_png", 100,
+                 [] { smk::Texture texture(asset::hero_png); });
+
+  // The same image, encoded in every formats decoded.
+  const std::vector<uint8_t> png = ReadFile(asset::hero_png);
+  smk::ImageDecoder::Image image;
+  if (smk::ImageDecoder::Bundled()->Decode(png.data(), png.size(), &image)) {
+    const double pixels = double(image.width) * image.height;
+    BenchmarkDecoders("hero_png", png, pixels);
+    if (image.channels >= 3)
+      BenchmarkDecoders("hero_qoi", EncodeQoi(image), pixels);
+  }
+
+  // Decode several files at once, in the worker threads of the AssetLoader.
+  // The textures are uploaded by the main thread.
+  const int kFiles = 16;
+  for (int threads : {1, 2, 4, 8}) {
+    benchmark::Run(
+        "texture_decode_parallel/" + std::to_string(threads), 10,
+        [threads] {
+          smk::AssetLoader loader(threads);
+          for (int i = 0; i < kFiles; ++i)
+            loader.LoadTexture(asset::hero_png);
+          loader.Finish();
+        },
+        true, kFiles);
+  }
+
+  // Rasterize the printable ASCII and Latin-1 characters in a new font.
+  for (float size : {16.f, 64.f}) {
+    benchmark::Run(
+        "font_glyphs/" + std::to_string(int(size)), 20, [size] {
+          smk::Font font(asset::arial_ttf, size);
+          for (wchar_t c = 32; c < 256; ++c)
+            font.FetchGlyph(c);
+        });
+  }
+
+  benchmark::Run(
+      "sound_decode/water_mp3", 10,
+      [] { smk::SoundBuffer sound_buffer(asset::water_mp3); }, false);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <smk/Color.hpp>
+#include <smk/Font.hpp>
+#include <smk/Framebuffer.hpp>
+#include <smk/Shader.hpp>
+#include <smk/Shape.hpp>
+#include <smk/Sprite.hpp>
+#include <smk/SpriteBatch.hpp>
+#include <smk/Text.hpp>
+#include <smk/Texture.hpp>
+#include <string>
+#include <vector>
+
+#include "asset.hpp"
+#include "benchmark.hpp"
+
+namespace {
+
+const int kIterations = 200;
+
+// Sprites at deterministic positions, alternating between two textures.
+std::vector<smk::Sprite> MakeSprites(int count,
+                                     const smk::Texture& a,
+                                     const smk::Texture& b) {
+  std::vector<smk::Sprite> sprites;
+  for (int i = 0; i < count; ++i) {
+    smk::Sprite sprite(i % 2 ? a : b);
+    sprite.SetPosition((i * 37) % 1024, (i * 91) % 1024);
+    sprites.push_back(sprite);
+  }
+  return sprites;
+}
+
+}  // namespace
+
+int main() {
+  auto window = benchmark::HiddenWindow();
+  auto framebuffer = smk::Framebuffer(1024, 1024);
+
+  auto texture_a = smk::Texture(asset::hero_png);
+  auto texture_b = smk::Texture(asset::hero_png);
+
+  for (int count : {100, 1000, 10000}) {
+    auto sprites = MakeSprites(count, texture_a, texture_a);
+    benchmark::Run("sprites/" + std::to_string(count), kIterations, [&] {
+      framebuffer.Clear(smk::Color::Black);
+      for (auto& sprite : sprites)
+        framebuffer.Draw(sprite);
+    });
+  }
+
+  for (int count : {1000, 10000}) {
+    auto sprites = MakeSprites(count, texture_a, texture_b);
+    benchmark::Run("sprites_two_textures/" + std::to_string(count),
+                   kIterations, [&] {
+                     framebuffer.Clear(smk::Color::Black);
+                     for (auto& sprite : sprites)
+                       framebuffer.Draw(sprite);
+                   });
+
+    framebuffer.SetDeferred(true);
+    benchmark::Run("sprites_two_textures_deferred/" + std::to_string(count),
+                   kIterations, [&] {
+                     framebuffer.Clear(smk::Color::Black);
+                     for (auto& sprite : sprites)
+                       framebuffer.Draw(sprite);
+                     framebuffer.Flush();
+                   });
+    framebuffer.SetDeferred(false);
+
+    smk::SpriteBatch batch;
+    for (auto& sprite : sprites)
+      batch.Add(sprite);
+    benchmark::Run("sprite_batch/" + std::to_string(count), kIterations, [&] {
+      framebuffer.Clear(smk::Color::Black);
+      framebuffer.Draw(batch);
+    });
+  }
+
+  auto font = smk::Font(asset::arial_ttf, 16);
+  for (int count : {100, 1000, 10000}) {
+    std::string string;
+    for (int i = 0; i < count; ++i)
+      string += (i % 80 == 79) ? '\n' : char('a' + i % 26);
+    auto text = smk::Text(font, string);
+    benchmark::Run("glyphs/" + std::to_string(count), kIterations, [&] {
+      framebuffer.Clear(smk::Color::Black);
+      framebuffer.Draw(text);
+    });
+  }
+
+  // A second 2D program, so that every draw switches the program.
+  auto vertex_shader = smk::Shader::FromString(R"(
+    layout(location = 0) in vec2 space_position;
+    layout(location = 1) in vec2 texture_position;
+    uniform mat4 projection;
+    uniform mat4 view;
+    out vec2 f_texture_position;
+    void main() {
+      f_texture_position = texture_position;
+      gl_Position = projection * view * vec4(space_position, 0.0, 1.0);
+    }
+  )", GL_VERTEX_SHADER);
+  auto fragment_shader = smk::Shader::FromString(R"(
+    in vec2 f_texture_position;
+    uniform sampler2D texture_0;
+    uniform vec4 color;
+    out vec4 out_color;
+    void main() {
+      out_color = texture(texture_0, f_texture_position) * color;
+    }
+  )", GL_FRAGMENT_SHADER);
+  smk::ShaderProgram other_program;
+  other_program.AddShader(vertex_shader);
+  other_program.AddShader(fragment_shader);
+  other_program.Link();
+
+  auto square = smk::Shape::Square();
+  square.SetScale(16, 16);
+  for (int count : {100, 1000}) {
+    benchmark::Run("shader_switches/" + std::to_string(count), kIterations,
+                   [&] {
+                     framebuffer.Clear(smk::Color::Black);
+                     for (int i = 0; i < count; ++i) {
+                       framebuffer.SetShaderProgram(
+                           i % 2 ? framebuffer.shader_program_2d()
+                                 : other_program);
+                       framebuffer.Draw(square);
+                     }
+                     framebuffer.SetShaderProgram(
+                         framebuffer.shader_program_2d());
+                   });
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <smk/Color.hpp>
+#include <smk/InstancedMesh.hpp>
+#include <smk/Shape.hpp>
+#include <smk/Window.hpp>
+
+#include "asset.hpp"
+
+int main() {
+  // Open a new window.
+  auto window = smk::Window(640, 480, "test");
+  window.SetShaderProgram(window.shader_program_3d());
+
+  // A grid of 50x50 cubes, drawn at once.
+  auto cubes = smk::InstancedMesh();
+  cubes.SetVertexArray(smk::Shape::Cube().vertex_array());
+  cubes.SetTexture(smk::Texture(asset::hero_png));
+
+  float time = 0.f;
+
+  window.ExecuteMainLoop([&] {
+    window.PoolEvents();
+    window.Clear(smk::Color::Black);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glEnable(GL_CULL_FACE);
+
+    time += 0.016f;
+
+    window.SetView(glm::perspective(
+        70.f, float(window.width()) / window.height(), 0.1f, 200.f));
+
+    cubes.Clear();
+    for (int x = -25; x < 25; ++x) {
+      for (int y = -25; y < 25; ++y) {
+        glm::mat4 transformation(1.f);
+        transformation =
+            glm::translate(transformation, {x * 2.f, y * 2.f, -60.f});
+        transformation =
+            glm::rotate(transformation, time + 0.1f * (x + y), {0.f, 1.f, 0.f});
+        glm::vec4 color = {0.5f + 0.02f * x, 0.5f + 0.02f * y, 1.f, 1.f};
+        cubes.Add(transformation, color);
+      }
+    }
+    window.Draw(cubes);
+
+    window.Display();
+  });
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+#include <smk/Color.hpp>
+#include <smk/Input.hpp>
+#include <smk/RenderGraph.hpp>
+#include <smk/Shape.hpp>
+#include <smk/Sprite.hpp>
+#include <smk/Window.hpp>
+
+int main() {
+  int dim = 512;
+  auto window = smk::Window(dim, dim, "RenderGraph example");
+  auto circle = smk::Shape::Circle(dim * 0.15);
+
+  smk::RenderGraph graph;
+
+  window.ExecuteMainLoop([&] {
+    window.PoolEvents();
+
+    graph.Clear();
+    auto scene = graph.CreateTarget(dim, dim);
+    auto half = graph.CreateTarget(dim / 2, dim / 2);
+    auto unused = graph.CreateTarget(dim, dim);
+    auto screen = graph.ImportTarget(window);
+
+    // Draw the circle under user's mouse.
+    graph.AddPass("scene", {}, scene,
+                  [&](smk::RenderTarget& target,
+                      const std::vector<smk::Texture>&) {
+                    target.Clear(smk::Color::Black);
+                    circle.SetPosition(window.input().cursor());
+                    target.Draw(circle);
+                  });
+
+    // Downscale it.
+    graph.AddPass("downscale", {scene}, half,
+                  [&](smk::RenderTarget& target,
+                      const std::vector<smk::Texture>& inputs) {
+                    target.Clear(smk::Color::Black);
+                    auto sprite = smk::Sprite(inputs[0]);
+                    sprite.SetScale(0.5f, 0.5f);
+                    target.Draw(sprite);
+                  });
+
+    // This pass doesn't contribute to the screen. It is skipped.
+    graph.AddPass("unused", {}, unused,
+                  [&](smk::RenderTarget& target,
+                      const std::vector<smk::Texture>&) {
+                    target.Clear(smk::Color::White);
+                  });
+
+    // Compose the scene with its pixelated copy.
+    graph.AddPass("compose", {scene, half}, screen,
+                  [&](smk::RenderTarget& target,
+                      const std::vector<smk::Texture>& inputs) {
+                    target.Clear(smk::Color::Black);
+                    auto sprite = smk::Sprite(inputs[0]);
+                    target.Draw(sprite);
+                    auto pixelated = smk::Sprite(inputs[1]);
+                    pixelated.SetColor({0.6f, 0.7f, 1.f, 0.5f});
+                    pixelated.SetScale(2.f, 2.f);
+                    target.Draw(pixelated);
+                  });
+
+    graph.Execute();
+    window.Display();
+  });
+  return EXIT_SUCCESS;
+}
+
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
@@ -42,7 +42,8 @@ const char* kFragmentShader = R"(
     hue = fract(hue);
     out_color.rgb = hsv(vec3(hue, 1.0, 1.0));
 
-    out_color.a = texture(texture_0, f_texture_position).a;
+    // The glyph atlas stores the coverage in its single red channel.
+    out_color.a = texture(texture_0, f_texture_position).r;
   }
 )";
 
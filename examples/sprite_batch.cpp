@@ -0,0 +1,47 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#include <cmath>
+#include <smk/Color.hpp>
+#include <smk/Sprite.hpp>
+#include <smk/SpriteBatch.hpp>
+#include <smk/Texture.hpp>
+#include <smk/Window.hpp>
+#include <vector>
+
+#include "asset.hpp"
+
+int main() {
+  auto window = smk::Window(640, 480, "smk/example/sprite_batch");
+  auto texture = smk::Texture(asset::hero_png);
+
+  std::vector<smk::Sprite> sprites;
+  for (int i = 0; i < 10000; ++i) {
+    sprites.emplace_back(texture);
+    sprites.back().SetCenter(texture.width() / 2.f, texture.height() / 2.f);
+  }
+
+  smk::SpriteBatch batch;
+
+  window.ExecuteMainLoop([&] {
+    window.PoolEvents();
+    window.Clear(smk::Color::Black);
+
+    // Rebuild the batch every frame. The whole batch uses one draw call.
+    batch.Clear();
+    float time = window.time();
+    for (size_t i = 0; i < sprites.size(); ++i) {
+      float angle = i * 0.01f + time * 0.3f;
+      float radius = 20.f + i * 0.02f;
+      sprites[i].SetPosition(320.f + radius * std::cos(angle),
+                             240.f + radius * std::sin(angle));
+      sprites[i].SetRotation(angle * 50.f);
+      batch.Add(sprites[i]);
+    }
+    window.Draw(batch);
+
+    window.Display();
+  });
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_ASSET_ARCHIVE_HPP
+#define SMK_ASSET_ARCHIVE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace smk {
+
+/// Many assets packed into a single file, read through a memory mapping.
+/// Opening thousands of small files is slow on spinning disks and with the
+/// WebAssembly virtual file system. Reading them out of one file isn't.
+///
+/// The archive starts with an index of the entries. Each entry is either
+/// stored, and read in place out of the mapping without any copy, or
+/// compressed with LZ4. The compressed entries are decompressed on their first
+/// access, and kept until the archive is destroyed.
+///
+/// The entries are given to the loaders taking memory:
+/// - smk::Texture::FromMemory()
+/// - smk::SoundBuffer::FromMemory()
+/// - smk::Shader::FromMemory()
+/// - smk::Font(data, size, line_height)
+///
+/// The archive must outlive the Fonts loaded from it. The other loaders don't
+/// keep the data.
+///
+/// Get() can be called from any thread.
+///
+/// This is a move-only resource.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// // At build time:
+/// smk::AssetArchive::Write("./assets.smk", {
+///     {"ball.png", "./assets/ball.png"},
+///     {"level.json", "./assets/level.json", /*compress=*/true},
+/// });
+///
+/// [...]
+///
+/// smk::AssetArchive archive("./assets.smk");
+/// smk::AssetArchive::Span ball = archive.Get("ball.png");
+/// auto texture = smk::Texture::FromMemory(ball.data, ball.size);
+/// ~~~
+class AssetArchive {
+ public:
+  // A view on the content of an entry. Empty when the entry is missing.
+  struct Span {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    explicit operator bool() const { return data != nullptr; }
+  };
+
+  // A file to be packed by Write().
+  struct File {
+    std::string name;      // The name of the entry.
+    std::string filename;  // The file to read.
+    bool compress = false;  // Kept stored when it doesn't shrink.
+  };
+
+  AssetArchive();  // Empty archive.
+  explicit AssetArchive(const std::string& filename);
+  ~AssetArchive();
+
+  // Return false and display an error when the archive is invalid.
+  bool Open(const std::string& filename);
+
+  bool Contains(const std::string& name) const;
+  Span Get(const std::string& name) const;
+
+  // The names of the entries, in the order they were packed.
+  std::vector<std::string> names() const;
+
+  // Pack |files| into a new archive. Return false and display an error on
+  // failure.
+  static bool Write(const std::string& filename,
+                    const std::vector<File>& files);
+
+  // --- Move only resource ----------------------------------------------------
+  AssetArchive(AssetArchive&&) noexcept;
+  AssetArchive(const AssetArchive&) = delete;
+  AssetArchive& operator=(AssetArchive&&) noexcept;
+  AssetArchive& operator=(const AssetArchive&) = delete;
+  // ---------------------------------------------------------------------------
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_ASSET_ARCHIVE_HPP */
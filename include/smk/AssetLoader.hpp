@@ -0,0 +1,110 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_ASSET_LOADER_HPP
+#define SMK_ASSET_LOADER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <smk/Font.hpp>
+#include <smk/SoundBuffer.hpp>
+#include <smk/Texture.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace smk {
+
+/// Load Textures, Fonts and SoundBuffers without blocking the main loop.
+///
+/// The files are read and decoded by a pool of worker threads. The decoded
+/// data are uploaded to the GPU (or to OpenAL) by Update(), which must be
+/// called regularly from the OpenGL thread. It spends at most a given time
+/// budget per call.
+///
+/// Every Load function returns immediately a Handle. The asset can be used once
+/// Handle::IsReady() returns true.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::AssetLoader loader;
+/// auto texture = loader.LoadTexture("./ball.png");
+///
+/// window.ExecuteMainLoop([&] {
+///   loader.Update();
+///   [...]
+///   if (texture.IsReady())
+///     window.Draw(smk::Sprite(texture.Get()));
+///   [...]
+/// });
+/// ~~~
+class AssetLoader {
+ public:
+  template <typename T>
+  class Handle {
+   public:
+    Handle() = default;
+    bool IsReady() const { return state_ && state_->ready; }
+    // The asset must be ready.
+    T& Get() const { return state_->value; }
+
+   private:
+    friend class AssetLoader;
+    struct State {
+      T value;
+      bool ready = false;
+    };
+    std::shared_ptr<State> state_;
+  };
+
+  AssetLoader();
+  explicit AssetLoader(int threads);
+  ~AssetLoader();
+
+  Handle<Texture> LoadTexture(const std::string& filename);
+  Handle<Texture> LoadTexture(const std::string& filename,
+                              const Texture::Option& option);
+  Handle<Font> LoadFont(
+      const std::string& filename,
+      float line_height,
+      Font::Rendering rendering = Font::Rendering::Bitmap);
+  Handle<SoundBuffer> LoadSoundBuffer(const std::string& filename);
+
+  // Upload the decoded assets. Must be called from the OpenGL thread. At least
+  // one asset is uploaded, and no more are started after |budget| seconds.
+  void Update(float budget = 0.004f);
+
+  // The number of assets not uploaded yet.
+  size_t pending() const;
+
+  // Block until every assets are uploaded.
+  void Finish();
+
+  AssetLoader(const AssetLoader&) = delete;
+  void operator=(const AssetLoader&) = delete;
+
+ private:
+  using Upload = std::function<void()>;
+  using Decode = std::function<Upload()>;
+
+  template <typename T>
+  Handle<T> Enqueue(std::function<std::function<T()>()> decode);
+  void Run();
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Decode> decodes_;
+  std::deque<Upload> uploads_;
+  size_t pending_ = 0;
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_ASSET_LOADER_HPP */
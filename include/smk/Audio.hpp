@@ -5,8 +5,14 @@
 #ifndef SMK_AUDIO_HPP
 #define SMK_AUDIO_HPP
 
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <string>
+
 namespace smk {
 
+class SoundBuffer;
+
 /// Used to Initialize OpenAL. It is required to use it in the main() function.
 /// Coucou
 ///
@@ -29,11 +35,86 @@ namespace smk {
 ///   [...]
 /// }
 /// ~~~
+///
+/// It creates a fixed pool of OpenAL sources, lent to the sounds being played.
+/// Playing a sound never creates OpenAL objects.
+///
+/// The OpenAL context can be configured with an Audio::Option, for instance to
+/// reduce the output latency:
+///
+/// ~~~cpp
+/// smk::Audio::Option option;
+/// option.refresh = 200;  // 5ms mixing updates.
+/// option.hrtf = false;
+/// smk::Audio audio(option);
+///
+/// [...]
+///
+/// // The time the sound written now takes to reach the speakers.
+/// double latency = smk::Audio::latency();
+/// ~~~
 class Audio {
  public:
+  // The attributes of the OpenAL context. 0 keeps the device default.
+  struct Option {
+    std::string device;       // The device name. Empty for the default one.
+    int frequency = 0;        // The mixing frequency, in Hz.
+    int refresh = 0;          // The mixing updates per second.
+    int mono_sources = 0;     // Hints about the number of sources needed.
+    int stereo_sources = 0;
+    bool hrtf = true;         // When false, HRTF is disabled (ALC_SOFT_HRTF).
+    size_t voice_count = 32;  // The sources of the pool, the maximum number of
+                              // sounds played simultaneously.
+
+    // Print the devices found at startup. Disable it on servers, where the
+    // enumeration can be slow.
+    bool list_devices = true;
+
+    // Open the device on first use, by the first SoundBuffer, Sound or Music,
+    // instead of in the constructor. Applications that may not play any sound
+    // don't pay for it at startup.
+    bool lazy = false;
+  };
+
   Audio();
+  explicit Audio(const Option& option);
   ~Audio();
+  // Opens the device, when it was deferred by Option::lazy.
   static bool Initialized();
+
+  // The mixing frequency of the device, in Hz. 0 when not initialized.
+  static int frequency();
+
+  // The delay in between the samples being mixed and them being heard, in
+  // seconds, as measured by the device. 0 when the device doesn't support
+  // ALC_SOFT_device_clock.
+  static double latency();
+
+  // The time the device has spent playing, in seconds. It is meant to
+  // synchronize the gameplay with the audio. 0 when the device doesn't support
+  // ALC_SOFT_device_clock.
+  static double clock();
+
+  // Play a SoundBuffer on a source of the pool, without keeping track of it.
+  // When every sources are busy, the oldest one playing with the lowest
+  // priority, not above |priority|, is stolen. |buffer| must outlive the
+  // playback.
+  static void PlayOneShot(const SoundBuffer& buffer,
+                          float volume = 1.f,
+                          int priority = 0);
+
+  // The number of sources of the pool.
+  static size_t voice_count();
+
+  // The listener of the 3D sounds. The changes are applied by Update().
+  static void SetListenerPosition(const glm::vec3& position);
+  static void SetListenerVelocity(const glm::vec3& velocity);
+  static void SetListenerOrientation(const glm::vec3& forward,
+                                     const glm::vec3& up);
+
+  // Send the spatial parameters of the listener and of the sounds modified
+  // since the last call, in a single batch. Call it once per frame.
+  static void Update();
 };
 
 }  // namespace smk
@@ -0,0 +1,39 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_BOUNDING_BOX_HPP
+#define SMK_BOUNDING_BOX_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+
+namespace smk {
+
+/// An axis aligned box. The default one is empty.
+/// @see VertexArray::bounds(), Frustum.
+struct BoundingBox {
+  glm::vec3 min = {INFINITY, INFINITY, INFINITY};
+  glm::vec3 max = {-INFINITY, -INFINITY, -INFINITY};
+
+  bool empty() const { return min.x > max.x; }
+
+  // Grow the box to contain |point|.
+  void Extend(const glm::vec3& point) {
+    min.x = std::min(min.x, point.x);
+    min.y = std::min(min.y, point.y);
+    min.z = std::min(min.z, point.z);
+    max.x = std::max(max.x, point.x);
+    max.y = std::max(max.y, point.y);
+    max.z = std::max(max.z, point.z);
+  }
+
+  // The bounding sphere of the box.
+  glm::vec3 center() const { return (min + max) * 0.5f; }
+  float radius() const { return glm::length(max - min) * 0.5f; }
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_BOUNDING_BOX_HPP */
@@ -0,0 +1,64 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_COMMAND_LIST_HPP
+#define SMK_COMMAND_LIST_HPP
+
+#include <smk/RenderTarget.hpp>
+
+namespace smk {
+
+/// A list of draws recorded by any thread, and drawn later into a RenderTarget
+/// by the thread owning it. This spreads the preparation of large scenes over
+/// several cores.
+///
+/// Every thread records into its own CommandList. The lists are then appended
+/// to the target in the order they must be drawn. The memory of a list is kept
+/// across frames.
+///
+/// While recording, only Draw(), SetView() and SetLayer() can be used. The
+/// drawables must not create OpenGL objects in their Draw(). For instance, a
+/// smk::Text must have its glyphs loaded beforehand.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// std::vector<smk::CommandList> lists(threads);
+/// for (auto& list : lists)
+///   list.Reset(window);
+///
+/// // On every worker thread |i|:
+/// for (auto& sprite : sprites[i])
+///   lists[i].Draw(sprite);
+///
+/// // Once the workers are done:
+/// for (auto& list : lists)
+///   window.Append(list);
+/// ~~~
+class CommandList : public RenderTarget {
+ public:
+  CommandList();
+  explicit CommandList(RenderTarget& target);
+
+  // Drop the recorded draws and record new ones for |target|, using its view
+  // and ShaderProgram. Must be called by the thread owning |target|.
+  void Reset(RenderTarget& target);
+
+  void Draw(const Drawable& drawable) override;
+  using RenderTarget::Draw;
+
+  // The number of draws recorded.
+  size_t size() const { return queue_.size(); }
+
+  // --- Move only resource ----------------------------------------------------
+  CommandList(CommandList&&) noexcept;
+  CommandList(const CommandList&) = delete;
+  CommandList& operator=(CommandList&&) noexcept;
+  CommandList& operator=(const CommandList&) = delete;
+  // ---------------------------------------------------------------------------
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_COMMAND_LIST_HPP */
@@ -5,45 +5,162 @@
 #ifndef SMK_FONT_HPP
 #define SMK_FONT_HPP
 
+#include <array>
+#include <deque>
+#include <functional>
 #include <glm/glm.hpp>
-#include <map>
 #include <memory>
 #include <smk/OpenGL.hpp>
+#include <smk/Rectangle.hpp>
 #include <smk/Texture.hpp>
+#include <smk/TextureAtlas.hpp>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace smk {
 
+class AssetLoader;
+class FontFace;
+
+/// A Font loaded from a file. Its glyphs are rasterized on demand and packed
+/// into a few shared atlas textures.
+///
+/// The Latin-1 glyphs are rasterized when the Font is created. Another set of
+/// characters, possibly empty, can be chosen with SetPreloadedCharacters(): the
+/// startup time then only depends on the characters actually used.
+///
+/// In asynchronous mode, the glyphs missing from the atlas are rasterized by a
+/// worker thread instead of stalling the caller. They are uploaded by Update(),
+/// on the OpenGL thread. Until then, FetchGlyph() returns nullptr for them and
+/// Text skips them.
+///
+/// The atlas has a single channel: the glyph coverage is in the red channel.
+/// Text draws it with RenderTarget::shader_program_2d_glyph(), which turns it
+/// into the alpha of a white texel. A custom ShaderProgram drawing Text must do
+/// the same.
+///
+/// With Rendering::DistanceField, the atlas stores the signed distance to the
+/// glyph outlines instead of their coverage. Text draws them with
+/// RenderTarget::shader_program_2d_distance_field(), which stays sharp at any
+/// scale: a single Font rasterized once can serve every text sizes.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// auto font =
+///     smk::Font("./arial.ttf", 48, smk::Font::Rendering::DistanceField);
+/// auto title = smk::Text(font, "Title");
+/// auto note = smk::Text(font, "Note");
+/// note.SetScale(0.25f);
+///
+/// // Rasterize nothing at startup, but the digits of a score.
+/// smk::Font::SetPreloadedCharacters(L"");
+/// auto digits = smk::Font("./arial.ttf", 32);
+/// digits.Preload(L"0123456789");
+/// ~~~
 class Font {
  public:
-  Font() = default;  // Empty font.
-  Font(const std::string& filename, float line_height);
+  enum class Rendering {
+    Bitmap,         // The glyph coverage. Sharpest when drawn at scale 1.
+    DistanceField,  // The signed distance to the outlines. Scales smoothly.
+  };
+
+  Font();  // Empty font.
+  Font(const std::string& filename,
+       float line_height,
+       Rendering rendering = Rendering::Bitmap);
+  // |data| must outlive the Font. It can be an entry of an smk::AssetArchive.
+  Font(const uint8_t* data,
+       size_t size,
+       float line_height,
+       Rendering rendering = Rendering::Bitmap);
+  ~Font();
 
   float line_height() const { return line_height_; }
+  Rendering rendering() const { return rendering_; }
   float baseline_position() const { return baseline_position_; }
 
+  // The characters rasterized by the Fonts created afterward. Default to the
+  // Latin-1 range. The other glyphs are rasterized on first use.
+  static void SetPreloadedCharacters(const std::wstring& characters);
+
+  // Rasterize the glyphs of |characters| now, instead of on first use.
+  void Preload(const std::wstring& characters);
+
+  // Rasterize the missing glyphs in a worker thread.
+  void SetAsynchronous(bool asynchronous);
+  bool asynchronous() const { return bool(worker_); }
+
+  // Upload the glyphs rasterized asynchronously into the atlas. This is called
+  // by Text::Draw().
+  void Update();
+
+  // Incremented every time a glyph is added. Used to detect when a layout
+  // must be recomputed.
+  size_t generation() const { return generation_; }
+
   struct Glyph {
-    smk::Texture texture;
+    smk::Texture texture;  // The atlas page containing the glyph.
+    Rectangle texture_rectangle = {0.f, 0.f, 0.f, 0.f};  // Normalized.
+    glm::ivec2 size = {0, 0};     // Dimensions of the bitmap in pixels.
     glm::ivec2 bearing = {0, 0};  // Offset from baseline to left/top of glyph
     float advance = 0;            // Offset to advance to next glyph
   };
+  // Return the glyph for a given character, or nullptr if the font doesn't
+  // provide it. The returned pointer stays valid for the lifetime of the Font.
   Glyph* FetchGlyph(wchar_t in);
 
   // --- Move only resource ----------------------------------------------------
-  Font(Font&&) = default;
+  Font(Font&&) noexcept;
   Font(const Font&) = delete;
   void operator=(Font&&) noexcept;
   void operator=(const Font&) = delete;
   // ---------------------------------------------------------------------------
 
  private:
+  friend class AssetLoader;
+
+  // Rasterize the preloaded glyphs of a font. This can run on any thread. The
+  // returned function builds the Font, and must run on the OpenGL thread.
+  static std::function<Font()> Prepare(const std::string& filename,
+                                       float line_height,
+                                       Rendering rendering);
+
+  void Init();
+  struct Bitmap;
+  struct Worker;
+  static std::vector<Bitmap> PreloadedBitmaps(FontFace& face,
+                                              float line_height,
+                                              Rendering rendering);
+  void InitAtlas(std::vector<Bitmap> bitmaps);
   void LoadGlyphs(const std::vector<wchar_t>& chars);
+  void AddGlyph(const Bitmap& bitmap);
+  bool AddToAtlas(int width,
+                  int height,
+                  const uint8_t* pixels,
+                  Glyph* glyph);
+
+  TextureAtlas atlas_;
+
+  Glyph*& GlyphEntry(wchar_t character);
+
+  // The glyphs, stored contiguously. std::deque keeps the pointers stable while
+  // growing.
+  std::deque<Glyph> glyphs_;
 
-  std::map<wchar_t, std::unique_ptr<Glyph>> glyphs_;
+  // Lookup tables pointing into |glyphs_|. The Latin-1 range uses a dense
+  // table. The other characters are hashed.
+  static constexpr size_t kLatin1Size = 256;
+  std::array<Glyph*, kLatin1Size> latin1_glyphs_ = {};
+  std::unordered_map<wchar_t, Glyph*> other_glyphs_;
+  std::shared_ptr<FontFace> face_;
+  std::unique_ptr<Worker> worker_;
+  size_t generation_ = 0;
   std::string filename_;
   float line_height_ = 0.f;
   float baseline_position_ = 0.f;
+  Rendering rendering_ = Rendering::Bitmap;
 };
 
 }  // namespace smk
@@ -0,0 +1,99 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_FRAME_ARENA_HPP
+#define SMK_FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace smk {
+
+/// A linear allocator for the data needed only during the current frame, for
+/// instance transient vertices. Allocating moves a pointer. Nothing is freed
+/// individually: everything is released at once by Window::Display() and the
+/// memory is reused by the next frame.
+///
+/// Every thread has its own arena. Window::Display() resets only the arena of
+/// the thread calling it. The other threads own theirs: they call Reset() once
+/// their allocations aren't used anymore, for instance at the end of a task.
+/// Until then, their memory is kept.
+///
+/// No constructors or destructors are run. Store only trivially destructible
+/// data, or use a smk::FrameVector.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::FrameVector<smk::Vertex2D> vertices;
+/// [...]
+/// vertex_array.Update(vertices.data(), vertices.size());
+/// ~~~
+class FrameArena {
+ public:
+  // The arena of the calling thread.
+  static FrameArena& Get();
+
+  // Reset the arena of the calling thread. Called by Window::Display().
+  static void NewFrame();
+
+  // Release every allocation of this arena. Must be called by its thread.
+  void Reset();
+
+  void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+  template <typename T>
+  T* Allocate(size_t count) {
+    return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  // The bytes allocated during the current frame, and the bytes reserved.
+  size_t used() const { return used_; }
+  size_t capacity() const;
+
+ private:
+  FrameArena() = default;
+
+  struct Block {
+    std::unique_ptr<uint8_t[]> data;
+    size_t size;
+  };
+  std::vector<Block> blocks_;
+  size_t offset_ = 0;  // In the last block.
+  size_t used_ = 0;
+};
+
+/// A standard allocator using the FrameArena of the calling thread. The
+/// memory is given back at the end of the frame only.
+template <typename T>
+struct FrameAllocator {
+  using value_type = T;
+
+  FrameAllocator() = default;
+  template <typename U>
+  FrameAllocator(const FrameAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    return FrameArena::Get().Allocate<T>(count);
+  }
+  void deallocate(T*, size_t) {}
+
+  template <typename U>
+  bool operator==(const FrameAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const FrameAllocator<U>&) const {
+    return false;
+  }
+};
+
+/// A std::vector valid until the end of the frame.
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_FRAME_ARENA_HPP */
@@ -0,0 +1,51 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_FRAME_BLOCK_HPP
+#define SMK_FRAME_BLOCK_HPP
+
+#include <glm/glm.hpp>
+
+namespace smk {
+
+/// The state shared by every ShaderProgram. It is stored in a single uniform
+/// buffer, uploaded only when it changes, for instance after a
+/// RenderTarget::SetView or once per frame for the time.
+///
+/// A ShaderProgram can access it by declaring the uniform block:
+/// ~~~glsl
+/// layout(std140) uniform smk_frame {
+///   mat4 projection;
+///   vec4 light_position;
+///   float time;
+///   float ambient;
+///   float diffuse;
+///   float specular;
+///   float specular_power;
+/// };
+/// ~~~
+///
+/// The lighting parameters are used by the default 3D ShaderProgram. They can
+/// be modified using smk::RenderTarget::frame_block(). Setting them by name
+/// with ShaderProgram::SetUniform(), on a program declaring the block, updates
+/// the block too.
+///
+/// The members follow the std140 layout. Don't reorder them.
+struct FrameBlock {
+  /// The uniform buffer binding point of the block.
+  static constexpr unsigned int kBinding = 0;
+
+  glm::mat4 projection = glm::mat4(1.f);  ///< Set by the RenderTarget.
+  glm::vec4 light_position = glm::vec4(0.f, 5.f, 0.f, 1.f);
+  float time = 0.f;  ///< Set by Window::Display.
+  float ambient = 0.3f;
+  float diffuse = 0.5f;
+  float specular = 0.5f;
+  float specular_power = 4.0f;
+  float padding[3] = {0.f, 0.f, 0.f};  ///< std140 rounds blocks to vec4.
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_FRAME_BLOCK_HPP */
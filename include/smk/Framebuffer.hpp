@@ -15,10 +15,40 @@ namespace smk {
 /// @example framebuffer.cpp
 
 /// An off-screen drawable area. You can also draw it later in a smk::Sprite.
+///
+/// A multisampled Framebuffer draws into renderbuffers. Its color textures are
+/// only updated when calling Resolve().
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::Framebuffer::Option option;
+/// option.samples = 4;
+/// auto scene = smk::Framebuffer(640, 480, option);
+///
+/// [...]
+///
+/// scene.Clear(smk::Color::Black);
+/// scene.Draw(mesh);
+/// scene.Resolve();
+/// scene.Invalidate(smk::RenderTarget::All);  // The samples are not needed.
+/// window.Draw(smk::Sprite(scene));
+/// ~~~
 class Framebuffer : public RenderTarget {
  public:
+  struct Option {
+    // Allocate a depth-stencil buffer. Pure 2D passes don't need one.
+    bool depth_stencil = true;
+
+    // The number of samples per pixel. 0 disables multisampling. When using
+    // your own color textures, they must be GL_RGBA8.
+    int samples = 0;
+  };
+
   explicit Framebuffer(int width, int height);
+  Framebuffer(int width, int height, const Option& option);
   Framebuffer(std::vector<Texture> color_textures);
+  Framebuffer(std::vector<Texture> color_textures, const Option& option);
   ~Framebuffer();
 
   // Move only ressource.
@@ -29,9 +59,17 @@ class Framebuffer : public RenderTarget {
 
   smk::Texture& color_texture();
 
+  // Copy the multisampled content into the color textures. Does nothing for a
+  // Framebuffer without multisampling.
+  void Resolve();
+  int samples() const { return samples_; }
+
  private:
-  void Init();
+  void Init(const Option& option);
   GLuint render_buffer_ = 0;
+  int samples_ = 0;
+  GLuint resolve_frame_buffer_ = 0;
+  std::vector<GLuint> color_render_buffers_;
   std::vector<smk::Texture> color_textures_;
 };
 
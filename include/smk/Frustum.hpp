@@ -0,0 +1,35 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_FRUSTUM_HPP
+#define SMK_FRUSTUM_HPP
+
+#include <glm/glm.hpp>
+#include <smk/BoundingBox.hpp>
+
+namespace smk {
+
+/// The volume visible through a projection matrix, delimited by 6 planes.
+///
+/// Built from |projection * view|, the tests take boxes in the space before
+/// |view|. This is how RenderTarget culls the drawables: their local bounds
+/// are tested against the frustum of |projection * view * transformation|.
+class Frustum {
+ public:
+  Frustum() = default;  // Contains everything.
+  explicit Frustum(const glm::mat4& matrix);
+
+  // Whether the volume may be visible. These are conservative: a volume near a
+  // corner of the frustum can be reported visible.
+  bool Intersects(const BoundingBox& box) const;
+  bool Intersects(const glm::vec3& center, float radius) const;
+
+ private:
+  // The planes (normal, distance), normals pointing inside.
+  glm::vec4 planes_[6] = {};
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_FRUSTUM_HPP */
@@ -0,0 +1,137 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_HANDLE_HPP
+#define SMK_HANDLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace smk {
+
+class InstanceArray;
+class ShaderProgram;
+class Texture;
+class VertexArray;
+
+/// A reference to a resource owned by a smk::ResourceRegistry. It is a plain
+/// pair of integers: copying it doesn't touch any ref-count.
+///
+/// The generation detects the handles outliving their resource. Once the
+/// resource is removed, the registry doesn't resolve them anymore, even if
+/// its slot is reused.
+template <typename T>
+struct Handle {
+  uint32_t index = 0;  // The slot in the registry, plus one. 0 is null.
+  uint32_t generation = 0;
+
+  explicit operator bool() const { return index != 0; }
+  bool operator==(const Handle& other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+using TextureHandle = Handle<Texture>;
+using VertexArrayHandle = Handle<VertexArray>;
+using ShaderProgramHandle = Handle<ShaderProgram>;
+using InstanceArrayHandle = Handle<InstanceArray>;
+
+/// Own a set of resources and give a smk::Handle to each of them.
+///
+/// The pointers returned by Get() are valid until the next Add(). They can be
+/// used to fill a smk::RenderStateRef, so that drawing only copies the
+/// handles.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::ResourceRegistry<smk::Texture> textures;
+/// smk::TextureHandle ball = textures.Add(smk::Texture("./ball.png"));
+///
+/// [...]
+///
+/// smk::RenderStateRef ref(state);
+/// ref.texture = textures.Get(ball);
+/// target.Draw(ref);
+/// ~~~
+template <typename T>
+class ResourceRegistry {
+ public:
+  Handle<T> Add(T resource) {
+    uint32_t index;
+    if (free_.empty()) {
+      index = uint32_t(slots_.size());
+      slots_.emplace_back();
+    } else {
+      index = free_.back();
+      free_.pop_back();
+    }
+    Slot& slot = slots_[index];
+    slot.resource = std::move(resource);
+    slot.used = true;
+    ++size_;
+
+    Handle<T> handle;
+    handle.index = index + 1;
+    handle.generation = slot.generation;
+    return handle;
+  }
+
+  // Release the resource. The handles referring to it become invalid.
+  void Remove(Handle<T> handle) {
+    Slot* slot = Find(handle);
+    if (!slot)
+      return;
+    slot->resource = T();
+    slot->used = false;
+    ++slot->generation;
+    free_.push_back(handle.index - 1);
+    --size_;
+  }
+
+  // Return nullptr when the handle is null or its resource was removed.
+  T* Get(Handle<T> handle) {
+    Slot* slot = Find(handle);
+    return slot ? &slot->resource : nullptr;
+  }
+  const T* Get(Handle<T> handle) const {
+    return const_cast<ResourceRegistry*>(this)->Get(handle);
+  }
+
+  bool Contains(Handle<T> handle) const { return Get(handle) != nullptr; }
+
+  // The number of resources.
+  size_t size() const { return size_; }
+
+ private:
+  struct Slot {
+    T resource;
+    uint32_t generation = 1;
+    bool used = false;
+  };
+
+  Slot* Find(Handle<T> handle) {
+    if (handle.index == 0 || handle.index > slots_.size())
+      return nullptr;
+    Slot& slot = slots_[handle.index - 1];
+    if (!slot.used || slot.generation != handle.generation)
+      return nullptr;
+    return &slot;
+  }
+
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> free_;
+  size_t size_ = 0;
+};
+
+static_assert(std::is_trivially_copyable<TextureHandle>::value,
+              "Handles must be trivially copyable");
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_HANDLE_HPP */
@@ -0,0 +1,87 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_IMAGE_DECODER_HPP
+#define SMK_IMAGE_DECODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace smk {
+
+/// Decode one image format, for smk::Texture, smk::AssetLoader and the
+/// textures reloaded by smk::Residency.
+///
+/// The registered decoders are tried from the most recently registered, before
+/// the bundled stb_image. The first one accepting the data decodes it. This
+/// lets the application plug faster codecs, like libspng, libjpeg-turbo or
+/// libwebp, without smk depending on them. A QOI decoder is registered by
+/// default.
+///
+/// The files are decoded in parallel by the worker threads of the AssetLoader:
+/// Accept() and Decode() can be called from several threads at once.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// class SpngDecoder : public smk::ImageDecoder {
+///  public:
+///   const char* name() const override { return "libspng"; }
+///   bool Accept(const uint8_t* data, size_t size) const override {
+///     return size >= 8 && !std::memcmp(data, "\x89PNG\r\n\x1A\n", 8);
+///   }
+///   bool Decode(const uint8_t* data,
+///               size_t size,
+///               Image* image) const override {
+///     [...]
+///   }
+/// };
+///
+/// smk::ImageDecoder::Register(std::make_shared<SpngDecoder>());
+/// auto texture = smk::Texture("./ball.png");  // Decoded by libspng.
+/// ~~~
+class ImageDecoder {
+ public:
+  struct Image {
+    int width = 0;
+    int height = 0;
+    int channels = 0;  // 1 (grey), 2 (grey, alpha), 3 (RGB) or 4 (RGBA).
+    // 8 bits per channel. The rows are tightly packed, from top to bottom.
+    std::vector<uint8_t> pixels;
+  };
+
+  virtual ~ImageDecoder() = default;
+
+  // Used to identify the decoder, for instance in the benchmarks.
+  virtual const char* name() const = 0;
+
+  // Whether |data| is in the format decoded. Usually checks the signature.
+  virtual bool Accept(const uint8_t* data, size_t size) const = 0;
+
+  // Return false on failure.
+  virtual bool Decode(const uint8_t* data,
+                      size_t size,
+                      Image* image) const = 0;
+
+  // Try |decoder| before the ones already registered.
+  static void Register(std::shared_ptr<ImageDecoder> decoder);
+  static void Unregister(const ImageDecoder* decoder);
+
+  // The registered decoders, in the order they are tried.
+  static std::vector<std::shared_ptr<ImageDecoder>> decoders();
+
+  // The first registered decoder accepting |data|, or nullptr to use
+  // stb_image.
+  static std::shared_ptr<ImageDecoder> Find(const uint8_t* data, size_t size);
+
+  // The bundled stb_image, used when no registered decoder accepts the data.
+  // It isn't part of decoders(). Useful to compare the other decoders with.
+  static std::shared_ptr<ImageDecoder> Bundled();
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_IMAGE_DECODER_HPP */
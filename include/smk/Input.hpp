@@ -62,6 +62,24 @@ class Input {
   /// @return the mouse position.
   virtual glm::vec2 mouse() const = 0;
 
+  // Events --------------------------------------------------------------------
+
+  enum class Device { Keyboard, Mouse };
+
+  /// A keyboard or mouse button changing state.
+  struct ButtonEvent {
+    Device device;
+    int button;  // The GLFW key or mouse button.
+    int action;  // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT.
+    double time;  // In seconds, see glfwGetTime().
+  };
+
+  /// @brief The button events received since the previous frame, in order.
+  /// Unlike the states above, this doesn't miss a button pressed and released
+  /// within the same frame.
+  /// @return the button events.
+  virtual const std::vector<ButtonEvent>& events() const = 0;
+
   // Touch.
   using FingerID = int;
 
@@ -0,0 +1,78 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_INSTANCE_ARRAY_HPP
+#define SMK_INSTANCE_ARRAY_HPP
+
+#include <atomic>
+#include <smk/OpenGL.hpp>
+#include <smk/Vertex.hpp>
+#include <smk/VertexArray.hpp>
+#include <vector>
+
+namespace smk {
+
+/// @brief A VertexArray drawn once per instance moved to the GPU memory. Every
+/// instance has its own transformation and color. The VertexArray is made of
+/// smk::Vertex3D with smk::Instance3D, or of smk::Vertex2D with the compact
+/// smk::Instance2D or with smk::Particle2D.
+///
+/// This class is movable and copyable. It is refcounted. The GPU data is
+/// automatically released when the last smk::InstanceArray is deleted.
+///
+/// @see InstancedMesh
+class InstanceArray {
+ public:
+  InstanceArray();  // The null InstanceArray.
+  InstanceArray(const VertexArray& vertex_array,
+                const std::vector<Instance3D>& instances);
+  InstanceArray(const VertexArray& vertex_array,
+                const std::vector<Instance2D>& instances);
+  // The particles are written by the GPU. See ParticleSystem.
+  InstanceArray(const VertexArray& vertex_array,
+                const std::vector<Particle2D>& particles);
+
+  ~InstanceArray();
+
+  void Bind() const;
+
+  // --- Movable-Copyable resource ---------------------------------------------
+  InstanceArray(InstanceArray&&) noexcept;
+  InstanceArray(const InstanceArray&);
+  InstanceArray& operator=(InstanceArray&&) noexcept;
+  InstanceArray& operator=(const InstanceArray&);
+  // ---------------------------------------------------------------------------
+  bool operator==(const smk::InstanceArray&) const;
+  bool operator!=(const smk::InstanceArray&) const;
+
+  // The number of instances.
+  size_t size() const;
+
+  // The vertices drawn for every instance.
+  const VertexArray& vertex_array() const { return vertex_array_; }
+
+  // The buffer holding the instances.
+  GLuint vbo() const { return vbo_; }
+
+ private:
+  void Allocate(size_t size, const void* data, GLenum usage = GL_STATIC_DRAW);
+  void Release();
+  static void Setup(const void* data);
+
+  VertexArray vertex_array_;
+  bool two_dimensional_ = false;  // Vertex2D and Instance2D or Particle2D.
+  void (*instance_layout_)() = &Instance3D::Bind;
+  GLFWwindow* context_ = nullptr;  // The context owning |vao_|.
+  GLuint vbo_ = 0;
+  GLuint vao_ = 0;
+  size_t size_ = 0u;
+
+  // Used to support copy. Counts how many instances shares this resource. It
+  // is atomic, so that copies can be made and released by several threads.
+  std::atomic<int>* ref_count_ = nullptr;
+};
+
+}  // namespace smk.
+
+#endif /* end of include guard: SMK_INSTANCE_ARRAY_HPP */
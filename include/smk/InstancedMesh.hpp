@@ -0,0 +1,136 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_INSTANCED_MESH_HPP
+#define SMK_INSTANCED_MESH_HPP
+
+#include <glm/glm.hpp>
+#include <smk/InstanceArray.hpp>
+#include <smk/Transformable.hpp>
+#include <smk/Vertex.hpp>
+#include <vector>
+
+namespace smk {
+
+/// @example instancing.cpp
+
+/// A 3D mesh drawn many times using a single draw call. Every instance has its
+/// own transformation and color, applied after the ones of the InstancedMesh
+/// itself.
+///
+/// The texture, the blend mode and the VertexArray are shared by every
+/// instances. The VertexArray must be made of smk::Vertex3D, like the ones
+/// produced by smk::Shape.
+///
+/// It is drawn using RenderTarget::shader_program_3d_instanced() when the
+/// current ShaderProgram is one of the default ones. A custom ShaderProgram
+/// reads the instances attributes from the locations 3 (mat4) and 7 (vec4).
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::InstancedMesh cubes;
+/// cubes.SetVertexArray(smk::Shape::Cube().vertex_array());
+///
+/// [...]
+///
+/// cubes.Clear();
+/// for(auto& cube : cubes_states)
+///   cubes.Add(cube.transformation, cube.color);
+/// window.Draw(cubes);
+/// ~~~
+class InstancedMesh : public Transformable3D {
+ public:
+  InstancedMesh() = default;
+
+  // Remove every instances.
+  void Clear();
+
+  // Append an instance.
+  void Add(const glm::mat4& transformation,
+           const glm::vec4& color = {1.f, 1.f, 1.f, 1.f});
+  void Add(const Transformable3D& object);
+
+  // The number of instances added since the last Clear().
+  size_t size() const { return instances_.size(); }
+
+  // Drawable override:
+  void Draw(RenderTarget& target, RenderState state) const override;
+
+  // Movable-copyable class.
+  InstancedMesh(InstancedMesh&&) noexcept = default;
+  InstancedMesh(const InstancedMesh&) = default;
+  InstancedMesh& operator=(InstancedMesh&&) noexcept = default;
+  InstancedMesh& operator=(const InstancedMesh&) = default;
+
+ private:
+  std::vector<Instance3D> instances_;
+
+  // The GPU copy of |instances_|, rebuilt before drawing when modified.
+  mutable InstanceArray instance_array_;
+  mutable bool dirty_ = false;
+};
+
+/// A 2D mesh drawn many times using a single draw call. This is the 2D
+/// counterpart of smk::InstancedMesh. Every instance uses a compact 2x3
+/// transformation, expanded by the vertex shader.
+///
+/// The VertexArray must be made of smk::Vertex2D, for instance a unit square.
+///
+/// It is drawn using RenderTarget::shader_program_2d_instanced() when the
+/// current ShaderProgram is the default 2D one. A custom ShaderProgram reads the
+/// instances attributes from the locations 3 and 4 (vec3, the rows of the
+/// transformation) and 7 (vec4, the color).
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::InstancedMesh2D particles;
+/// particles.SetVertexArray(square);
+///
+/// [...]
+///
+/// particles.Clear();
+/// for(auto& particle : particles_states)
+///   particles.Add(particle.position, particle.rotation);
+/// window.Draw(particles);
+/// ~~~
+class InstancedMesh2D : public Transformable {
+ public:
+  InstancedMesh2D() = default;
+
+  // Remove every instances.
+  void Clear();
+
+  // Append an instance.
+  void Add(const Instance2D& instance);
+  void Add(const glm::vec2& position,
+           float rotation = 0.f,
+           const glm::vec2& scale = {1.f, 1.f},
+           const glm::vec4& color = {1.f, 1.f, 1.f, 1.f});
+  void Add(const Transformable& object);
+
+  // The number of instances added since the last Clear().
+  size_t size() const { return instances_.size(); }
+
+  // Drawable override:
+  void Draw(RenderTarget& target, RenderState state) const override;
+
+  // Movable-copyable class.
+  InstancedMesh2D(InstancedMesh2D&&) noexcept = default;
+  InstancedMesh2D(const InstancedMesh2D&) = default;
+  InstancedMesh2D& operator=(InstancedMesh2D&&) noexcept = default;
+  InstancedMesh2D& operator=(const InstancedMesh2D&) = default;
+
+ private:
+  std::vector<Instance2D> instances_;
+
+  // The GPU copy of |instances_|, rebuilt before drawing when modified.
+  mutable InstanceArray instance_array_;
+  mutable bool dirty_ = false;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_INSTANCED_MESH_HPP */
@@ -0,0 +1,86 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_MUSIC_HPP
+#define SMK_MUSIC_HPP
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace smk {
+
+/// @brief A long sound file, streamed while it is played.
+///
+/// Unlike a SoundBuffer, the file isn't loaded in memory. A worker thread
+/// decodes it chunk by chunk, a fraction of second ahead of the playback. The
+/// chunks are queued into a small ring of OpenAL buffers. The memory used stays
+/// constant and the playback starts immediately.
+///
+/// WAV files are read from the disk progressively. The other formats are
+/// decoded entirely by the worker thread first, because libnyquist has no
+/// incremental decoder. They don't block the caller, but use the memory of the
+/// decoded file.
+///
+/// Update() queues the chunks decoded. It must be called regularly, typically
+/// once per frame.
+///
+/// Example
+/// -------
+/// ~~~cpp
+/// auto music = smk::Music("./theme.wav");
+/// music.SetLoop(true);
+/// music.Play();
+///
+/// window.ExecuteMainLoop([&] {
+///   music.Update();
+///   [...]
+/// });
+/// ~~~
+///
+/// Please make sure to init OpenAL in main() by creating a smk::Audio.
+class Music {
+ public:
+  Music();  // Null music.
+  Music(const std::string& filename);
+  ~Music();
+
+  void Play();
+  void Stop();
+  void SetLoop(bool looping);
+  bool IsPlaying() const;
+
+  // The gain applied to the source. Default is 1.
+  void SetVolume(float volume);
+
+  // Queue the chunks decoded since the last call, and recycle the OpenAL
+  // buffers already played.
+  void Update();
+
+  // -- Move-only resource ---
+  Music(Music&&) noexcept;
+  Music(const Music&) = delete;
+  void operator=(Music&&) noexcept;
+  void operator=(const Music&) = delete;
+
+ private:
+  static constexpr size_t kBufferCount = 4;
+  struct Decoder;
+
+  void EnsureSourceIsCreated();
+
+  std::string filename_;
+  unsigned int source_ = 0;
+  std::array<unsigned int, kBufferCount> buffers_ = {};
+  std::vector<unsigned int> free_buffers_;
+  std::unique_ptr<Decoder> decoder_;
+  bool looping_ = false;
+  bool is_playing_ = false;
+  float volume_ = 1.f;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_MUSIC_HPP */
@@ -0,0 +1,111 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_PARTICLE_SYSTEM_HPP
+#define SMK_PARTICLE_SYSTEM_HPP
+
+#include <glm/glm.hpp>
+#include <smk/InstanceArray.hpp>
+#include <smk/Transformable.hpp>
+#include <smk/Vertex.hpp>
+
+namespace smk {
+
+/// A set of 2D particles, simulated and drawn by the GPU. The state of the
+/// particles never leaves the GPU memory: Update() moves them using transform
+/// feedback, and Draw() draws all of them with a single instanced draw call.
+/// The CPU does no per-particle work.
+///
+/// The particles are emitted continuously by the Emitter. A dead particle is
+/// spawned again, with a random speed, direction and lifetime. Their size and
+/// color are interpolated over their life. The emitter and the particles live
+/// in the local space of the ParticleSystem, which can be moved, rotated and
+/// colored as any Transformable.
+///
+/// Every particle is drawn as a unit square centered on its position, scaled by
+/// its size. It uses the texture of the ParticleSystem. An other shape made of
+/// smk::Vertex2D can be given to the constructor. It can't be replaced later.
+///
+/// It is drawn using RenderTarget::shader_program_2d_particles() when the
+/// current ShaderProgram is the default 2D one. A custom ShaderProgram reads the
+/// Particle2D attributes from the locations 3 (vec2 position), 4 (vec2
+/// velocity), 5 (vec3 age, lifetime and size) and 7 (vec4 color).
+///
+/// Update() must be called by the thread owning the OpenGL context.
+///
+/// This is a move-only resource.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::ParticleSystem smoke(100000);
+/// smk::ParticleSystem::Emitter emitter;
+/// emitter.position = {320.f, 400.f};
+/// emitter.direction = -90.f;  // Up.
+/// emitter.spread = 30.f;
+/// smoke.SetEmitter(emitter);
+/// smoke.SetTexture(smoke_texture);
+/// smoke.SetBlendMode(smk::BlendMode::Add);
+///
+/// [...]
+///
+/// smoke.Update(delta);
+/// window.Draw(smoke);
+/// ~~~
+class ParticleSystem : public Transformable {
+ public:
+  struct Emitter {
+    glm::vec2 position = {0.f, 0.f};
+    // The mean direction, in degrees. 0 points toward +x, 90 toward +y.
+    float direction = 0.f;
+    // The angle covered by the directions, in degrees, centered on
+    // |direction|.
+    float spread = 360.f;
+    glm::vec2 speed = {50.f, 100.f};  // Min and max, in pixels per second.
+    glm::vec2 lifetime = {1.f, 2.f};  // Min and max, in seconds.
+    glm::vec2 gravity = {0.f, 0.f};   // In pixels per second squared.
+    glm::vec2 size = {8.f, 0.f};      // At birth and at death, in pixels.
+    glm::vec4 start_color = {1.f, 1.f, 1.f, 1.f};
+    glm::vec4 end_color = {1.f, 1.f, 1.f, 0.f};
+    // When disabled, the dead particles aren't spawned again.
+    bool emitting = true;
+  };
+
+  ParticleSystem() = default;  // No particles.
+  explicit ParticleSystem(size_t capacity);
+  ParticleSystem(size_t capacity, const VertexArray& shape);
+
+  void SetEmitter(const Emitter& emitter) { emitter_ = emitter; }
+  const Emitter& emitter() const { return emitter_; }
+
+  // Advance the simulation by |delta| seconds.
+  void Update(float delta);
+
+  // The number of particles, alive or not.
+  size_t capacity() const { return capacity_; }
+
+  // Drawable override:
+  void Draw(RenderTarget& target, RenderState state) const override;
+
+  // --- Move only resource ----------------------------------------------------
+  ParticleSystem(ParticleSystem&&) noexcept;
+  ParticleSystem(const ParticleSystem&) = delete;
+  ParticleSystem& operator=(ParticleSystem&&) noexcept;
+  ParticleSystem& operator=(const ParticleSystem&) = delete;
+  // ---------------------------------------------------------------------------
+
+ private:
+  Emitter emitter_;
+  size_t capacity_ = 0;
+  unsigned int seed_ = 0;  // Changes every Update().
+
+  // The state of the particles, before and after an Update(). They are
+  // swapped after every Update().
+  InstanceArray particles_[2];
+  int current_ = 0;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_PARTICLE_SYSTEM_HPP */
@@ -0,0 +1,80 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_PATH_BUILDER_HPP
+#define SMK_PATH_BUILDER_HPP
+
+#include <smk/Transformable.hpp>
+#include <smk/Vertex.hpp>
+#include <smk/VertexArray.hpp>
+#include <vector>
+
+namespace smk {
+
+/// A path of a given thickness, built incrementally. This is the streaming
+/// version of Shape::Path(), suited to strokes and plots growing every frame.
+///
+/// Adding a point only tessellates the new segment and the joint with the
+/// previous one. Only those vertices are uploaded on the next draw, into a
+/// buffer whose capacity grows geometrically.
+///
+/// This is a move-only resource.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::PathBuilder stroke(/*thickness=*/4.f);
+/// stroke.SetColor(smk::Color::Red);
+///
+/// [...]
+///
+/// stroke.Add(window.input().mouse());
+/// window.Draw(stroke);
+/// ~~~
+class PathBuilder : public Transformable {
+ public:
+  PathBuilder() = default;
+  explicit PathBuilder(float thickness);
+
+  // Append points at the end of the path.
+  void Add(const glm::vec2& point);
+  void AddBezier(const std::vector<glm::vec2>& points, size_t subdivision);
+  void Clear();
+
+  // Changing the thickness tessellates the whole path again.
+  void SetThickness(float thickness);
+  float thickness() const { return thickness_; }
+
+  const std::vector<glm::vec2>& points() const { return points_; }
+
+  // Drawable override:
+  void Draw(RenderTarget& target, RenderState state) const override;
+
+  // --- Move only resource ----------------------------------------------------
+  PathBuilder(PathBuilder&&) = default;
+  PathBuilder(const PathBuilder&) = delete;
+  PathBuilder& operator=(PathBuilder&&) = default;
+  PathBuilder& operator=(const PathBuilder&) = delete;
+  // ---------------------------------------------------------------------------
+
+ private:
+  void ComputeOutline(size_t index);
+  void WriteSegment(size_t segment);
+
+  float thickness_ = 1.f;
+  std::vector<glm::vec2> points_;
+  // The outline of the path at every points.
+  std::vector<glm::vec2> left_;
+  std::vector<glm::vec2> right_;
+  // Two triangles per segment.
+  std::vector<Vertex2D> vertices_;
+
+  // The vertices from |dirty_| haven't been uploaded yet.
+  mutable size_t dirty_ = 0;
+  mutable VertexArray vertex_array_;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_PATH_BUILDER_HPP */
@@ -0,0 +1,107 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_PROFILER_HPP
+#define SMK_PROFILER_HPP
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace smk {
+
+class Font;
+class RenderTarget;
+
+/// A lightweight CPU profiler.
+///
+/// The time spent in a scope is recorded by a Profiler::Scope, usually
+/// declared with SMK_PROFILE_SCOPE. Every threads records into its own ring
+/// buffer. When the profiler is disabled, a scope costs a single test.
+///
+/// smk records its own hot paths: polling the events, drawing, displaying,
+/// loading textures and glyphs. Window::Display() closes the frame and
+/// records the GPU time measured by the timer queries.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::Profiler::SetEnabled(true);
+///
+/// window.ExecuteMainLoop([&] {
+///   {
+///     SMK_PROFILE_SCOPE("Game::Update");
+///     Update();
+///   }
+///   [...]
+///   smk::Profiler::DrawOverlay(window, font);
+///   window.Display();
+/// });
+///
+/// smk::Profiler::ExportChromeTrace("trace.json");
+/// ~~~
+class Profiler {
+ public:
+  // A recorded scope. Times are in seconds.
+  struct Event {
+    const char* name;
+    double begin;
+    double end;
+    int thread;
+    int depth;
+  };
+
+  static void SetEnabled(bool enabled);
+  static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  // Record the time spent until the end of the scope. |name| must outlive the
+  // profiler, typically a string literal.
+  class Scope {
+   public:
+    explicit Scope(const char* name) {
+      if (enabled())
+        Begin(name);
+    }
+    ~Scope() {
+      if (name_)
+        End();
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    void Begin(const char* name);
+    void End();
+    const char* name_ = nullptr;
+    double begin_ = 0.0;
+  };
+
+  // Close the current frame. Called by Window::Display().
+  static void NewFrame(float gpu_time);
+
+  // The scopes ended during the last frame, on every threads.
+  static std::vector<Event> last_frame();
+  static float last_frame_duration();  // In milliseconds.
+  static float last_frame_gpu_time();  // In milliseconds, -1 when unknown.
+
+  // Draw the time spent in every scope during the last frame, in the top left
+  // corner of the current view of |target|.
+  static void DrawOverlay(RenderTarget& target, Font& font);
+
+  // Write the recorded scopes using the Chrome trace format. It can be loaded
+  // in chrome://tracing or https://ui.perfetto.dev. Return false on failure.
+  static bool ExportChromeTrace(const std::string& filename);
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+}  // namespace smk
+
+#define SMK_PROFILE_CONCAT_(a, b) a##b
+#define SMK_PROFILE_CONCAT(a, b) SMK_PROFILE_CONCAT_(a, b)
+#define SMK_PROFILE_SCOPE(name) \
+  ::smk::Profiler::Scope SMK_PROFILE_CONCAT(smk_profile_scope_, __LINE__)(name)
+
+#endif /* end of include guard: SMK_PROFILER_HPP */
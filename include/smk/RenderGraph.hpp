@@ -0,0 +1,137 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_RENDER_GRAPH_HPP
+#define SMK_RENDER_GRAPH_HPP
+
+#include <functional>
+#include <memory>
+#include <smk/Framebuffer.hpp>
+#include <smk/Texture.hpp>
+#include <string>
+#include <vector>
+
+namespace smk {
+
+/// @example render_graph.cpp
+
+/// A chain of offscreen passes, for instance for post-processing.
+///
+/// Every frame, the passes are declared with the targets they read and the one
+/// they write. Execute() then:
+///  * skips the passes not contributing to an imported target,
+///  * runs the other ones in dependency order,
+///  * backs the transient targets with Framebuffers taken from a pool. A
+///    Framebuffer is given back to the pool after the last pass reading it, so
+///    that targets not alive at the same time share it. The pool is kept
+///    across frames. A Framebuffer unused for kPoolLifetime executions is
+///    deleted.
+///
+/// The content of a transient target is undefined when its first pass starts.
+/// The pass must clear it.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::RenderGraph graph;
+///
+/// [...]
+///
+/// graph.Clear();
+/// auto scene = graph.CreateTarget(640, 480, true);
+/// auto screen = graph.ImportTarget(window);
+/// graph.AddPass("scene", {}, scene, [&](smk::RenderTarget& target,
+///                                       const std::vector<smk::Texture>&) {
+///   target.Clear(smk::Color::Black);
+///   target.Draw(mesh);
+/// });
+/// graph.AddPass("blur", {scene}, screen, [&](smk::RenderTarget& target,
+///                                 const std::vector<smk::Texture>& inputs) {
+///   target.Draw(smk::Sprite(inputs[0]));
+/// });
+/// graph.Execute();
+/// ~~~
+class RenderGraph {
+ public:
+  // Identify a target in the graph.
+  using Target = int;
+
+  // Draw into |output|. |inputs| are the color textures of the pass inputs.
+  using Execution = std::function<void(RenderTarget& output,
+                                       const std::vector<Texture>& inputs)>;
+
+  RenderGraph();
+  ~RenderGraph();
+
+  // Declare a target allocated by the graph.
+  Target CreateTarget(int width, int height, bool depth_stencil = false);
+
+  // Declare a target owned by the caller. It must outlive Execute(). Only
+  // Framebuffers can be read by other passes.
+  Target ImportTarget(RenderTarget& render_target);
+  Target ImportTarget(Framebuffer& framebuffer);
+
+  void AddPass(const std::string& name,
+               std::vector<Target> inputs,
+               Target output,
+               Execution execution);
+
+  // Run the passes.
+  void Execute();
+
+  // Remove the passes and the targets. The pooled Framebuffers are kept.
+  void Clear();
+
+  // The number of Execute() after which an unused pooled Framebuffer is
+  // deleted.
+  static constexpr int kPoolLifetime = 60;
+
+  // The names of the passes run by the last Execute(), in order.
+  const std::vector<std::string>& executed_passes() const {
+    return executed_passes_;
+  }
+
+  // --- Move only resource ----------------------------------------------------
+  RenderGraph(RenderGraph&&) noexcept;
+  RenderGraph(const RenderGraph&) = delete;
+  RenderGraph& operator=(RenderGraph&&) noexcept;
+  RenderGraph& operator=(const RenderGraph&) = delete;
+  // ---------------------------------------------------------------------------
+
+ private:
+  struct Resource {
+    int width = 0;
+    int height = 0;
+    bool depth_stencil = false;
+    RenderTarget* imported = nullptr;
+    Framebuffer* framebuffer = nullptr;  // Assigned while executing.
+  };
+
+  struct Pass {
+    std::string name;
+    std::vector<Target> inputs;
+    Target output;
+    Execution execution;
+  };
+
+  struct Pooled {
+    std::unique_ptr<Framebuffer> framebuffer;
+    bool depth_stencil;
+    bool used;
+    int last_execution;  // The last Execute() using it.
+  };
+
+  Framebuffer* Acquire(const Resource& resource);
+  void Release(Framebuffer* framebuffer);
+
+  std::vector<Resource> resources_;
+  std::vector<Pass> passes_;
+  std::vector<Pooled> pool_;
+  int execution_ = 0;
+  std::vector<std::string> executed_passes_;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_RENDER_GRAPH_HPP */
@@ -7,6 +7,7 @@
 
 #include <glm/glm.hpp>
 #include <smk/BlendMode.hpp>
+#include <smk/InstanceArray.hpp>
 #include <smk/Shader.hpp>
 #include <smk/Texture.hpp>
 #include <smk/VertexArray.hpp>
@@ -14,13 +15,87 @@
 namespace smk {
 
 /// Contain all the data needed to draw
+///
+/// Besides |texture|, bound to the unit 0, up to kExtraTextureUnits textures
+/// can be bound for the effects sampling several inputs in a single pass: a
+/// mask, a normal map, a palette, ... |textures[i]| is bound to the unit i+1.
+/// The ShaderProgram samples it using the "texture_<i+1>" uniform, assigned by
+/// RenderTarget::SetShaderProgram().
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// // Samples texture_0 and texture_1.
+/// window.SetShaderProgram(masked_program);
+/// smk::RenderState state;
+/// state.shader_program = masked_program;
+/// state.color = smk::Color::White;
+/// state.textures[0] = mask;
+/// sprite.Draw(window, state);
+/// ~~~
 struct RenderState {
+  static const int kExtraTextureUnits = 3;
+
   ShaderProgram shader_program;             ///< The shader used.
   Texture texture;                          ///< The texture 0 bound.
+  Texture textures[kExtraTextureUnits];     ///< The textures 1, 2 and 3 bound.
   VertexArray vertex_array;                 ///< The shape to to be drawn
+  InstanceArray instances;  ///< When set, draw its VertexArray once per instance.
   glm::mat4 view = glm::mat4(1.f);          ///< The "view" transformation.
   glm::vec4 color = glm::vec4(0.f);         ///< The masking color.
+  /// The area of the texture mapped onto the [0,1]^2 texture coordinates, as
+  /// (left, top, right, bottom).
+  glm::vec4 texture_rectangle = {0.f, 0.f, 1.f, 1.f};
   BlendMode blend_mode = BlendMode::Alpha;  ///< The OpenGL BlendMode
+  /// When |clip| is set, only the pixels inside |clip_box| are drawn. It is a
+  /// glScissor() box: (x, y, width, height) in pixels, from the bottom-left
+  /// corner of the RenderTarget. See RenderTarget::PushClip().
+  bool clip = false;
+  glm::ivec4 clip_box = glm::ivec4(0);
+};
+
+/// A non-owning view of a RenderState. Drawing through it copies no resources
+/// and leaves their ref-counts untouched. The resources pointed to must
+/// outlive the RenderTarget::Draw() call.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// void MyDrawable::Draw(smk::RenderTarget& target,
+///                       smk::RenderState state) const {
+///   smk::RenderStateRef ref(state);
+///   ref.texture = &texture_;
+///   ref.vertex_array = &vertex_array_;
+///   target.Draw(ref);
+/// }
+/// ~~~
+struct RenderStateRef {
+  RenderStateRef(const RenderState& state)
+      : shader_program(&state.shader_program),
+        texture(&state.texture),
+        vertex_array(&state.vertex_array),
+        instances(&state.instances),
+        view(state.view),
+        color(state.color),
+        texture_rectangle(state.texture_rectangle),
+        blend_mode(state.blend_mode),
+        clip(state.clip),
+        clip_box(state.clip_box) {
+    for (int i = 0; i < RenderState::kExtraTextureUnits; ++i)
+      textures[i] = &state.textures[i];
+  }
+
+  const ShaderProgram* shader_program;
+  const Texture* texture;
+  const Texture* textures[RenderState::kExtraTextureUnits];
+  const VertexArray* vertex_array;
+  const InstanceArray* instances;
+  glm::mat4 view;
+  glm::vec4 color;
+  glm::vec4 texture_rectangle;
+  BlendMode blend_mode;
+  bool clip;
+  glm::ivec4 clip_box;
 };
 
 }  // namespace smk
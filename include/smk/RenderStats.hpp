@@ -0,0 +1,40 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_RENDER_STATS_HPP
+#define SMK_RENDER_STATS_HPP
+
+namespace smk {
+
+/// The work submitted to the GPU during a frame.
+///
+/// The counters are accumulated by every RenderTarget and reset by
+/// Window::Display(). See RenderTarget::stats() and Window::frame_stats().
+struct RenderStats {
+  int draw_calls = 0;
+  int vertices = 0;
+
+  // The draws skipped, because they were outside of the view.
+  int culled_draws = 0;
+
+  // State changes, by category:
+  int shader_changes = 0;
+  int texture_changes = 0;
+  int vertex_array_changes = 0;
+  int blend_mode_changes = 0;
+  int uniform_uploads = 0;
+
+  // Data transfers:
+  int texture_uploads = 0;
+  int buffer_allocations = 0;
+
+  // The GPU time of the most recent frame whose result is available, in
+  // milliseconds. The measure arrives with a few frames of latency. It is
+  // negative when unsupported.
+  float gpu_time = -1.f;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_RENDER_STATS_HPP */
@@ -5,17 +5,25 @@
 #ifndef SMK_RENDER_TARGET_HPP
 #define SMK_RENDER_TARGET_HPP
 
+#include <cstdint>
+#include <functional>
 #include <glm/glm.hpp>
 #include <memory>
+#include <smk/BoundingBox.hpp>
+#include <smk/FrameBlock.hpp>
 #include <smk/RenderState.hpp>
+#include <smk/RenderStats.hpp>
 #include <smk/Shader.hpp>
 #include <smk/VertexArray.hpp>
 #include <smk/View.hpp>
+#include <vector>
 
 namespace smk {
 
+class CommandList;
 class Drawable;
 struct RenderState;
+struct RenderStateRef;
 
 /// A texture where things can be / a smk::Drawable can be drawn on.
 ///
@@ -30,22 +38,101 @@ class RenderTarget {
   void operator=(RenderTarget&& other) noexcept;
   void operator=(const RenderTarget& rhs) = delete;
 
+  // The buffers of a render target. They can be combined.
+  enum Attachment {
+    Color = 1 << 0,
+    Depth = 1 << 1,
+    Stencil = 1 << 2,
+    All = Color | Depth | Stencil,
+  };
+
   // 0. Clear the framebuffer
   void Clear(const glm::vec4& color);
+  void Clear(const glm::vec4& color, int attachments);
+
+  // Tell the GPU the content of some attachments is no longer needed, for
+  // instance the depth buffer once a pass is drawn. On tiled GPUs, this avoids
+  // writing them back to memory. Their content becomes undefined.
+  void Invalidate(int attachments);
 
   // 1. Set the view
   void SetView(const View& view);
   void SetView(const glm::mat4& mat);
   const View& view() const;
 
+  // Whether the drawables entirely outside of the view are skipped, before
+  // any uniform upload. Enabled by default. Disable it when a ShaderProgram
+  // moves the vertices outside of their VertexArray::bounds().
+  void SetFrustumCulling(bool enabled) { frustum_culling_ = enabled; }
+  bool frustum_culling() const { return frustum_culling_; }
+  // Whether |bounds|, transformed by |view|, may be visible. When it isn't,
+  // the draw is counted in RenderStats::culled_draws. Empty bounds are
+  // unknown: the drawables without them are always drawn.
+  bool IsVisible(const BoundingBox& bounds, const glm::mat4& view) const;
+  // The diameter in pixels of the bounding sphere of |bounds| transformed by
+  // |view|, once projected on this RenderTarget. 0 when behind the camera.
+  float ProjectedSize(const BoundingBox& bounds, const glm::mat4& view) const;
+
+  // Restrict the next draws to a rectangle, in pixels from the top-left corner
+  // of the surface: (left, top, right, bottom). It is intersected with the
+  // clip rectangles pushed before. This uses the scissor test: the clipped
+  // content needs no intermediate Framebuffer. Clear() ignores the clip.
+  void PushClip(const glm::ivec4& rectangle);
+  void PopClip();
+
   // 2. Set a shader to render elements.
   void SetShaderProgram(ShaderProgram& shader_program);
   ShaderProgram& shader_program_2d();
+  ShaderProgram& shader_program_2d_instanced();
+  ShaderProgram& shader_program_2d_glyph();
+  ShaderProgram& shader_program_2d_distance_field();
+  ShaderProgram& shader_program_2d_array();
+  ShaderProgram& shader_program_2d_colored();
+  ShaderProgram& shader_program_2d_particles();
   ShaderProgram& shader_program_3d();
+  ShaderProgram& shader_program_3d_instanced();
+
+  // The state shared by every ShaderProgram. Modifications are uploaded
+  // before the next draw.
+  static FrameBlock& frame_block();
+
+  // The work submitted since the last Window::Display().
+  static const RenderStats& stats();
 
   // 3. Draw some stuff.
   virtual void Draw(const Drawable& drawable);
   virtual void Draw(RenderState& state);
+  void Draw(const RenderStateRef& state);
+
+  // 4. Optionally, defer the draws and submit them sorted to reduce the state
+  // changes.
+  void SetDeferred(bool deferred);
+  bool deferred() const { return deferred_; }
+  void SetLayer(int layer);
+  void Flush();
+
+  // Optionally, with deferred draws, sort the draws of every layer by depth.
+  // Suited for 3D: the opaque draws are submitted front-to-back with depth
+  // test and writes, then the other ones back-to-front with depth test only.
+  // Like after Clear(), the depth test is disabled after Flush().
+  void SetDepthSorting(bool depth_sorting) { depth_sorting_ = depth_sorting; }
+  bool depth_sorting() const { return depth_sorting_; }
+
+  // Draw the draws recorded by |list|, possibly by an other thread, and
+  // empty it. See CommandList.
+  void Append(CommandList& list);
+
+  // 5. Optionally, read back the pixels drawn so far. The copy happens in the
+  // background. The callback receives RGBA(8,8,8,8) pixels, from the top row
+  // to the bottom one, once they are available. See CompleteReadbacks().
+  using ReadbackCallback =
+      std::function<void(std::vector<uint8_t> rgba, int width, int height)>;
+  void ReadPixelsAsync(ReadbackCallback callback);
+
+  // Deliver the readbacks completed by the GPU, without waiting. This is
+  // called by Window::Display(). When |wait| is true, block until every
+  // pending readbacks are delivered.
+  static void CompleteReadbacks(bool wait = false);
 
   // Surface dimensions:
   glm::vec2 dimensions() const;
@@ -58,6 +145,38 @@ class RenderTarget {
 
  protected:
   void InitRenderTarget();
+  // Derive the clip of a draw from the clip rectangles pushed.
+  void ApplyClip(RenderState& state) const;
+  // Disable the scissor test of the current context, before clearing or
+  // blitting the whole surface.
+  static void DisableClipBound();
+  // |uniforms| are the custom uniforms recorded with a replayed draw. They
+  // are the latest ones otherwise.
+  void Submit(const RenderStateRef& state,
+              const glm::mat4& projection_matrix,
+              const ShaderProgram::UniformValues* uniforms = nullptr);
+
+  // A command recorded instead of being executed, for an other thread to
+  // replay it. See Window::Option::render_thread.
+  struct Command {
+    enum Type { Clear, Invalidate, Draw, Depth };
+    Type type;
+    int attachments;
+    glm::vec4 color;
+    RenderState state;
+    glm::mat4 projection_matrix;
+    std::shared_ptr<const ShaderProgram::UniformValues> uniforms;
+  };
+  void RecordDraw(RenderState state, const glm::mat4& projection_matrix);
+
+  // Execute |commands| on the current thread. |width| and |height| are the
+  // dimensions of the surface when they were recorded.
+  void Replay(std::vector<Command>& commands, int width, int height);
+
+  // When set, the commands are appended to |recording_| instead.
+  std::vector<Command>* recording_ = nullptr;
+  friend struct RecordedFrame;
+  friend class CommandList;
 
   int width_ = 0;
   int height_ = 0;
@@ -65,20 +184,41 @@ class RenderTarget {
   // View:
   glm::mat4 projection_matrix_ = glm::mat4(1);
   smk::View view_;
+  bool frustum_culling_ = true;
 
-  // Shaders:
-  Shader vertex_shader_2d_;
-  Shader fragment_shader_2d_;
-  ShaderProgram shader_program_2d_;
+  // The clip rectangles pushed, each intersected with the previous one.
+  std::vector<glm::ivec4> clips_;
 
-  Shader vertex_shader_3d_;
-  Shader fragment_shader_3d_;
-  ShaderProgram shader_program_3d_;
+  // Shaders:
+  struct DefaultPrograms;
+  DefaultPrograms& default_programs();
+  // Build all of them, once per OpenGL context. Used by the CommandLists.
+  void BuildDefaultPrograms();
+  std::shared_ptr<DefaultPrograms> default_programs_;
 
-  // Current shader program.
+  // Current shader program. The 2D one when not set.
   ShaderProgram shader_program_;
 
+  // The OpenGL context owning |frame_buffer_|. Framebuffer objects aren't
+  // shared between the windows. It is made current while drawing, and the
+  // previous context is made current again afterward.
+  GLFWwindow* context_ = nullptr;
   GLuint frame_buffer_ = 0;
+  int color_attachment_count_ = 1;
+
+  // Deferred draws:
+  struct QueuedDraw {
+    RenderState state;
+    glm::mat4 projection_matrix;
+    int layer;
+    bool blended;
+    uint64_t key;
+    float depth;  // The projected depth. Used with |depth_sorting_|.
+  };
+  std::vector<QueuedDraw> queue_;
+  bool deferred_ = false;
+  bool depth_sorting_ = false;
+  int layer_ = 0;
 };
 
 }  // namespace smk
@@ -0,0 +1,55 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_RESIDENCY_HPP
+#define SMK_RESIDENCY_HPP
+
+#include <cstddef>
+
+namespace smk {
+
+/// Account the GPU memory used by the Textures, the vertex buffers and the
+/// Framebuffers, and keep it under a budget.
+///
+/// When the memory in use exceeds the budget, Window::Display() evicts the
+/// textures drawn least recently, until it fits again. Only the textures loaded
+/// from a file can be evicted: their GPU storage is released, but every copy
+/// of the smk::Texture stays valid. The next draw using one of them reloads it
+/// from its file, transparently.
+///
+/// The textures drawn during the last two frames are never evicted. The sizes
+/// are estimates: the drivers align and pad the allocations. With
+/// Window::Option::render_thread, the textures are evicted by the render
+/// thread, after every frame it renders.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// // Keep the resources under 256MB.
+/// smk::Residency::SetBudget(256 << 20);
+/// ~~~
+class Residency {
+ public:
+  // 0, the default, disables the eviction.
+  static void SetBudget(size_t bytes);
+  static size_t budget();
+
+  // The GPU memory in use, in bytes.
+  static size_t bytes();
+  static size_t texture_bytes();
+  static size_t buffer_bytes();         // VertexArray and InstanceArray.
+  static size_t render_buffer_bytes();  // Framebuffer depth and multisampling.
+
+  // The number of textures evicted and reloaded, since the start.
+  static size_t evictions();
+  static size_t reloads();
+
+  // Evict textures until the budget is met, and start a new frame. Called by
+  // Window::Display(), or by the render thread of the Window when it has one.
+  static void NewFrame();
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_RESIDENCY_HPP */
@@ -0,0 +1,144 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_RETAINED_LAYER_HPP
+#define SMK_RETAINED_LAYER_HPP
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <smk/Drawable.hpp>
+#include <smk/Framebuffer.hpp>
+#include <smk/Handle.hpp>
+#include <smk/Rectangle.hpp>
+#include <smk/Sprite.hpp>
+#include <smk/Transformable.hpp>
+#include <vector>
+
+namespace smk {
+
+class Text;
+
+/// A set of 2D Drawables rendered once into a Framebuffer, and drawn as a
+/// single textured quad. Only the areas where something changed are rendered
+/// again, using the scissor test. A static UI costs a single draw call per
+/// frame.
+///
+/// The Transformables and the Texts added are tracked: they are rendered again
+/// after a modification of their transformation, color, texture, shape or
+/// string. Their bounds are computed from their shape. The changes of the other
+/// Drawables must be signaled with Invalidate().
+///
+/// The Drawables are owned by the caller. They must outlive the layer, or be
+/// removed before being destroyed. They are drawn in the order they were
+/// added, in the coordinates of the layer: its pixels, from its top-left
+/// corner.
+///
+/// Like with any Framebuffer, the translucent content is blended with the
+/// background of the layer. Give it an opaque background when the exact colors
+/// matter. The layer is rendered by Draw(), on the thread owning the OpenGL
+/// context.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::RetainedLayer dashboard(640, 480);
+/// dashboard.SetBackground(smk::Color::Black);
+/// dashboard.Add(title);
+/// dashboard.Add(chart_frame);
+/// auto fps = dashboard.Add(fps_text);
+///
+/// window.ExecuteMainLoop([&] {
+///   fps_text.SetString(std::to_string(fps));  // Only its area is redrawn.
+///   window.Draw(dashboard);
+/// });
+/// ~~~
+class RetainedLayer : public Drawable {
+ public:
+  // Identify an object in the layer.
+  using Id = Handle<RetainedLayer>;
+
+  RetainedLayer() = default;  // Empty layer.
+  RetainedLayer(int width, int height);
+
+  Id Add(const TransformableBase& object);
+  Id Add(const Text& text);
+  // The changes of |drawable| aren't detected. |bounds| is the area it covers.
+  Id Add(const Drawable& drawable, const Rectangle& bounds);
+  void Remove(Id id);
+  void Clear();
+
+  // Render again an object, or an area, during the next Draw().
+  void Invalidate(Id id);
+  void Invalidate(const Rectangle& area);
+  void InvalidateAll();
+
+  // Move an object whose changes aren't detected. Both areas are rendered
+  // again.
+  void SetBounds(Id id, const Rectangle& bounds);
+
+  void SetBackground(const glm::vec4& color);
+  const glm::vec4& background() const { return background_; }
+
+  // Where the layer is drawn, in the coordinates of the View.
+  void SetPosition(const glm::vec2& position);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+  // The number of objects, and the number rendered by the last Draw().
+  size_t size() const { return size_; }
+  size_t redrawn() const { return redrawn_; }
+
+  // Drawable override:
+  void Draw(RenderTarget& target, RenderState state) const override;
+
+  // --- Move only resource ----------------------------------------------------
+  RetainedLayer(RetainedLayer&&) noexcept = default;
+  RetainedLayer(const RetainedLayer&) = delete;
+  RetainedLayer& operator=(RetainedLayer&&) noexcept = default;
+  RetainedLayer& operator=(const RetainedLayer&) = delete;
+  // ---------------------------------------------------------------------------
+
+ private:
+  struct Object {
+    const Drawable* drawable = nullptr;
+    // Tracked objects. Null when the changes must be signaled.
+    const TransformableBase* transformable = nullptr;
+    const Text* text = nullptr;
+    // Where it was rendered, and the generations rendered.
+    mutable Rectangle bounds = {0.f, 0.f, 0.f, 0.f};
+    mutable size_t generation = 0;
+    mutable size_t font_generation = 0;
+    uint32_t handle_generation = 1;
+  };
+
+  Id Insert(const Object& object);
+  Object* Find(Id id);
+  static Rectangle TrackedBounds(const Object& object);
+  void Track() const;
+  void Redraw() const;
+  void AddDirty(glm::ivec4 area) const;
+
+  int width_ = 0;
+  int height_ = 0;
+  glm::vec4 background_ = {0.f, 0.f, 0.f, 0.f};
+  std::vector<Object> objects_;
+  std::vector<uint32_t> free_;
+  std::vector<uint32_t> order_;  // The objects, in the order they were added.
+  size_t size_ = 0;
+
+  // Null for an empty layer. It is composited by |sprite_|.
+  std::unique_ptr<Framebuffer> framebuffer_;
+  Sprite sprite_;
+  Transformable clear_quad_;
+
+  // The areas to render again, in pixels: (left, top, right, bottom).
+  mutable std::vector<glm::ivec4> dirty_;
+  mutable size_t redrawn_ = 0;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_RETAINED_LAYER_HPP */
@@ -0,0 +1,115 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_SCENE_2D_HPP
+#define SMK_SCENE_2D_HPP
+
+#include <cstdint>
+#include <smk/Drawable.hpp>
+#include <smk/Handle.hpp>
+#include <smk/Rectangle.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace smk {
+
+class Sprite;
+class TransformableBase;
+
+/// A set of 2D Drawables indexed by their bounds in a uniform grid. Drawing it
+/// only draws the objects intersecting the View of the RenderTarget, seen
+/// through the transformation of the RenderState. The cost depends on the
+/// visible area, not on the size of the scene.
+///
+/// The Drawables are owned by the caller. They must outlive the scene, or be
+/// removed before being destroyed. When an object moves, its new bounds must be
+/// given with Update(). Only the cells it leaves or enters are modified.
+///
+/// The visible objects are drawn in the order they were added.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::Scene2D scene;
+/// std::vector<smk::Sprite> tiles = [...];
+/// for(auto& tile : tiles)
+///   scene.Add(tile, smk::Scene2D::Bounds(tile));
+///
+/// [...]
+///
+/// window.SetView(camera);
+/// window.Draw(scene);
+/// ~~~
+class Scene2D : public Drawable {
+ public:
+  // Identify an object in the scene.
+  using Id = Handle<Scene2D>;
+
+  // |cell_size| is the size of the grid cells. It should be of the order of
+  // the size of the objects.
+  explicit Scene2D(float cell_size = 256.f);
+
+  Id Add(const Drawable& drawable, const Rectangle& bounds);
+  void Update(Id id, const Rectangle& bounds);
+  void Remove(Id id);
+  void Clear();
+
+  // The bounds of objects, in the coordinates of the View.
+  static Rectangle Bounds(const Sprite& sprite);
+  static Rectangle Bounds(const TransformableBase& object,
+                          const Rectangle& local);
+
+  // The number of objects.
+  size_t size() const { return size_; }
+
+  // The number of objects drawn by the last Draw().
+  size_t drawn() const { return drawn_; }
+
+  // Return the objects intersecting |area|, in the order they were added.
+  void Query(const Rectangle& area, std::vector<const Drawable*>* out) const;
+
+  // Drawable override:
+  void Draw(RenderTarget& target, RenderState state) const override;
+
+  // --- Movable-Copyable ------------------------------------------------------
+  Scene2D(Scene2D&&) noexcept = default;
+  Scene2D(const Scene2D&) = default;
+  Scene2D& operator=(Scene2D&&) noexcept = default;
+  Scene2D& operator=(const Scene2D&) = default;
+  // ---------------------------------------------------------------------------
+
+ private:
+  struct Object {
+    const Drawable* drawable = nullptr;
+    Rectangle bounds = {0.f, 0.f, 0.f, 0.f};
+    uint64_t order = 0;
+    uint32_t generation = 1;
+    mutable uint32_t query = 0;  // The last query having found it.
+  };
+
+  struct Span {
+    int left, top, right, bottom;  // Inclusive cell coordinates.
+  };
+
+  Object* Find(Id id);
+  Span CellSpan(const Rectangle& bounds) const;
+  void Insert(uint32_t index, const Span& span);
+  void Erase(uint32_t index, const Span& span);
+  static uint64_t CellKey(int x, int y);
+
+  float cell_size_;
+  std::vector<Object> objects_;
+  std::vector<uint32_t> free_;
+  std::unordered_map<uint64_t, std::vector<uint32_t>> cells_;
+  uint64_t next_order_ = 0;
+  size_t size_ = 0;
+
+  mutable uint32_t query_ = 0;
+  mutable std::vector<uint32_t> visible_;
+  mutable size_t drawn_ = 0;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_SCENE_2D_HPP */
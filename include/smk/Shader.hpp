@@ -5,6 +5,7 @@
 #ifndef SMK_SHADER_HPP
 #define SMK_SHADER_HPP
 
+#include <atomic>
 #include <glm/glm.hpp>
 #include <initializer_list>
 #include <map>
@@ -61,6 +62,10 @@ class ShaderProgram;
 ///
 /// window.SetShaderProgram(shader_program);
 /// ~~~
+///
+/// When ShaderProgram::SetBinaryCacheDirectory() is used, the compilation of
+/// the Shader is delayed. It is skipped when the program using it is found in
+/// the cache.
 //
 /// @see ShaderProgram
 class Shader {
@@ -68,6 +73,7 @@ class Shader {
   Shader();  // Invalid shader.
   static Shader FromFile(const std::string& filename, GLenum type);
   static Shader FromString(const std::string& content, GLenum type);
+  static Shader FromMemory(const char* data, size_t size, GLenum type);
 
   ~Shader();
 
@@ -97,9 +103,9 @@ class Shader {
   // opengl program identifier.
   GLuint id_ = 0;
 
-  // Used to support copy. Nullptr as long as this class is not copied.
-  // Otherwise an integer counting how many instances shares this resource.
-  mutable int* ref_count_ = nullptr;
+  // Used to support copy. Counts how many instances shares this resource. It
+  // is atomic, so that copies can be made and released by several threads.
+  std::atomic<int>* ref_count_ = nullptr;
 };
 
 /// @brief A shader program is a set of shader (for instance vertex shader +
@@ -117,6 +123,12 @@ class ShaderProgram {
   void AddShader(const Shader& shader);
   void Link();
 
+  // Store the linked programs in |directory| and load them back on the next
+  // launches, skipping the compilation of their shaders. Must be called before
+  // creating the Window. The directory must exist. Empty disables the cache.
+  // This is not supported by WebGL.
+  static void SetBinaryCacheDirectory(const std::string& directory);
+
   // Linking shader is an asynchronous process. Using the shader can causes the
   // CPU to wait until its completion. If you need to do some work before the
   // completion, you can use this function and use the Shader only after it
@@ -146,6 +158,24 @@ class ShaderProgram {
   GLint Uniform(const std::string& name);
   GLint operator[](const std::string& name);
 
+  // Location of the uniforms set by the RenderTarget on every draw. They are
+  // resolved once, on first use.
+  GLint projection_uniform() const;
+  GLint view_uniform() const;
+  GLint color_uniform() const;
+  GLint texture_rectangle_uniform() const;
+
+  // Whether the program declares the "smk_frame" uniform block. If so, the
+  // block is bound to the shared FrameBlock buffer.
+  bool UsesFrameBlock() const;
+
+  // Assign the built-in uniforms. The upload is skipped when the program
+  // already holds the value.
+  void SetProjectionUniform(const glm::mat4& projection) const;
+  void SetViewUniform(const glm::mat4& view) const;
+  void SetColorUniform(const glm::vec4& color) const;
+  void SetTextureRectangleUniform(const glm::vec4& texture_rectangle) const;
+
   // affect uniform
   void SetUniform(const std::string& name, float x, float y, float z);
   void SetUniform(const std::string& name, const glm::vec3& v);
@@ -155,6 +185,20 @@ class ShaderProgram {
   void SetUniform(const std::string& name, float val);
   void SetUniform(const std::string& name, int val);
 
+  // affect uniform, using a location obtained from Uniform(). This avoids
+  // looking up the name on every call.
+  void SetUniform(GLint uniform, float x, float y, float z);
+  void SetUniform(GLint uniform, const glm::vec3& v);
+  void SetUniform(GLint uniform, const glm::vec4& v);
+  void SetUniform(GLint uniform, const glm::mat4& m);
+  void SetUniform(GLint uniform, const glm::mat3& m);
+  void SetUniform(GLint uniform, float val);
+  void SetUniform(GLint uniform, int val);
+
+  // While a render thread runs, SetUniform() only records the values. Upload
+  // them before drawing with direct OpenGL calls. The program must be in use.
+  void UploadRecordedUniforms() const;
+
   ~ShaderProgram();
 
   // --- Movable-Copyable (via ref-count) --------------------------------------
@@ -168,6 +212,23 @@ class ShaderProgram {
   bool operator!=(const ShaderProgram& rhs) const;
 
  private:
+  friend class RenderTarget;
+  friend class ShaderWatcher;
+  void StoreBinary() const;
+  void SwapProgram(ShaderProgram& other);
+  void AssignTextureUnits();
+
+  // While a render thread runs, SetUniform() records the values instead of
+  // uploading them. Every recorded draw holds the values set before it, and
+  // the render thread uploads them. See Window::Option::render_thread.
+  struct UniformValues;
+  bool RecordUniform(GLint uniform,
+                     GLenum type,
+                     const glm::mat4& value,
+                     int integer = 0);
+  std::shared_ptr<const UniformValues> recorded_uniforms() const;
+  void UploadUniforms(const UniformValues& values) const;
+
   struct Impl;
   std::shared_ptr<Impl> impl_;
 };
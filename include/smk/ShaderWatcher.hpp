@@ -0,0 +1,73 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_SHADER_WATCHER_HPP
+#define SMK_SHADER_WATCHER_HPP
+
+#include <cstdint>
+#include <smk/Shader.hpp>
+#include <string>
+#include <vector>
+
+namespace smk {
+
+/// A ShaderProgram built from files, rebuilt whenever they are modified.
+///
+/// The new version is compiled and linked in the background, using
+/// KHR_parallel_shader_compile when available. Until it is ready, the previous
+/// version keeps being used. It then replaces the previous one in every copies
+/// of program(), for instance the one given to RenderTarget::SetShaderProgram.
+/// A version failing to compile is reported and ignored.
+///
+/// The uniforms set with ShaderProgram::SetUniform must be set again after a
+/// reload. The samplers "texture_0" to "texture_N" are assigned their texture
+/// unit again.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// auto shader = smk::ShaderWatcher("./shader.vert", "./shader.frag");
+/// window.SetShaderProgram(shader.program());
+///
+/// window.ExecuteMainLoop([&] {
+///   shader.Update();
+///   [...]
+/// });
+/// ~~~
+class ShaderWatcher {
+ public:
+  ShaderWatcher();  // Empty program.
+  ShaderWatcher(const std::string& vertex_shader_file,
+                const std::string& fragment_shader_file);
+
+  // The last version linked successfully.
+  ShaderProgram& program() { return program_; }
+
+  // Start rebuilding the program when a file was modified, and swap it once
+  // linked. This never waits for the driver. Return true when the program was
+  // replaced.
+  bool Update();
+
+ private:
+  struct File {
+    std::string filename;
+    GLenum type;
+    int64_t time;  // The last modification time.
+  };
+
+  bool Modified();
+  void Build(ShaderProgram& program);
+
+  std::vector<File> files_;
+  ShaderProgram program_;
+
+  // The version being linked.
+  ShaderProgram pending_program_;
+  std::vector<Shader> pending_shaders_;
+  bool pending_ = false;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_SHADER_WATCHER_HPP */
@@ -17,6 +17,11 @@
 namespace smk {
 
 /// A collection of static function to build simple shape.
+///
+/// The shapes built with the same parameters share their VertexArray. Only
+/// Line() and Path() build a new one on every call. The 64 most recently used
+/// shapes are kept. A path growing over time is better built with
+/// smk::PathBuilder.
 class Shape {
  public:
   static Transformable FromVertexArray(VertexArray vertex_array);
@@ -26,6 +31,7 @@ class Shape {
   static Transformable Square();
   static Transformable Circle(float radius);
   static Transformable Circle(float radius, int subdivisions);
+  static Transformable CircleLod(float radius);
   static Transformable Path(const std::vector<glm::vec2>& points,
                             float thickness);
   static Transformable RoundedRectangle(float width,
@@ -33,9 +39,22 @@ class Shape {
                                         float radius);
   static Transformable3D Cube();
   static Transformable3D IcoSphere(int interation);
+  static Transformable3D IcoSphereLod(int max_iteration = 5);
   static Transformable3D Plane();
   static std::vector<glm::vec2> Bezier(const std::vector<glm::vec2>& point,
                                        size_t subdivision);
+
+  // Release the VertexArrays shared by the shapes built so far.
+  static void ReleaseCache();
+
+ private:
+  static VertexArray CircleVertexArray(float radius, int subdivisions);
+  static VertexArray CubeVertexArray();
+  static VertexArray IcoSphereVertexArray(int iteration);
+  static VertexArray PlaneVertexArray();
+  static VertexArray RoundedRectangleVertexArray(float width,
+                                                 float height,
+                                                 float radius);
 };
 
 }  // namespace smk
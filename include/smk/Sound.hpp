@@ -5,10 +5,14 @@
 #ifndef SMK_SOUND_HPP
 #define SMK_SOUND_HPP
 
+#include <glm/glm.hpp>
+#include <smk/Handle.hpp>
 #include <smk/SoundBuffer.hpp>
 
 namespace smk {
 
+class SourcePool;
+
 /// @example sound.cpp
 
 /// @brief Represent a sound being played.
@@ -27,6 +31,15 @@ namespace smk {
 /// sound.Play()
 /// ~~~
 ///
+/// The OpenAL sources are lent by a pool owned by smk::Audio, for the time the
+/// sound plays. When every sources are busy, Play() steals the oldest one of
+/// the lowest priority. For a fire-and-forget effect, use Audio::PlayOneShot().
+///
+/// The sound can be positioned in 3D, relatively to the listener set with
+/// smk::Audio. The position and the velocity are sent to OpenAL by
+/// Audio::Update(), in a single batch per frame. Only the mono SoundBuffers are
+/// spatialized.
+///
 /// Please make sure to init OpenAL in main() by creating a smk::Audio.
 class Sound {
  public:
@@ -42,6 +55,15 @@ class Sound {
   // The gain applied to the source. Default is 1.
   void SetVolume(float volume);
 
+  // The sounds of higher priority steal the sources of the lower ones, never
+  // the opposite. Default is 0.
+  void SetPriority(int priority);
+
+  // The position and the velocity of the source. They are applied by the next
+  // Audio::Update().
+  void SetPosition(const glm::vec3& position);
+  void SetVelocity(const glm::vec3& velocity);
+
   // -- Move-only resource ---
   Sound(Sound&&) noexcept;
   Sound(const Sound&) = delete;
@@ -50,10 +72,12 @@ class Sound {
 
  private:
   const SoundBuffer* buffer_ = nullptr;
-  unsigned int source_ = 0;
-  bool is_playing_ = false;
-
-  void EnsureSourceIsCreated();
+  Handle<SourcePool> voice_;
+  bool looping_ = false;
+  float volume_ = 1.f;
+  int priority_ = 0;
+  glm::vec3 position_ = {0.f, 0.f, 0.f};
+  glm::vec3 velocity_ = {0.f, 0.f, 0.f};
 };
 
 }  // namespace smk
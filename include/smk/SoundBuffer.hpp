@@ -5,6 +5,8 @@
 #ifndef SMK_SOUND_BUFFER_HPP
 #define SMK_SOUND_BUFFER_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace smk {
@@ -34,9 +36,31 @@ class SoundBuffer {
  public:
   SoundBuffer();  // Empty sound buffer
   SoundBuffer(const std::string& filename);
+  SoundBuffer(const int16_t* samples,
+              size_t count,
+              int channels,
+              int sample_rate);
+  // The samples are uploaded as is when OpenAL supports AL_EXT_float32, and
+  // converted to 16 bits otherwise.
+  SoundBuffer(const float* samples,
+              size_t count,
+              int channels,
+              int sample_rate);
 
   ~SoundBuffer();
 
+  // Decode a file held in memory, for instance an entry of an
+  // smk::AssetArchive. |extension| gives its format: "wav", "ogg", ...
+  static SoundBuffer FromMemory(const uint8_t* data,
+                                size_t size,
+                                const std::string& extension);
+
+  // Store the decoded samples of the files loaded later in |directory|, and
+  // map them back on the next launches, skipping their decoding. The entries
+  // depend on the path, size and modification time of the files. The directory
+  // must exist. Empty disables the cache.
+  static void SetCacheDirectory(const std::string& directory);
+
   // --- Move only resource ----------------------------------------------------
   SoundBuffer(SoundBuffer&&) noexcept;
   SoundBuffer(const SoundBuffer&) = delete;
@@ -9,6 +9,7 @@
 #include <smk/RenderState.hpp>
 #include <smk/Texture.hpp>
 #include <smk/Transformable.hpp>
+#include <smk/VertexArray.hpp>
 
 namespace smk {
 
@@ -20,6 +21,11 @@ class Framebuffer;
 
 /// A Drawable specialised in displaying rectangular texture.
 ///
+/// Every sprites share the same unit square VertexArray. Their size and
+/// texture area are applied when drawing, so sprites don't own GPU buffers. A
+/// custom ShaderProgram without the "texture_rectangle" uniform is still
+/// supported: the sprite then builds and draws its own quad.
+///
 /// Example:
 /// -------
 /// ~~~cpp
@@ -47,6 +53,23 @@ class Sprite : public Transformable {
   // Modify the sprite.
   void SetTexture(const Texture& texture);
   void SetTextureRectangle(const Rectangle& rectangle);
+
+  // The quad drawn by this sprite, in the sprite's local space.
+  const glm::vec2& size() const { return size_; }
+  const Rectangle& texture_coordinates() const { return texture_coordinates_; }
+
+  // Drawable override:
+  void Draw(RenderTarget& target, RenderState state) const override;
+
+ private:
+  void SetQuad(const glm::vec2& size, const Rectangle& texture_coordinates);
+
+  glm::vec2 size_ = {0.f, 0.f};
+  Rectangle texture_coordinates_ = {0.f, 0.f, 0.f, 0.f};
+
+  // The quad with the texture coordinates of this sprite. Built only for the
+  // ShaderPrograms without the "texture_rectangle" uniform.
+  mutable VertexArray quad_;
 };
 
 }  // namespace smk
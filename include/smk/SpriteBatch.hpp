@@ -0,0 +1,121 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_SPRITE_BATCH_HPP
+#define SMK_SPRITE_BATCH_HPP
+
+#include <glm/glm.hpp>
+#include <smk/BlendMode.hpp>
+#include <smk/Drawable.hpp>
+#include <smk/Texture.hpp>
+#include <smk/Vertex.hpp>
+#include <smk/VertexArray.hpp>
+#include <vector>
+
+namespace smk {
+
+class Sprite;
+
+/// @example sprite_batch.cpp
+
+/// A Drawable collecting many Sprites, and drawing them using as few draw
+/// calls as possible.
+///
+/// The sprites are transformed on the CPU when they are added. Consecutive
+/// sprites sharing the same Texture and BlendMode are merged into a single
+/// vertex array drawn at once. The ShaderProgram is the one used to draw the
+/// SpriteBatch itself.
+///
+/// With the default ShaderProgram, the colors of the sprites are stored in
+/// their vertices: the sprites of different colors are merged too, and drawn
+/// with RenderTarget::shader_program_2d_colored(). A custom ShaderProgram only
+/// reads the "color" uniform: a draw call is issued per color change. The
+/// colors outside of [0,1] always use the uniform.
+///
+/// The order of the sprites is preserved: a sprite is always drawn over the
+/// ones added before it.
+///
+/// The sprites whose Texture is a texture array (see Texture::Array) pick one
+/// of its layers. The consecutive sprites using the same array are merged,
+/// whatever their layer. This draws sprites from many images of the same size
+/// at once. They are drawn with RenderTarget::shader_program_2d_array(),
+/// unless an other ShaderProgram than the default one is used.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::SpriteBatch batch;
+///
+/// [...]
+///
+/// batch.Clear();
+/// for(auto& sprite : sprites)
+///   batch.Add(sprite);
+/// window.Draw(batch);
+/// ~~~
+class SpriteBatch : public Drawable {
+ public:
+  SpriteBatch() = default;
+
+  // Remove every sprites.
+  void Clear();
+
+  // Append a sprite. It is drawn over the previous ones. |layer| is the layer
+  // of its texture, when it is a texture array.
+  void Add(const Sprite& sprite);
+  void Add(const Sprite& sprite, int layer);
+
+  // The number of sprites added since the last Clear().
+  size_t size() const { return size_; }
+
+  // The number of draw calls needed to render this batch, with the default
+  // ShaderProgram.
+  size_t draw_calls() const { return merged_batches_; }
+
+  // Drawable override:
+  void Draw(RenderTarget& target, RenderState state) const override;
+
+  // Movable-copyable class. Copies don't share their GPU buffers.
+  SpriteBatch(SpriteBatch&&) noexcept = default;
+  SpriteBatch(const SpriteBatch&);
+  SpriteBatch& operator=(SpriteBatch&&) noexcept = default;
+  SpriteBatch& operator=(const SpriteBatch&);
+
+ private:
+  // A set of sprites sharing the same states.
+  struct Batch {
+    Texture texture;
+    BlendMode blend_mode;
+    glm::vec4 color;
+    std::vector<Vertex2D> vertices;
+    std::vector<Vertex2DLayered> layered_vertices;  // For the texture arrays.
+  };
+
+  // Consecutive batches drawn at once, using colored vertices.
+  struct Group {
+    size_t first;
+    size_t count;
+  };
+
+  static bool Mergeable(const Batch& a, const Batch& b);
+  void Upload(bool vertex_colors) const;
+
+  std::vector<Batch> batches_;
+  size_t size_ = 0;
+  size_t merged_batches_ = 0;
+
+  // The GPU copy of every groups. They are kept across Clear() and updated
+  // in place, instead of being allocated again every frame.
+  mutable std::vector<Group> groups_;
+  mutable std::vector<VertexArray> vertex_arrays_;
+
+  // Whether the GPU vertex arrays must be updated before drawing, and whether
+  // they were built with colored vertices.
+  mutable bool dirty_ = false;
+  mutable bool vertex_colors_ = false;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_SPRITE_BATCH_HPP */
@@ -0,0 +1,91 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_STREAMING_TEXTURE_HPP
+#define SMK_STREAMING_TEXTURE_HPP
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <smk/Texture.hpp>
+#include <string>
+#include <vector>
+
+namespace smk {
+
+/// A large texture whose mipmap levels are uploaded progressively.
+///
+/// The image and its mipmap chain are kept in memory. Only the small levels
+/// are uploaded when it is created. The higher resolution levels are uploaded
+/// later by StreamingTexture::Update(), within an upload budget, up to the
+/// level needed for the size the texture is drawn at. The levels that are no
+/// longer needed are released, so the memory used by the GPU stays bounded.
+///
+/// This is a move-only ressource.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// auto map = smk::StreamingTexture("./map.png");
+/// auto sprite = smk::Sprite(map.texture());
+///
+/// window.ExecuteMainLoop([&] {
+///   map.SetDisplaySize({640, 480});
+///   smk::StreamingTexture::Update();
+///   [...]
+/// });
+/// ~~~
+class StreamingTexture {
+ public:
+  StreamingTexture();  // Empty texture.
+  StreamingTexture(const std::string& filename);
+  StreamingTexture(const std::string& filename, const Texture::Option& option);
+  ~StreamingTexture();
+
+  // The GPU texture. Its dimensions are the ones of the full resolution image,
+  // even when it isn't uploaded yet.
+  const Texture& texture() const { return texture_; }
+
+  // The size in pixels this texture is drawn at on screen. This selects the
+  // resolution to be uploaded. Default to the full resolution.
+  void SetDisplaySize(const glm::vec2& size);
+
+  // Levels are indexed from the full resolution (0) to the 1x1 one.
+  int level_count() const { return int(levels_.size()); }
+  int resident_level() const { return resident_level_; }
+  int needed_level() const { return needed_level_; }
+
+  // Upload and release the levels of every StreamingTextures, the most
+  // blurry ones first. Stop once |budget| bytes have been uploaded. Must be
+  // called from the OpenGL thread.
+  static void Update(size_t budget = 1 << 20);
+
+  // --- Move only resource ----------------------------------------------------
+  StreamingTexture(StreamingTexture&&) noexcept;
+  StreamingTexture(const StreamingTexture&) = delete;
+  StreamingTexture& operator=(StreamingTexture&&) noexcept;
+  StreamingTexture& operator=(const StreamingTexture&) = delete;
+  // ---------------------------------------------------------------------------
+
+ private:
+  struct Level {
+    int width;
+    int height;
+    std::vector<uint8_t> rgba;
+  };
+
+  void UploadLevel(int level);
+  void ReleaseLevel(int level);
+  void TrackResidentLevels() const;
+  float Priority() const;
+
+  Texture texture_;
+  std::vector<Level> levels_;
+  int resident_level_ = 0;
+  int needed_level_ = 0;
+  glm::vec2 display_size_ = {0.f, 0.f};
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_STREAMING_TEXTURE_HPP */
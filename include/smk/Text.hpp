@@ -5,12 +5,14 @@
 #ifndef SMK_TEXT_HPP
 #define SMK_TEXT_HPP
 
+#include <smk/Font.hpp>
 #include <smk/Texture.hpp>
 #include <smk/Transformable.hpp>
+#include <smk/VertexArray.hpp>
 #include <string>
+#include <vector>
 
 namespace smk {
-class Font;
 
 /// @example text.cpp
 
@@ -34,6 +36,11 @@ class Font;
 ///
 /// window.Draw(text);
 /// ~~~
+///
+/// The glyphs are drawn from the Font's atlas. The layout and the vertex array
+/// are computed once and reused until the string, the font or its line height
+/// change. Draw then costs a single draw call per atlas page used by the
+/// string.
 class Text : public Transformable {
  public:
   Text();
@@ -58,6 +65,39 @@ class Text : public Transformable {
  public:
   Font* font_ = nullptr;
   std::wstring string_;
+
+ private:
+  void UpdateLayout() const;
+  void UpdateGeometry() const;
+
+  // The position of a glyph relative to the Text origin.
+  struct Placement {
+    const Font::Glyph* glyph;
+    glm::vec2 position;
+  };
+
+  // A line of text, as a range of |placements_|.
+  struct Line {
+    size_t begin;
+    size_t end;
+    float width;
+  };
+
+  // Layout:
+  mutable std::vector<Placement> placements_;
+  mutable std::vector<Line> lines_;
+  mutable glm::vec2 dimensions_ = {0.f, 0.f};
+  mutable float layout_line_height_ = 0.f;
+  mutable size_t layout_font_generation_ = 0;
+  mutable bool layout_dirty_ = true;
+
+  // The geometry using a given atlas texture.
+  struct Batch {
+    Texture texture;
+    VertexArray vertex_array;
+  };
+  mutable std::vector<Batch> batches_;
+  mutable bool geometry_dirty_ = true;
 };
 
 }  // namespace smk
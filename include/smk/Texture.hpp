@@ -5,8 +5,11 @@
 #ifndef SMK_TEXTURE_HPP
 #define SMK_TEXTURE_HPP
 
+#include <atomic>
 #include <smk/OpenGL.hpp>
+#include <smk/Rectangle.hpp>
 #include <string>
+#include <vector>
 
 namespace smk {
 
@@ -35,6 +38,21 @@ namespace smk {
 /// - HDR (radiance rgbE format)
 /// - PIC (Softimage PIC)
 /// - PNM (PPM and PGM binary only)
+///
+/// QOI images are decoded too. Other decoders, faster or for other formats,
+/// can be plugged with smk::ImageDecoder::Register().
+///
+/// It also loads KTX and KTX2 containers, with their mipmap chain. They can
+/// hold textures compressed for the GPU (BC, ETC2, ASTC), uploaded without
+/// being decompressed. The GPU must support the format. Basis Universal and
+/// zstd supercompressed KTX2 aren't supported.
+///
+/// Texture arrays:
+/// ---------------
+///
+/// Texture::Array() stacks images of the same dimensions in the layers of a
+/// GL_TEXTURE_2D_ARRAY. Sprites using different layers of the same array are
+/// drawn by smk::SpriteBatch in a single draw call.
 struct Texture {
  public:
   struct Option {
@@ -46,6 +64,11 @@ struct Texture {
     GLenum format = GL_RGBA;
     GLenum type = GL_UNSIGNED_BYTE;
     bool generate_mipmap = true;
+
+    // When false, the grey and RGB images loaded from a file are kept in the
+    // GL_RED and GL_RGB formats, instead of being expanded to RGBA. This saves
+    // GPU memory and loading time.
+    bool convert_to_rgba = true;
   };
 
   Texture();  // empty texture.
@@ -53,15 +76,48 @@ struct Texture {
   Texture(const std::string& filename, const Option& option);
   Texture(const uint8_t* data, int width, int height);
   Texture(const uint8_t* data, int width, int height, const Option& option);
+  // Import a texture owned by the caller. It is never deleted by smk.
   Texture(GLuint id, int width, int height);
   ~Texture();
 
+  // Take the ownership of the texture |id|. It is deleted with the last copy.
+  static Texture Adopt(GLuint id, int width, int height);
+
+  // Decode an image file held in memory, for instance an entry of an
+  // smk::AssetArchive. KTX containers are uploaded straight out of |data|.
+  static Texture FromMemory(const uint8_t* data, size_t size);
+  static Texture FromMemory(const uint8_t* data,
+                            size_t size,
+                            const Option& option);
+
+  // A GL_TEXTURE_2D_ARRAY whose layers are the images of |filenames|. They
+  // must have the same dimensions. They are converted to RGBA.
+  static Texture Array(const std::vector<std::string>& filenames);
+  static Texture Array(const std::vector<std::string>& filenames,
+                       const Option& option);
+  // A GL_TEXTURE_2D_ARRAY from |layers| consecutive images in memory.
+  static Texture Array(const uint8_t* data,
+                       int width,
+                       int height,
+                       int layers,
+                       const Option& option);
+
   void Bind(GLuint active_texture = GL_TEXTURE0) const;
 
+  // Replace a part of the texture with RGBA(8,8,8,8) pixels. The transfer goes
+  // through a ring of pixel buffers, so it overlaps with the rendering. The
+  // mipmaps aren't regenerated. The texture arrays can't be updated.
+  void Update(const uint8_t* rgba);
+  void Update(const Rectangle& rectangle, const uint8_t* rgba);
+
   int width() const;
   int height() const;
   GLuint id() const;
 
+  // GL_TEXTURE_2D, or GL_TEXTURE_2D_ARRAY for the texture arrays.
+  GLenum target() const { return target_; }
+  int layers() const { return layers_; }
+
   operator bool() const { return id_ != 0; }
 
   // --- Copyable Movable resource ---------------------------------------------
@@ -70,18 +126,22 @@ struct Texture {
   void operator=(Texture&&) noexcept;
   Texture& operator=(const Texture&);
   //----------------------------------------------------------------------------
-  bool operator==(const Texture& other);
-  bool operator!=(const Texture& other);
+  bool operator==(const Texture& other) const;
+  bool operator!=(const Texture& other) const;
 
  private:
   void Load(const uint8_t* data, int width, int height, const Option& option);
+  void Release();
   GLuint id_ = 0;
   int width_ = 0;
   int height_ = 0;
+  GLenum target_ = GL_TEXTURE_2D;
+  int layers_ = 1;
+  bool owned_ = true;  // Whether |id_| is deleted with the last copy.
 
-  // Used to support copy. Nullptr as long as this class is not copied.
-  // Otherwise an integer counting how many instances shares this resource.
-  mutable int* ref_count_ = nullptr;
+  // Used to support copy. Counts how many instances shares this resource. It
+  // is atomic, so that copies can be made and released by several threads.
+  std::atomic<int>* ref_count_ = nullptr;
 };
 
 }  // namespace smk
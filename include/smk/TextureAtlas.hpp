@@ -0,0 +1,70 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_TEXTURE_ATLAS_HPP
+#define SMK_TEXTURE_ATLAS_HPP
+
+#include <memory>
+#include <smk/Rectangle.hpp>
+#include <smk/Texture.hpp>
+#include <string>
+#include <vector>
+
+namespace smk {
+
+/// Pack many small images into a few large textures, called pages. Drawing
+/// sprites sharing a page doesn't require binding another texture, and lets
+/// smk::SpriteBatch merge them.
+///
+/// This is a move-only ressource.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::TextureAtlas atlas;
+/// auto ball = atlas.Add("./ball.png");
+/// auto hero = atlas.Add("./hero.png");
+///
+/// auto ball_sprite = smk::Sprite(ball.texture, ball.rectangle);
+/// auto hero_sprite = smk::Sprite(hero.texture, hero.rectangle);
+/// ~~~
+class TextureAtlas {
+ public:
+  TextureAtlas();  // 1024x1024 pages.
+  TextureAtlas(int page_width, int page_height);
+  TextureAtlas(int page_width, int page_height, const Texture::Option& option);
+  ~TextureAtlas();
+
+  /// An image stored in one of the pages.
+  struct Region {
+    Texture texture;      ///< The page containing the image.
+    Rectangle rectangle;  ///< The image area in the page, in pixels.
+  };
+
+  // Add an image. Return a null texture on failure.
+  Region Add(const std::string& filename);
+  // |pixels| is in the format of the pages: RGBA(8,8,8,8) by default.
+  Region Add(const uint8_t* pixels, int width, int height);
+
+  // The number of pages allocated so far.
+  size_t page_count() const { return pages_.size(); }
+
+  // --- Move only resource ----------------------------------------------------
+  TextureAtlas(TextureAtlas&&) noexcept;
+  TextureAtlas(const TextureAtlas&) = delete;
+  TextureAtlas& operator=(TextureAtlas&&) noexcept;
+  TextureAtlas& operator=(const TextureAtlas&) = delete;
+  // ---------------------------------------------------------------------------
+
+ private:
+  struct Page;
+  std::vector<std::unique_ptr<Page>> pages_;
+  int page_width_ = 1024;
+  int page_height_ = 1024;
+  Texture::Option option_;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_TEXTURE_ATLAS_HPP */
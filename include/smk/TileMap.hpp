@@ -0,0 +1,96 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_TILE_MAP_HPP
+#define SMK_TILE_MAP_HPP
+
+#include <smk/Texture.hpp>
+#include <smk/Transformable.hpp>
+#include <smk/VertexArray.hpp>
+#include <vector>
+
+namespace smk {
+
+/// A grid of tiles read from a tileset texture, drawn as a single layer.
+///
+/// The tiles are baked into one VertexArray per chunk of kChunkSize x
+/// kChunkSize tiles. Modifying a tile only rebuilds its chunk, on the next
+/// draw. Only the chunks intersecting the View of the RenderTarget are drawn.
+///
+/// The tileset is divided in tiles of |tile_width| x |tile_height| pixels,
+/// numbered from left to right then from top to bottom, starting at 0. The
+/// tile -1 is empty.
+///
+/// This is a move-only resource.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// smk::TileMap map(tileset, 16, 16, 1000, 500);
+/// for(int y = 0; y<map.height(); ++y) {
+///   for(int x = 0; x<map.width(); ++x)
+///     map.SetTile(x, y, level[y][x]);
+/// }
+///
+/// [...]
+///
+/// window.Draw(map);
+/// ~~~
+class TileMap : public Transformable {
+ public:
+  static const int kChunkSize = 32;
+
+  TileMap() = default;
+  TileMap(const Texture& tileset,
+          int tile_width,
+          int tile_height,
+          int width,
+          int height);
+
+  // The tiles.
+  void SetTile(int x, int y, int tile);
+  int tile(int x, int y) const;
+
+  // The dimensions, in tiles.
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+  // The number of chunks drawn by the last Draw().
+  size_t drawn_chunks() const { return drawn_chunks_; }
+
+  // Drawable override:
+  void Draw(RenderTarget& target, RenderState state) const override;
+
+  // --- Move only resource ----------------------------------------------------
+  TileMap(TileMap&&) = default;
+  TileMap(const TileMap&) = delete;
+  TileMap& operator=(TileMap&&) = default;
+  TileMap& operator=(const TileMap&) = delete;
+  // ---------------------------------------------------------------------------
+
+ private:
+  struct Chunk {
+    VertexArray vertex_array;
+    bool dirty = true;
+  };
+
+  void Rebuild(int chunk_x, int chunk_y) const;
+
+  int tile_width_ = 0;
+  int tile_height_ = 0;
+  int width_ = 0;
+  int height_ = 0;
+  int tileset_columns_ = 0;
+  int tileset_rows_ = 0;
+  std::vector<int> tiles_;
+
+  int chunk_columns_ = 0;
+  int chunk_rows_ = 0;
+  mutable std::vector<Chunk> chunks_;
+  mutable size_t drawn_chunks_ = 0;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_TILE_MAP_HPP */
@@ -5,6 +5,7 @@
 #ifndef SMK_TOUCH_HPP
 #define SMK_TOUCH_HPP
 
+#include <cstddef>
 #include <glm/glm.hpp>
 #include <vector>
 
@@ -14,14 +15,59 @@ namespace smk {
 
 struct TouchDataPoint {
   glm::vec2 position = {0, 0};
-  float time = 0.f;
+  float time = 0.f;  // In seconds, see glfwGetTime().
+};
+
+/// The last positions of a touch, oldest first. It is a ring buffer with a
+/// fixed capacity: once full, the oldest positions are dropped. The memory
+/// used doesn't grow with the duration of the touch.
+class TouchHistory {
+ public:
+  TouchHistory();  // Use Touch::history_capacity().
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t capacity() const { return points_.size(); }
+
+  // |index| 0 is the oldest point.
+  const TouchDataPoint& operator[](size_t index) const {
+    return points_[(first_ + index) % points_.size()];
+  }
+  const TouchDataPoint& front() const { return (*this)[0]; }
+  const TouchDataPoint& back() const { return (*this)[size_ - 1]; }
+  // The first point pushed since clear(), kept once dropped from the history.
+  const TouchDataPoint& start() const { return start_; }
+
+  void push_back(const TouchDataPoint& point);
+  void clear();
+
+ private:
+  std::vector<TouchDataPoint> points_;
+  size_t first_ = 0;
+  size_t size_ = 0;
+  TouchDataPoint start_;
 };
 
 struct Touch {
   int finger_id = 0;
-  std::vector<TouchDataPoint> data_points;
+  TouchHistory data_points;
 
   glm::vec2 position() const;
+
+  // The movement since the touch started.
+  glm::vec2 displacement() const;
+
+  // The average velocity, in pixels per second, over the last |duration|
+  // seconds.
+  glm::vec2 velocity(float duration = 0.1f) const;
+
+  // The position at |time|, interpolated from the history. Clamped to the
+  // oldest and latest positions.
+  glm::vec2 Sample(float time) const;
+
+  // The number of positions kept by the touches created later. Default to 64.
+  static void SetHistoryCapacity(size_t capacity);
+  static size_t history_capacity();
 };
 
 }  // namespace smk
@@ -7,6 +7,7 @@
 
 #include <smk/Drawable.hpp>
 #include <smk/RenderState.hpp>
+#include <vector>
 
 namespace smk {
 struct Texture;
@@ -39,6 +40,23 @@ class TransformableBase : public Drawable {
   void SetVertexArray(VertexArray vertex_array);
   const VertexArray& vertex_array() const { return vertex_array_; }
 
+  // Levels of detail. The VertexArray drawn is the last level whose
+  // |min_size| is below the size of the object on the screen, in pixels. See
+  // RenderTarget::ProjectedSize(). The levels are sorted by increasing
+  // |min_size|. vertex_array() is the last one.
+  struct LevelOfDetail {
+    VertexArray vertex_array;
+    float min_size;
+  };
+  void SetLevelsOfDetail(std::vector<LevelOfDetail> levels);
+  const std::vector<LevelOfDetail>& levels_of_detail() const {
+    return levels_of_detail_;
+  }
+
+  // Incremented by every modification. Used to detect when a cached rendering
+  // must be updated. @see RetainedLayer.
+  size_t generation() const { return generation_; }
+
   // Drawable override
   void Draw(RenderTarget& target, RenderState state) const override;
 
@@ -49,11 +67,16 @@ class TransformableBase : public Drawable {
   TransformableBase& operator=(TransformableBase&&) noexcept = default;
   TransformableBase& operator=(const TransformableBase&) = default;
 
+ protected:
+  void Touch() { ++generation_; }
+
  private:
+  size_t generation_ = 0;
   glm::vec4 color_ = {1.0, 1.0, 1.0, 1.0};
   Texture texture_;
   BlendMode blend_mode_ = BlendMode::Alpha;
   VertexArray vertex_array_;
+  std::vector<LevelOfDetail> levels_of_detail_;
 };
 
 /// A 2D Drawable object supporting several transformations:
@@ -86,7 +109,8 @@ class Transformable : public TransformableBase {
   void SetScaleX(float scale_x);
   void SetScaleY(float scale_y);
 
-  // Transformable override;
+  // Transformable override. The matrix is cached. It is recomputed only after
+  // a modification.
   glm::mat4 transformation() const override;
 
   // Movable-copyable class.
@@ -101,6 +125,9 @@ class Transformable : public TransformableBase {
   glm::vec2 center_ = {0.f, 0.f};
   glm::vec2 position_ = {0.f, 0.f};
   glm::vec2 scale_ = {1.0, 1.0};
+
+  mutable glm::mat4 transformation_ = glm::mat4(1.f);
+  mutable bool transformation_dirty_ = true;
 };
 
 /// A 2D Drawable object supporting several transformations:
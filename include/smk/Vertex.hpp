@@ -6,6 +6,7 @@
 #define SMK_VERTEX_HPP
 
 #include <glm/glm.hpp>
+#include <smk/VertexLayout.hpp>
 
 namespace smk {
 
@@ -17,6 +18,27 @@ struct Vertex2D {
   static void Bind();
 };
 
+/// The vertex structure of the 2D shader sampling a texture array. Every
+/// vertex selects the layer of the texture. @see Texture::Array.
+struct Vertex2DLayered {
+  glm::vec2 space_position = {0.f, 0.f};
+  glm::vec2 texture_position = {0.f, 0.f};
+  float layer = 0.f;
+
+  static void Bind();
+};
+
+/// The vertex structure of the 2D shader reading a color per vertex. It is
+/// multiplied by the "color" uniform. This lets differently colored shapes
+/// be drawn at once. @see RenderTarget::shader_program_2d_colored().
+struct Vertex2DColored {
+  glm::vec2 space_position = {0.f, 0.f};
+  glm::vec2 texture_position = {0.f, 0.f};
+  Color8 color;
+
+  static void Bind();
+};
+
 /// The vertex structure suitable for a 2D shader.
 struct Vertex3D {
   glm::vec3 space_position = {0.f, 0.f, 0.f};
@@ -26,6 +48,39 @@ struct Vertex3D {
   static void Bind();
 };
 
+/// The per-instance attributes of an instanced draw. @see InstanceArray.
+struct Instance3D {
+  glm::mat4 transformation = glm::mat4(1.f);
+  glm::vec4 color = {1.f, 1.f, 1.f, 1.f};
+
+  static void Bind();
+};
+
+/// The per-instance attributes of an instanced 2D draw. The transformation is
+/// a 2x3 affine matrix: the instance vertex (x,y) is moved to
+/// (dot(row_x, (x,y,1)), dot(row_y, (x,y,1))). It is half the size of a
+/// smk::Instance3D. @see InstanceArray.
+struct Instance2D {
+  glm::vec3 row_x = {1.f, 0.f, 0.f};
+  glm::vec3 row_y = {0.f, 1.f, 0.f};
+  glm::vec4 color = {1.f, 1.f, 1.f, 1.f};
+
+  static void Bind();
+};
+
+/// The per-instance state of a particle, simulated by the GPU.
+/// @see ParticleSystem
+struct Particle2D {
+  glm::vec4 color = {1.f, 1.f, 1.f, 1.f};
+  glm::vec2 position = {0.f, 0.f};
+  glm::vec2 velocity = {0.f, 0.f};
+  float age = 0.f;       // In seconds. Negative before its first spawn.
+  float lifetime = 0.f;  // In seconds.
+  float size = 0.f;      // In pixels. 0 when dead.
+
+  static void Bind();
+};
+
 using Vertex = Vertex2D;
 
 }  // namespace smk.
@@ -5,9 +5,13 @@
 #ifndef SMK_VERTEX_ARRAY_HPP
 #define SMK_VERTEX_ARRAY_HPP
 
+#include <atomic>
+#include <cstdint>
 #include <initializer_list>
+#include <smk/BoundingBox.hpp>
 #include <smk/OpenGL.hpp>
 #include <smk/Vertex.hpp>
+#include <type_traits>
 #include <vector>
 
 namespace smk {
@@ -15,6 +19,16 @@ namespace smk {
 /// @brief An array of smk::Vertex moved to the GPU memory. This represent a set
 /// of triangles to be drawn by the GPU.
 ///
+/// The triangles can optionally be described by an array of 16 or 32 bits
+/// indices into the vertices. This allows sharing the vertices in between
+/// adjacent triangles.
+///
+/// The content can be replaced with @ref Update. The GPU buffers are reused,
+/// which suits geometry modified every frames.
+///
+/// Besides the smk::Vertex types, it can store custom vertex types, for
+/// instance using compact attributes. See smk::VertexLayout.
+///
 /// This class is movable and copyable. It is refcounted. The GPU data is
 /// automatically released when the last smk::VertextArray is deleted.
 class VertexArray {
@@ -22,12 +36,58 @@ class VertexArray {
   VertexArray();  // The null VertexArray.
   VertexArray(const std::vector<Vertex2D>& array);
   VertexArray(const std::vector<Vertex3D>& array);
+  VertexArray(const std::vector<Vertex2DLayered>& array);
+  VertexArray(const std::vector<Vertex2D>& array,
+              const std::vector<uint16_t>& indices);
+  VertexArray(const std::vector<Vertex2D>& array,
+              const std::vector<uint32_t>& indices);
+  VertexArray(const std::vector<Vertex3D>& array,
+              const std::vector<uint16_t>& indices);
+  VertexArray(const std::vector<Vertex3D>& array,
+              const std::vector<uint32_t>& indices);
+
+  // Custom vertex types. See VertexLayout. The indices are uint16_t or
+  // uint32_t.
+  template <typename VertexType>
+  VertexArray(const std::vector<VertexType>& array);
+  template <typename VertexType, typename IndexType>
+  VertexArray(const std::vector<VertexType>& array,
+              const std::vector<IndexType>& indices);
 
   ~VertexArray();
 
   void Bind() const;
   void UnBind() const;
 
+  // Replace the content, reusing the GPU buffers. The buffers, their size()
+  // and their bounds() are shared with the copies of this VertexArray. With a
+  // render thread, the buffers still drawn by a pending frame are replaced
+  // instead of being reused: the copies it holds keep the previous content.
+  void Update(const std::vector<Vertex2D>& array);
+  void Update(const std::vector<Vertex3D>& array);
+  void Update(const std::vector<Vertex2DLayered>& array);
+  void Update(const std::vector<Vertex2D>& array,
+              const std::vector<uint16_t>& indices);
+  void Update(const std::vector<Vertex2D>& array,
+              const std::vector<uint32_t>& indices);
+  void Update(const std::vector<Vertex3D>& array,
+              const std::vector<uint16_t>& indices);
+  void Update(const std::vector<Vertex3D>& array,
+              const std::vector<uint32_t>& indices);
+  void Update(const Vertex2D* data, size_t size);
+  void Update(const Vertex3D* data, size_t size);
+  void Update(const Vertex2DLayered* data, size_t size);
+  template <typename VertexType>
+  void Update(const std::vector<VertexType>& array);
+  template <typename VertexType>
+  void Update(const VertexType* data, size_t size);
+
+  // Replace the vertices, knowing only [first, size) changed. It uploads only
+  // them, unless the buffer must grow. Its capacity is doubled, so that
+  // appending vertices has a constant amortized cost.
+  void UpdateRange(const Vertex2D* data, size_t size, size_t first);
+  void UpdateRange(const Vertex3D* data, size_t size, size_t first);
+
   // --- Movable-Copyable resource ---------------------------------------------
   VertexArray(VertexArray&&) noexcept;
   VertexArray(const VertexArray&);
@@ -38,20 +98,111 @@ class VertexArray {
   bool operator!=(const smk::VertexArray&) const;
 
   size_t size() const;
+  const BoundingBox& bounds() const;
+
+  // Indices. |index_type| is one of {GL_NONE, GL_UNSIGNED_SHORT,
+  // GL_UNSIGNED_INT}.
+  bool indexed() const { return index_type() != GL_NONE; }
+  size_t index_count() const { return shared_ ? shared_->index_count : 0u; }
+  GLenum index_type() const { return shared_ ? shared_->index_type : GL_NONE; }
+
+  // Provide the OpenGL buffer identifiers.
+  GLuint vbo() const { return vbo_; }
+  GLuint ebo() const { return shared_ ? shared_->ebo : 0u; }
 
  private:
-  void Allocate(int element_size, void* data);
+  void Allocate(size_t size, int element_size, void* data);
+  void AllocateIndices(size_t count, GLenum type, const void* data);
+  template <typename VertexType>
+  void UpdateVertices(const VertexType* data, size_t size);
+  void UpdateVertices(const void* data,
+                      size_t size,
+                      size_t element_size,
+                      void (*layout)(),
+                      const BoundingBox& bounds);
+  template <typename VertexType>
+  void UpdateVerticesRange(const VertexType* data, size_t size, size_t first);
+  void UpdateIndices(size_t count, GLenum type, const void* data);
   void Release();
+  static void Setup(const void* data);
+
+  // The bounds of the |space_position| of the vertices.
+  template <typename VertexType>
+  static BoundingBox Bounds(const VertexType* data, size_t size);
+  static glm::vec3 Position3D(const glm::vec2& p) { return glm::vec3(p, 0.f); }
+  static glm::vec3 Position3D(const glm::vec3& p) { return p; }
+
+  // The context owning |vao_|. The other windows use their own vertex array
+  // object, referring to the same buffers.
+  GLFWwindow* context_ = nullptr;
+  void (*layout_)() = nullptr;  // The Bind() function of the vertex type.
 
   GLuint vbo_ = 0;
   GLuint vao_ = 0;
-  size_t size_ = 0u;
 
-  // Used to support copy. Nullptr as long as this class is not copied.
-  // Otherwise an integer counting how many instances shares this resource.
-  mutable int* ref_count_ = nullptr;
+  // The state of the buffers, shared by the copies, so that they all see the
+  // content of the last Update().
+  struct Shared {
+    // Used to support copy. Counts how many instances shares this resource.
+    // It is atomic, so that copies can be made and released by several
+    // threads.
+    std::atomic<int> ref_count{1};
+    GLuint ebo = 0;
+    size_t size = 0u;
+    size_t capacity = 0u;  // The number of vertices the buffer can hold.
+    size_t index_count = 0u;
+    GLenum index_type = GL_NONE;
+    BoundingBox bounds;
+  };
+  Shared* shared_ = nullptr;
 };
 
+/// Constructor for a vector of custom vertices.
+/// @param array A set of triangles.
+template <typename VertexType>
+VertexArray::VertexArray(const std::vector<VertexType>& array) {
+  Update(array.data(), array.size());
+}
+
+/// Constructor for indexed custom vertices.
+/// @param array The vertices.
+/// @param indices Every 3 consecutive indices in |array| form a triangle.
+template <typename VertexType, typename IndexType>
+VertexArray::VertexArray(const std::vector<VertexType>& array,
+                         const std::vector<IndexType>& indices)
+    : VertexArray(array) {
+  static_assert(std::is_same<IndexType, uint16_t>::value ||
+                    std::is_same<IndexType, uint32_t>::value,
+                "The indices must be uint16_t or uint32_t");
+  AllocateIndices(indices.size(),
+                  sizeof(IndexType) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+                  indices.data());
+}
+
+/// @brief Replace the vertices.
+/// @param array A set of triangles.
+template <typename VertexType>
+void VertexArray::Update(const std::vector<VertexType>& array) {
+  Update(array.data(), array.size());
+}
+
+/// @brief Replace the vertices. The data is copied.
+/// @param data A set of triangles.
+/// @param size The number of vertices.
+template <typename VertexType>
+void VertexArray::Update(const VertexType* data, size_t size) {
+  UpdateVertices(data, size, sizeof(VertexType), &VertexType::Bind,
+                 Bounds(data, size));
+}
+
+template <typename VertexType>
+BoundingBox VertexArray::Bounds(const VertexType* data, size_t size) {
+  BoundingBox bounds;
+  for (size_t i = 0; i < size; ++i)
+    bounds.Extend(Position3D(data[i].space_position));
+  return bounds;
+}
+
 }  // namespace smk.
 
 #endif /* end of include guard: SMK_VERTEX_ARRAY_HPP */
@@ -0,0 +1,194 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_VERTEX_LAYOUT_HPP
+#define SMK_VERTEX_LAYOUT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <smk/OpenGL.hpp>
+
+namespace smk {
+
+// --- Compact attribute types -------------------------------------------------
+// They reduce the memory and the bandwidth used by the vertices. The shaders
+// read them as floats.
+
+// Convert a float to a 16 bits IEEE half float, rounding to the nearest.
+inline uint16_t PackHalf(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint32_t sign = (bits >> 16) & 0x8000;
+  const int exponent = int((bits >> 23) & 0xFF) - 127 + 15;
+  uint32_t mantissa = bits & 0x7FFFFF;
+  if (exponent >= 31) {
+    // Too large, infinite or NaN.
+    const bool nan = (bits & 0x7F800000) == 0x7F800000 && mantissa;
+    return uint16_t(sign | 0x7C00 | (nan ? 0x200 : 0));
+  }
+  if (exponent <= 0) {
+    // Subnormal, or too small.
+    if (exponent < -10)
+      return uint16_t(sign);
+    mantissa |= 0x800000;
+    const int shift = 14 - exponent;
+    uint32_t half = mantissa >> shift;
+    if ((mantissa >> (shift - 1)) & 1)
+      ++half;
+    return uint16_t(sign | half);
+  }
+  uint32_t half = sign | uint32_t(exponent) << 10 | mantissa >> 13;
+  if (mantissa & 0x1000)
+    ++half;  // A carry into the exponent is still correctly rounded.
+  return uint16_t(half);
+}
+
+/// Two half floats. Read as a vec2. Suited for the texture coordinates.
+struct Half2 {
+  uint16_t x = 0;
+  uint16_t y = 0;
+
+  Half2() = default;
+  Half2(const glm::vec2& v) : x(PackHalf(v.x)), y(PackHalf(v.y)) {}
+};
+
+/// Four half floats. Read as a vec4.
+struct Half4 {
+  uint16_t x = 0;
+  uint16_t y = 0;
+  uint16_t z = 0;
+  uint16_t w = 0;
+
+  Half4() = default;
+  Half4(const glm::vec4& v)
+      : x(PackHalf(v.x)),
+        y(PackHalf(v.y)),
+        z(PackHalf(v.z)),
+        w(PackHalf(v.w)) {}
+};
+
+/// A color as four normalized bytes. Read as a vec4 in [0,1].
+struct Color8 {
+  uint8_t r = 255;
+  uint8_t g = 255;
+  uint8_t b = 255;
+  uint8_t a = 255;
+
+  Color8() = default;
+  Color8(const glm::vec4& color)
+      : r(Pack(color.r)),
+        g(Pack(color.g)),
+        b(Pack(color.b)),
+        a(Pack(color.a)) {}
+
+ private:
+  static uint8_t Pack(float v) {
+    return uint8_t(std::lround(std::min(std::max(v, 0.f), 1.f) * 255.f));
+  }
+};
+
+/// A unit vector packed into 32 bits, 10 bits per component. Read as a vec4 in
+/// [-1,1], with w = 0. Suited for the normals.
+struct PackedNormal {
+  uint32_t bits = 0;
+
+  PackedNormal() = default;
+  PackedNormal(const glm::vec3& normal)
+      : bits(Pack(normal.x) | Pack(normal.y) << 10 | Pack(normal.z) << 20) {}
+
+ private:
+  static uint32_t Pack(float v) {
+    const long i = std::lround(std::min(std::max(v, -1.f), 1.f) * 511.f);
+    return uint32_t(i) & 0x3FF;
+  }
+};
+
+// --- Attribute formats -------------------------------------------------------
+// How a C++ type is read by the vertex shader.
+
+template <typename Type>
+struct VertexAttributeFormat;
+
+#define SMK_VERTEX_ATTRIBUTE_FORMAT(Type, Components, GLType, Normalized) \
+  template <>                                                             \
+  struct VertexAttributeFormat<Type> {                                    \
+    static const GLint components = Components;                           \
+    static const GLenum type = GLType;                                    \
+    static const GLboolean normalized = Normalized;                       \
+  }
+
+SMK_VERTEX_ATTRIBUTE_FORMAT(float, 1, GL_FLOAT, GL_FALSE);
+SMK_VERTEX_ATTRIBUTE_FORMAT(glm::vec2, 2, GL_FLOAT, GL_FALSE);
+SMK_VERTEX_ATTRIBUTE_FORMAT(glm::vec3, 3, GL_FLOAT, GL_FALSE);
+SMK_VERTEX_ATTRIBUTE_FORMAT(glm::vec4, 4, GL_FLOAT, GL_FALSE);
+SMK_VERTEX_ATTRIBUTE_FORMAT(Half2, 2, GL_HALF_FLOAT, GL_FALSE);
+SMK_VERTEX_ATTRIBUTE_FORMAT(Half4, 4, GL_HALF_FLOAT, GL_FALSE);
+SMK_VERTEX_ATTRIBUTE_FORMAT(Color8, 4, GL_UNSIGNED_BYTE, GL_TRUE);
+SMK_VERTEX_ATTRIBUTE_FORMAT(PackedNormal, 4, GL_INT_2_10_10_10_REV, GL_TRUE);
+
+#undef SMK_VERTEX_ATTRIBUTE_FORMAT
+
+// --- Layouts -----------------------------------------------------------------
+
+/// One attribute of a vertex type, read from the shader |location|. Everything
+/// is known at compile time. See SMK_VERTEX_ATTRIBUTE.
+template <GLuint location, typename Type, size_t offset>
+struct VertexAttribute {
+  static void Bind(GLsizei stride) {
+    typedef VertexAttributeFormat<Type> Format;
+    glEnableVertexAttribArray(location);
+    glVertexAttribPointer(location, Format::components, Format::type,
+                          Format::normalized, stride,
+                          reinterpret_cast<const void*>(offset));
+  }
+};
+
+/// The attribute |member| of |Vertex|, read from the shader |location|.
+#define SMK_VERTEX_ATTRIBUTE(location, Vertex, member)                \
+  ::smk::VertexAttribute<location, decltype(Vertex::member),          \
+                         offsetof(Vertex, member)>
+
+/// The layout of a custom vertex type, generated from the list of its
+/// attributes. Its Bind() function is the one VertexArray expects from the
+/// vertex types.
+///
+/// The vertex type can be stored into a VertexArray when it has a Bind()
+/// function, and a glm::vec2 or glm::vec3 |space_position| member, used to
+/// compute the bounds.
+///
+/// Example:
+/// --------
+/// ~~~cpp
+/// struct CompactVertex {
+///   glm::vec2 space_position;
+///   smk::Half2 texture_position;
+///   smk::Color8 color;
+///
+///   static void Bind() {
+///     smk::VertexLayout<
+///         CompactVertex,
+///         SMK_VERTEX_ATTRIBUTE(0, CompactVertex, space_position),
+///         SMK_VERTEX_ATTRIBUTE(1, CompactVertex, texture_position),
+///         SMK_VERTEX_ATTRIBUTE(2, CompactVertex, color)>::Bind();
+///   }
+/// };
+///
+/// std::vector<CompactVertex> vertices = ...;
+/// smk::VertexArray vertex_array(vertices);  // 16 bytes per vertex.
+/// ~~~
+template <typename Vertex, typename... Attributes>
+struct VertexLayout {
+  static void Bind() {
+    const int expand[] = {(Attributes::Bind(sizeof(Vertex)), 0)...};
+    (void)expand;
+  }
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_VERTEX_LAYOUT_HPP */
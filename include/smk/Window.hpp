@@ -5,11 +5,14 @@
 #ifndef SMK_WINDOW_HPP
 #define SMK_WINDOW_HPP
 
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <glm/glm.hpp>
 #include <memory>
 #include <smk/RenderTarget.hpp>
 #include <string>
+#include <vector>
 
 struct GLFWwindow;
 
@@ -20,6 +23,8 @@ class VertexArray;
 class Sprite;
 class Input;
 class InputImpl;
+class RenderThread;
+struct RecordedFrame;
 
 /// @brief A window. You can draw objects on the window.
 ///
@@ -28,10 +33,69 @@ class InputImpl;
 /// ~~~cpp
 /// auto window = smk::Window(640, 480, "Window title");
 /// ~~~
+///
+/// Rendering a thumbnail on a headless server:
+/// ~~~cpp
+/// smk::Window::Option option;
+/// option.headless = true;
+/// auto context = smk::Window(1, 1, "", option);
+///
+/// smk::Framebuffer thumbnail(256, 256);
+/// thumbnail.Clear(smk::Color::Black);
+/// thumbnail.Draw(sprite);
+/// ~~~
 class Window : public RenderTarget {
  public:
+  struct Option {
+    // The number of samples per pixel of the window's surface. Use 0 to
+    // disable multisampling and use a multisampled smk::Framebuffer only for
+    // the content that needs it.
+    int samples = 4;
+
+    // Share the textures, buffers and shaders with the windows already
+    // created, so that they can be drawn in every window without being
+    // uploaded again.
+    bool share_context = true;
+
+    // Run the OpenGL commands drawing the window on a dedicated thread. The
+    // draws are recorded and replayed by the render thread during the next
+    // frame, while the application prepares the following one.
+    //
+    // The recorded draws hold copies of the VertexArrays and Textures, so they
+    // can be released safely. A VertexArray updated while a pending frame uses
+    // it receives new buffers: the SpriteBatches, Texts, TileMaps and
+    // PathBuilders can be modified freely. The values given to
+    // ShaderProgram::SetUniform() are recorded with the draws following them.
+    // The pixels of the Textures are shared with the render thread: they must
+    // stay unmodified until the next Display() returns.
+    //
+    // The Framebuffers are still drawn by the application thread.
+    // ReadPixelsAsync() isn't supported by the window. This is not supported
+    // by WebGL.
+    bool render_thread = false;
+
+    // Create the OpenGL context without showing a window, to render into
+    // smk::Framebuffers on a server. The context is created with EGL when
+    // available and, with GLFW 3.4, without a display server. In this case,
+    // it must be the first Window created. Nothing is logged at startup.
+    bool headless = false;
+  };
+
+  // How ExecuteMainLoop() paces the frames.
+  enum class FramePacing {
+    Capped,        // Wait until the frame rate set by SetFrameRate() is met.
+    VSync,         // Swap the buffers at the display refresh rate.
+    AdaptiveSync,  // VSync, but late frames are displayed immediately.
+    Uncapped,      // As fast as possible. Useful for benchmarking.
+    OnDemand,      // Only when an input arrives or a redraw is requested.
+  };
+
   Window();
   Window(int width, int height, const std::string& title);
+  Window(int width,
+         int height,
+         const std::string& title,
+         const Option& option);
   ~Window();
 
   GLFWwindow* window() const;
@@ -41,6 +105,27 @@ class Window : public RenderTarget {
   void ExecuteMainLoop(std::function<void(void)> loop);
   void ExecuteMainLoopUntil(std::function<bool(void)> loop);
 
+  // Call |update| every |timestep| seconds of simulated time, independently
+  // of the frame rate, and |draw| once per frame. |draw| receives how far the
+  // current time is between the last update and the next one, in [0,1[, to
+  // interpolate the state drawn. |timestep| must be positive. At most 16
+  // updates run per frame: past that, the simulation slows down.
+  void ExecuteMainLoop(float timestep,
+                       std::function<void(float timestep)> update,
+                       std::function<void(float interpolation)> draw);
+
+  // Frame pacing used by ExecuteMainLoop(). Default to Capped, at 60 fps. On
+  // the web, the browser paces the frames.
+  void SetFramePacing(FramePacing pacing);
+  void SetFrameRate(float fps);
+
+  // With FramePacing::OnDemand, ExecuteMainLoop() waits for an input, or for
+  // a redraw to be requested. Call RequestRedraw() when the content changes,
+  // for instance every frame during an animation. It can be called from any
+  // thread.
+  void RequestRedraw();
+  void RequestRedraw(float delay);  // Redraw in |delay| seconds.
+
   // Pool new events. This update the |input()| element.
   void PoolEvents();
 
@@ -48,8 +133,12 @@ class Window : public RenderTarget {
   // are swapped.
   void Display();
 
+  // The work submitted during the last displayed frame.
+  const RenderStats& frame_stats() const { return frame_stats_; }
+
   // Wait until the end of the frame to maintain a targetted frame per seconds.
-  // (optional).
+  // (optional). It sleeps, and then spins during the last milliseconds to
+  // meet the deadline accurately.
   void LimitFrameRate(float fps);
 
   // Returns true when the user wants to close the window.
@@ -66,9 +155,36 @@ class Window : public RenderTarget {
 
   // Time:
   float time_ = 0.f;
-  float time_last_sleep_ = 0.f;
+  double frame_deadline_ = 0.0;
+
+  // Frame pacing:
+  FramePacing frame_pacing_ = FramePacing::Capped;
+  float frame_rate_ = 60.f;
+  void PaceFrame();
+
+  // On demand rendering:
+  std::atomic<bool> redraw_requested_{true};
+  double redraw_deadline_ = -1.0;  // Negative when unset.
+  bool WaitForRedraw();
 
   void UpdateDimensions();
+  void MeasureGpuTime();
+
+  // Render thread:
+  friend class RenderThread;
+  void StartRenderThread();
+  void SubmitFrame();
+  void RenderFrame(RecordedFrame& frame);
+  std::unique_ptr<RenderThread> render_thread_;
+  GLFWwindow* upload_context_ = nullptr;  // Used by the application thread.
+  int swap_interval_ = -2;  // Not set by SetFramePacing() yet.
+
+  // Statistics:
+  RenderStats frame_stats_;
+  float gpu_time_ = -1.f;
+  GLuint gpu_query_ = 0;
+  std::deque<GLuint> gpu_queries_pending_;
+  std::vector<GLuint> gpu_queries_free_;
 
   std::unique_ptr<InputImpl> input_;
   int id_ = 0;
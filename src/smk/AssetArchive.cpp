@@ -0,0 +1,375 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <smk/AssetArchive.hpp>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "MappedFile.hpp"
+
+namespace smk {
+
+namespace {
+
+// The archive starts with a Header, followed by the index: for each entry, an
+// IndexEntry and its name. The data of the entries follow, aligned on
+// kAlignment bytes.
+const char kMagic[4] = {'S', 'M', 'K', 'P'};
+const uint32_t kVersion = 1;
+const size_t kAlignment = 16;
+
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint32_t entry_count;
+  uint32_t index_size;  // In bytes, after the header.
+};
+
+enum Compression : uint32_t {
+  kStored = 0,
+  kLZ4 = 1,
+};
+
+struct IndexEntry {
+  uint64_t offset;       // From the start of the archive.
+  uint64_t size;         // Once decompressed.
+  uint64_t stored_size;  // In the archive.
+  uint32_t compression;
+  uint32_t name_size;
+};
+
+// --- LZ4 block format --------------------------------------------------------
+// See https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+
+const int kHashBits = 14;
+const size_t kMinMatch = 4;
+const size_t kMaxOffset = 65535;
+
+void WriteLength(std::vector<uint8_t>* out, size_t length) {
+  for (; length >= 255; length -= 255)
+    out->push_back(255);
+  out->push_back(uint8_t(length));
+}
+
+void WriteSequence(std::vector<uint8_t>* out,
+                   const uint8_t* literals,
+                   size_t literal_count,
+                   size_t offset,
+                   size_t match_length) {
+  const size_t match = match_length ? match_length - kMinMatch : 0;
+  out->push_back(uint8_t(std::min<size_t>(literal_count, 15) << 4 |
+                         std::min<size_t>(match, 15)));
+  if (literal_count >= 15)
+    WriteLength(out, literal_count - 15);
+  out->insert(out->end(), literals, literals + literal_count);
+  if (!match_length)
+    return;
+  out->push_back(uint8_t(offset));
+  out->push_back(uint8_t(offset >> 8));
+  if (match >= 15)
+    WriteLength(out, match - 15);
+}
+
+// A greedy compressor. The last match starts 12 bytes before the end at the
+// latest, and the last 5 bytes are literals, as required by the format.
+std::vector<uint8_t> Compress(const uint8_t* in, size_t size) {
+  std::vector<uint8_t> out;
+  std::vector<size_t> table(size_t(1) << kHashBits, 0);  // Position + 1.
+  const size_t limit = size > 12 ? size - 12 : 0;
+  size_t anchor = 0;
+  size_t i = 0;
+  while (i < limit) {
+    uint32_t sequence;
+    std::memcpy(&sequence, in + i, sizeof(sequence));
+    const uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+    const size_t candidate = table[hash];
+    table[hash] = i + 1;
+    if (!candidate || i + 1 - candidate > kMaxOffset ||
+        std::memcmp(in + candidate - 1, in + i, kMinMatch)) {
+      ++i;
+      continue;
+    }
+
+    const size_t match = candidate - 1;
+    size_t length = kMinMatch;
+    while (i + length < size - 5 && in[match + length] == in[i + length])
+      ++length;
+    WriteSequence(&out, in + anchor, i - anchor, i - match, length);
+    i += length;
+    anchor = i;
+  }
+  WriteSequence(&out, in + anchor, size - anchor, 0, 0);
+  return out;
+}
+
+bool ReadLength(const uint8_t*& in, const uint8_t* end, size_t* length) {
+  uint8_t byte;
+  do {
+    if (in == end)
+      return false;
+    byte = *in++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+// Return false when |in| isn't a valid block of |out_size| bytes.
+bool Decompress(const uint8_t* in,
+                size_t in_size,
+                uint8_t* out,
+                size_t out_size) {
+  const uint8_t* in_end = in + in_size;
+  uint8_t* op = out;
+  uint8_t* out_end = out + out_size;
+  while (in < in_end) {
+    const uint8_t token = *in++;
+
+    size_t literals = token >> 4;
+    if (literals == 15 && !ReadLength(in, in_end, &literals))
+      return false;
+    if (literals > size_t(in_end - in) || literals > size_t(out_end - op))
+      return false;
+    std::memcpy(op, in, literals);
+    op += literals;
+    in += literals;
+    if (in == in_end)
+      break;  // The last sequence has no match.
+
+    if (in_end - in < 2)
+      return false;
+    const size_t offset = size_t(in[0]) | size_t(in[1]) << 8;
+    in += 2;
+    if (offset == 0 || offset > size_t(op - out))
+      return false;
+    size_t length = token & 15;
+    if (length == 15 && !ReadLength(in, in_end, &length))
+      return false;
+    length += kMinMatch;
+    if (length > size_t(out_end - op))
+      return false;
+
+    // The match can overlap the bytes being written.
+    const uint8_t* match = op - offset;
+    while (length--)
+      *op++ = *match++;
+  }
+  return op == out_end;
+}
+
+}  // namespace
+
+struct AssetArchive::Impl {
+  struct Entry {
+    IndexEntry index;
+    std::vector<uint8_t> decompressed;
+    bool decompressed_ready = false;
+  };
+
+  MappedFile file;
+  std::unordered_map<std::string, Entry> entries;
+  std::vector<std::string> names;
+  std::mutex mutex;  // Guard the decompression.
+};
+
+/// @brief An empty archive.
+AssetArchive::AssetArchive() : impl_(std::make_unique<Impl>()) {}
+
+/// @brief Open an archive.
+/// @param filename The archive, written by AssetArchive::Write().
+AssetArchive::AssetArchive(const std::string& filename) : AssetArchive() {
+  Open(filename);
+}
+
+AssetArchive::~AssetArchive() = default;
+
+AssetArchive::AssetArchive(AssetArchive&& other) noexcept : AssetArchive() {
+  operator=(std::move(other));
+}
+
+AssetArchive& AssetArchive::operator=(AssetArchive&& other) noexcept {
+  std::swap(impl_, other.impl_);
+  return *this;
+}
+
+/// @brief Open an archive, replacing the one opened before.
+/// @param filename The archive, written by AssetArchive::Write().
+/// @return false when the archive can't be read or is invalid.
+bool AssetArchive::Open(const std::string& filename) {
+  impl_ = std::make_unique<Impl>();
+  if (!impl_->file.Open(filename)) {
+    std::cerr << "SMK > Can't open the archive " << filename << std::endl;
+    return false;
+  }
+
+  const uint8_t* data = impl_->file.data();
+  const size_t size = impl_->file.size();
+  auto invalid = [&] {
+    std::cerr << "SMK > Invalid archive " << filename << std::endl;
+    impl_ = std::make_unique<Impl>();
+    return false;
+  };
+
+  Header header;
+  if (size < sizeof(header))
+    return invalid();
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) ||
+      header.version != kVersion ||
+      header.index_size > size - sizeof(header)) {
+    return invalid();
+  }
+
+  size_t position = sizeof(header);
+  const size_t index_end = sizeof(header) + header.index_size;
+  for (uint32_t i = 0; i < header.entry_count; ++i) {
+    IndexEntry index;
+    if (index_end - position < sizeof(index))
+      return invalid();
+    std::memcpy(&index, data + position, sizeof(index));
+    position += sizeof(index);
+    if (index_end - position < index.name_size ||
+        index.offset > size || index.stored_size > size - index.offset ||
+        (index.compression == kStored && index.size != index.stored_size) ||
+        index.compression > kLZ4) {
+      return invalid();
+    }
+
+    std::string name(reinterpret_cast<const char*>(data + position),
+                     index.name_size);
+    position += index.name_size;
+    // The entries are looked up by name. A duplicate would be unreachable.
+    auto inserted = impl_->entries.try_emplace(name);
+    if (!inserted.second)
+      return invalid();
+    inserted.first->second.index = index;
+    impl_->names.push_back(std::move(name));
+  }
+  return true;
+}
+
+/// @brief Whether the archive contains an entry.
+/// @param name The name of the entry.
+bool AssetArchive::Contains(const std::string& name) const {
+  return impl_->entries.count(name) != 0;
+}
+
+/// @brief The content of an entry. The stored entries are read in place. The
+/// compressed ones are decompressed on their first access.
+/// @param name The name of the entry.
+/// @return An empty span when the entry is missing or corrupted. Otherwise, it
+///         remains valid until the archive is destroyed or reopened.
+AssetArchive::Span AssetArchive::Get(const std::string& name) const {
+  auto it = impl_->entries.find(name);
+  if (it == impl_->entries.end())
+    return {};
+
+  Impl::Entry& entry = it->second;
+  const uint8_t* stored = impl_->file.data() + entry.index.offset;
+  if (entry.index.compression == kStored)
+    return {stored, size_t(entry.index.size)};
+
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  if (!entry.decompressed_ready) {
+    entry.decompressed.resize(size_t(entry.index.size));
+    if (!Decompress(stored, size_t(entry.index.stored_size),
+                    entry.decompressed.data(), entry.decompressed.size())) {
+      std::cerr << "SMK > Corrupted archive entry " << name << std::endl;
+      entry.decompressed.clear();
+      return {};
+    }
+    entry.decompressed_ready = true;
+  }
+  return {entry.decompressed.data(), entry.decompressed.size()};
+}
+
+/// @brief The names of the entries, in the order they were packed.
+std::vector<std::string> AssetArchive::names() const {
+  return impl_->names;
+}
+
+/// @brief Pack files into a new archive.
+/// @param filename The archive to write. It is replaced when it exists.
+/// @param files The files to pack, with the name of their entry.
+/// @return false when a file can't be read, when two entries have the same
+///         name, or when the archive can't be written.
+// static
+bool AssetArchive::Write(const std::string& filename,
+                         const std::vector<File>& files) {
+  std::unordered_set<std::string> names;
+  for (const File& file : files) {
+    if (!names.insert(file.name).second) {
+      std::cerr << "SMK > Duplicate archive entry " << file.name << std::endl;
+      return false;
+    }
+  }
+
+  std::vector<IndexEntry> index(files.size());
+  std::vector<std::vector<uint8_t>> contents(files.size());
+  uint32_t index_size = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    MappedFile file;
+    if (!file.Open(files[i].filename)) {
+      std::cerr << "SMK > Can't read " << files[i].filename << std::endl;
+      return false;
+    }
+
+    index[i].size = file.size();
+    index[i].compression = kStored;
+    index[i].name_size = uint32_t(files[i].name.size());
+    index_size += uint32_t(sizeof(IndexEntry) + files[i].name.size());
+    if (files[i].compress && file.size()) {
+      contents[i] = Compress(file.data(), file.size());
+      if (contents[i].size() < file.size()) {
+        index[i].compression = kLZ4;
+        index[i].stored_size = contents[i].size();
+        continue;
+      }
+    }
+    contents[i].assign(file.data(), file.data() + file.size());
+    index[i].stored_size = file.size();
+  }
+
+  auto align = [](size_t offset) {
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+  };
+  size_t offset = align(sizeof(Header) + index_size);
+  for (IndexEntry& entry : index) {
+    entry.offset = offset;
+    offset = align(offset + entry.stored_size);
+  }
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.entry_count = uint32_t(files.size());
+  header.index_size = index_size;
+
+  std::ofstream out(filename, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (size_t i = 0; i < files.size(); ++i) {
+    out.write(reinterpret_cast<const char*>(&index[i]), sizeof(IndexEntry));
+    out.write(files[i].name.data(), files[i].name.size());
+  }
+  const char padding[kAlignment] = {};
+  size_t position = sizeof(header) + index_size;
+  for (size_t i = 0; i < files.size(); ++i) {
+    out.write(padding, index[i].offset - position);
+    out.write(reinterpret_cast<const char*>(contents[i].data()),
+              contents[i].size());
+    position = index[i].offset + contents[i].size();
+  }
+
+  if (!out) {
+    std::cerr << "SMK > Can't write the archive " << filename << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace smk
@@ -0,0 +1,176 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <chrono>
+#include <smk/AssetLoader.hpp>
+
+#include "DecodedImage.hpp"
+#include "DecodedSound.hpp"
+
+namespace smk {
+
+/// @brief Create an AssetLoader using two worker threads.
+AssetLoader::AssetLoader() : AssetLoader(2) {}
+
+/// @brief Create an AssetLoader.
+/// @param threads The number of worker threads decoding the files.
+AssetLoader::AssetLoader(int threads) {
+#if defined __EMSCRIPTEN__ && !defined __EMSCRIPTEN_PTHREADS__
+  threads = 0;  // No threads available. The files are decoded by Enqueue().
+#endif
+  for (int i = 0; i < threads; ++i)
+    threads_.emplace_back(&AssetLoader::Run, this);
+}
+
+/// @brief Stop the workers. The assets not uploaded yet are dropped.
+AssetLoader::~AssetLoader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  condition_.notify_all();
+  for (auto& thread : threads_)
+    thread.join();
+}
+
+/// @brief Load a Texture from a file.
+/// @param filename The file name of the image to be loaded.
+AssetLoader::Handle<Texture> AssetLoader::LoadTexture(
+    const std::string& filename) {
+  return LoadTexture(filename, Texture::Option());
+}
+
+/// @brief Load a Texture from a file.
+/// @param filename The file name of the image to be loaded.
+/// @param option Additionnal option (texture wrap, min filter, mag filter, ...)
+AssetLoader::Handle<Texture> AssetLoader::LoadTexture(
+    const std::string& filename,
+    const Texture::Option& option) {
+  return Enqueue<Texture>([filename, option]() -> std::function<Texture()> {
+    auto image = std::make_shared<DecodedImage>();
+    if (!image->Decode(filename, option))
+      return [] { return Texture(); };
+    return [image] { return image->Upload(); };
+  });
+}
+
+/// @brief Load a Font from a file. Its Latin-1 glyphs are rasterized by the
+/// workers.
+/// @param filename The path to the font file.
+/// @param line_height The size of the font, in pixels.
+/// @param rendering How the glyphs are rasterized.
+AssetLoader::Handle<Font> AssetLoader::LoadFont(const std::string& filename,
+                                                float line_height,
+                                                Font::Rendering rendering) {
+  return Enqueue<Font>([filename, line_height, rendering] {
+    return Font::Prepare(filename, line_height, rendering);
+  });
+}
+
+/// @brief Load a SoundBuffer from a file.
+/// @param filename The path to the sound file.
+AssetLoader::Handle<SoundBuffer> AssetLoader::LoadSoundBuffer(
+    const std::string& filename) {
+  return Enqueue<SoundBuffer>([filename]() -> std::function<SoundBuffer()> {
+    auto sound = std::make_shared<DecodedSound>();
+    if (!sound->Decode(filename))
+      return [] { return SoundBuffer(); };
+    return [sound] { return sound->Upload(); };
+  });
+}
+
+template <typename T>
+AssetLoader::Handle<T> AssetLoader::Enqueue(
+    std::function<std::function<T()>()> decode) {
+  Handle<T> handle;
+  handle.state_ = std::make_shared<typename Handle<T>::State>();
+  auto state = handle.state_;
+
+  // Runs on a worker. Returns the function to run on the OpenGL thread.
+  Decode task = [decode, state]() -> Upload {
+    std::function<T()> create = decode();
+    return [create, state] {
+      state->value = create();
+      state->ready = true;
+    };
+  };
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++pending_;
+  if (threads_.empty()) {
+    uploads_.push_back(task());
+    return handle;
+  }
+  decodes_.push_back(std::move(task));
+  condition_.notify_one();
+  return handle;
+}
+
+void AssetLoader::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    condition_.wait(lock, [&] { return stop_ || !decodes_.empty(); });
+    if (stop_)
+      return;
+    Decode task = std::move(decodes_.front());
+    decodes_.pop_front();
+    lock.unlock();
+
+    Upload upload = task();
+
+    lock.lock();
+    uploads_.push_back(std::move(upload));
+    condition_.notify_all();
+  }
+}
+
+/// @brief Upload the decoded assets, within a time budget.
+/// @param budget The time in seconds after which no more uploads are started.
+void AssetLoader::Update(float budget) {
+  using clock = std::chrono::steady_clock;
+  const auto deadline =
+      clock::now() + std::chrono::duration_cast<clock::duration>(
+                         std::chrono::duration<float>(budget));
+  do {
+    Upload upload;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (uploads_.empty())
+        return;
+      upload = std::move(uploads_.front());
+      uploads_.pop_front();
+    }
+    upload();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    --pending_;
+  } while (clock::now() < deadline);
+}
+
+/// @brief The number of assets requested, but not uploaded yet.
+size_t AssetLoader::pending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_;
+}
+
+/// @brief Wait for every assets to be decoded and uploaded. Must be called from
+/// the OpenGL thread.
+void AssetLoader::Finish() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    condition_.wait(lock, [&] { return pending_ == 0 || !uploads_.empty(); });
+    if (pending_ == 0)
+      return;
+    Upload upload = std::move(uploads_.front());
+    uploads_.pop_front();
+    lock.unlock();
+
+    upload();
+
+    lock.lock();
+    --pending_;
+  }
+}
+
+}  // namespace smk
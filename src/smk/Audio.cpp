@@ -5,18 +5,52 @@
 #include <AL/al.h>
 #include <AL/alc.h>
 
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <mutex>
 #include <smk/Audio.hpp>
+#include <smk/SoundBuffer.hpp>
 #include <string>
 #include <vector>
+
+#include "SourcePool.hpp"
+
 namespace smk {
 
 namespace {
+
+// ALC_SOFT_HRTF and ALC_SOFT_device_clock. They aren't in every alc.h.
+const ALCint kHrtfSoft = 0x1992;
+const ALCenum kDeviceClockSoft = 0x1600;
+const ALCenum kDeviceLatencySoft = 0x1601;
+using GetInteger64vSoft = void (*)(ALCdevice*, ALCenum, ALCsizei, int64_t*);
+// AL_SOFT_deferred_updates.
+using DeferUpdatesSoft = void (*)();
+
 int g_ref_count = 0;
+GetInteger64vSoft g_get_integer64 = nullptr;
+DeferUpdatesSoft g_defer_updates = nullptr;
+DeferUpdatesSoft g_process_updates = nullptr;
+
+// The listener, sent by Audio::Update() when |g_listener_dirty|.
+struct Listener {
+  glm::vec3 position = {0.f, 0.f, 0.f};
+  glm::vec3 velocity = {0.f, 0.f, 0.f};
+  glm::vec3 forward = {0.f, 0.f, -1.f};
+  glm::vec3 up = {0.f, 1.f, 0.f};
+};
+Listener g_listener;
+bool g_listener_dirty = false;
 ALCdevice* g_audio_device = nullptr;
 ALCcontext* g_audio_context = nullptr;
 
+// The option of the device opened on first use, with Option::lazy.
+Audio::Option g_lazy_option;
+std::atomic<bool> g_lazy_pending(false);
+std::mutex g_lazy_mutex;
+
 void GetDevices(std::vector<std::string>& devices) {
   // Vidage de la liste
   // Clear the list
@@ -35,22 +69,22 @@ void GetDevices(std::vector<std::string>& devices) {
   }
 }
 
-}  // namespace
+// Open the device and create the OpenAL context.
+void Open(const Audio::Option& option) {
+  if (option.list_devices) {
+    std::vector<std::string> devices;
+    GetDevices(devices);
+    std::cout << "Audio devices found " << devices.size() << ":" << std::endl;
 
-Audio::Audio() {
-  if (g_ref_count++)
-    return;
-  std::vector<std::string> devices;
-  GetDevices(devices);
-  std::cout << "Audio devices found " << devices.size() << ":" << std::endl;
+    for (auto& it : devices) {
+      std::cout << "* " << it << std::endl;
+    }
 
-  for (auto& it : devices) {
-    std::cout << "* " << it << std::endl;
+    std::cout << std::endl;
   }
 
-  std::cout << std::endl;
-
-  g_audio_device = alcOpenDevice(devices[0].c_str());
+  g_audio_device =
+      alcOpenDevice(option.device.empty() ? nullptr : option.device.c_str());
 
   if (!g_audio_device) {
     std::cerr << "Failed to get an OpenAL device. Please check you have some "
@@ -60,7 +94,24 @@ Audio::Audio() {
     return;
   }
 
-  g_audio_context = alcCreateContext(g_audio_device, nullptr);
+  std::vector<ALCint> attributes;
+  auto add = [&](ALCint name, ALCint value) {
+    attributes.push_back(name);
+    attributes.push_back(value);
+  };
+  if (option.frequency)
+    add(ALC_FREQUENCY, option.frequency);
+  if (option.refresh)
+    add(ALC_REFRESH, option.refresh);
+  if (option.mono_sources)
+    add(ALC_MONO_SOURCES, option.mono_sources);
+  if (option.stereo_sources)
+    add(ALC_STEREO_SOURCES, option.stereo_sources);
+  if (!option.hrtf && alcIsExtensionPresent(g_audio_device, "ALC_SOFT_HRTF"))
+    add(kHrtfSoft, ALC_FALSE);
+  attributes.push_back(0);
+
+  g_audio_context = alcCreateContext(g_audio_device, attributes.data());
   if (!g_audio_context) {
     std::cerr << "Failed to get an OpenAL context" << std::endl;
     return;
@@ -70,11 +121,53 @@ Audio::Audio() {
     std::cerr << "Failed to make the OpenAL context active" << std::endl;
     return;
   }
+
+  if (alcIsExtensionPresent(g_audio_device, "ALC_SOFT_device_clock")) {
+    g_get_integer64 = reinterpret_cast<GetInteger64vSoft>(
+        alcGetProcAddress(g_audio_device, "alcGetInteger64vSOFT"));
+  }
+
+  if (alIsExtensionPresent("AL_SOFT_deferred_updates")) {
+    g_defer_updates = reinterpret_cast<DeferUpdatesSoft>(
+        alGetProcAddress("alDeferUpdatesSOFT"));
+    g_process_updates = reinterpret_cast<DeferUpdatesSoft>(
+        alGetProcAddress("alProcessUpdatesSOFT"));
+  }
+
+  SourcePool::Get().Init(option.voice_count);
+}
+
+}  // namespace
+
+/// @brief Initialize OpenAL with the default device and attributes.
+Audio::Audio() : Audio(Option()) {}
+
+/// @brief Initialize OpenAL.
+/// @param option The device and the attributes of the OpenAL context. They are
+///               ignored when OpenAL is already initialized.
+Audio::Audio(const Option& option) {
+  if (g_ref_count++)
+    return;
+
+  if (option.lazy) {
+    std::lock_guard<std::mutex> lock(g_lazy_mutex);
+    g_lazy_option = option;
+    g_lazy_pending = true;
+    return;
+  }
+
+  Open(option);
 }
 
 Audio::~Audio() {
   if (--g_ref_count)
     return;
+  g_lazy_pending = false;
+  SourcePool::Get().Release();
+  g_get_integer64 = nullptr;
+  g_defer_updates = nullptr;
+  g_process_updates = nullptr;
+
   // Destroy the context
   alcMakeContextCurrent(nullptr);
   if (g_audio_context) {
@@ -89,10 +182,132 @@ Audio::~Audio() {
   }
 }
 
-/// @return true if there is at least one Audio class instanciated.
+/// @return true if there is at least one Audio class instanciated. With
+/// Option::lazy, the first call opens the device.
 // static
 bool Audio::Initialized() {
-  return g_ref_count;
+  if (!g_ref_count)
+    return false;
+
+  if (g_lazy_pending) {
+    std::lock_guard<std::mutex> lock(g_lazy_mutex);
+    if (g_lazy_pending) {
+      Open(g_lazy_option);
+      g_lazy_pending = false;
+    }
+  }
+  return true;
+}
+
+/// @return The mixing frequency of the device, in Hz.
+// static
+int Audio::frequency() {
+  if (!g_audio_device)
+    return 0;
+  ALCint frequency = 0;
+  alcGetIntegerv(g_audio_device, ALC_FREQUENCY, 1, &frequency);
+  return frequency;
+}
+
+/// @return The output latency measured by the device, in seconds.
+// static
+double Audio::latency() {
+  if (!g_get_integer64)
+    return 0.0;
+  int64_t nanoseconds = 0;
+  g_get_integer64(g_audio_device, kDeviceLatencySoft, 1, &nanoseconds);
+  return nanoseconds * 1e-9;
+}
+
+/// @return The playback clock of the device, in seconds.
+// static
+double Audio::clock() {
+  if (!g_get_integer64)
+    return 0.0;
+  int64_t nanoseconds = 0;
+  g_get_integer64(g_audio_device, kDeviceClockSoft, 1, &nanoseconds);
+  return nanoseconds * 1e-9;
+}
+
+/// @brief Play a sound, without keeping track of it.
+/// @param buffer The sound to play. It must outlive the playback.
+/// @param volume The gain applied to the source.
+/// @param priority The sounds of higher priority steal the sources of the
+///                 lower ones.
+// static
+void Audio::PlayOneShot(const SoundBuffer& buffer, float volume, int priority) {
+  if (!buffer.buffer())
+    return;
+  SourcePool& pool = SourcePool::Get();
+  const unsigned int source = pool.source(pool.Acquire(priority));
+  if (!source)
+    return;
+  alSourcei(source, AL_BUFFER, buffer.buffer());
+  alSourcef(source, AL_GAIN, volume);
+  alSourcePlay(source);
+}
+
+/// @brief Set the position of the listener. It is applied by Update().
+// static
+void Audio::SetListenerPosition(const glm::vec3& position) {
+  g_listener.position = position;
+  g_listener_dirty = true;
+}
+
+/// @brief Set the velocity of the listener, used for the Doppler effect. It is
+/// applied by Update().
+// static
+void Audio::SetListenerVelocity(const glm::vec3& velocity) {
+  g_listener.velocity = velocity;
+  g_listener_dirty = true;
+}
+
+/// @brief Set the orientation of the listener. It is applied by Update().
+/// @param forward The direction the listener is looking at.
+/// @param up The direction of the top of its head.
+// static
+void Audio::SetListenerOrientation(const glm::vec3& forward,
+                                   const glm::vec3& up) {
+  g_listener.forward = forward;
+  g_listener.up = up;
+  g_listener_dirty = true;
+}
+
+/// @brief Send the spatial parameters modified since the last call. OpenAL
+/// applies them all at once: with AL_SOFT_deferred_updates when available, or
+/// by suspending the context.
+// static
+void Audio::Update() {
+  if (!g_audio_context)
+    return;
+
+  if (g_defer_updates)
+    g_defer_updates();
+  else
+    alcSuspendContext(g_audio_context);
+
+  if (g_listener_dirty) {
+    g_listener_dirty = false;
+    const float orientation[6] = {
+        g_listener.forward.x, g_listener.forward.y, g_listener.forward.z,
+        g_listener.up.x,      g_listener.up.y,      g_listener.up.z,
+    };
+    alListenerfv(AL_POSITION, &g_listener.position.x);
+    alListenerfv(AL_VELOCITY, &g_listener.velocity.x);
+    alListenerfv(AL_ORIENTATION, orientation);
+  }
+  SourcePool::Get().Apply();
+
+  if (g_process_updates)
+    g_process_updates();
+  else
+    alcProcessContext(g_audio_context);
+}
+
+/// @return The number of OpenAL sources of the pool.
+// static
+size_t Audio::voice_count() {
+  return SourcePool::Get().size();
 }
 
 }  // namespace smk
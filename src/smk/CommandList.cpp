@@ -0,0 +1,65 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <smk/Color.hpp>
+#include <smk/CommandList.hpp>
+#include <smk/Drawable.hpp>
+
+namespace smk {
+
+CommandList::CommandList() {
+  deferred_ = true;
+}
+
+/// @brief Build a list recording draws for |target|.
+/// @see Reset
+CommandList::CommandList(RenderTarget& target) : CommandList() {
+  Reset(target);
+}
+
+CommandList::CommandList(CommandList&& other) noexcept {
+  operator=(std::move(other));
+}
+
+CommandList& CommandList::operator=(CommandList&& other) noexcept {
+  RenderTarget::operator=(std::move(other));
+  return *this;
+}
+
+/// @brief Drop the recorded draws and prepare recording new ones for |target|.
+/// The default programs of |target| are built by the first Reset() of its
+/// OpenGL context, so that the recording threads never need one.
+/// @param target The RenderTarget the draws are for.
+void CommandList::Reset(RenderTarget& target) {
+  queue_.clear();
+  layer_ = 0;
+  deferred_ = true;
+  width_ = target.width_;
+  height_ = target.height_;
+  projection_matrix_ = target.projection_matrix_;
+  view_ = target.view_;
+  clips_ = target.clips_;
+  frustum_culling_ = target.frustum_culling_;
+  depth_sorting_ = target.depth_sorting_;
+
+  target.BuildDefaultPrograms();
+  if (!target.shader_program_.id())
+    target.SetShaderProgram(target.shader_program_2d());
+  default_programs_ = target.default_programs_;
+  shader_program_ = target.shader_program_;
+}
+
+/// @brief Record the draws of |drawable|. Can be called by any thread.
+/// @param drawable The object to be drawn.
+void CommandList::Draw(const Drawable& drawable) {
+  RenderState state;
+  state.shader_program = shader_program_;
+  state.view = glm::mat4(1.0);
+  state.color = smk::Color::White;
+  state.blend_mode = smk::BlendMode::Alpha;
+  ApplyClip(state);
+  drawable.Draw(*this, std::move(state));
+}
+
+}  // namespace smk
@@ -0,0 +1,39 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_CONTEXT_SCOPE_HPP
+#define SMK_CONTEXT_SCOPE_HPP
+
+#include <smk/OpenGL.hpp>
+
+namespace smk {
+
+// Make |context| current, and make the previous context current again when
+// going out of scope. Nothing is switched when |context| is null or already
+// current, so that the nested scopes are free.
+class ContextScope {
+ public:
+  explicit ContextScope(GLFWwindow* context)
+      : previous_(glfwGetCurrentContext()) {
+    if (!context || context == previous_)
+      return;
+    glfwMakeContextCurrent(context);
+    switched_ = true;
+  }
+
+  ~ContextScope() {
+    if (switched_)
+      glfwMakeContextCurrent(previous_);
+  }
+
+  ContextScope(const ContextScope&) = delete;
+  ContextScope& operator=(const ContextScope&) = delete;
+
+ private:
+  GLFWwindow* previous_ = nullptr;
+  bool switched_ = false;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_CONTEXT_SCOPE_HPP */
@@ -0,0 +1,470 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include "DecodedImage.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <smk/ImageDecoder.hpp>
+#include <smk/Profiler.hpp>
+#include <smk/RenderStats.hpp>
+
+#include "PixelConversion.hpp"
+#include "ResidencyTracker.hpp"
+#include "StbImage.hpp"
+#include "UnpackAlignment.hpp"
+
+namespace smk {
+extern thread_local bool g_invalidate_textures;
+extern thread_local RenderStats g_render_stats;
+
+namespace {
+
+// The texture swizzle is needed to sample GL_RED images as grey. WebGL doesn't
+// support it.
+#ifdef __EMSCRIPTEN__
+const bool kTextureSwizzle = false;
+#else
+const bool kTextureSwizzle = true;
+#endif
+
+const uint8_t kKTXIdentifier[12] = {0xAB, 'K',  'T',  'X', ' ',  '1',
+                                    '1',  0xBB, '\r', '\n', 0x1A, '\n'};
+const uint8_t kKTX2Identifier[12] = {0xAB, 'K',  'T',  'X', ' ',  '2',
+                                     '0',  0xBB, '\r', '\n', 0x1A, '\n'};
+
+uint32_t ReadU32(const uint8_t* data, size_t offset) {
+  uint32_t value;
+  std::memcpy(&value, data + offset, sizeof(value));
+  return value;
+}
+
+uint64_t ReadU64(const uint8_t* data, size_t offset) {
+  uint64_t value;
+  std::memcpy(&value, data + offset, sizeof(value));
+  return value;
+}
+
+// Whether a KTX header declares valid dimensions, and at most the complete
+// mipmap chain: floor(log2(max(width, height))) + 1 levels. Larger counts
+// would shift the dimensions by 32 bits or more.
+bool ValidLevels(int width, int height, uint32_t level_count) {
+  if (width <= 0 || height <= 0 ||
+      level_count > uint32_t(MipmapLevelCount(width, height))) {
+    std::cerr << "SMK > Invalid KTX dimensions or mipmap levels" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// The size in bytes of an uncompressed pixel. Zero when unsupported.
+size_t PixelSize(GLenum format, GLenum type) {
+  switch (type) {
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+      return 2;
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+    case GL_UNSIGNED_INT_5_9_9_9_REV:
+      return 4;
+  }
+
+  size_t component_size = 0;
+  switch (type) {
+    case GL_UNSIGNED_BYTE:
+    case GL_BYTE:
+      component_size = 1;
+      break;
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+    case GL_HALF_FLOAT:
+      component_size = 2;
+      break;
+    case GL_UNSIGNED_INT:
+    case GL_INT:
+    case GL_FLOAT:
+      component_size = 4;
+      break;
+  }
+  switch (format) {
+    case GL_RED:
+    case GL_RED_INTEGER:
+      return component_size;
+    case GL_RG:
+    case GL_RG_INTEGER:
+      return 2 * component_size;
+    case GL_RGB:
+    case GL_RGB_INTEGER:
+      return 3 * component_size;
+    case GL_RGBA:
+    case GL_RGBA_INTEGER:
+      return 4 * component_size;
+  }
+  return 0;
+}
+
+struct Format {
+  uint32_t vk_format;
+  GLenum internal_format;
+  GLenum format;  // GL_NONE for compressed formats.
+  GLenum type;
+};
+
+// The Vulkan formats used by KTX2, with their OpenGL equivalent. The
+// compressed formats are written as values, because the GLES headers don't
+// define every extension.
+// clang-format off
+const Format kFormats[] = {
+  {9, GL_R8, GL_RED, GL_UNSIGNED_BYTE},              // R8_UNORM
+  {23, GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE},           // R8G8B8_UNORM
+  {37, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE},         // R8G8B8A8_UNORM
+  {43, GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE},  // R8G8B8A8_SRGB
+  {131, 0x83F0}, {132, 0x8C4C},  // BC1_RGB
+  {133, 0x83F1}, {134, 0x8C4D},  // BC1_RGBA
+  {135, 0x83F2}, {136, 0x8C4E},  // BC2
+  {137, 0x83F3}, {138, 0x8C4F},  // BC3
+  {139, 0x8DBB}, {140, 0x8DBC},  // BC4
+  {141, 0x8DBD}, {142, 0x8DBE},  // BC5
+  {143, 0x8E8F}, {144, 0x8E8E},  // BC6H
+  {145, 0x8E8C}, {146, 0x8E8D},  // BC7
+  {147, 0x9274}, {148, 0x9275},  // ETC2_R8G8B8
+  {149, 0x9276}, {150, 0x9277},  // ETC2_R8G8B8A1
+  {151, 0x9278}, {152, 0x9279},  // ETC2_R8G8B8A8
+  {153, 0x9270}, {154, 0x9271},  // EAC_R11
+  {155, 0x9272}, {156, 0x9273},  // EAC_R11G11
+  {157, 0x93B0}, {158, 0x93D0},  // ASTC_4x4
+  {159, 0x93B1}, {160, 0x93D1},  // ASTC_5x4
+  {161, 0x93B2}, {162, 0x93D2},  // ASTC_5x5
+  {163, 0x93B3}, {164, 0x93D3},  // ASTC_6x5
+  {165, 0x93B4}, {166, 0x93D4},  // ASTC_6x6
+  {167, 0x93B5}, {168, 0x93D5},  // ASTC_8x5
+  {169, 0x93B6}, {170, 0x93D6},  // ASTC_8x6
+  {171, 0x93B7}, {172, 0x93D7},  // ASTC_8x8
+  {173, 0x93B8}, {174, 0x93D8},  // ASTC_10x5
+  {175, 0x93B9}, {176, 0x93D9},  // ASTC_10x6
+  {177, 0x93BA}, {178, 0x93DA},  // ASTC_10x8
+  {179, 0x93BB}, {180, 0x93DB},  // ASTC_10x10
+  {181, 0x93BC}, {182, 0x93DC},  // ASTC_12x10
+  {183, 0x93BD}, {184, 0x93DD},  // ASTC_12x12
+};
+// clang-format on
+
+// Whether an smk::ImageDecoder produced a consistent image.
+bool IsValid(const ImageDecoder::Image& image) {
+  return image.width > 0 && image.height > 0 && image.channels >= 1 &&
+         image.channels <= 4 &&
+         image.pixels.size() >=
+             size_t(image.width) * size_t(image.height) * image.channels;
+}
+
+}  // namespace
+
+bool DecodedImage::Decode(const std::string& filename,
+                          const Texture::Option& option) {
+  if (!file_.Open(filename)) {
+    std::cerr << "File " << filename << " not found" << std::endl;
+    return false;
+  }
+  if (Decode(file_.data(), file_.size(), option))
+    return true;
+  std::cerr << "SMK > Can't decode the image " << filename << std::endl;
+  return false;
+}
+
+bool DecodedImage::Decode(const uint8_t* data,
+                          size_t size,
+                          const Texture::Option& option) {
+  SMK_PROFILE_SCOPE("Texture::Decode");
+  data_ = data;
+  size_ = size;
+  option_ = option;
+
+  // KTX containers are uploaded as they are, from |data|.
+  if (size_ >= 12 && !std::memcmp(data_, kKTXIdentifier, 12))
+    return DecodeKTX();
+  if (size_ >= 12 && !std::memcmp(data_, kKTX2Identifier, 12))
+    return DecodeKTX2();
+
+  // The registered decoders are preferred over stb_image.
+  int comp = -1;
+  const uint8_t* decoded = nullptr;
+  if (auto decoder = ImageDecoder::Find(data_, size_)) {
+    ImageDecoder::Image image;
+    if (!decoder->Decode(data_, size_, &image) || !IsValid(image))
+      return false;
+    width_ = image.width;
+    height_ = image.height;
+    comp = image.channels;
+    image_pixels_ = std::move(image.pixels);
+    decoded = image_pixels_.data();
+  } else {
+    decoded_ = {stbi_load_from_memory(data_, int(size_), &width_, &height_,
+                                      &comp, 0),
+                stbi_image_free};
+    if (!decoded_)
+      return false;
+    decoded = decoded_.get();
+  }
+
+  // 4-channel images are uploaded directly. When allowed, the grey and RGB
+  // images are uploaded in their own format. The other ones are canonicalized
+  // to RGBA(8,8,8,8).
+  if (comp == 4) {
+    pixels_ = decoded;
+  } else if (!option.convert_to_rgba &&
+             (comp == 3 || (comp == 1 && kTextureSwizzle))) {
+    option_.internal_format = comp == 1 ? GL_R8 : GL_RGB8;
+    option_.format = comp == 1 ? GL_RED : GL_RGB;
+    grey_ = comp == 1;
+    pixels_ = decoded;
+  } else {
+    size_t count = size_t(width_) * size_t(height_);
+    converted_.resize(count * 4);
+    switch (comp) {
+      case 1:
+        GreyToRGBA(decoded, converted_.data(), count);
+        break;
+      case 2:
+        GreyAlphaToRGBA(decoded, converted_.data(), count);
+        break;
+      default:
+        RGBToRGBA(decoded, converted_.data(), count);
+        break;
+    }
+    decoded_.reset();
+    image_pixels_.clear();
+    pixels_ = converted_.data();
+  }
+  return true;
+}
+
+// See https://www.khronos.org/registry/KTX/specs/1.0/ktxspec_v1.html
+bool DecodedImage::DecodeKTX() {
+  const size_t kHeaderSize = 64;
+  if (size_ < kHeaderSize || ReadU32(data_, 12) != 0x04030201)
+    return false;
+
+  const uint32_t type = ReadU32(data_, 16);
+  const uint32_t format = ReadU32(data_, 24);
+  const uint32_t internal_format = ReadU32(data_, 28);
+  width_ = ReadU32(data_, 36);
+  height_ = std::max(1u, ReadU32(data_, 40));
+  const uint32_t depth = ReadU32(data_, 44);
+  const uint32_t array_elements = ReadU32(data_, 48);
+  const uint32_t faces = ReadU32(data_, 52);
+  const uint32_t level_count = std::max(1u, ReadU32(data_, 56));
+  const uint32_t key_value_size = ReadU32(data_, 60);
+  if (depth > 1 || array_elements > 0 || faces != 1) {
+    std::cerr << "SMK > Only 2D KTX textures are supported" << std::endl;
+    return false;
+  }
+  if (!ValidLevels(width_, height_, level_count))
+    return false;
+
+  compressed_ = type == 0;
+  option_.internal_format = internal_format;
+  option_.format = format;
+  option_.type = type;
+  unpack_alignment_ = 4;  // The KTX rows are padded to 4 bytes.
+
+  // The sizes are read from the file, and compared without overflowing.
+  if (key_value_size > size_ - kHeaderSize)
+    return false;
+  size_t offset = kHeaderSize + key_value_size;
+  for (uint32_t i = 0; i < level_count; ++i) {
+    if (size_ - offset < 4)
+      return false;
+    const size_t size = ReadU32(data_, offset);
+    offset += 4;
+    if (!AddLevel(i, offset, size))
+      return false;
+    // The padding of the last level may be missing.
+    offset += std::min((size + 3) & ~size_t(3), size_ - offset);
+  }
+  return true;
+}
+
+// See https://github.khronos.org/KTX-Specification/
+bool DecodedImage::DecodeKTX2() {
+  const size_t kHeaderSize = 80;
+  if (size_ < kHeaderSize)
+    return false;
+
+  const uint32_t vk_format = ReadU32(data_, 12);
+  width_ = ReadU32(data_, 20);
+  height_ = std::max(1u, ReadU32(data_, 24));
+  const uint32_t depth = ReadU32(data_, 28);
+  const uint32_t layers = ReadU32(data_, 32);
+  const uint32_t faces = ReadU32(data_, 36);
+  const uint32_t level_count = std::max(1u, ReadU32(data_, 40));
+  const uint32_t supercompression = ReadU32(data_, 44);
+  if (depth > 1 || layers > 0 || faces != 1) {
+    std::cerr << "SMK > Only 2D KTX2 textures are supported" << std::endl;
+    return false;
+  }
+  if (!ValidLevels(width_, height_, level_count))
+    return false;
+
+  // Basis Universal and zstd payloads would need to be transcoded first.
+  if (supercompression != 0 || vk_format == 0) {
+    std::cerr << "SMK > Supercompressed KTX2 textures are not supported"
+              << std::endl;
+    return false;
+  }
+
+  const Format* format =
+      std::find_if(std::begin(kFormats), std::end(kFormats),
+                   [&](const Format& f) { return f.vk_format == vk_format; });
+  if (format == std::end(kFormats)) {
+    std::cerr << "SMK > Unsupported KTX2 format " << vk_format << std::endl;
+    return false;
+  }
+
+  compressed_ = format->format == GL_NONE;
+  option_.internal_format = format->internal_format;
+  option_.format = format->format;
+  option_.type = format->type;
+  unpack_alignment_ = 1;
+
+  if (level_count > (size_ - kHeaderSize) / 24)
+    return false;
+  for (uint32_t i = 0; i < level_count; ++i) {
+    // The 64 bits values are checked before being narrowed to size_t.
+    const uint64_t offset = ReadU64(data_, kHeaderSize + i * 24);
+    const uint64_t size = ReadU64(data_, kHeaderSize + i * 24 + 8);
+    if (offset > size_ || size > size_ - offset)
+      return false;
+    if (!AddLevel(i, size_t(offset), size_t(size)))
+      return false;
+  }
+  return true;
+}
+
+// Add the mipmap |level|, stored in |size| bytes at |offset|. They must fit in
+// the file. An uncompressed level must hold all its pixels.
+bool DecodedImage::AddLevel(uint32_t level, size_t offset, size_t size) {
+  if (offset > size_ || size > size_ - offset)
+    return false;
+  const int width = std::max(1, width_ >> level);
+  const int height = std::max(1, height_ >> level);
+  if (!compressed_) {
+    const size_t pixel_size = PixelSize(option_.format, option_.type);
+    if (!pixel_size) {
+      std::cerr << "SMK > Unsupported KTX pixel format" << std::endl;
+      return false;
+    }
+    const size_t alignment = size_t(unpack_alignment_);
+    const size_t row = (width * pixel_size + alignment - 1) / alignment *
+                       alignment;
+    if (size / row < size_t(height)) {
+      std::cerr << "SMK > KTX mipmap level " << level << " is truncated"
+                << std::endl;
+      return false;
+    }
+  }
+  levels_.push_back({width, height, offset, size});
+  return true;
+}
+
+Texture DecodedImage::Upload() const {
+  GLuint id = 0;
+  glGenTextures(1, &id);
+  if (!Upload(id)) {
+    glDeleteTextures(1, &id);
+    return Texture();
+  }
+  return Texture::Adopt(id, width_, height_);
+}
+
+// Specify the content of the texture |id|. It is called again with the same
+// |id| when an evicted texture is reloaded.
+bool DecodedImage::Upload(GLuint id) const {
+  if (!levels_.empty())
+    return UploadLevels(id);
+
+  glBindTexture(GL_TEXTURE_2D, id);
+  {
+    UnpackAlignment alignment(1);
+    glTexImage2D(GL_TEXTURE_2D, 0, option_.internal_format, width_, height_,
+                 0, option_.format, option_.type, pixels_);
+  }
+  ++g_render_stats.texture_uploads;
+
+  // An evicted texture was reduced to a single level.
+  int levels = 1;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+  if (option_.generate_mipmap) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+    levels = MipmapLevelCount(width_, height_);
+  }
+
+  if (grey_) {
+    // Sample the grey level as (grey, grey, grey, 1).
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+  }
+  SetParameters();
+  TrackTexture(
+      id, TextureBytes(option_.internal_format, width_, height_, levels),
+      levels);
+  return true;
+}
+
+// Upload the mipmap chain of a KTX container.
+bool DecodedImage::UploadLevels(GLuint id) const {
+  while (glGetError() != GL_NO_ERROR) {
+  }
+
+  glBindTexture(GL_TEXTURE_2D, id);
+  UnpackAlignment alignment(unpack_alignment_);
+  size_t bytes = 0;
+  for (size_t i = 0; i < levels_.size(); ++i) {
+    const Level& level = levels_[i];
+    const uint8_t* data = data_ + level.offset;
+    if (compressed_) {
+      glCompressedTexImage2D(GL_TEXTURE_2D, i, option_.internal_format,
+                             level.width, level.height, 0, level.size, data);
+    } else {
+      glTexImage2D(GL_TEXTURE_2D, i, option_.internal_format, level.width,
+                   level.height, 0, option_.format, option_.type, data);
+    }
+    bytes += level.size;
+    ++g_render_stats.texture_uploads;
+  }
+
+  // The compressed textures can't generate their mipmaps.
+  int levels = int(levels_.size());
+  if (levels == 1 && option_.generate_mipmap && !compressed_) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    levels = MipmapLevelCount(width_, height_);
+    bytes = bytes * 4 / 3;
+  } else {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+  }
+  SetParameters();
+
+  if (glGetError() != GL_NO_ERROR) {
+    std::cerr << "SMK > The GPU doesn't support the texture format 0x"
+              << std::hex << option_.internal_format << std::dec << std::endl;
+    return false;
+  }
+
+  TrackTexture(id, bytes, levels);
+  return true;
+}
+
+// Assign the sampling parameters of the bound texture, and unbind it.
+void DecodedImage::SetParameters() const {
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, option_.min_filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, option_.mag_filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, option_.wrap_s);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, option_.wrap_t);
+  glBindTexture(GL_TEXTURE_2D, GL_NONE);
+  g_invalidate_textures = true;
+}
+
+}  // namespace smk
@@ -0,0 +1,75 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_DECODED_IMAGE_HPP
+#define SMK_DECODED_IMAGE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <smk/Texture.hpp>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+namespace smk {
+
+// An image file decoded in memory, in the format it will be uploaded with.
+// Decode() can run on any thread. Upload() must run on the OpenGL thread.
+//
+// The files are mapped in memory. When decoding from memory instead, |data|
+// must outlive the call to Upload().
+//
+// The registered smk::ImageDecoders are tried before stb_image. Besides the
+// formats they decode, KTX and KTX2 containers are uploaded as they are, with
+// their mipmap chain. They can contain formats compressed for the GPU (BC,
+// ETC2, ASTC).
+class DecodedImage {
+ public:
+  // Return false and display an error on failure.
+  bool Decode(const std::string& filename, const Texture::Option& option);
+  bool Decode(const uint8_t* data, size_t size, const Texture::Option& option);
+  Texture Upload() const;
+  // Replace the content of an existing texture.
+  bool Upload(GLuint id) const;
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  // The decoded pixels, in the format of the Texture::Option. Null for the KTX
+  // containers.
+  const uint8_t* pixels() const { return levels_.empty() ? pixels_ : nullptr; }
+
+ private:
+  bool DecodeKTX();
+  bool DecodeKTX2();
+  bool UploadLevels(GLuint id) const;
+  bool AddLevel(uint32_t level, size_t offset, size_t size);
+  void SetParameters() const;
+
+  std::unique_ptr<uint8_t, void (*)(void*)> decoded_ = {nullptr, nullptr};
+  std::vector<uint8_t> image_pixels_;  // Decoded by an smk::ImageDecoder.
+  std::vector<uint8_t> converted_;
+  const uint8_t* pixels_ = nullptr;
+  int width_ = 0;
+  int height_ = 0;
+  Texture::Option option_;
+  bool grey_ = false;
+
+  // KTX and KTX2 containers:
+  struct Level {
+    int width;
+    int height;
+    size_t offset;  // In |data_|.
+    size_t size;
+  };
+  MappedFile file_;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  std::vector<Level> levels_;
+  bool compressed_ = false;
+  int unpack_alignment_ = 4;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_DECODED_IMAGE_HPP */
@@ -0,0 +1,53 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_DECODED_SOUND_HPP
+#define SMK_DECODED_SOUND_HPP
+
+#include <cstdint>
+#include <smk/SoundBuffer.hpp>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+namespace nqr {
+struct AudioData;
+}  // namespace nqr
+
+namespace smk {
+
+// A sound file decoded in memory. The samples are kept as 32 bits floats when
+// OpenAL accepts them, and converted to 16 bits otherwise. Decode() can run on
+// any thread. Upload() creates the OpenAL buffer.
+//
+// With SoundBuffer::SetCacheDirectory(), the samples are stored after being
+// decoded. The next decodings map the cached file instead. The files decoded
+// from memory aren't cached.
+class DecodedSound {
+ public:
+  // Return false and display an error on failure.
+  bool Decode(const std::string& filename);
+  bool Decode(const uint8_t* data, size_t size, const std::string& extension);
+  SoundBuffer Upload() const;
+
+ private:
+  bool Assign(nqr::AudioData* fileData, const std::string& name);
+  bool LoadCache(const std::string& path);
+  void StoreCache(const std::string& path) const;
+
+  // The samples of the cache, in |cache_|.
+  MappedFile cache_;
+  const uint8_t* cached_samples_ = nullptr;
+  size_t cached_count_ = 0;
+  int cached_bits_ = 0;
+
+  std::vector<float> float_samples_;
+  std::vector<int16_t> samples_;
+  int channels_ = 0;
+  int sample_rate_ = 0;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_DECODED_SOUND_HPP */
@@ -2,108 +2,547 @@
 // Use of this source code is governed by the MIT license that can be found in
 // the LICENSE file.
 
-#include <ft2build.h>
-
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
 #include <iostream>
+#include <mutex>
 #include <smk/Font.hpp>
+#include <smk/Profiler.hpp>
+#include <thread>
 #include <vector>
-#include FT_FREETYPE_H
+
+#include "FontFace.hpp"
 
 namespace smk {
 
+namespace {
+
+constexpr float kInfinity = 1e20f;
+
+// The distance, in pixels, covered by the signed distance fields on each side
+// of the glyph outlines. Zero for the bitmap rendering.
+int DistanceFieldSpread(Font::Rendering rendering, float line_height) {
+  if (rendering != Font::Rendering::DistanceField)
+    return 0;
+  return std::max(2, int(line_height / 8.f));
+}
+
+// The squared distance transform of a 1D function, computed as the lower
+// envelope of parabolas [Felzenszwalb & Huttenlocher]. This is O(n).
+// |v| and |z| are scratch buffers of |n| and |n| + 1 elements.
+void SquaredDistance1D(const float* f, int n, float* d, int* v, float* z) {
+  int k = 0;
+  v[0] = 0;
+  z[0] = -kInfinity;
+  z[1] = kInfinity;
+  for (int q = 1; q < n; ++q) {
+    float s;
+    while (true) {
+      const int p = v[k];
+      s = ((f[q] + q * q) - (f[p] + p * p)) / float(2 * q - 2 * p);
+      if (s > z[k] || k == 0)
+        break;
+      --k;
+    }
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = kInfinity;
+  }
+  k = 0;
+  for (int q = 0; q < n; ++q) {
+    while (z[k + 1] < q)
+      ++k;
+    d[q] = float((q - v[k]) * (q - v[k])) + f[v[k]];
+  }
+}
+
+// The squared distance from every pixels to the nearest pixel where
+// |grid| is 0. The other pixels must be kInfinity.
+void SquaredDistance2D(std::vector<float>& grid, int width, int height) {
+  const int n = std::max(width, height);
+  std::vector<float> f(n), d(n), z(n + 1);
+  std::vector<int> v(n);
+  for (int x = 0; x < width; ++x) {
+    for (int y = 0; y < height; ++y)
+      f[y] = grid[x + y * width];
+    SquaredDistance1D(f.data(), height, d.data(), v.data(), z.data());
+    for (int y = 0; y < height; ++y)
+      grid[x + y * width] = d[y];
+  }
+  for (int y = 0; y < height; ++y) {
+    float* row = &grid[y * width];
+    SquaredDistance1D(row, width, d.data(), v.data(), z.data());
+    std::copy(d.begin(), d.begin() + width, row);
+  }
+}
+
+}  // namespace
+
+// A glyph rasterized by FreeType, not yet added to the atlas.
+struct Font::Bitmap {
+  wchar_t character = 0;
+  bool valid = false;
+  glm::ivec2 size = {0, 0};
+  glm::ivec2 bearing = {0, 0};
+  float advance = 0.f;
+  std::vector<uint8_t> pixels;  // One channel, 8 bits per pixel.
+
+  // The caller must hold the face's lock and have selected the pixel size.
+  // When |spread| isn't zero, a signed distance field is produced instead of
+  // the coverage, with |spread| pixels of margin.
+  void Load(FT_Face face, wchar_t c, int spread) {
+    character = c;
+    if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
+      std::wcout << L"SMK > FreeType: Failed to load Glyph: \"" << c << "\""
+                 << std::endl;
+      return;
+    }
+
+    valid = true;
+    size = {int(face->glyph->bitmap.width), int(face->glyph->bitmap.rows)};
+    bearing = {+face->glyph->bitmap_left, -face->glyph->bitmap_top};
+    advance = face->glyph->advance.x / (64.0f);
+
+    // The coverage is kept as is. The rows are only made contiguous.
+    const FT_Bitmap& bitmap = face->glyph->bitmap;
+    pixels.resize(size.x * size.y);
+    for (int y = 0; y < size.y; ++y) {
+      std::memcpy(pixels.data() + y * size.x, bitmap.buffer + y * bitmap.pitch,
+                  size.x);
+    }
+
+    if (spread && size.x && size.y)
+      LoadDistanceField(spread);
+  }
+
+  // Replace the coverage by 0.5 on the outline, decreasing outward and
+  // increasing inward by 0.5 every |spread| pixels.
+  void LoadDistanceField(int spread) {
+    const uint8_t* coverage = pixels.data();
+    const int width = size.x + 2 * spread;
+    const int height = size.y + 2 * spread;
+    std::vector<float> outside(width * height, 0.f);
+    std::vector<float> inside(width * height, kInfinity);
+    for (int y = 0; y < size.y; ++y) {
+      for (int x = 0; x < size.x; ++x) {
+        if (coverage[x + y * size.x] < 128)
+          continue;
+        const int i = (x + spread) + (y + spread) * width;
+        outside[i] = kInfinity;
+        inside[i] = 0.f;
+      }
+    }
+    // |outside| is the distance of the inner pixels to the outside, and
+    // conversely.
+    SquaredDistance2D(outside, width, height);
+    SquaredDistance2D(inside, width, height);
+
+    std::vector<uint8_t> field(width * height);
+    for (int i = 0; i < width * height; ++i) {
+      // The edge is half a pixel away from the pixel centers.
+      const float distance = inside[i] != 0.f ? std::sqrt(inside[i]) - 0.5f
+                                              : 0.5f - std::sqrt(outside[i]);
+      const float value = 0.5f - distance / (2.f * spread);
+      field[i] = uint8_t(255.f * std::min(1.f, std::max(0.f, value)));
+    }
+    pixels = std::move(field);
+    size = {width, height};
+    bearing -= glm::ivec2(spread, spread);
+  }
+};
+
+// Rasterize the requested glyphs in a separate thread.
+struct Font::Worker {
+  Worker(std::shared_ptr<FontFace> face, float line_height, int spread)
+      : face_(std::move(face)),
+        line_height_(line_height),
+        spread_(spread),
+        thread_(&Worker::Run, this) {}
+
+  ~Worker() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    condition_.notify_one();
+    thread_.join();
+  }
+
+  void Request(wchar_t character) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests_.push_back(character);
+    }
+    condition_.notify_one();
+  }
+
+  std::vector<Bitmap> TakeResults() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::move(results_);
+  }
+
+ private:
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      condition_.wait(lock, [&] { return stop_ || !requests_.empty(); });
+      if (stop_)
+        return;
+      const wchar_t character = requests_.front();
+      requests_.pop_front();
+      lock.unlock();
+
+      Bitmap bitmap;
+      {
+        std::lock_guard<std::mutex> face_lock(face_->mutex());
+        face_->SetPixelSize(line_height_);
+        bitmap.Load(face_->face(), character, spread_);
+      }
+
+      lock.lock();
+      results_.push_back(std::move(bitmap));
+    }
+  }
+
+  std::shared_ptr<FontFace> face_;
+  float line_height_;
+  int spread_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<wchar_t> requests_;
+  std::vector<Bitmap> results_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+namespace {
+
+// Choose the atlas page dimension, so that the Latin-1 glyphs preloaded by the
+// Font fit in one or two pages.
+int PageSize(float line_height) {
+  int size = 256;
+  while (size < 16 * line_height && size < 2048)
+    size *= 2;
+  return size;
+}
+
+// The glyphs are stored in a single channel, a quarter of the RGBA size. The
+// text shaders read the coverage from the red channel.
+Texture::Option AtlasOption() {
+  Texture::Option option;
+  option.generate_mipmap = false;
+  option.min_filter = GL_LINEAR;
+  option.mag_filter = GL_LINEAR;
+  option.internal_format = GL_R8;
+  option.format = GL_RED;
+  return option;
+}
+
+// Used in the lookup tables to remember the characters the font can't provide,
+// so that they aren't loaded again.
+Font::Glyph* MissingGlyph() {
+  static Font::Glyph missing;
+  return &missing;
+}
+
+// Used in the lookup tables for the characters being rasterized by the worker.
+Font::Glyph* PendingGlyph() {
+  static Font::Glyph pending;
+  return &pending;
+}
+
+// The characters rasterized by the Font constructors. They can run on the
+// AssetLoader threads.
+std::mutex g_preloaded_mutex;
+std::wstring& PreloadedCharacters() {
+  static std::wstring characters = [] {
+    std::wstring latin1(256, L'\0');
+    for (size_t i = 0; i < latin1.size(); ++i)
+      latin1[i] = wchar_t(i);
+    return latin1;
+  }();
+  return characters;
+}
+
+}  // namespace
+
+Font::Font() = default;
+Font::~Font() = default;
+Font::Font(Font&& other) noexcept {
+  operator=(std::move(other));
+}
+
+Font::Glyph*& Font::GlyphEntry(wchar_t character) {
+  if (size_t(character) < kLatin1Size)
+    return latin1_glyphs_[character];
+  return other_glyphs_[character];
+}
+
 Font::Glyph* Font::FetchGlyph(wchar_t in) {
   // Load from cache.
-  {
-    auto character = glyphs_.find(in);
-    if (character != glyphs_.end())
-      return character->second.get();
-  }
+  Glyph*& glyph = GlyphEntry(in);
 
   // Load from file.
-  if (line_height_) {
-    LoadGlyphs({in});
-    auto character = glyphs_.find(in);
-    if (character != glyphs_.end())
-      return character->second.get();
+  if (!glyph && line_height_) {
+    if (worker_) {
+      glyph = PendingGlyph();
+      worker_->Request(in);
+    } else {
+      LoadGlyphs({in});
+    }
   }
 
   // Fallback.
-  return nullptr;
+  if (glyph == MissingGlyph() || glyph == PendingGlyph())
+    return nullptr;
+  return glyph;
 }
 
-void Font::operator=(Font&& other) noexcept {
-  glyphs_.insert(std::make_move_iterator(begin(other.glyphs_)),
-                 std::make_move_iterator(end(other.glyphs_)));
-  filename_ = other.filename_;
-  line_height_ = other.line_height_;
-  baseline_position_ = other.baseline_position_;
+/// Choose the characters rasterized by the Fonts created afterward.
+/// @param characters The characters. Empty to rasterize every glyphs on first
+///                   use.
+// static
+void Font::SetPreloadedCharacters(const std::wstring& characters) {
+  std::lock_guard<std::mutex> lock(g_preloaded_mutex);
+  PreloadedCharacters() = characters;
 }
 
-Font::Font(const std::string& filename, float line_height)
-    : filename_(filename), line_height_(line_height) {
-  std::vector<wchar_t> preloaded_characters;
-  for (wchar_t c = 0; c < 256; ++c)
-    preloaded_characters.push_back(c);
-  LoadGlyphs(preloaded_characters);
+/// Rasterize the glyphs of some characters into the atlas, if not already. In
+/// asynchronous mode, they are requested to the worker thread.
+/// @param characters The characters.
+void Font::Preload(const std::wstring& characters) {
+  if (!line_height_)
+    return;
+
+  std::vector<wchar_t> missing;
+  for (wchar_t character : characters) {
+    Glyph*& glyph = GlyphEntry(character);
+    if (glyph)
+      continue;
+    if (worker_) {
+      glyph = PendingGlyph();
+      worker_->Request(character);
+    } else {
+      glyph = MissingGlyph();  // Skip the duplicates.
+      missing.push_back(character);
+    }
+  }
+  LoadGlyphs(missing);
 }
 
-void Font::LoadGlyphs(const std::vector<wchar_t>& chars) {
-  FT_Library ft;
-  if (FT_Init_FreeType(&ft)) {
-    std::cerr << "SMK > FreeType: Could not init FreeType Library" << std::endl;
+/// Choose whether the missing glyphs are rasterized in a worker thread.
+/// @param asynchronous True to use a worker thread, false to rasterize the
+///                     glyphs immediately in FetchGlyph().
+void Font::SetAsynchronous(bool asynchronous) {
+  if (asynchronous == bool(worker_))
+    return;
+
+  if (asynchronous) {
+#if defined __EMSCRIPTEN__ && !defined __EMSCRIPTEN_PTHREADS__
+    return;  // No threads available.
+#endif
+    if (face_)
+      worker_ = std::make_unique<Worker>(
+          face_, line_height_, DistanceFieldSpread(rendering_, line_height_));
+    return;
   }
 
-  FT_Face face;
-  if (FT_New_Face(ft, filename_.c_str(), 0, &face)) {
-    std::cerr << "SMK > FreeType: Failed to load" << filename_ << std::endl;
+  Update();
+  worker_.reset();
+
+  // The glyphs not rasterized yet will be loaded again synchronously.
+  for (auto& it : latin1_glyphs_) {
+    if (it == PendingGlyph())
+      it = nullptr;
   }
+  for (auto& it : other_glyphs_) {
+    if (it.second == PendingGlyph())
+      it.second = nullptr;
+  }
+}
+
+/// Upload into the atlas the glyphs rasterized by the worker thread since the
+/// last call. This must be called from the OpenGL thread, typically once per
+/// frame. Text::Draw() calls it.
+void Font::Update() {
+  if (!worker_)
+    return;
+
+  std::vector<Bitmap> bitmaps = worker_->TakeResults();
+  if (bitmaps.empty())
+    return;
+
+  for (const auto& bitmap : bitmaps)
+    AddGlyph(bitmap);
+}
+
+void Font::operator=(Font&& other) noexcept {
+  std::swap(atlas_, other.atlas_);
+  std::swap(glyphs_, other.glyphs_);
+  std::swap(latin1_glyphs_, other.latin1_glyphs_);
+  std::swap(other_glyphs_, other.other_glyphs_);
+  std::swap(face_, other.face_);
+  std::swap(worker_, other.worker_);
+  std::swap(generation_, other.generation_);
+  std::swap(filename_, other.filename_);
+  std::swap(line_height_, other.line_height_);
+  std::swap(rendering_, other.rendering_);
+  std::swap(baseline_position_, other.baseline_position_);
+}
+
+/// Load a font from a file.
+/// @param filename The path to the font file.
+/// @param line_height The size of the font, in pixels.
+/// @param rendering How the glyphs are rasterized.
+Font::Font(const std::string& filename, float line_height, Rendering rendering)
+    : face_(FontFace::FromFile(filename)),
+      filename_(filename),
+      line_height_(line_height),
+      rendering_(rendering) {
+  Init();
+}
+
+/// Load a font from a file already loaded in memory. Fonts created from the
+/// same buffer share a single parsed face, whatever their size.
+/// @param data The content of the font file. It isn't copied and must outlive
+///             the Font.
+/// @param size The size of |data| in bytes.
+/// @param line_height The size of the font, in pixels.
+/// @param rendering How the glyphs are rasterized.
+Font::Font(const uint8_t* data,
+           size_t size,
+           float line_height,
+           Rendering rendering)
+    : face_(FontFace::FromMemory(data, size)),
+      line_height_(line_height),
+      rendering_(rendering) {
+  Init();
+}
 
+void Font::Init() {
+  if (!face_)
+    return;
+  InitAtlas(PreloadedBitmaps(*face_, line_height_, rendering_));
+}
+
+// static
+std::function<Font()> Font::Prepare(const std::string& filename,
+                                    float line_height,
+                                    Rendering rendering) {
+  auto face = FontFace::FromFile(filename);
+  auto bitmaps = std::make_shared<std::vector<Bitmap>>();
+  if (face)
+    *bitmaps = PreloadedBitmaps(*face, line_height, rendering);
+
+  return [face, bitmaps, filename, line_height, rendering] {
+    Font font;
+    font.face_ = face;
+    font.filename_ = filename;
+    font.line_height_ = line_height;
+    font.rendering_ = rendering;
+    if (face)
+      font.InitAtlas(std::move(*bitmaps));
+    return font;
+  };
+}
+
+// Rasterize the glyphs chosen by SetPreloadedCharacters().
+// static
+std::vector<Font::Bitmap> Font::PreloadedBitmaps(FontFace& face,
+                                                 float line_height,
+                                                 Rendering rendering) {
+  std::wstring characters;
+  {
+    std::lock_guard<std::mutex> lock(g_preloaded_mutex);
+    characters = PreloadedCharacters();
+  }
+
+  const int spread = DistanceFieldSpread(rendering, line_height);
+  std::vector<Bitmap> bitmaps(characters.size());
+  std::lock_guard<std::mutex> lock(face.mutex());
+  face.SetPixelSize(line_height);
+  for (size_t i = 0; i < characters.size(); ++i)
+    bitmaps[i].Load(face.face(), characters[i], spread);
+  return bitmaps;
+}
+
+// Create the atlas and add the preloaded glyphs. Must run on the OpenGL
+// thread.
+void Font::InitAtlas(std::vector<Bitmap> bitmaps) {
+  const int page_size = PageSize(line_height_);
+  atlas_ = TextureAtlas(page_size, page_size, AtlasOption());
+
+  FT_Face face = face_->face();
   baseline_position_ =
       line_height_ *
       ((float(face->ascender) / (face->ascender - face->descender)));
-  FT_Set_Pixel_Sizes(face, line_height_, line_height_);
-  if (FT_Load_Char(face, 'X', FT_LOAD_RENDER)) {
-    std::cerr << "ERROR::FREETYTPE: Failed to load Glyph for file " << filename_
-              << std::endl;
-  }
 
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);  // Disable byte-alignment restriction
+  for (const auto& bitmap : bitmaps)
+    AddGlyph(bitmap);
+}
 
-  for (auto c : chars) {
-    // Load character glyph
-    if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-      std::wcout << L"SMK > FreeType: Failed to load Glyph: \"" << c << "\""
-                 << std::endl;
-      continue;
-    }
+void Font::LoadGlyphs(const std::vector<wchar_t>& chars) {
+  if (!face_ || chars.empty())
+    return;
+  SMK_PROFILE_SCOPE("Font::LoadGlyphs");
 
-    int width = face->glyph->bitmap.width;
-    int height = face->glyph->bitmap.rows;
-    auto character = std::make_unique<Glyph>();
-    character->bearing =
-        glm::ivec2(+face->glyph->bitmap_left, -face->glyph->bitmap_top);
-    character->advance = face->glyph->advance.x / (64.0f);
+  std::vector<Bitmap> bitmaps(chars.size());
+  {
+    // The face is shared with the Fonts of other sizes and their workers.
+    std::lock_guard<std::mutex> lock(face_->mutex());
+    face_->SetPixelSize(line_height_);
+    const int spread = DistanceFieldSpread(rendering_, line_height_);
+    for (size_t i = 0; i < chars.size(); ++i)
+      bitmaps[i].Load(face_->face(), chars[i], spread);
+  }
 
-    if (width * height != 0) {
-      std::vector<uint8_t> buffer_rgba(width * height * 4);
-      {
-        int j = 0;
-        for (int i = 0; i < width * height; ++i) {
-          const uint8_t v = face->glyph->bitmap.buffer[i];
-          buffer_rgba[j++] = 255;
-          buffer_rgba[j++] = 255;
-          buffer_rgba[j++] = 255;
-          buffer_rgba[j++] = v;
-        }
-      }
-      character->texture = smk::Texture(buffer_rgba.data(), width, height);
-    }
+  for (const auto& bitmap : bitmaps)
+    AddGlyph(bitmap);
+}
+
+// Store a rasterized glyph into the atlas and the lookup tables.
+void Font::AddGlyph(const Bitmap& bitmap) {
+  Glyph*& entry = GlyphEntry(bitmap.character);
+  entry = MissingGlyph();
+  if (!bitmap.valid)
+    return;
 
-    glyphs_[c] = std::move(character);
+  Glyph glyph;
+  glyph.bearing = bitmap.bearing;
+  glyph.advance = bitmap.advance;
+  if (bitmap.size.x * bitmap.size.y != 0 &&
+      !AddToAtlas(bitmap.size.x, bitmap.size.y, bitmap.pixels.data(), &glyph)) {
+    return;
   }
 
-  FT_Done_Face(face);
-  FT_Done_FreeType(ft);
+  glyphs_.push_back(std::move(glyph));
+  entry = &glyphs_.back();
+  ++generation_;
+}
+
+// Copy a glyph bitmap into the atlas.
+bool Font::AddToAtlas(int width,
+                      int height,
+                      const uint8_t* pixels,
+                      Glyph* glyph) {
+  TextureAtlas::Region region = atlas_.Add(pixels, width, height);
+  if (!region.texture)
+    return false;
+
+  const float page_width = region.texture.width();
+  const float page_height = region.texture.height();
+  glyph->texture = region.texture;
+  glyph->size = {width, height};
+  glyph->texture_rectangle = {
+      region.rectangle.left / page_width,
+      region.rectangle.top / page_height,
+      region.rectangle.right / page_width,
+      region.rectangle.bottom / page_height,
+  };
+  return true;
 }
 
 }  // namespace smk
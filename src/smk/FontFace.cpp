@@ -0,0 +1,119 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include "FontFace.hpp"
+
+#include <iostream>
+#include <map>
+#include <mutex>
+
+namespace smk {
+
+namespace {
+
+// Faces can be created from several threads, see AssetLoader. This guards the
+// caches and the FreeType library. It is recursive, because a face released
+// while creating an other one locks it again.
+std::recursive_mutex& Mutex() {
+  static std::recursive_mutex mutex;
+  return mutex;
+}
+
+// The FreeType library is initialized once, and released when the last face
+// using it is destroyed.
+std::shared_ptr<FT_LibraryRec_> Library() {
+  static std::weak_ptr<FT_LibraryRec_> cache;
+  if (auto library = cache.lock())
+    return library;
+
+  FT_Library ft;
+  if (FT_Init_FreeType(&ft)) {
+    std::cerr << "SMK > FreeType: Could not init FreeType Library" << std::endl;
+    return nullptr;
+  }
+
+  auto library = std::shared_ptr<FT_LibraryRec_>(ft, FT_Done_FreeType);
+  cache = library;
+  return library;
+}
+
+std::map<std::string, std::weak_ptr<FontFace>> g_file_faces;
+std::map<const uint8_t*, std::weak_ptr<FontFace>> g_memory_faces;
+
+}  // namespace
+
+/// Return the face parsed from a file. The file is read only once, even when
+/// used by several Fonts.
+/// @param filename The path to the font file.
+// static
+std::shared_ptr<FontFace> FontFace::FromFile(const std::string& filename) {
+  std::lock_guard<std::recursive_mutex> lock(Mutex());
+  auto it = g_file_faces.find(filename);
+  if (it != g_file_faces.end()) {
+    if (auto face = it->second.lock())
+      return face;
+    // The face expired. It is only cached again once loaded successfully.
+    g_file_faces.erase(it);
+  }
+
+  auto face = std::shared_ptr<FontFace>(new FontFace());
+  face->library_ = Library();
+  if (!face->library_)
+    return nullptr;
+
+  if (FT_New_Face(face->library_.get(), filename.c_str(), 0, &face->face_)) {
+    std::cerr << "SMK > FreeType: Failed to load " << filename << std::endl;
+    return nullptr;
+  }
+
+  g_file_faces[filename] = face;
+  return face;
+}
+
+/// Return the face parsed from a font file loaded in memory. The buffer is
+/// parsed only once, even when used by several Fonts.
+/// @param data The font file content. It must outlive the face.
+/// @param size The size of |data| in bytes.
+// static
+std::shared_ptr<FontFace> FontFace::FromMemory(const uint8_t* data,
+                                               size_t size) {
+  std::lock_guard<std::recursive_mutex> lock(Mutex());
+  auto it = g_memory_faces.find(data);
+  if (it != g_memory_faces.end()) {
+    if (auto face = it->second.lock())
+      return face;
+    // The face expired. It is only cached again once loaded successfully.
+    g_memory_faces.erase(it);
+  }
+
+  auto face = std::shared_ptr<FontFace>(new FontFace());
+  face->library_ = Library();
+  if (!face->library_)
+    return nullptr;
+
+  if (FT_New_Memory_Face(face->library_.get(), data, FT_Long(size), 0,
+                         &face->face_)) {
+    std::cerr << "SMK > FreeType: Failed to load font from memory"
+              << std::endl;
+    return nullptr;
+  }
+
+  g_memory_faces[data] = face;
+  return face;
+}
+
+FontFace::~FontFace() {
+  std::lock_guard<std::recursive_mutex> lock(Mutex());
+  if (face_)
+    FT_Done_Face(face_);
+}
+
+void FontFace::SetPixelSize(float line_height) {
+  if (pixel_size_ == line_height)
+    return;
+  pixel_size_ = line_height;
+  FT_Set_Pixel_Sizes(face_, FT_UInt(line_height), FT_UInt(line_height));
+}
+
+}  // namespace smk
@@ -0,0 +1,52 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_FONT_FACE_HPP
+#define SMK_FONT_FACE_HPP
+
+#include <ft2build.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include FT_FREETYPE_H
+
+namespace smk {
+
+// A parsed FreeType face. It is shared by every Fonts using the same file or
+// the same memory buffer, whatever their size. Faces can be created and
+// released from any thread.
+class FontFace {
+ public:
+  // Return nullptr on failure.
+  static std::shared_ptr<FontFace> FromFile(const std::string& filename);
+  // The |data| isn't copied. It must outlive the returned FontFace.
+  static std::shared_ptr<FontFace> FromMemory(const uint8_t* data, size_t size);
+
+  ~FontFace();
+
+  // Select the size of the glyphs rasterized next. The face is shared, so this
+  // must be called before loading glyphs.
+  void SetPixelSize(float line_height);
+
+  FT_Face face() const { return face_; }
+
+  // FreeType faces aren't thread-safe. Lock this while using the face.
+  std::mutex& mutex() { return mutex_; }
+
+  FontFace(const FontFace&) = delete;
+  void operator=(const FontFace&) = delete;
+
+ private:
+  FontFace() = default;
+
+  std::shared_ptr<FT_LibraryRec_> library_;
+  FT_Face face_ = nullptr;
+  float pixel_size_ = 0.f;
+  std::mutex mutex_;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_FONT_FACE_HPP */
@@ -0,0 +1,74 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <smk/FrameArena.hpp>
+
+namespace smk {
+
+namespace {
+
+const size_t kMinimumBlockSize = 64 * 1024;
+
+}  // namespace
+
+// static
+FrameArena& FrameArena::Get() {
+  thread_local FrameArena arena;
+  return arena;
+}
+
+/// @brief Release the allocations of the calling thread's arena. The other
+/// threads reset theirs explicitly.
+// static
+void FrameArena::NewFrame() {
+  Get().Reset();
+}
+
+/// @brief Allocate memory valid until the end of the frame.
+/// @param size The number of bytes.
+/// @param alignment The alignment of the returned address. A power of two.
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+  if (!blocks_.empty()) {
+    Block& block = blocks_.back();
+    uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+    uintptr_t address = (base + offset_ + alignment - 1) & ~(alignment - 1);
+    if (address + size <= base + block.size) {
+      used_ += address + size - (base + offset_);
+      offset_ = address + size - base;
+      return reinterpret_cast<void*>(address);
+    }
+  }
+
+  // The previous blocks are kept until the end of the frame.
+  const size_t block_size =
+      std::max({kMinimumBlockSize, size + alignment, 2 * capacity()});
+  blocks_.push_back({std::unique_ptr<uint8_t[]>(new uint8_t[block_size]),
+                     block_size});
+  offset_ = 0;
+  return Allocate(size, alignment);
+}
+
+/// @brief The number of bytes reserved by the arena.
+size_t FrameArena::capacity() const {
+  size_t capacity = 0;
+  for (const Block& block : blocks_)
+    capacity += block.size;
+  return capacity;
+}
+
+/// @brief Release every allocation at once. Only the largest block is kept,
+/// so that the next frames fit in a single one. The allocations must not be
+/// used anymore.
+void FrameArena::Reset() {
+  if (blocks_.size() > 1) {
+    Block last = std::move(blocks_.back());
+    blocks_.clear();
+    blocks_.push_back(std::move(last));
+  }
+  offset_ = 0;
+  used_ = 0;
+}
+
+}  // namespace smk
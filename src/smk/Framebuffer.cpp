@@ -2,27 +2,42 @@
 // Use of this source code is governed by the MIT license that can be found in
 // the LICENSE file.
 
+#include <algorithm>
 #include <smk/Color.hpp>
 #include <smk/Drawable.hpp>
 #include <smk/Framebuffer.hpp>
 #include <smk/RenderState.hpp>
 
+#include "ContextScope.hpp"
+#include "ResidencyTracker.hpp"
+
 namespace smk {
 
 /// @brief Construct a Framebuffer of a given dimensions.
 /// @param width The width of the drawing surface.
 /// @param height The width of the drawing surface.
-Framebuffer::Framebuffer(int width, int height) {
-  Texture::Option option;
-  option.internal_format = GL_RGB;
-  option.format = GL_RGB;
-  option.type = GL_UNSIGNED_BYTE;
-  option.generate_mipmap = false;
-  option.min_filter = GL_LINEAR;
-  option.mag_filter = GL_LINEAR;
-  color_textures_.push_back(smk::Texture(nullptr, width, height, option));
-
-  Init();
+Framebuffer::Framebuffer(int width, int height)
+    : Framebuffer(width, height, Option()) {}
+
+/// @brief Construct a Framebuffer of a given dimensions.
+/// @param width The width of the drawing surface.
+/// @param height The width of the drawing surface.
+/// @param option Additionnal option (depth-stencil buffer, ...)
+Framebuffer::Framebuffer(int width, int height, const Option& option) {
+  // The multisampled content is resolved into the texture. Both must use the
+  // same format.
+  const bool multisample = option.samples > 1;
+  Texture::Option texture_option;
+  texture_option.internal_format = multisample ? GL_RGBA8 : GL_RGB;
+  texture_option.format = multisample ? GL_RGBA : GL_RGB;
+  texture_option.type = GL_UNSIGNED_BYTE;
+  texture_option.generate_mipmap = false;
+  texture_option.min_filter = GL_LINEAR;
+  texture_option.mag_filter = GL_LINEAR;
+  color_textures_.push_back(
+      smk::Texture(nullptr, width, height, texture_option));
+
+  Init(option);
 }
 
 /// @brief Construct a Framebuffer from a list of color textures. Those textures
@@ -31,54 +46,126 @@ Framebuffer::Framebuffer(int width, int height) {
 /// @param width The width of the drawing surface.
 /// @param height The width of the drawing surface.
 Framebuffer::Framebuffer(std::vector<Texture> color_textures)
+    : Framebuffer(std::move(color_textures), Option()) {}
+
+/// @brief Construct a Framebuffer from a list of color textures.
+/// @param color_textures The textures to draw into. See above.
+/// @param option Additionnal option (depth-stencil buffer, ...)
+Framebuffer::Framebuffer(std::vector<Texture> color_textures,
+                         const Option& option)
     : color_textures_(std::move(color_textures)) {
-  Init();
+  Init(option);
 }
 
-void Framebuffer::Init() {
+void Framebuffer::Init(const Option& option) {
   width_ = color_texture().width();
   height_ = color_texture().height();
+  color_attachment_count_ = color_textures_.size();
+
+  if (option.samples > 1) {
+    GLint max_samples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+    samples_ = std::min(option.samples, int(max_samples));
+  }
 
   // The frame buffer.
   glGenFramebuffers(1, &frame_buffer_);
   glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
 
-  // Attach the textures to the framebuffer.
-  for (size_t i = 0; i < color_textures_.size(); ++i) {
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
-                           GL_TEXTURE_2D, color_textures_[i].id(), 0);
+  if (samples_ > 1) {
+    // Draw into multisampled render buffers.
+    color_render_buffers_.resize(color_textures_.size());
+    glGenRenderbuffers(color_render_buffers_.size(),
+                       color_render_buffers_.data());
+    for (size_t i = 0; i < color_render_buffers_.size(); ++i) {
+      glBindRenderbuffer(GL_RENDERBUFFER, color_render_buffers_[i]);
+      glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples_, GL_RGBA8,
+                                       width_, height_);
+      TrackRenderBuffer(color_render_buffers_[i],
+                        size_t(width_) * size_t(height_) * 4 * samples_);
+      glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
+                                GL_RENDERBUFFER, color_render_buffers_[i]);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  } else {
+    // Attach the textures to the framebuffer.
+    for (size_t i = 0; i < color_textures_.size(); ++i) {
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
+                             GL_TEXTURE_2D, color_textures_[i].id(), 0);
+    }
   }
 
-  // The render buffer.
-  glGenRenderbuffers(1, &render_buffer_);
-  glBindRenderbuffer(GL_RENDERBUFFER, render_buffer_);
-  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width_, height_);
-  glBindRenderbuffer(GL_RENDERBUFFER, 0);
-
-  // Attach it to the framebuffer.
-  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
-                            GL_RENDERBUFFER, render_buffer_);
+  // The depth-stencil render buffer.
+  if (option.depth_stencil) {
+    glGenRenderbuffers(1, &render_buffer_);
+    glBindRenderbuffer(GL_RENDERBUFFER, render_buffer_);
+    if (samples_ > 1) {
+      glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples_,
+                                       GL_DEPTH24_STENCIL8, width_, height_);
+    } else {
+      glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width_,
+                            height_);
+    }
+    TrackRenderBuffer(render_buffer_, size_t(width_) * size_t(height_) * 4 *
+                                          std::max(1, samples_));
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // Attach it to the framebuffer.
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                              GL_RENDERBUFFER, render_buffer_);
+  }
 
   if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
     std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!"
               << std::endl;
   }
 
+  // The frame buffer the multisampled content is resolved into.
+  if (samples_ > 1) {
+    glGenFramebuffers(1, &resolve_frame_buffer_);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolve_frame_buffer_);
+    for (size_t i = 0; i < color_textures_.size(); ++i) {
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
+                             GL_TEXTURE_2D, color_textures_[i].id(), 0);
+    }
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      std::cout << "ERROR::FRAMEBUFFER:: Resolve framebuffer is not complete!"
+                << std::endl;
+    }
+  }
+
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
   InitRenderTarget();
 }
 
 Framebuffer::~Framebuffer() {
+  // The framebuffer objects must be deleted by the context owning them.
+  ContextScope context(context_);
+
   if (frame_buffer_) {
     glDeleteFramebuffers(1, &frame_buffer_);
     frame_buffer_ = 0;
   }
 
   if (render_buffer_) {
+    UntrackRenderBuffer(render_buffer_);
     glDeleteRenderbuffers(1, &render_buffer_);
     render_buffer_ = 0;
   }
+
+  if (resolve_frame_buffer_) {
+    glDeleteFramebuffers(1, &resolve_frame_buffer_);
+    resolve_frame_buffer_ = 0;
+  }
+
+  if (!color_render_buffers_.empty()) {
+    for (GLuint render_buffer : color_render_buffers_)
+      UntrackRenderBuffer(render_buffer);
+    glDeleteRenderbuffers(color_render_buffers_.size(),
+                          color_render_buffers_.data());
+    color_render_buffers_.clear();
+  }
 }
 
 Framebuffer::Framebuffer(Framebuffer&& other) noexcept {
@@ -89,10 +176,43 @@ void Framebuffer::operator=(Framebuffer&& other) noexcept {
   RenderTarget::operator=(std::move(other));
   std::swap(color_textures_, other.color_textures_);
   std::swap(render_buffer_, other.render_buffer_);
+  std::swap(samples_, other.samples_);
+  std::swap(resolve_frame_buffer_, other.resolve_frame_buffer_);
+  std::swap(color_render_buffers_, other.color_render_buffers_);
 }
 
 smk::Texture& Framebuffer::color_texture() {
   return color_textures_[0];
 }
 
+/// @brief Copy the multisampled content into the color textures. Must be
+/// called before reading them, for instance before drawing a smk::Sprite of
+/// this Framebuffer.
+void Framebuffer::Resolve() {
+  if (!resolve_frame_buffer_)
+    return;
+  Flush();
+  ContextScope context(recording_ ? nullptr : context_);
+  Bind(this);
+
+  DisableClipBound();  // The scissor test applies to the blits.
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, frame_buffer_);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolve_frame_buffer_);
+  std::vector<GLenum> draw_buffers;
+  for (size_t i = 0; i < color_textures_.size(); ++i) {
+    // The attachment i is copied into the attachment i.
+    draw_buffers.assign(i + 1, GL_NONE);
+    draw_buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    glReadBuffer(GL_COLOR_ATTACHMENT0 + i);
+    glDrawBuffers(draw_buffers.size(), draw_buffers.data());
+    glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  }
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+  // Restore the binding expected by RenderTarget::Bind().
+  glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
+  Bind(this);
+}
+
 }  // namespace smk
@@ -0,0 +1,57 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <smk/Frustum.hpp>
+
+namespace smk {
+
+/// @brief Extract the planes of the frustum of a projection matrix.
+/// @param matrix The projection, optionally multiplied by a view.
+Frustum::Frustum(const glm::mat4& matrix) {
+  // The rows of |matrix|. A point is visible when -w <= x,y,z <= w in the clip
+  // space.
+  glm::vec4 row[4];
+  for (int i = 0; i < 4; ++i)
+    row[i] = {matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]};
+
+  planes_[0] = row[3] + row[0];
+  planes_[1] = row[3] - row[0];
+  planes_[2] = row[3] + row[1];
+  planes_[3] = row[3] - row[1];
+  planes_[4] = row[3] + row[2];
+  planes_[5] = row[3] - row[2];
+  for (glm::vec4& plane : planes_) {
+    float length = glm::length(glm::vec3(plane));
+    if (length > 0.f)
+      plane *= 1.f / length;
+  }
+}
+
+/// @brief Whether an axis aligned box may be visible.
+bool Frustum::Intersects(const BoundingBox& box) const {
+  if (box.empty())
+    return false;
+  for (const glm::vec4& plane : planes_) {
+    // The corner the most inside the plane.
+    glm::vec3 corner = {
+        plane.x >= 0.f ? box.max.x : box.min.x,
+        plane.y >= 0.f ? box.max.y : box.min.y,
+        plane.z >= 0.f ? box.max.z : box.min.z,
+    };
+    if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.f)
+      return false;
+  }
+  return true;
+}
+
+/// @brief Whether a sphere may be visible.
+bool Frustum::Intersects(const glm::vec3& center, float radius) const {
+  for (const glm::vec4& plane : planes_) {
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+      return false;
+  }
+  return true;
+}
+
+}  // namespace smk
@@ -0,0 +1,107 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <mutex>
+#include <smk/ImageDecoder.hpp>
+
+#include "QoiDecoder.hpp"
+#include "StbImage.hpp"
+
+namespace smk {
+
+namespace {
+
+// The decoders are looked up by the AssetLoader threads.
+std::mutex g_mutex;
+
+// smk::DecodedImage calls stb_image directly, saving a copy of the pixels.
+class StbDecoder : public ImageDecoder {
+ public:
+  const char* name() const override { return "stb_image"; }
+
+  bool Accept(const uint8_t* data, size_t size) const override {
+    int width, height, channels;
+    return stbi_info_from_memory(data, int(size), &width, &height, &channels);
+  }
+
+  bool Decode(const uint8_t* data, size_t size, Image* image) const override {
+    uint8_t* pixels = stbi_load_from_memory(data, int(size), &image->width,
+                                            &image->height, &image->channels,
+                                            0);
+    if (!pixels)
+      return false;
+    image->pixels.assign(pixels, pixels + size_t(image->width) *
+                                              size_t(image->height) *
+                                              image->channels);
+    stbi_image_free(pixels);
+    return true;
+  }
+};
+
+std::vector<std::shared_ptr<ImageDecoder>>& Decoders() {
+  static std::vector<std::shared_ptr<ImageDecoder>> decoders = {
+      std::make_shared<QoiDecoder>(),
+  };
+  return decoders;
+}
+
+}  // namespace
+
+/// @brief Register a decoder. It is tried before the ones already registered.
+/// @param decoder The decoder.
+// static
+void ImageDecoder::Register(std::shared_ptr<ImageDecoder> decoder) {
+  if (!decoder)
+    return;
+  std::lock_guard<std::mutex> lock(g_mutex);
+  auto& decoders = Decoders();
+  decoders.insert(decoders.begin(), std::move(decoder));
+}
+
+/// @brief Stop using a decoder. The images being decoded by it aren't
+/// affected.
+/// @param decoder The decoder.
+// static
+void ImageDecoder::Unregister(const ImageDecoder* decoder) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  auto& decoders = Decoders();
+  decoders.erase(std::remove_if(decoders.begin(), decoders.end(),
+                                [&](const auto& it) {
+                                  return it.get() == decoder;
+                                }),
+                 decoders.end());
+}
+
+/// @brief The registered decoders, in the order they are tried.
+// static
+std::vector<std::shared_ptr<ImageDecoder>> ImageDecoder::decoders() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  return Decoders();
+}
+
+/// @brief Find the decoder of an encoded image.
+/// @param data The encoded image.
+/// @param size The size of |data|, in bytes.
+/// @return The first registered decoder accepting |data|, or nullptr when none
+///         does.
+// static
+std::shared_ptr<ImageDecoder> ImageDecoder::Find(const uint8_t* data,
+                                                 size_t size) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  for (const auto& decoder : Decoders()) {
+    if (decoder->Accept(data, size))
+      return decoder;
+  }
+  return nullptr;
+}
+
+/// @brief The bundled stb_image decoder.
+// static
+std::shared_ptr<ImageDecoder> ImageDecoder::Bundled() {
+  static auto decoder = std::make_shared<StbDecoder>();
+  return decoder;
+}
+
+}  // namespace smk
@@ -19,22 +19,49 @@
 
 namespace smk {
 
+namespace {
+
+template <class Buttons>
+void Apply(Buttons& buttons, int button, int action) {
+  if (button < 0 || button >= int(buttons.held.size()) ||
+      action == GLFW_REPEAT) {
+    return;
+  }
+  bool press = (action == GLFW_PRESS);
+  if (buttons.held[button] == press)
+    return;
+  buttons.held[button] = press;
+  (press ? buttons.pressed : buttons.released)[button] = true;
+  buttons.changed.push_back(button);
+}
+
+template <class Buttons>
+void ClearChanges(Buttons& buttons) {
+  for (int button : buttons.changed) {
+    buttons.pressed[button] = false;
+    buttons.released[button] = false;
+  }
+  buttons.changed.clear();
+}
+
+}  // namespace
+
 void InputImpl::Update(GLFWwindow* window) {
   // Get window dimension.
   int width, height;
   glfwGetWindowSize(window, &width, &height);
 
-  // Update key
-  for (auto it = key_state_.begin(); it != key_state_.end(); ++it) {
-    it->second.second = it->second.first;
-    it->second.first = glfwGetKey(window, it->first);
-  }
-
-  // Update mouse
-  for (auto it = mouse_state_.begin(); it != mouse_state_.end(); ++it) {
-    it->second.second = it->second.first;
-    it->second.first = glfwGetMouseButton(window, it->first);
+  // Apply the button events received since the last frame.
+  ClearChanges(keys_);
+  ClearChanges(mouse_buttons_);
+  for (const ButtonEvent& event : events_pending_) {
+    if (event.device == Device::Keyboard)
+      Apply(keys_, event.button, event.action);
+    else
+      Apply(mouse_buttons_, event.button, event.action);
   }
+  std::swap(events_, events_pending_);
+  events_pending_.clear();
 
   // get mouse position
   double mouse_x, mouse_y;
@@ -52,7 +79,7 @@ void InputImpl::Update(GLFWwindow* window) {
     cursor_press_ = false;
   } else {
     cursor_ = mouse_;
-    cursor_press_ = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_1);
+    cursor_press_ = mouse_buttons_.held[GLFW_MOUSE_BUTTON_1];
   }
 
   // Update scroll.
@@ -70,7 +97,7 @@ void InputImpl::OnTouchEvent(int eventType,
         eventType == EMSCRIPTEN_EVENT_TOUCHMOVE) {
       TouchDataPoint data = {
           glm::vec2(touch.targetX, touch.targetY),
-          0.f,
+          float(glfwGetTime()),
       };
       auto& internal_touch = touches_[touch.identifier];
       internal_touch.finger_id = touch.identifier;
@@ -89,29 +116,35 @@ void InputImpl::OnScrollEvent(glm::vec2 offset) {
   scroll_ += offset;
 }
 
+void InputImpl::OnButtonEvent(Device device,
+                              int button,
+                              int action,
+                              double time) {
+  events_pending_.push_back({device, button, action, time});
+}
+
+const std::vector<Input::ButtonEvent>& InputImpl::events() const {
+  return events_;
+}
+
 bool InputImpl::IsKeyPressed(int key) {
-  auto p = key_state_[key];
-  return ((p.first == GLFW_PRESS) && (p.second == GLFW_RELEASE));
+  return keys_.Get(keys_.pressed, key);
 }
 
 bool InputImpl::IsKeyReleased(int key) {
-  auto p = key_state_[key];
-  return ((p.first == GLFW_RELEASE) && (p.second == GLFW_PRESS));
+  return keys_.Get(keys_.released, key);
 }
 
 bool InputImpl::IsKeyHold(int key) {
-  auto p = key_state_[key];
-  return (p.first == GLFW_PRESS);
+  return keys_.Get(keys_.held, key);
 }
 
 bool InputImpl::IsMousePressed(int key) {
-  auto p = mouse_state_[key];
-  return ((p.first == GLFW_PRESS) && (p.second == GLFW_RELEASE));
+  return mouse_buttons_.Get(mouse_buttons_.pressed, key);
 }
 
 bool InputImpl::IsMouseReleased(int key) {
-  auto p = mouse_state_[key];
-  return ((p.first == GLFW_RELEASE) && (p.second == GLFW_PRESS));
+  return mouse_buttons_.Get(mouse_buttons_.released, key);
 }
 
 glm::vec2 InputImpl::mouse() const {
@@ -123,8 +156,7 @@ std::map<Input::FingerID, Touch>& InputImpl::touches() {
 }
 
 bool InputImpl::IsMouseHeld(int key) {
-  auto p = mouse_state_[key];
-  return (p.first == GLFW_PRESS);
+  return mouse_buttons_.Get(mouse_buttons_.held, key);
 }
 
 bool InputImpl::IsCursorHeld() {
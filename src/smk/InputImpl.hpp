@@ -4,6 +4,10 @@
 #ifndef SMK_INPUTIMPL_H_
 #define SMK_INPUTIMPL_H_
 
+#include <GLFW/glfw3.h>
+
+#include <array>
+#include <cstdint>
 #include <smk/Input.hpp>
 #include <unordered_set>
 #include <vector>
@@ -21,6 +25,7 @@ class InputImpl : public Input {
   void OnTouchEvent(int eventType, const EmscriptenTouchEvent* keyEvent);
 #endif
   void OnScrollEvent(glm::vec2 offset);
+  void OnButtonEvent(Device device, int button, int action, double time);
   void OnCharacterTyped(wchar_t character);
 
   class CharacterListenerImpl;
@@ -41,16 +46,36 @@ class InputImpl : public Input {
   bool IsCursorReleased() override;
   glm::vec2 cursor() const override;
   glm::vec2 scroll_offset() const override;
+  const std::vector<ButtonEvent>& events() const override;
   CharacterListener MakeCharacterListener() override;
 
  private:
+  // The state of the buttons of a device. It is updated from the events, so
+  // the cost doesn't depend on the number of buttons.
+  template <int size>
+  struct Buttons {
+    std::array<uint8_t, size> held = {};
+    std::array<uint8_t, size> pressed = {};
+    std::array<uint8_t, size> released = {};
+    std::vector<int> changed;  // The buttons pressed or released last frame.
+
+    // Return false for the buttons out of range.
+    static bool Get(const std::array<uint8_t, size>& state, int button) {
+      return button >= 0 && button < size && state[button];
+    }
+  };
+
   // Keyboard.
-  std::map<int, std::pair<int, int>> key_state_;
+  Buttons<GLFW_KEY_LAST + 1> keys_;
 
   // Mouse.
-  std::map<int, std::pair<int, int>> mouse_state_;
+  Buttons<GLFW_MOUSE_BUTTON_LAST + 1> mouse_buttons_;
   glm::vec2 mouse_ = {0.f, 0.f};
 
+  // The events received during the polling, and the ones of the last frame.
+  std::vector<ButtonEvent> events_pending_;
+  std::vector<ButtonEvent> events_;
+
   // Touch.
   std::map<FingerID, Touch> touches_;
 
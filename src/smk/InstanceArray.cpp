@@ -0,0 +1,178 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <smk/InstanceArray.hpp>
+#include <smk/RenderStats.hpp>
+#include <smk/VertexArrayObject.hpp>
+
+#include "ResidencyTracker.hpp"
+
+namespace smk {
+extern thread_local bool g_invalidate_vertex_array;
+extern thread_local RenderStats g_render_stats;
+
+InstanceArray::InstanceArray() = default;
+
+/// Constructor.
+/// @param vertex_array A set of 3D triangles, drawn for every instance.
+/// @param instances The transformation and color of every instance.
+InstanceArray::InstanceArray(const VertexArray& vertex_array,
+                             const std::vector<Instance3D>& instances)
+    : vertex_array_(vertex_array), size_(instances.size()) {
+  Allocate(size_ * sizeof(Instance3D), instances.data());
+}
+
+/// Constructor.
+/// @param vertex_array A set of 2D triangles, drawn for every instance.
+/// @param instances The transformation and color of every instance.
+InstanceArray::InstanceArray(const VertexArray& vertex_array,
+                             const std::vector<Instance2D>& instances)
+    : vertex_array_(vertex_array),
+      two_dimensional_(true),
+      instance_layout_(&Instance2D::Bind),
+      size_(instances.size()) {
+  Allocate(size_ * sizeof(Instance2D), instances.data());
+}
+
+/// Constructor.
+/// @param vertex_array A set of 2D triangles, drawn for every particle.
+/// @param particles The initial state of the particles. The buffer is meant to
+///                  be rewritten by the GPU, using transform feedback.
+InstanceArray::InstanceArray(const VertexArray& vertex_array,
+                             const std::vector<Particle2D>& particles)
+    : vertex_array_(vertex_array),
+      two_dimensional_(true),
+      instance_layout_(&Particle2D::Bind),
+      size_(particles.size()) {
+  Allocate(size_ * sizeof(Particle2D), particles.data(), GL_DYNAMIC_COPY);
+}
+
+void InstanceArray::Allocate(size_t size, const void* data, GLenum usage) {
+  ref_count_ = new std::atomic<int>(1);
+  glGenBuffers(1, &vbo_);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+  ++g_render_stats.buffer_allocations;
+  TrackBuffer(vbo_, size);
+
+  context_ = glfwGetCurrentContext();
+  glGenVertexArrays(1, &vao_);
+  glBindVertexArray(vao_);
+  g_invalidate_vertex_array = true;
+  Setup(this);
+  glBindVertexArray(0);
+}
+
+// Bind the buffers and the attributes into the bound vertex array object.
+void InstanceArray::Setup(const void* data) {
+  auto* self = static_cast<const InstanceArray*>(data);
+
+  // The per-vertex attributes, shared with |vertex_array|.
+  glBindBuffer(GL_ARRAY_BUFFER, self->vertex_array_.vbo());
+  glEnableVertexAttribArray(0);
+  if (self->two_dimensional_)
+    Vertex2D::Bind();
+  else
+    Vertex3D::Bind();
+  if (self->vertex_array_.indexed())
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, self->vertex_array_.ebo());
+
+  // The per-instance attributes.
+  glBindBuffer(GL_ARRAY_BUFFER, self->vbo_);
+  self->instance_layout_();
+}
+
+InstanceArray::~InstanceArray() {
+  Release();
+}
+
+void InstanceArray::Bind() const {
+  BindVertexArrayObject(context_, vao_, &InstanceArray::Setup, this);
+}
+
+InstanceArray::InstanceArray(const InstanceArray& other) {
+  this->operator=(other);
+}
+
+InstanceArray::InstanceArray(InstanceArray&& other) noexcept {
+  this->operator=(std::move(other));
+}
+
+InstanceArray& InstanceArray::operator=(const InstanceArray& other) {
+  Release();
+  if (!other.vbo_)
+    return *this;
+
+  vertex_array_ = other.vertex_array_;
+  two_dimensional_ = other.two_dimensional_;
+  instance_layout_ = other.instance_layout_;
+  context_ = other.context_;
+  vbo_ = other.vbo_;
+  vao_ = other.vao_;
+  ref_count_ = other.ref_count_;
+  size_ = other.size_;
+
+  (*ref_count_)++;
+  return *this;
+}
+
+InstanceArray& InstanceArray::operator=(InstanceArray&& other) noexcept {
+  std::swap(vertex_array_, other.vertex_array_);
+  std::swap(two_dimensional_, other.two_dimensional_);
+  std::swap(instance_layout_, other.instance_layout_);
+  std::swap(context_, other.context_);
+  std::swap(vbo_, other.vbo_);
+  std::swap(vao_, other.vao_);
+  std::swap(size_, other.size_);
+  std::swap(ref_count_, other.ref_count_);
+  return *this;
+}
+
+/// @brief The number of instances.
+size_t InstanceArray::size() const {
+  return size_;
+}
+
+bool InstanceArray::operator==(const smk::InstanceArray& other) const {
+  return vbo_ == other.vbo_;
+}
+
+bool InstanceArray::operator!=(const smk::InstanceArray& other) const {
+  return vbo_ != other.vbo_;
+}
+
+void InstanceArray::Release() {
+  vertex_array_ = VertexArray();
+
+  // Nothing to do for the null InstanceArray.
+  if (!vbo_)
+    return;
+
+  // Transfert state to local.
+  GLFWwindow* context = nullptr;
+  GLuint vbo = 0;
+  GLuint vao = 0;
+  std::atomic<int>* ref_count = nullptr;
+  std::swap(context, context_);
+  std::swap(vbo, vbo_);
+  std::swap(vao, vao_);
+  std::swap(ref_count, ref_count_);
+  size_ = 0;
+
+  // Early return without releasing the resource if it is still hold by copy of
+  // this class.
+  if (ref_count) {
+    if (--(*ref_count))
+      return;
+    delete ref_count;
+    ref_count = nullptr;
+  }
+
+  // Release the OpenGL objects.
+  UntrackBuffer(vbo);
+  glDeleteBuffers(1, &vbo);
+  DeleteVertexArrayObject(context, vao);
+}
+
+}  // namespace smk.
@@ -0,0 +1,115 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <cmath>
+#include <smk/InstancedMesh.hpp>
+#include <smk/RenderTarget.hpp>
+
+namespace smk {
+
+/// @brief Remove every instances.
+void InstancedMesh::Clear() {
+  instances_.clear();
+  dirty_ = true;
+}
+
+/// @brief Append an instance.
+/// @param transformation The transformation of the instance.
+/// @param color The color of the instance, multiplied by the InstancedMesh's
+///              color.
+void InstancedMesh::Add(const glm::mat4& transformation,
+                        const glm::vec4& color) {
+  instances_.push_back({transformation, color});
+  dirty_ = true;
+}
+
+/// @brief Append an instance, using the current transformation and color of a
+/// Transformable3D. Its texture and VertexArray are ignored.
+/// @param object The object to be added.
+void InstancedMesh::Add(const Transformable3D& object) {
+  Add(object.transformation(), object.color());
+}
+
+/// @brief Draw every instances, using a single draw call.
+void InstancedMesh::Draw(RenderTarget& target, RenderState state) const {
+  if (instances_.empty() || !vertex_array().size())
+    return;
+
+  if (dirty_ || instance_array_.vertex_array() != vertex_array()) {
+    dirty_ = false;
+    instance_array_ = InstanceArray(vertex_array(), instances_);
+  }
+
+  if (state.shader_program == target.shader_program_2d() ||
+      state.shader_program == target.shader_program_3d()) {
+    state.shader_program = target.shader_program_3d_instanced();
+  }
+  state.instances = instance_array_;
+  Transformable3D::Draw(target, std::move(state));
+}
+
+/// @brief Remove every instances.
+void InstancedMesh2D::Clear() {
+  instances_.clear();
+  dirty_ = true;
+}
+
+/// @brief Append an instance.
+/// @param instance The transformation and color of the instance.
+void InstancedMesh2D::Add(const Instance2D& instance) {
+  instances_.push_back(instance);
+  dirty_ = true;
+}
+
+/// @brief Append an instance. No matrix is built: the 2x3 transformation is
+/// computed directly.
+/// @param position The position of the instance.
+/// @param rotation The rotation of the instance, in degree. It uses the same
+///                 convention as Transformable::SetRotation().
+/// @param scale The size multiplier of the instance.
+/// @param color The color of the instance, multiplied by the InstancedMesh2D's
+///              color.
+void InstancedMesh2D::Add(const glm::vec2& position,
+                          float rotation,
+                          const glm::vec2& scale,
+                          const glm::vec4& color) {
+  const float angle = -rotation * (2.f * 3.1415f / 360.f);
+  const float c = std::cos(angle);
+  const float s = std::sin(angle);
+  Instance2D instance;
+  instance.row_x = {c * scale.x, -s * scale.y, position.x};
+  instance.row_y = {s * scale.x, c * scale.y, position.y};
+  instance.color = color;
+  Add(instance);
+}
+
+/// @brief Append an instance, using the current transformation and color of a
+/// Transformable. Its texture and VertexArray are ignored.
+/// @param object The object to be added.
+void InstancedMesh2D::Add(const Transformable& object) {
+  const glm::mat4 m = object.transformation();
+  Instance2D instance;
+  instance.row_x = {m[0][0], m[1][0], m[3][0]};
+  instance.row_y = {m[0][1], m[1][1], m[3][1]};
+  instance.color = object.color();
+  Add(instance);
+}
+
+/// @brief Draw every instances, using a single draw call.
+void InstancedMesh2D::Draw(RenderTarget& target, RenderState state) const {
+  if (instances_.empty() || !vertex_array().size())
+    return;
+
+  if (dirty_ || instance_array_.vertex_array() != vertex_array()) {
+    dirty_ = false;
+    instance_array_ = InstanceArray(vertex_array(), instances_);
+  }
+
+  if (state.shader_program == target.shader_program_2d())
+    state.shader_program = target.shader_program_2d_instanced();
+  state.instances = instance_array_;
+  Transformable::Draw(target, std::move(state));
+}
+
+}  // namespace smk
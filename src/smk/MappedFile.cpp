@@ -0,0 +1,67 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <fstream>
+#include <iterator>
+
+#include "MappedFile.hpp"
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+  #define SMK_HAS_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace smk {
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+bool MappedFile::Open(const std::string& filename) {
+  Close();
+
+#ifdef SMK_HAS_MMAP
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat status;
+  if (fstat(fd, &status) == 0 && status.st_size > 0) {
+    void* data =
+        mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      data_ = static_cast<const uint8_t*>(data);
+      size_ = size_t(status.st_size);
+      mapped_ = true;
+    }
+  }
+  close(fd);
+  if (mapped_)
+    return true;
+#endif
+
+  std::ifstream file(filename, std::ios::binary);
+  if (!file)
+    return false;
+  content_.assign(std::istreambuf_iterator<char>(file),
+                  std::istreambuf_iterator<char>());
+  data_ = content_.data();
+  size_ = content_.size();
+  return true;
+}
+
+void MappedFile::Close() {
+#ifdef SMK_HAS_MMAP
+  if (mapped_)
+    munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+  mapped_ = false;
+  data_ = nullptr;
+  size_ = 0;
+  content_.clear();
+}
+
+}  // namespace smk
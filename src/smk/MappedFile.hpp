@@ -0,0 +1,40 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_MAPPED_FILE_HPP
+#define SMK_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace smk {
+
+// A read-only file mapped in memory. Where mmap isn't available, the file is
+// read instead.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  // Return false when the file can't be opened.
+  bool Open(const std::string& filename);
+  void Close();
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  MappedFile(const MappedFile&) = delete;
+  void operator=(const MappedFile&) = delete;
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<uint8_t> content_;  // When the file couldn't be mapped.
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_MAPPED_FILE_HPP */
@@ -0,0 +1,251 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <AL/al.h>
+#include <AL/alc.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <smk/Audio.hpp>
+#include <smk/Music.hpp>
+#include <thread>
+
+#include "SoundStream.hpp"
+
+namespace smk {
+
+// Decode the file in a worker thread, a few chunks ahead of the playback.
+struct Music::Decoder {
+  // The number of chunks decoded ahead, waiting for a free OpenAL buffer.
+  static constexpr size_t kChunksAhead = 2;
+
+  struct Chunk {
+    std::vector<int16_t> samples;
+    int channels = 0;
+    int sample_rate = 0;
+  };
+
+  Decoder(const std::string& filename, bool looping)
+      : looping(looping), thread_(&Decoder::Run, this, filename) {}
+
+  ~Decoder() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    condition_.notify_one();
+    thread_.join();
+  }
+
+  // Return false when no chunk is ready.
+  bool TakeChunk(Chunk* chunk) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (chunks_.empty())
+        return false;
+      *chunk = std::move(chunks_.front());
+      chunks_.pop_front();
+    }
+    condition_.notify_one();
+    return true;
+  }
+
+  // Whether every chunks have been taken.
+  bool Finished() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return finished_ && chunks_.empty();
+  }
+
+  std::atomic<bool> looping;
+
+ private:
+  void Run(std::string filename) {
+    std::unique_ptr<SoundStream> stream = SoundStream::Open(filename);
+    if (!stream) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished_ = true;
+      return;
+    }
+
+    // A quarter of second per chunk. It holds whole frames, so that the
+    // interleaved channels aren't split across chunks.
+    const size_t channels = stream->channels();
+    const size_t chunk_size = stream->sample_rate() / 4 * channels;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock,
+                        [&] { return stop_ || chunks_.size() < kChunksAhead; });
+        if (stop_)
+          return;
+      }
+
+      Chunk chunk;
+      chunk.channels = stream->channels();
+      chunk.sample_rate = stream->sample_rate();
+      chunk.samples.resize(chunk_size);
+      size_t size = stream->Read(chunk.samples.data(), chunk_size);
+      if (size == 0 && looping) {
+        stream->Rewind();
+        size = stream->Read(chunk.samples.data(), chunk_size);
+      }
+      chunk.samples.resize(size);
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (size == 0) {
+        finished_ = true;
+        return;
+      }
+      chunks_.push_back(std::move(chunk));
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Chunk> chunks_;
+  bool stop_ = false;
+  bool finished_ = false;
+  std::thread thread_;
+};
+
+/// @brief Create a null Music.
+Music::Music() = default;
+
+/// @brief Create a Music streamed from a file. Nothing is read before Play().
+/// @param filename The sound file.
+Music::Music(const std::string& filename) : filename_(filename) {}
+
+Music::~Music() {
+  Stop();
+  if (source_) {
+    alDeleteSources(1, &source_);
+    alDeleteBuffers(kBufferCount, buffers_.data());
+  }
+}
+
+void Music::EnsureSourceIsCreated() {
+  if (source_)
+    return;
+
+  if (!Audio::Initialized()) {
+    static bool once = true;
+    if (once) {
+      std::cerr
+          << "Error: smk::Audio has not been initialized. Please create a "
+             "smk::Audio instance in the main() function before creating a "
+             "smk::Music"
+          << std::endl;
+      once = false;
+    }
+  }
+
+  alGenSources(1, &source_);
+  alGenBuffers(kBufferCount, buffers_.data());
+  free_buffers_.assign(buffers_.begin(), buffers_.end());
+  alSourcef(source_, AL_GAIN, volume_);
+}
+
+/// @brief Start playing the music from the beginning.
+void Music::Play() {
+  if (filename_.empty())
+    return;
+  Stop();
+  EnsureSourceIsCreated();
+  decoder_ = std::make_unique<Decoder>(filename_, looping_);
+  is_playing_ = true;
+  Update();
+}
+
+/// @brief Stop playing the music.
+void Music::Stop() {
+  if (!source_ || !is_playing_)
+    return;
+  alSourceStop(source_);
+  alSourcei(source_, AL_BUFFER, 0);  // Unqueue every buffers.
+  free_buffers_.assign(buffers_.begin(), buffers_.end());
+  decoder_.reset();
+  is_playing_ = false;
+}
+
+/// @brief Specify whether the music must restart when it has reached the end.
+/// @param looping whether the music must restart when it has reached the end.
+void Music::SetLoop(bool looping) {
+  looping_ = looping;
+  if (decoder_)
+    decoder_->looping = looping;
+}
+
+/// @return whether the music is being played. It stays true while the
+/// playback is starved by a slow decoder.
+bool Music::IsPlaying() const {
+  return is_playing_;
+}
+
+/// @brief Set the gain applied to the source.
+void Music::SetVolume(float volume) {
+  volume_ = volume;
+  if (source_)
+    alSourcef(source_, AL_GAIN, volume);
+}
+
+/// @brief Queue the decoded chunks into the free OpenAL buffers.
+void Music::Update() {
+  if (!is_playing_)
+    return;
+
+  ALint processed = 0;
+  alGetSourcei(source_, AL_BUFFERS_PROCESSED, &processed);
+  while (processed-- > 0) {
+    ALuint buffer = 0;
+    alSourceUnqueueBuffers(source_, 1, &buffer);
+    free_buffers_.push_back(buffer);
+  }
+
+  Decoder::Chunk chunk;
+  while (!free_buffers_.empty() && decoder_->TakeChunk(&chunk)) {
+    const ALuint buffer = free_buffers_.back();
+    free_buffers_.pop_back();
+    const ALenum format =
+        chunk.channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+    alBufferData(buffer, format, chunk.samples.data(),
+                 ALsizei(chunk.samples.size() * sizeof(ALshort)),
+                 chunk.sample_rate);
+    alSourceQueueBuffers(source_, 1, &buffer);
+  }
+
+  ALint state = AL_STOPPED;
+  alGetSourcei(source_, AL_SOURCE_STATE, &state);
+  if (state == AL_PLAYING)
+    return;
+
+  // Every queued buffers have been played.
+  if (free_buffers_.size() == kBufferCount) {
+    if (decoder_->Finished())
+      Stop();
+    return;
+  }
+
+  // Start, or restart after an underrun.
+  alSourcePlay(source_);
+}
+
+Music::Music(Music&& o) noexcept {
+  operator=(std::move(o));
+}
+
+void Music::operator=(Music&& o) noexcept {
+  std::swap(filename_, o.filename_);
+  std::swap(source_, o.source_);
+  std::swap(buffers_, o.buffers_);
+  std::swap(free_buffers_, o.free_buffers_);
+  std::swap(decoder_, o.decoder_);
+  std::swap(looping_, o.looping_);
+  std::swap(is_playing_, o.is_playing_);
+  std::swap(volume_, o.volume_);
+}
+
+}  // namespace smk
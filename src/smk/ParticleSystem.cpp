@@ -0,0 +1,220 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <glm/gtc/constants.hpp>
+#include <map>
+#include <mutex>
+#include <smk/ParticleSystem.hpp>
+#include <smk/RenderStats.hpp>
+#include <smk/RenderTarget.hpp>
+#include <smk/Shader.hpp>
+#include <vector>
+
+namespace smk {
+extern thread_local bool g_invalidate_vertex_array;
+extern thread_local bool g_invalidate_shader_program;
+extern thread_local RenderStats g_render_stats;
+
+namespace {
+
+// Compute the next state of one particle per instance. The outputs are
+// captured, in this order, into the Particle2D buffer.
+const char* kSimulationVertexShader = R"(
+  precision highp float;
+
+  layout(location = 3) in vec2 position;
+  layout(location = 4) in vec2 velocity;
+  layout(location = 5) in vec3 life;  // age, lifetime, size.
+
+  uniform float delta;
+  uniform int seed;
+  uniform int emitting;
+  uniform vec4 emitter;       // position, direction, spread.
+  uniform vec4 ranges;        // speed, lifetime.
+  uniform vec4 gravity_size;  // gravity, size at birth and at death.
+  uniform vec4 start_color;
+  uniform vec4 end_color;
+
+  out vec4 out_color;
+  out vec2 out_position;
+  out vec2 out_velocity;
+  out vec3 out_life;
+
+  // A random number in [0,1), for this particle and this frame.
+  float Random(uint n) {
+    uint x = uint(gl_InstanceID) * 3u + n + uint(seed) * 0x9E3779B9u;
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return float(x >> 8) / 16777216.0;
+  }
+
+  void main() {
+    float age = life.x + delta;
+    float lifetime = life.y;
+    out_position = position;
+    out_velocity = velocity;
+    if (age >= lifetime && emitting != 0) {
+      float angle = emitter.z + (Random(0u) - 0.5) * emitter.w;
+      float speed = mix(ranges.x, ranges.y, Random(1u));
+      age = 0.0;
+      lifetime = mix(ranges.z, ranges.w, Random(2u));
+      out_position = emitter.xy;
+      out_velocity = speed * vec2(cos(angle), sin(angle));
+    } else {
+      out_velocity += gravity_size.xy * delta;
+      out_position += out_velocity * delta;
+    }
+
+    float t = clamp(age / max(lifetime, 0.0001), 0.0, 1.0);
+    bool alive = age >= 0.0 && age < lifetime;
+    float size = alive ? mix(gravity_size.z, gravity_size.w, t) : 0.0;
+    out_life = vec3(age, lifetime, size);
+    out_color = mix(start_color, end_color, t);
+  }
+)";
+
+// Nothing is rasterized, but OpenGL ES requires a fragment shader.
+const char* kSimulationFragmentShader = R"(
+  out vec4 out_color;
+  void main() {
+    out_color = vec4(0.0);
+  }
+)";
+
+// The simulation program of the current context.
+ShaderProgram& SimulationProgram() {
+  static std::map<GLFWwindow*, ShaderProgram> programs;
+  static std::mutex programs_mutex;
+  std::lock_guard<std::mutex> lock(programs_mutex);
+  ShaderProgram& program = programs[glfwGetCurrentContext()];
+  if (program.id())
+    return program;
+
+  // The shaders are kept until the program is linked: with the binary cache,
+  // their compilation is delayed until Link().
+  Shader vertex = Shader::FromString(kSimulationVertexShader, GL_VERTEX_SHADER);
+  Shader fragment =
+      Shader::FromString(kSimulationFragmentShader, GL_FRAGMENT_SHADER);
+  program.AddShader(vertex);
+  program.AddShader(fragment);
+  const char* varyings[] = {
+      "out_color",
+      "out_position",
+      "out_velocity",
+      "out_life",
+  };
+  glTransformFeedbackVaryings(program.id(), 4, varyings,
+                              GL_INTERLEAVED_ATTRIBS);
+  program.Link();
+  return program;
+}
+
+// The shape of a particle: a unit square centered on its position.
+VertexArray UnitSquare() {
+  return VertexArray(std::vector<Vertex2D>({
+      {{-0.5f, -0.5f}, {0.f, 0.f}},
+      {{+0.5f, -0.5f}, {1.f, 0.f}},
+      {{+0.5f, +0.5f}, {1.f, 1.f}},
+      {{-0.5f, -0.5f}, {0.f, 0.f}},
+      {{+0.5f, +0.5f}, {1.f, 1.f}},
+      {{-0.5f, +0.5f}, {0.f, 1.f}},
+  }));
+}
+
+}  // namespace
+
+/// @brief Allocate the particles on the GPU. None is alive at first. Their
+/// first births are spread over the maximum lifetime of the Emitter, so that
+/// they are emitted at a steady rate.
+/// @param capacity The number of particles.
+ParticleSystem::ParticleSystem(size_t capacity)
+    : ParticleSystem(capacity, UnitSquare()) {}
+
+/// @brief Allocate the particles on the GPU, drawn with a custom shape.
+/// @param capacity The number of particles.
+/// @param shape The shape of every particle, made of smk::Vertex2D. It is
+///              scaled by the size of the particle.
+ParticleSystem::ParticleSystem(size_t capacity, const VertexArray& shape)
+    : capacity_(capacity) {
+  SetVertexArray(shape);
+
+  std::vector<Particle2D> particles(capacity);
+  for (size_t i = 0; i < capacity; ++i)
+    particles[i].age = -emitter_.lifetime.y * float(i) / float(capacity);
+  particles_[0] = InstanceArray(vertex_array(), particles);
+  particles_[1] = InstanceArray(vertex_array(), particles);
+}
+
+ParticleSystem::ParticleSystem(ParticleSystem&& other) noexcept {
+  operator=(std::move(other));
+}
+
+ParticleSystem& ParticleSystem::operator=(ParticleSystem&& other) noexcept {
+  Transformable::operator=(std::move(other));
+  std::swap(emitter_, other.emitter_);
+  std::swap(capacity_, other.capacity_);
+  std::swap(seed_, other.seed_);
+  std::swap(particles_, other.particles_);
+  std::swap(current_, other.current_);
+  return *this;
+}
+
+/// @brief Advance the simulation. The particles are moved, aged and spawned
+/// again by the GPU, in a single draw call without rasterization.
+/// @param delta The elapsed time, in seconds.
+void ParticleSystem::Update(float delta) {
+  if (!capacity_)
+    return;
+
+  const float to_radian = glm::pi<float>() / 180.f;
+  ShaderProgram& program = SimulationProgram();
+  program.Use();
+  program.SetUniform("delta", delta);
+  program.SetUniform("seed", int(++seed_));
+  program.SetUniform("emitting", emitter_.emitting ? 1 : 0);
+  program.SetUniform("emitter", glm::vec4(emitter_.position,
+                                          emitter_.direction * to_radian,
+                                          emitter_.spread * to_radian));
+  program.SetUniform("ranges", glm::vec4(emitter_.speed, emitter_.lifetime));
+  program.SetUniform("gravity_size",
+                     glm::vec4(emitter_.gravity, emitter_.size));
+  program.SetUniform("start_color", emitter_.start_color);
+  program.SetUniform("end_color", emitter_.end_color);
+  program.UploadRecordedUniforms();
+
+  // Every instance reads one particle from |source|, and writes it into
+  // |destination|.
+  const InstanceArray& source = particles_[current_];
+  const InstanceArray& destination = particles_[1 - current_];
+  source.Bind();
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, destination.vbo());
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBeginTransformFeedback(GL_POINTS);
+  glDrawArraysInstanced(GL_POINTS, 0, 1, capacity_);
+  glEndTransformFeedback();
+  glDisable(GL_RASTERIZER_DISCARD);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  ++g_render_stats.draw_calls;
+
+  // The RenderTarget's cached bindings are no longer valid.
+  g_invalidate_vertex_array = true;
+  g_invalidate_shader_program = true;
+  current_ = 1 - current_;
+}
+
+/// @brief Draw every particles, using a single draw call.
+void ParticleSystem::Draw(RenderTarget& target, RenderState state) const {
+  if (!capacity_)
+    return;
+
+  if (state.shader_program == target.shader_program_2d())
+    state.shader_program = target.shader_program_2d_particles();
+  state.instances = particles_[current_];
+  Transformable::Draw(target, std::move(state));
+}
+
+}  // namespace smk
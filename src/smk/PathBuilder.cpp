@@ -0,0 +1,180 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <smk/PathBuilder.hpp>
+#include <smk/RenderTarget.hpp>
+#include <smk/Shape.hpp>
+
+namespace smk {
+
+/// @brief Constructor. The path is empty.
+/// @param thickness The width of the path.
+PathBuilder::PathBuilder(float thickness) : thickness_(thickness) {}
+
+/// @brief Append a point. Only the last segment is tessellated.
+/// @param point The next point the path is going through.
+void PathBuilder::Add(const glm::vec2& point) {
+  // A segment of null length has no direction.
+  if (!points_.empty() && points_.back() == point)
+    return;
+
+  points_.push_back(point);
+  left_.emplace_back();
+  right_.emplace_back();
+  const size_t size = points_.size();
+  if (size < 2)
+    return;
+
+  // The previous end of the path becomes a joint.
+  ComputeOutline(size - 2);
+  ComputeOutline(size - 1);
+  vertices_.resize(6 * (size - 1));
+  size_t first = size - 2;
+  if (size >= 3) {
+    first = size - 3;
+    WriteSegment(size - 3);
+  }
+  WriteSegment(size - 2);
+  dirty_ = std::min(dirty_, 6 * first);
+}
+
+/// @brief Append a Bezier curve.
+/// @param points The control points. The curve starts from the first one.
+/// @param subdivision The number of segments of the curve.
+void PathBuilder::AddBezier(const std::vector<glm::vec2>& points,
+                            size_t subdivision) {
+  for (const glm::vec2& point : Shape::Bezier(points, subdivision))
+    Add(point);
+}
+
+/// @brief Remove every points. The GPU buffer is kept for the next ones.
+void PathBuilder::Clear() {
+  points_.clear();
+  left_.clear();
+  right_.clear();
+  vertices_.clear();
+  dirty_ = 0;
+}
+
+/// @brief Set the width of the path.
+/// @param thickness The width of the path.
+void PathBuilder::SetThickness(float thickness) {
+  if (thickness_ == thickness)
+    return;
+  thickness_ = thickness;
+  if (points_.size() < 2)
+    return;
+  for (size_t i = 0; i < points_.size(); ++i)
+    ComputeOutline(i);
+  for (size_t segment = 0; segment + 1 < points_.size(); ++segment)
+    WriteSegment(segment);
+  dirty_ = 0;
+}
+
+// Compute left_[index] and right_[index], the outline of the path at
+// points_[index]. This uses the same construction as Shape::Path().
+void PathBuilder::ComputeOutline(size_t index) {
+  using namespace glm;
+  const float thickness = thickness_ * 0.5f;
+  const size_t last = points_.size() - 1;
+
+  // Cap begin.
+  if (index == 0) {
+    vec2 direction = normalize(points_[1] - points_[0]);
+    vec2 normal = {direction.y, -direction.x};
+    left_[0] = points_[0] - normal * thickness;
+    right_[0] = points_[0] + normal * thickness;
+    return;
+  }
+
+  // Cap end.
+  if (index == last) {
+    vec2 direction = normalize(points_[last - 1] - points_[last]);
+    vec2 normal = {direction.y, -direction.x};
+    left_[last] = points_[last] + normal * thickness;
+    right_[last] = points_[last] - normal * thickness;
+    return;
+  }
+
+  // Intersect the planes shifted by +/- |thickness| around the two lines.
+  const vec2& a = points_[index - 1];
+  const vec2& b = points_[index];
+  const vec2& c = points_[index + 1];
+  vec3 plane_left_ab = cross(vec3(a, 1.f), vec3(b, 1.f));
+  vec3 plane_left_bc = cross(vec3(b, 1.f), vec3(c, 1.f));
+  vec3 plane_right_ab = plane_left_ab;
+  vec3 plane_right_bc = plane_left_bc;
+  plane_left_ab.z -= thickness * length(vec2(plane_left_ab));
+  plane_right_ab.z += thickness * length(vec2(plane_right_ab));
+  plane_left_bc.z -= thickness * length(vec2(plane_left_bc));
+  plane_right_bc.z += thickness * length(vec2(plane_right_bc));
+
+  vec3 intersection_left = cross(plane_left_ab, plane_left_bc);
+  vec3 intersection_right = cross(plane_right_ab, plane_right_bc);
+
+  // Nearly aligned lines: use the normal of the average direction.
+  const float epsilon = 0.01f;
+  if (intersection_left.z * intersection_right.z < epsilon) {
+    vec2 direction = normalize(c - a);
+    vec2 normal = {direction.y, -direction.x};
+    left_[index] = b - normal * thickness;
+    right_[index] = b + normal * thickness;
+    return;
+  }
+
+  vec2 left = vec2(intersection_left / intersection_left.z);
+  vec2 right = vec2(intersection_right / intersection_right.z);
+  if (distance(left, right) > 10.f * thickness) {
+    vec2 middle = (left + right) * 0.5f;
+    vec2 dir = normalize(right - left) * 5.f * thickness;
+    left = middle - dir;
+    right = middle + dir;
+  }
+  left_[index] = left;
+  right_[index] = right;
+}
+
+// Fill the segment in between points_[segment] and points_[segment + 1]
+// using two triangles.
+// ...-A--C-...  A = left_[segment]
+//     |\ | ...  B = right_[segment]
+//     | \| ...  C = left_[segment + 1]
+// ...-B--D-...  D = right_[segment + 1];
+void PathBuilder::WriteSegment(size_t segment) {
+  const Vertex2D A = {left_[segment], {0.f, 0.f}};
+  const Vertex2D B = {right_[segment], {0.f, 0.f}};
+  const Vertex2D C = {left_[segment + 1], {0.f, 0.f}};
+  const Vertex2D D = {right_[segment + 1], {0.f, 0.f}};
+  Vertex2D* v = &vertices_[6 * segment];
+  v[0] = A;
+  v[1] = B;
+  v[2] = D;
+  v[3] = A;
+  v[4] = D;
+  v[5] = C;
+}
+
+/// @brief Upload the new vertices, then draw the path.
+void PathBuilder::Draw(RenderTarget& target, RenderState state) const {
+  if (vertices_.empty())
+    return;
+
+  if (dirty_ < vertices_.size()) {
+    vertex_array_.UpdateRange(vertices_.data(), vertices_.size(), dirty_);
+    dirty_ = vertices_.size();
+  }
+
+  RenderStateRef ref(state);
+  ref.color *= color();
+  ref.texture = &texture();
+  ref.view *= transformation();
+  if (!target.IsVisible(vertex_array_.bounds(), ref.view))
+    return;
+  ref.vertex_array = &vertex_array_;
+  ref.blend_mode = blend_mode();
+  target.Draw(ref);
+}
+
+}  // namespace smk
@@ -0,0 +1,85 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include "PixelConversion.hpp"
+
+#if defined(__SSSE3__)
+  #include <tmmintrin.h>
+#endif
+
+namespace smk {
+
+void RGBToRGBA(const uint8_t* source, uint8_t* destination, size_t count) {
+  size_t i = 0;
+#if defined(__SSSE3__)
+  // 4 pixels per iteration. Every load reads 16 bytes, but only 12 are used,
+  // so the loop stops while 16 bytes are still readable.
+  const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1,  //
+                                        6, 7, 8, -1, 9, 10, 11, -1);
+  const __m128i alpha = _mm_set1_epi32(0xFF000000);
+  for (; i + 6 <= count; i += 4) {
+    __m128i rgb = _mm_loadu_si128((const __m128i*)(source + 3 * i));
+    __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha);
+    _mm_storeu_si128((__m128i*)(destination + 4 * i), rgba);
+  }
+#endif
+  for (; i < count; ++i) {
+    destination[4 * i + 0] = source[3 * i + 0];
+    destination[4 * i + 1] = source[3 * i + 1];
+    destination[4 * i + 2] = source[3 * i + 2];
+    destination[4 * i + 3] = 255;
+  }
+}
+
+void GreyToRGBA(const uint8_t* source, uint8_t* destination, size_t count) {
+  size_t i = 0;
+#if defined(__SSSE3__)
+  // 16 pixels per iteration.
+  const __m128i alpha = _mm_set1_epi32(0xFF000000);
+  const __m128i shuffles[4] = {
+      _mm_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1),
+      _mm_setr_epi8(4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1),
+      _mm_setr_epi8(8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1),
+      _mm_setr_epi8(12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15,
+                    -1),
+  };
+  for (; i + 16 <= count; i += 16) {
+    __m128i grey = _mm_loadu_si128((const __m128i*)(source + i));
+    for (int j = 0; j < 4; ++j) {
+      __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(grey, shuffles[j]), alpha);
+      _mm_storeu_si128((__m128i*)(destination + 4 * (i + 4 * j)), rgba);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    destination[4 * i + 0] = source[i];
+    destination[4 * i + 1] = source[i];
+    destination[4 * i + 2] = source[i];
+    destination[4 * i + 3] = 255;
+  }
+}
+
+void GreyAlphaToRGBA(const uint8_t* source,
+                     uint8_t* destination,
+                     size_t count) {
+  size_t i = 0;
+#if defined(__SSSE3__)
+  // 4 pixels per iteration, reading 8 bytes.
+  const __m128i shuffle = _mm_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3,  //
+                                        4, 4, 4, 5, 6, 6, 6, 7);
+  for (; i + 4 <= count; i += 4) {
+    __m128i grey_alpha = _mm_loadl_epi64((const __m128i*)(source + 2 * i));
+    __m128i rgba = _mm_shuffle_epi8(grey_alpha, shuffle);
+    _mm_storeu_si128((__m128i*)(destination + 4 * i), rgba);
+  }
+#endif
+  for (; i < count; ++i) {
+    destination[4 * i + 0] = source[2 * i + 0];
+    destination[4 * i + 1] = source[2 * i + 0];
+    destination[4 * i + 2] = source[2 * i + 0];
+    destination[4 * i + 3] = source[2 * i + 1];
+  }
+}
+
+}  // namespace smk
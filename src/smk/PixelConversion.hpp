@@ -0,0 +1,21 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_PIXEL_CONVERSION_HPP
+#define SMK_PIXEL_CONVERSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace smk {
+
+// Expand |count| pixels of |source| into RGBA(8,8,8,8) pixels in |destination|.
+// The missing alpha channel is opaque. |source| and |destination| must not
+// overlap.
+void RGBToRGBA(const uint8_t* source, uint8_t* destination, size_t count);
+void GreyToRGBA(const uint8_t* source, uint8_t* destination, size_t count);
+void GreyAlphaToRGBA(const uint8_t* source, uint8_t* destination, size_t count);
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_PIXEL_CONVERSION_HPP */
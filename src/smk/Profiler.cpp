@@ -0,0 +1,245 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <smk/Color.hpp>
+#include <smk/Font.hpp>
+#include <smk/Profiler.hpp>
+#include <smk/RenderTarget.hpp>
+#include <smk/Text.hpp>
+
+namespace smk {
+
+std::atomic<bool> Profiler::enabled_(false);
+
+namespace {
+
+// The number of events kept per thread.
+const size_t kCapacity = 1 << 14;
+
+using Clock = std::chrono::steady_clock;
+const Clock::time_point g_start = Clock::now();
+
+double Now() {
+  return std::chrono::duration<double>(Clock::now() - g_start).count();
+}
+
+struct ThreadBuffer {
+  std::mutex mutex;
+  std::vector<Profiler::Event> events;  // Ring buffer.
+  size_t written = 0;
+  int thread = 0;
+  int depth = 0;
+};
+
+// The buffers outlive their threads, so that their events can be exported.
+std::mutex g_buffers_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> g_buffers;
+
+ThreadBuffer& LocalBuffer() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+    auto buffer = std::make_shared<ThreadBuffer>();
+    buffer->events.resize(kCapacity);
+    std::lock_guard<std::mutex> lock(g_buffers_mutex);
+    buffer->thread = int(g_buffers.size());
+    g_buffers.push_back(buffer);
+    return buffer;
+  }();
+  return *buffer;
+}
+
+// The events ended after |from|, sorted by beginning.
+std::vector<Profiler::Event> Events(double from) {
+  std::vector<Profiler::Event> events;
+  std::lock_guard<std::mutex> lock(g_buffers_mutex);
+  for (auto& buffer : g_buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    size_t count = std::min(buffer->written, kCapacity);
+    for (size_t i = buffer->written - count; i < buffer->written; ++i) {
+      const Profiler::Event& event = buffer->events[i % kCapacity];
+      if (event.end >= from)
+        events.push_back(event);
+    }
+  }
+  std::sort(events.begin(), events.end(),
+            [](const Profiler::Event& a, const Profiler::Event& b) {
+              return a.begin < b.begin;
+            });
+  return events;
+}
+
+struct Frame {
+  double end;
+  float gpu_time;
+};
+
+std::mutex g_frames_mutex;
+std::vector<Frame> g_frames;  // Ring buffer.
+size_t g_frames_written = 0;
+double g_frame_begin = 0.0;
+std::vector<Profiler::Event> g_last_frame;
+float g_last_frame_duration = 0.f;
+float g_last_frame_gpu_time = -1.f;
+
+void WriteJsonString(std::ostream& out, const char* string) {
+  out << '"';
+  for (const char* c = string; *c; ++c) {
+    if (*c == '"' || *c == '\\')
+      out << '\\';
+    out << *c;
+  }
+  out << '"';
+}
+
+}  // namespace
+
+/// @brief Enable or disable the recording. It is disabled by default.
+// static
+void Profiler::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::Scope::Begin(const char* name) {
+  name_ = name;
+  begin_ = Now();
+  ++LocalBuffer().depth;
+}
+
+void Profiler::Scope::End() {
+  double end = Now();
+  ThreadBuffer& buffer = LocalBuffer();
+  --buffer.depth;
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.events[buffer.written % kCapacity] = {name_, begin_, end,
+                                               buffer.thread, buffer.depth};
+  ++buffer.written;
+}
+
+/// @brief Close the current frame. This is called by Window::Display().
+/// @param gpu_time The GPU time of the last frame measured, in milliseconds.
+// static
+void Profiler::NewFrame(float gpu_time) {
+  if (!enabled())
+    return;
+  double now = Now();
+  std::vector<Event> events = Events(g_frame_begin);
+
+  std::lock_guard<std::mutex> lock(g_frames_mutex);
+  g_last_frame = std::move(events);
+  g_last_frame_duration = float((now - g_frame_begin) * 1000.0);
+  g_last_frame_gpu_time = gpu_time;
+  g_frame_begin = now;
+
+  if (g_frames.size() < kCapacity)
+    g_frames.resize(kCapacity);
+  g_frames[g_frames_written % kCapacity] = {now, gpu_time};
+  ++g_frames_written;
+}
+
+/// @brief The scopes ended during the last frame, sorted by beginning.
+// static
+std::vector<Profiler::Event> Profiler::last_frame() {
+  std::lock_guard<std::mutex> lock(g_frames_mutex);
+  return g_last_frame;
+}
+
+/// @brief The CPU duration of the last frame, in milliseconds.
+// static
+float Profiler::last_frame_duration() {
+  std::lock_guard<std::mutex> lock(g_frames_mutex);
+  return g_last_frame_duration;
+}
+
+/// @brief The GPU time of the last frame measured, in milliseconds. -1 when
+/// the timer queries aren't supported.
+// static
+float Profiler::last_frame_gpu_time() {
+  std::lock_guard<std::mutex> lock(g_frames_mutex);
+  return g_last_frame_gpu_time;
+}
+
+/// @brief Draw the frame duration and the time spent in every scope during the
+/// last frame, sorted by total time.
+/// @param target The RenderTarget to draw into.
+/// @param font The font used to draw the text.
+// static
+void Profiler::DrawOverlay(RenderTarget& target, Font& font) {
+  struct Total {
+    double duration = 0.0;
+    int count = 0;
+  };
+  std::map<std::string, Total> totals;
+  for (const Event& event : last_frame()) {
+    Total& total = totals[event.name];
+    total.duration += event.end - event.begin;
+    ++total.count;
+  }
+  std::vector<std::pair<std::string, Total>> sorted(totals.begin(),
+                                                    totals.end());
+  std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+    return a.second.duration > b.second.duration;
+  });
+
+  char line[256];
+  std::string text;
+  snprintf(line, sizeof(line), "frame %.2f ms  gpu %.2f ms\n",
+           last_frame_duration(), last_frame_gpu_time());
+  text += line;
+  const size_t kMaxLines = 16;
+  for (size_t i = 0; i < sorted.size() && i < kMaxLines; ++i) {
+    snprintf(line, sizeof(line), "%7.3f ms %4dx %s\n",
+             sorted[i].second.duration * 1000.0, sorted[i].second.count,
+             sorted[i].first.c_str());
+    text += line;
+  }
+
+  auto overlay = Text(font, text);
+  overlay.SetPosition(10.f, 10.f);
+  overlay.SetColor(Color::White);
+  target.Draw(overlay);
+}
+
+/// @brief Write every recorded scopes and the GPU time of every frames to
+/// |filename|, using the Chrome trace event format.
+/// @param filename The file to be written.
+/// @return False when the file can't be written.
+// static
+bool Profiler::ExportChromeTrace(const std::string& filename) {
+  std::ofstream out(filename);
+  if (!out)
+    return false;
+
+  out << "{\"traceEvents\":[\n";
+  bool first = true;
+  for (const Event& event : Events(0.0)) {
+    out << (first ? "" : ",\n") << "{\"name\":";
+    WriteJsonString(out, event.name);
+    out << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+        << ",\"ts\":" << event.begin * 1e6
+        << ",\"dur\":" << (event.end - event.begin) * 1e6 << "}";
+    first = false;
+  }
+
+  std::lock_guard<std::mutex> lock(g_frames_mutex);
+  size_t count = std::min(g_frames_written, kCapacity);
+  for (size_t i = g_frames_written - count; i < g_frames_written; ++i) {
+    const Frame& frame = g_frames[i % kCapacity];
+    if (frame.gpu_time < 0.f)
+      continue;
+    out << (first ? "" : ",\n")
+        << "{\"name\":\"gpu\",\"ph\":\"C\",\"pid\":0,\"ts\":"
+        << frame.end * 1e6 << ",\"args\":{\"ms\":" << frame.gpu_time << "}}";
+    first = false;
+  }
+  out << "\n]}\n";
+  return bool(out);
+}
+
+}  // namespace smk
@@ -0,0 +1,124 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include "QoiDecoder.hpp"
+
+#include <cstring>
+
+namespace smk {
+
+namespace {
+
+const size_t kHeaderSize = 14;
+const uint8_t kEndMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+// Reject the dimensions whose pixels wouldn't fit in memory.
+const uint32_t kMaxPixels = 400000000;
+
+const uint8_t kOpIndex = 0x00;  // 00xxxxxx
+const uint8_t kOpDiff = 0x40;   // 01xxxxxx
+const uint8_t kOpLuma = 0x80;   // 10xxxxxx
+const uint8_t kOpRun = 0xC0;    // 11xxxxxx
+const uint8_t kOpRGB = 0xFE;
+const uint8_t kOpRGBA = 0xFF;
+const uint8_t kMask = 0xC0;
+
+uint32_t ReadU32BigEndian(const uint8_t* data) {
+  return uint32_t(data[0]) << 24 | uint32_t(data[1]) << 16 |
+         uint32_t(data[2]) << 8 | uint32_t(data[3]);
+}
+
+struct Pixel {
+  uint8_t r = 0;
+  uint8_t g = 0;
+  uint8_t b = 0;
+  uint8_t a = 255;
+
+  int Hash() const { return (r * 3 + g * 5 + b * 7 + a * 11) % 64; }
+};
+
+}  // namespace
+
+bool QoiDecoder::Accept(const uint8_t* data, size_t size) const {
+  return size >= kHeaderSize && !std::memcmp(data, "qoif", 4);
+}
+
+bool QoiDecoder::Decode(const uint8_t* data,
+                        size_t size,
+                        Image* image) const {
+  if (size < kHeaderSize + sizeof(kEndMarker) || !Accept(data, size))
+    return false;
+
+  const uint32_t width = ReadU32BigEndian(data + 4);
+  const uint32_t height = ReadU32BigEndian(data + 8);
+  const int channels = data[12];
+  if (!width || !height || height > kMaxPixels / width ||
+      (channels != 3 && channels != 4)) {
+    return false;
+  }
+
+  image->width = int(width);
+  image->height = int(height);
+  image->channels = channels;
+  const size_t count = size_t(width) * height;
+  image->pixels.resize(count * channels);
+  uint8_t* out = image->pixels.data();
+
+  // The previously seen pixels start transparent black, unlike the first one.
+  Pixel index[64];
+  for (Pixel& it : index)
+    it.a = 0;
+  Pixel pixel;
+  int run = 0;
+  size_t p = kHeaderSize;
+  const size_t end = size - sizeof(kEndMarker);
+  for (size_t i = 0; i < count; ++i) {
+    if (run > 0) {
+      --run;
+    } else if (p < end) {
+      const uint8_t op = data[p++];
+      if (op == kOpRGB) {
+        if (p + 3 > end)
+          return false;
+        pixel.r = data[p++];
+        pixel.g = data[p++];
+        pixel.b = data[p++];
+      } else if (op == kOpRGBA) {
+        if (p + 4 > end)
+          return false;
+        pixel.r = data[p++];
+        pixel.g = data[p++];
+        pixel.b = data[p++];
+        pixel.a = data[p++];
+      } else if ((op & kMask) == kOpIndex) {
+        pixel = index[op];
+      } else if ((op & kMask) == kOpDiff) {
+        pixel.r += ((op >> 4) & 0x03) - 2;
+        pixel.g += ((op >> 2) & 0x03) - 2;
+        pixel.b += (op & 0x03) - 2;
+      } else if ((op & kMask) == kOpLuma) {
+        if (p + 1 > end)
+          return false;
+        const uint8_t next = data[p++];
+        const int dg = (op & 0x3F) - 32;
+        pixel.r += dg - 8 + ((next >> 4) & 0x0F);
+        pixel.g += dg;
+        pixel.b += dg - 8 + (next & 0x0F);
+      } else if ((op & kMask) == kOpRun) {
+        run = op & 0x3F;
+      }
+      index[pixel.Hash()] = pixel;
+    }
+
+    out[0] = pixel.r;
+    out[1] = pixel.g;
+    out[2] = pixel.b;
+    if (channels == 4)
+      out[3] = pixel.a;
+    out += channels;
+  }
+  return true;
+}
+
+}  // namespace smk
@@ -0,0 +1,23 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_QOI_DECODER_HPP
+#define SMK_QOI_DECODER_HPP
+
+#include <smk/ImageDecoder.hpp>
+
+namespace smk {
+
+// Decode the "Quite OK Image" format. It is lossless, like PNG, but decodes
+// several times faster, in a single pass without entropy coding.
+// See https://qoiformat.org/qoi-specification.pdf
+class QoiDecoder : public ImageDecoder {
+ public:
+  const char* name() const override { return "qoi"; }
+  bool Accept(const uint8_t* data, size_t size) const override;
+  bool Decode(const uint8_t* data, size_t size, Image* image) const override;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_QOI_DECODER_HPP */
@@ -0,0 +1,255 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <iostream>
+#include <smk/RenderGraph.hpp>
+
+namespace smk {
+
+RenderGraph::RenderGraph() = default;
+RenderGraph::~RenderGraph() = default;
+RenderGraph::RenderGraph(RenderGraph&&) noexcept = default;
+RenderGraph& RenderGraph::operator=(RenderGraph&&) noexcept = default;
+
+/// @brief Declare a transient target, backed by a pooled Framebuffer.
+/// @param width The width of the target.
+/// @param height The height of the target.
+/// @param depth_stencil Whether the target needs a depth-stencil buffer.
+RenderGraph::Target RenderGraph::CreateTarget(int width,
+                                              int height,
+                                              bool depth_stencil) {
+  Resource resource;
+  resource.width = width;
+  resource.height = height;
+  resource.depth_stencil = depth_stencil;
+  resources_.push_back(resource);
+  return Target(resources_.size() - 1);
+}
+
+/// @brief Declare a target owned by the caller, for instance the Window. The
+/// passes writing into it are always executed.
+RenderGraph::Target RenderGraph::ImportTarget(RenderTarget& render_target) {
+  Resource resource;
+  resource.imported = &render_target;
+  resources_.push_back(resource);
+  return Target(resources_.size() - 1);
+}
+
+/// @brief Declare a Framebuffer owned by the caller. It can be read by the
+/// passes.
+RenderGraph::Target RenderGraph::ImportTarget(Framebuffer& framebuffer) {
+  Resource resource;
+  resource.imported = &framebuffer;
+  resource.framebuffer = &framebuffer;
+  resources_.push_back(resource);
+  return Target(resources_.size() - 1);
+}
+
+/// @brief Declare a pass.
+/// @param name The name of the pass, reported by executed_passes().
+/// @param inputs The targets whose color texture is read by the pass.
+/// @param output The target drawn by the pass.
+/// @param execution The function drawing the pass.
+void RenderGraph::AddPass(const std::string& name,
+                          std::vector<Target> inputs,
+                          Target output,
+                          Execution execution) {
+  passes_.push_back(
+      {name, std::move(inputs), output, std::move(execution)});
+}
+
+/// @brief Remove every passes and targets. The Framebuffers allocated so far
+/// are kept for the next frames.
+void RenderGraph::Clear() {
+  passes_.clear();
+  resources_.clear();
+}
+
+// Whether the pass |reader| reads a version of its input |target| written by
+// a pass declared before it.
+static bool ReadsEarlierWrite(const std::vector<int>& writers,
+                              int reader) {
+  return std::any_of(writers.begin(), writers.end(),
+                     [&](int writer) { return writer < reader; });
+}
+
+/// @brief Execute the passes contributing to an imported target, in dependency
+/// order.
+void RenderGraph::Execute() {
+  const int pass_count = int(passes_.size());
+  executed_passes_.clear();
+  ++execution_;
+
+  // The passes writing every targets.
+  std::vector<std::vector<int>> writers(resources_.size());
+  for (int i = 0; i < pass_count; ++i)
+    writers[passes_[i].output].push_back(i);
+
+  // A pass reads the targets written by the passes declared before it. When
+  // none are, it reads the ones written by the passes declared after it.
+  std::vector<std::vector<int>> dependencies(pass_count);
+  for (int i = 0; i < pass_count; ++i) {
+    const Pass& pass = passes_[i];
+    for (Target input : pass.inputs) {
+      const bool earlier = ReadsEarlierWrite(writers[input], i);
+      for (int writer : writers[input]) {
+        if (writer != i && (writer < i || !earlier))
+          dependencies[i].push_back(writer);
+      }
+    }
+    // Consecutive writes of the same target keep their order.
+    for (int writer : writers[pass.output]) {
+      if (writer < i)
+        dependencies[i].push_back(writer);
+    }
+  }
+  // A write waits for the passes reading the previous version of the target.
+  for (int i = 0; i < pass_count; ++i) {
+    for (Target input : passes_[i].inputs) {
+      if (!ReadsEarlierWrite(writers[input], i))
+        continue;
+      for (int writer : writers[input]) {
+        if (writer > i)
+          dependencies[writer].push_back(i);
+      }
+    }
+  }
+
+  // Cull the passes not contributing to an imported target.
+  std::vector<bool> needed(pass_count, false);
+  std::vector<int> stack;
+  for (int i = 0; i < pass_count; ++i) {
+    if (resources_[passes_[i].output].imported) {
+      needed[i] = true;
+      stack.push_back(i);
+    }
+  }
+  while (!stack.empty()) {
+    int pass = stack.back();
+    stack.pop_back();
+    for (int dependency : dependencies[pass]) {
+      if (!needed[dependency]) {
+        needed[dependency] = true;
+        stack.push_back(dependency);
+      }
+    }
+  }
+
+  // Order the passes. Among the ready ones, the first declared goes first. A
+  // cycle is broken using the declaration order.
+  std::vector<int> order;
+  std::vector<bool> done(pass_count, false);
+  for (int i = 0; i < pass_count; ++i)
+    done[i] = !needed[i];
+  while (true) {
+    int next = -1;
+    int fallback = -1;
+    for (int i = 0; i < pass_count && next == -1; ++i) {
+      if (done[i])
+        continue;
+      if (fallback == -1)
+        fallback = i;
+      bool ready = std::all_of(dependencies[i].begin(), dependencies[i].end(),
+                               [&](int dependency) { return done[dependency]; });
+      if (ready)
+        next = i;
+    }
+    if (next == -1)
+      next = fallback;
+    if (next == -1)
+      break;
+    done[next] = true;
+    order.push_back(next);
+  }
+
+  // The last position using every transient target.
+  std::vector<int> last_use(resources_.size(), -1);
+  for (int position = 0; position < int(order.size()); ++position) {
+    const Pass& pass = passes_[order[position]];
+    last_use[pass.output] = position;
+    for (Target input : pass.inputs)
+      last_use[input] = position;
+  }
+
+  for (int position = 0; position < int(order.size()); ++position) {
+    Pass& pass = passes_[order[position]];
+
+    std::vector<Texture> inputs;
+    for (Target input : pass.inputs) {
+      Resource& resource = resources_[input];
+      if (!resource.framebuffer && !resource.imported)
+        resource.framebuffer = Acquire(resource);
+      if (resource.framebuffer) {
+        inputs.push_back(resource.framebuffer->color_texture());
+      } else {
+        std::cerr << "SMK > RenderGraph: The pass " << pass.name
+                  << " reads a target that isn't a Framebuffer" << std::endl;
+        inputs.push_back(Texture());
+      }
+    }
+
+    Resource& output = resources_[pass.output];
+    if (!output.framebuffer && !output.imported)
+      output.framebuffer = Acquire(output);
+    RenderTarget& target =
+        output.imported ? *output.imported : *output.framebuffer;
+
+    pass.execution(target, inputs);
+    target.Flush();
+    executed_passes_.push_back(pass.name);
+
+    // Only the color of the transient targets is read by the next passes.
+    if (!output.imported && output.depth_stencil)
+      target.Invalidate(RenderTarget::Depth | RenderTarget::Stencil);
+
+    // Give back the targets no longer used.
+    for (size_t i = 0; i < resources_.size(); ++i) {
+      Resource& resource = resources_[i];
+      if (last_use[i] == position && !resource.imported &&
+          resource.framebuffer) {
+        Release(resource.framebuffer);
+        resource.framebuffer = nullptr;
+      }
+    }
+  }
+
+  // Delete the Framebuffers no longer needed, so that the pool doesn't keep
+  // the peak usage forever.
+  pool_.erase(std::remove_if(pool_.begin(), pool_.end(),
+                             [&](const Pooled& pooled) {
+                               return !pooled.used &&
+                                      execution_ - pooled.last_execution >
+                                          kPoolLifetime;
+                             }),
+              pool_.end());
+}
+
+Framebuffer* RenderGraph::Acquire(const Resource& resource) {
+  for (Pooled& pooled : pool_) {
+    if (!pooled.used && pooled.framebuffer->width() == resource.width &&
+        pooled.framebuffer->height() == resource.height &&
+        pooled.depth_stencil == resource.depth_stencil) {
+      pooled.used = true;
+      pooled.last_execution = execution_;
+      return pooled.framebuffer.get();
+    }
+  }
+
+  Framebuffer::Option option;
+  option.depth_stencil = resource.depth_stencil;
+  pool_.push_back({std::make_unique<Framebuffer>(resource.width,
+                                                 resource.height, option),
+                   resource.depth_stencil, true, execution_});
+  return pool_.back().framebuffer.get();
+}
+
+void RenderGraph::Release(Framebuffer* framebuffer) {
+  for (Pooled& pooled : pool_) {
+    if (pooled.framebuffer.get() == framebuffer)
+      pooled.used = false;
+  }
+}
+
+}  // namespace smk
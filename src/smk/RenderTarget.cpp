@@ -3,12 +3,33 @@
 // the LICENSE file.
 
 #include <smk/Color.hpp>
+#include <smk/CommandList.hpp>
 #include <smk/Drawable.hpp>
+#include <smk/Frustum.hpp>
+#include <smk/Profiler.hpp>
 #include <smk/RenderTarget.hpp>
 #include <smk/Texture.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ContextScope.hpp"
+#include "ResidencyTracker.hpp"
 
 namespace smk {
-bool g_invalidate_textures = false;
+// Every thread drawing uses its own OpenGL context. It has its own bindings and
+// statistics. See Window::Option::render_thread.
+thread_local bool g_invalidate_textures = false;
+thread_local bool g_invalidate_shader_program = false;
+thread_local RenderStats g_render_stats;
+extern thread_local bool g_invalidate_vertex_array;
+extern std::atomic<int> g_render_threads;
 namespace {
 
 const Texture& WhiteTexture() {
@@ -20,17 +41,457 @@ const Texture& WhiteTexture() {
   return white_texture;
 }
 
-RenderTarget* render_target = nullptr;
-RenderState cached_render_state_;
+// What is known to be bound in an OpenGL context. The windows sharing their
+// objects still have their own bindings.
+struct ContextState {
+  RenderTarget* render_target = nullptr;
+  RenderState cached_render_state;
+
+  // The FrameBlock buffer of this context, and its content.
+  GLuint frame_block_buffer = 0;
+  FrameBlock uploaded_frame_block;
+};
+std::map<GLFWwindow*, ContextState> g_context_states;
+std::mutex g_context_states_mutex;
+thread_local GLFWwindow* g_current_context = nullptr;
+thread_local ContextState* g_context_state = nullptr;
+
+// The state of the current OpenGL context.
+ContextState& CurrentContextState() {
+  GLFWwindow* context = glfwGetCurrentContext();
+  if (!g_context_state || context != g_current_context) {
+    std::lock_guard<std::mutex> lock(g_context_states_mutex);
+    g_current_context = context;
+    g_context_state = &g_context_states[context];
+    // The objects created meanwhile may have changed the bindings.
+    g_invalidate_textures = true;
+    g_invalidate_vertex_array = true;
+    g_invalidate_shader_program = true;
+  }
+  return *g_context_state;
+}
+
+static_assert(sizeof(FrameBlock) == 112, "FrameBlock must match std140");
+thread_local FrameBlock frame_block_;
+
+// The pixels being copied from a RenderTarget into a pixel buffer.
+struct Readback {
+  GLuint buffer;
+  size_t capacity;  // The size of the buffer storage, in bytes.
+  GLsync fence;
+  int width;
+  int height;
+  RenderTarget::ReadbackCallback callback;
+};
+std::vector<Readback> g_readbacks;
+// The pixel buffers no longer used, with the size of their storage.
+std::vector<std::pair<GLuint, size_t>> g_free_readback_buffers;
+
+// The default 2D shaders. When INSTANCED is defined, the 2x3 affine
+// transformation and the color of every instance are read from the vertex
+// attributes. When GLYPH is defined, the texture has a single channel holding
+// the alpha of a white texel, as in the Font atlas. When DISTANCE_FIELD is
+// defined, this channel is a signed distance field instead, as produced by
+// Font::Rendering::DistanceField. When TEXTURE_ARRAY is defined, the texture is
+// a GL_TEXTURE_2D_ARRAY and every vertex selects its layer. When VERTEX_COLOR
+// is defined, every vertex has a color, multiplied by the "color" uniform. When
+// PARTICLES is defined, the instances are Particle2D: the shape is scaled by
+// the size of the particle, and moved to its position.
+const char* kVertexShader2D = R"(
+  layout(location = 0) in vec2 space_position;
+  layout(location = 1) in vec2 texture_position;
+#ifdef TEXTURE_ARRAY
+  layout(location = 2) in float texture_layer;
+  out float f_texture_layer;
+#endif
+#ifdef VERTEX_COLOR
+  layout(location = 2) in vec4 vertex_color;
+  out vec4 f_color;
+#endif
+#if defined(PARTICLES)
+  layout(location = 3) in vec2 instance_position;
+  layout(location = 5) in vec3 instance_life;  // age, lifetime, size.
+  layout(location = 7) in vec4 instance_color;
+  out vec4 f_color;
+#elif defined(INSTANCED)
+  layout(location = 3) in vec3 instance_row_x;
+  layout(location = 4) in vec3 instance_row_y;
+  layout(location = 7) in vec4 instance_color;
+  out vec4 f_color;
+#endif
+
+  layout(std140) uniform smk_frame {
+    mat4 projection;
+    vec4 light_position;
+    float time;
+    float ambient;
+    float diffuse;
+    float specular;
+    float specular_power;
+  };
+  uniform mat4 view;
+  uniform vec4 texture_rectangle;
+
+  out vec2 f_texture_position;
+
+  void main() {
+    f_texture_position =
+        mix(texture_rectangle.xy, texture_rectangle.zw, texture_position);
+#ifdef TEXTURE_ARRAY
+    f_texture_layer = texture_layer;
+#endif
+#ifdef VERTEX_COLOR
+    f_color = vertex_color;
+#endif
+#if defined(PARTICLES)
+    vec2 position = instance_position + space_position * instance_life.z;
+    f_color = instance_color;
+    gl_Position = projection * view * vec4(position, 0.0, 1.0);
+#elif defined(INSTANCED)
+    vec3 position = vec3(space_position, 1.0);
+    position.xy = vec2(dot(instance_row_x, position),
+                       dot(instance_row_y, position));
+    f_color = instance_color;
+    gl_Position = projection * view * vec4(position.xy, 0.0, 1.0);
+#else
+    gl_Position = projection * view * vec4(space_position, 0.0, 1.0);
+#endif
+  }
+)";
+
+const char* kFragmentShader2D = R"(
+  in vec2 f_texture_position;
+  uniform vec4 color;
+#if defined(INSTANCED) || defined(VERTEX_COLOR)
+  in vec4 f_color;
+#endif
+  out vec4 out_color;
+
+#ifdef TEXTURE_ARRAY
+  uniform sampler2DArray texture_0;
+  in float f_texture_layer;
+  vec4 Sample(vec2 position) {
+    return texture(texture_0, vec3(position, f_texture_layer));
+  }
+#else
+  uniform sampler2D texture_0;
+  vec4 Sample(vec2 position) {
+    return texture(texture_0, position);
+  }
+#endif
+
+  void main() {
+#if defined(DISTANCE_FIELD)
+    // The distance to the outline is 0.5 on it. Antialias over the width of a
+    // screen pixel.
+    float distance = Sample(f_texture_position).r;
+    float width = max(0.7 * fwidth(distance), 0.0001);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+    out_color = vec4(1.0, 1.0, 1.0, alpha) * color;
+#elif defined(GLYPH)
+    float alpha = Sample(f_texture_position).r;
+    out_color = vec4(1.0, 1.0, 1.0, alpha) * color;
+#else
+    out_color = Sample(f_texture_position) * color;
+#endif
+#if defined(INSTANCED) || defined(VERTEX_COLOR)
+    out_color *= f_color;
+#endif
+  }
+)";
+
+// The default 3D shaders. When INSTANCED is defined, the transformation and the
+// color of every instance are read from the vertex attributes.
+const char* kVertexShader3D = R"(
+  layout(location = 0) in vec3 space_position;
+  layout(location = 1) in vec3 normal;
+  layout(location = 2) in vec2 texture_position;
+#ifdef INSTANCED
+  layout(location = 3) in mat4 instance_transformation;
+  layout(location = 7) in vec4 instance_color;
+  out vec4 fColor;
+#endif
+
+  layout(std140) uniform smk_frame {
+    mat4 projection;
+    vec4 light_position;
+    float time;
+    float ambient;
+    float diffuse;
+    float specular;
+    float specular_power;
+  };
+  uniform mat4 view;
+
+  out vec4 fPosition;
+  out vec2 fTexture;
+  out vec3 fNormal;
+
+  void main() {
+#ifdef INSTANCED
+    mat4 model_view = view * instance_transformation;
+    fColor = instance_color;
+#else
+    mat4 model_view = view;
+#endif
+    fTexture = texture_position;
+    fPosition = model_view * vec4(space_position,1.0);
+    fNormal = vec3(model_view * vec4(normal,0.0));
+
+    gl_Position = projection * fPosition;
+  }
+)";
+
+const char* kFragmentShader3D = R"(
+  uniform sampler2D texture_0;
+  uniform vec4 color;
+
+  layout(std140) uniform smk_frame {
+    mat4 projection;
+    vec4 light_position;
+    float time;
+    float ambient;
+    float diffuse;
+    float specular;
+    float specular_power;
+  };
+
+  in vec4 fPosition;
+  in vec2 fTexture;
+  in vec3 fNormal;
+#ifdef INSTANCED
+  in vec4 fColor;
+#endif
+
+  out vec4 out_color;
+
+  void main(void)
+  {
+    vec3 object_dir =-normalize(fPosition.xyz);
+    vec3 normal_dir = normalize(fNormal);
+    vec3 light_dir = normalize(light_position.xyz-fPosition.xyz);
+    vec3 reflect_dir = -reflect(object_dir,normal_dir);
+
+    float diffuse_strength = max(0.0, dot(normal_dir, light_dir));
+    float specular_strength = pow(max(0.0, dot(reflect_dir, light_dir)),
+                                  specular_power);
+
+    out_color = texture(texture_0, fTexture);
+    out_color.rgb *= ambient +
+                     diffuse * diffuse_strength +
+                     specular * specular_strength;
+    out_color *= color;
+#ifdef INSTANCED
+    out_color *= fColor;
+#endif
+  }
+)";
+
+// The shaders are kept until the program is linked: with the binary cache,
+// their compilation is delayed until Link().
+void BuildProgram(ShaderProgram& program,
+                  const std::string& vertex_shader,
+                  const std::string& fragment_shader) {
+  Shader vertex = Shader::FromString(vertex_shader, GL_VERTEX_SHADER);
+  Shader fragment = Shader::FromString(fragment_shader, GL_FRAGMENT_SHADER);
+  program.AddShader(vertex);
+  program.AddShader(fragment);
+  program.Link();
+}
+
+// Upload the FrameBlock when it changed since the last draw.
+// Every context uses its own buffer, so that the contexts drawing
+// concurrently don't overwrite each other's.
+void UpdateFrameBlock(ContextState& context) {
+  if (!context.frame_block_buffer) {
+    glGenBuffers(1, &context.frame_block_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, context.frame_block_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), &frame_block_,
+                 GL_DYNAMIC_DRAW);
+    ++g_render_stats.buffer_allocations;
+    glBindBufferBase(GL_UNIFORM_BUFFER, FrameBlock::kBinding,
+                     context.frame_block_buffer);
+    context.uploaded_frame_block = frame_block_;
+    return;
+  }
+
+  if (!std::memcmp(&frame_block_, &context.uploaded_frame_block,
+                   sizeof(FrameBlock)))
+    return;
+  context.uploaded_frame_block = frame_block_;
+  glBindBuffer(GL_UNIFORM_BUFFER, context.frame_block_buffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &frame_block_);
+}
+
+// The key used to sort the deferred draws. The most expensive state changes
+// are in the most significant bits. Two different states can share the same
+// key; this only makes the sorting less effective.
+uint64_t SortKey(const RenderState& state) {
+  const VertexArray& vertex_array = state.instances.size()
+                                        ? state.instances.vertex_array()
+                                        : state.vertex_array;
+  uint64_t program = state.shader_program.id() & 0xFFF;
+  uint64_t texture = state.texture.id();
+  for (const Texture& extra : state.textures)
+    texture = texture * 31 + extra.id();
+  texture &= 0xFFFFF;
+  uint64_t blend_mode = (state.blend_mode.src_rgb ^ state.blend_mode.dst_rgb ^
+                         state.blend_mode.src_alpha ^
+                         state.blend_mode.dst_alpha ^
+                         state.blend_mode.equation_rgb ^
+                         state.blend_mode.equation_alpha) &
+                        0xFF;
+  uint64_t buffer = vertex_array.vbo() & 0xFFFFFF;
+  return program << 52 | texture << 32 | blend_mode << 24 | buffer;
+}
+
+// The depth of the center of the drawn geometry, as compared by the depth
+// test: the normalized z after the projection. Unlike the view space z, it
+// orders the draws correctly whatever the projection.
+float DepthKey(const RenderState& state, const glm::mat4& projection_matrix) {
+  const VertexArray& vertex_array = state.instances.size()
+                                        ? state.instances.vertex_array()
+                                        : state.vertex_array;
+  const BoundingBox& bounds = vertex_array.bounds();
+  if (bounds.empty())
+    return 0.f;
+  const glm::vec4 clip =
+      projection_matrix * state.view * glm::vec4(bounds.center(), 1.f);
+  // Behind the eye of a perspective projection: nearer than everything else.
+  if (clip.w <= 0.f)
+    return -std::numeric_limits<float>::infinity();
+  return clip.z / clip.w;
+}
+
+// The area covered by the drawn geometry, in normalized device coordinates:
+// {min x, min y, max x, max y}. It covers everything when unknown.
+glm::vec4 ScreenArea(const RenderState& state,
+                     const glm::mat4& projection_matrix) {
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  const glm::vec4 everything = {-inf, -inf, inf, inf};
+  // The bounds of the instances don't include the instanced geometry.
+  if (state.instances.size())
+    return everything;
+  const BoundingBox& bounds = state.vertex_array.bounds();
+  if (bounds.empty())
+    return everything;
+
+  const glm::mat4 transform = projection_matrix * state.view;
+  glm::vec4 area = {inf, inf, -inf, -inf};
+  for (int i = 0; i < 8; ++i) {
+    const glm::vec4 corner =
+        transform * glm::vec4((i & 1) ? bounds.max.x : bounds.min.x,
+                              (i & 2) ? bounds.max.y : bounds.min.y,
+                              (i & 4) ? bounds.max.z : bounds.min.z, 1.f);
+    if (corner.w <= 0.f)
+      return everything;
+    const float x = corner.x / corner.w;
+    const float y = corner.y / corner.w;
+    area.x = std::min(area.x, x);
+    area.y = std::min(area.y, y);
+    area.z = std::max(area.z, x);
+    area.w = std::max(area.w, y);
+  }
+  return area;
+}
+
+bool Overlap(const glm::vec4& a, const glm::vec4& b) {
+  return a.x < b.z && b.x < a.z && a.y < b.w && b.y < a.w;
+}
+
+// The number of batches a deferred 2D draw looks back to find one it can join.
+constexpr size_t kBatchLookback = 32;
+
+// The depth test of the bound render target, used while submitting the depth
+// sorted draws.
+enum DepthMode { kDepthOff, kDepthWrite, kDepthTest };
+void SetDepthModeBound(int mode) {
+  if (mode == kDepthOff) {
+    glDisable(GL_DEPTH_TEST);
+  } else {
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+  }
+  glDepthMask(mode == kDepthTest ? GL_FALSE : GL_TRUE);
+}
+
+// Disable the scissor test of the current context.
+void DisableScissorBound() {
+  RenderState& cached_render_state = CurrentContextState().cached_render_state;
+  if (!cached_render_state.clip)
+    return;
+  cached_render_state.clip = false;
+  glDisable(GL_SCISSOR_TEST);
+}
+
+// Clear the bound render target.
+void ClearBound(const glm::vec4& color, int attachments) {
+  DisableScissorBound();  // The scissor test applies to glClear().
+  GLbitfield mask = 0;
+  if (attachments & RenderTarget::Color) {
+    glClearColor(color.r, color.g, color.b, color.a);
+    mask |= GL_COLOR_BUFFER_BIT;
+  }
+  if (attachments & RenderTarget::Depth)
+    mask |= GL_DEPTH_BUFFER_BIT;
+  if (attachments & RenderTarget::Stencil)
+    mask |= GL_STENCIL_BUFFER_BIT;
+  if (mask)
+    glClear(mask);
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_CULL_FACE);
+}
+
+// Invalidate some attachments of the bound render target.
+void InvalidateBound(GLuint frame_buffer,
+                     int color_attachment_count,
+                     int attachments) {
+  std::vector<GLenum> buffers;
+  if (frame_buffer == 0) {
+    // The default framebuffer uses its own names.
+    if (attachments & RenderTarget::Color)
+      buffers.push_back(GL_COLOR);
+    if (attachments & RenderTarget::Depth)
+      buffers.push_back(GL_DEPTH);
+    if (attachments & RenderTarget::Stencil)
+      buffers.push_back(GL_STENCIL);
+  } else {
+    if (attachments & RenderTarget::Color) {
+      for (int i = 0; i < color_attachment_count; ++i)
+        buffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+    }
+    const bool depth = attachments & RenderTarget::Depth;
+    const bool stencil = attachments & RenderTarget::Stencil;
+    if (depth && stencil)
+      buffers.push_back(GL_DEPTH_STENCIL_ATTACHMENT);
+    else if (depth)
+      buffers.push_back(GL_DEPTH_ATTACHMENT);
+    else if (stencil)
+      buffers.push_back(GL_STENCIL_ATTACHMENT);
+  }
+
+  if (!buffers.empty())
+    glInvalidateFramebuffer(GL_FRAMEBUFFER, buffers.size(), buffers.data());
+}
 
 }  // namespace
 
+// The callers hold a ContextScope, restoring the previous context afterward.
 void RenderTarget::Bind(RenderTarget* target) {
-  if (render_target == target)
+  // The target is bound by the thread replaying its commands.
+  if (target->recording_)
+    return;
+
+  // With several windows, draw using the context owning the target.
+  if (target->context_ && target->context_ != glfwGetCurrentContext())
+    glfwMakeContextCurrent(target->context_);
+
+  ContextState& context = CurrentContextState();
+  if (context.render_target == target)
     return;
-  render_target = target;
-  glBindFramebuffer(GL_FRAMEBUFFER, render_target->frame_buffer_);
-  glViewport(0, 0, render_target->width_, render_target->height_);
+  context.render_target = target;
+  glBindFramebuffer(GL_FRAMEBUFFER, target->frame_buffer_);
+  glViewport(0, 0, target->width_, target->height_);
 }
 
 /// @brief Build an invalid RenderTarget.
@@ -48,24 +509,57 @@ void RenderTarget::operator=(RenderTarget&& other) noexcept {
   std::swap(height_, other.height_);
   std::swap(projection_matrix_, other.projection_matrix_);
   std::swap(view_, other.view_);
-  std::swap(vertex_shader_2d_, other.vertex_shader_2d_);
-  std::swap(fragment_shader_2d_, other.fragment_shader_2d_);
-  std::swap(shader_program_2d_, other.shader_program_2d_);
-  std::swap(vertex_shader_3d_, other.vertex_shader_3d_);
-  std::swap(fragment_shader_3d_, other.fragment_shader_3d_);
-  std::swap(shader_program_3d_, other.shader_program_3d_);
+  std::swap(clips_, other.clips_);
+  std::swap(default_programs_, other.default_programs_);
   std::swap(shader_program_, other.shader_program_);
+  std::swap(context_, other.context_);
+  std::swap(recording_, other.recording_);
   std::swap(frame_buffer_, other.frame_buffer_);
+  std::swap(color_attachment_count_, other.color_attachment_count_);
+  std::swap(queue_, other.queue_);
+  std::swap(deferred_, other.deferred_);
+  std::swap(layer_, other.layer_);
 }
 
 /// @brief Clear the surface with a single color.
 /// @param color: An opaque color to fill the surface.
 void RenderTarget::Clear(const glm::vec4& color) {
+  Clear(color, All);
+}
+
+/// @brief Clear some attachments of the render target. Clearing every
+/// attachments at the beginning of a pass lets tiled GPUs skip loading their
+/// previous content.
+/// @param color The color used to clear the color attachment.
+/// @param attachments A combination of RenderTarget::Attachment.
+void RenderTarget::Clear(const glm::vec4& color, int attachments) {
+  Flush();
+  if (recording_) {
+    recording_->push_back({Command::Clear, attachments, color});
+    return;
+  }
+  ContextScope context(context_);
   Bind(this);
-  glClearColor(color.r, color.g, color.b, color.a);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-  glDisable(GL_DEPTH_TEST);
-  glDisable(GL_CULL_FACE);
+  ClearBound(color, attachments);
+}
+
+/// @brief Discard the content of some attachments. On tiled GPUs, this avoids
+/// storing them back to memory at the end of the pass. Does nothing when
+/// glInvalidateFramebuffer isn't supported.
+/// @param attachments A combination of RenderTarget::Attachment.
+void RenderTarget::Invalidate(int attachments) {
+#ifndef __EMSCRIPTEN__
+  if (!GLEW_VERSION_4_3 && !GLEW_ARB_invalidate_subdata)
+    return;
+#endif
+  Flush();
+  if (recording_) {
+    recording_->push_back({Command::Invalidate, attachments});
+    return;
+  }
+  ContextScope context(context_);
+  Bind(this);
+  InvalidateBound(frame_buffer_, color_attachment_count_, attachments);
 }
 
 /// @brief Set the View to use.
@@ -94,6 +588,103 @@ const View& RenderTarget::view() const {
   return view_;
 }
 
+/// @brief Restrict the next draws to a rectangle of the surface. The draws
+/// already made aren't affected. Every PushClip() must be followed by a
+/// PopClip().
+/// @param rectangle The visible area, in pixels from the top-left corner of the
+///                  surface, as (left, top, right, bottom). It is intersected
+///                  with the clip rectangle in use.
+///
+/// ## Example:
+///
+/// ~~~cpp
+/// // A scrolled panel.
+/// window.PushClip({10, 10, 210, 110});
+/// panel_content.SetPosition(10.f, 10.f - scroll);
+/// window.Draw(panel_content);
+/// window.PopClip();
+/// ~~~
+void RenderTarget::PushClip(const glm::ivec4& rectangle) {
+  glm::ivec4 clip = rectangle;
+  if (!clips_.empty()) {
+    const glm::ivec4& parent = clips_.back();
+    clip.x = std::max(clip.x, parent.x);
+    clip.y = std::max(clip.y, parent.y);
+    clip.z = std::min(clip.z, parent.z);
+    clip.w = std::min(clip.w, parent.w);
+  }
+  clips_.push_back(clip);
+}
+
+/// @brief Restore the clip rectangle in use before the last PushClip().
+void RenderTarget::PopClip() {
+  if (clips_.empty()) {
+    std::cerr << "SMK > PopClip() called without PushClip()" << std::endl;
+    return;
+  }
+  clips_.pop_back();
+}
+
+/// @brief Clip a draw with the clip rectangle in use, if any.
+/// @param state The state the drawables derive from.
+void RenderTarget::ApplyClip(RenderState& state) const {
+  if (clips_.empty())
+    return;
+  const glm::ivec4& clip = clips_.back();
+  state.clip = true;
+  state.clip_box = glm::ivec4(clip.x, height_ - clip.w,
+                              std::max(0, clip.z - clip.x),
+                              std::max(0, clip.w - clip.y));
+}
+
+/// @brief Disable the clipping of the current OpenGL context.
+// static
+void RenderTarget::DisableClipBound() {
+  DisableScissorBound();
+}
+
+/// @brief Test a volume against the frustum of the projection of this
+/// RenderTarget.
+/// @param bounds The volume, in the local space of a drawable.
+/// @param view The transformation applied to the drawable.
+/// @return Whether the volume may be visible. Empty bounds are unknown, and
+/// always reported visible.
+bool RenderTarget::IsVisible(const BoundingBox& bounds,
+                             const glm::mat4& view) const {
+  if (!frustum_culling_ || bounds.empty())
+    return true;
+  if (Frustum(projection_matrix_ * view).Intersects(bounds))
+    return true;
+  ++g_render_stats.culled_draws;
+  return false;
+}
+
+/// @brief The size of a volume on the screen, used to select a level of
+/// detail.
+/// @param bounds The volume, in the local space of a drawable.
+/// @param view The transformation applied to the drawable.
+/// @return The diameter of the bounding sphere of |bounds|, in pixels.
+float RenderTarget::ProjectedSize(const BoundingBox& bounds,
+                                  const glm::mat4& view) const {
+  if (bounds.empty())
+    return 0.f;
+
+  // The sphere in the view space. |view| can scale it.
+  glm::vec4 center = view * glm::vec4(bounds.center(), 1.f);
+  float scale = std::max({glm::length(glm::vec3(view[0])),
+                          glm::length(glm::vec3(view[1])),
+                          glm::length(glm::vec3(view[2]))});
+  float radius = bounds.radius() * scale;
+
+  // Project the center and a point on the sphere facing the camera.
+  glm::vec4 a = projection_matrix_ * center;
+  glm::vec4 b = projection_matrix_ * (center + glm::vec4(radius, 0.f, 0.f, 0.f));
+  if (a.w <= 0.f || b.w <= 0.f)
+    return 0.f;
+  glm::vec2 delta = glm::vec2(b) / b.w - glm::vec2(a) / a.w;
+  return glm::length(delta * glm::vec2(width_, height_));
+}
+
 /// @brief Set the ShaderProgram to be used.
 /// @param shader_program: The ShaderProgram to be used.
 ///
@@ -134,82 +725,693 @@ const View& RenderTarget::view() const {
 ///
 /// window.SetShaderProgram(shader_program);
 /// ~~~
+///
+/// Instead of the "projection" uniform, the program can declare the
+/// "smk_frame" uniform block. See smk::FrameBlock.
 /// {
 void RenderTarget::SetShaderProgram(ShaderProgram& shader_program) {
   shader_program_ = shader_program;
+  // The program may be in use by the thread replaying the commands. The
+  // uniforms are assigned when the draws are replayed.
+  if (recording_)
+    return;
   shader_program_.Use();
-  shader_program_.SetUniform("texture_0", 0);
+  shader_program_.AssignTextureUnits();
   shader_program_.SetUniform("color", glm::vec4(1.0, 1.0, 1.0, 1.0));
-  shader_program_.SetUniform("projection", glm::mat4(1.0));
+  if (!shader_program_.UsesFrameBlock())
+    shader_program_.SetUniform("projection", glm::mat4(1.0));
   shader_program_.SetUniform("view", glm::mat4(1.0));
 }
 
+/// @brief The state shared by every ShaderProgram declaring the "smk_frame"
+/// uniform block. It is uploaded only when modified.
+/// @see FrameBlock
+// static
+FrameBlock& RenderTarget::frame_block() {
+  return frame_block_;
+}
+
+/// @brief The work submitted to the GPU since the last Window::Display(), by
+/// every RenderTarget.
+/// @see Window::frame_stats()
+// static
+const RenderStats& RenderTarget::stats() {
+  return g_render_stats;
+}
+
+// The default programs. They are shared by every RenderTarget of the same
+// OpenGL context and built on first use.
+struct RenderTarget::DefaultPrograms {
+  ShaderProgram program_2d;
+  ShaderProgram program_2d_instanced;
+  ShaderProgram program_2d_glyph;
+  ShaderProgram program_2d_distance_field;
+  ShaderProgram program_2d_array;
+  ShaderProgram program_2d_colored;
+  ShaderProgram program_2d_particles;
+  ShaderProgram program_3d;
+  ShaderProgram program_3d_instanced;
+  bool all_built = false;  // See BuildDefaultPrograms().
+};
+
+RenderTarget::DefaultPrograms& RenderTarget::default_programs() {
+  if (default_programs_)
+    return *default_programs_;
+
+  // The programs are released with the last RenderTarget using them.
+  static std::map<GLFWwindow*, std::weak_ptr<DefaultPrograms>> registry;
+  static std::mutex registry_mutex;
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  std::weak_ptr<DefaultPrograms>& entry =
+      registry[context_ ? context_ : glfwGetCurrentContext()];
+  default_programs_ = entry.lock();
+  if (!default_programs_) {
+    default_programs_ = std::make_shared<DefaultPrograms>();
+    entry = default_programs_;
+  }
+  return *default_programs_;
+}
+
+// The recording threads of the CommandLists have no OpenGL context to build
+// the programs their drawables use.
+void RenderTarget::BuildDefaultPrograms() {
+  DefaultPrograms& programs = default_programs();
+  if (programs.all_built)
+    return;
+  shader_program_2d();
+  shader_program_2d_instanced();
+  shader_program_2d_glyph();
+  shader_program_2d_distance_field();
+  shader_program_2d_array();
+  shader_program_2d_colored();
+  shader_program_2d_particles();
+  shader_program_3d();
+  shader_program_3d_instanced();
+  programs.all_built = true;
+}
+
 /// @brief Return the default predefined 2D shader program. It is bound by
 /// default.
 ShaderProgram& RenderTarget::shader_program_2d() {
-  return shader_program_2d_;
+  ShaderProgram& program = default_programs().program_2d;
+  if (!program.id())
+    BuildProgram(program, kVertexShader2D, kFragmentShader2D);
+  return program;
 };
 
+/// @brief Return the default predefined 2D shader program for instanced
+/// drawing. It reads the 2x3 transformation and the color of every instance.
+/// @see InstancedMesh2D
+ShaderProgram& RenderTarget::shader_program_2d_instanced() {
+  ShaderProgram& program = default_programs().program_2d_instanced;
+  if (!program.id()) {
+    BuildProgram(program, std::string("#define INSTANCED\n") + kVertexShader2D,
+                 std::string("#define INSTANCED\n") + kFragmentShader2D);
+  }
+  return program;
+}
+
+/// @brief Return the default predefined 2D shader program for the single
+/// channel textures holding the alpha of white texels, like the Font atlas.
+/// @see Text
+ShaderProgram& RenderTarget::shader_program_2d_glyph() {
+  ShaderProgram& program = default_programs().program_2d_glyph;
+  if (!program.id()) {
+    BuildProgram(program, kVertexShader2D,
+                 std::string("#define GLYPH\n") + kFragmentShader2D);
+  }
+  return program;
+}
+
+/// @brief Return the default predefined 2D shader program for the single
+/// channel textures storing a signed distance field.
+/// @see Font::Rendering::DistanceField
+ShaderProgram& RenderTarget::shader_program_2d_distance_field() {
+  ShaderProgram& program = default_programs().program_2d_distance_field;
+  if (!program.id()) {
+    BuildProgram(program, kVertexShader2D,
+                 std::string("#define DISTANCE_FIELD\n") + kFragmentShader2D);
+  }
+  return program;
+}
+
+/// @brief Return the default predefined 2D shader program for the texture
+/// arrays. The layer is read from every vertex.
+/// @see Texture::Array
+/// @see Vertex2DLayered
+ShaderProgram& RenderTarget::shader_program_2d_array() {
+  ShaderProgram& program = default_programs().program_2d_array;
+  if (!program.id()) {
+    BuildProgram(program,
+                 std::string("#define TEXTURE_ARRAY\n") + kVertexShader2D,
+                 std::string("#define TEXTURE_ARRAY\n") + kFragmentShader2D);
+  }
+  return program;
+}
+
+/// @brief Return the default predefined 2D shader program for the vertices
+/// having their own color.
+/// @see Vertex2DColored
+ShaderProgram& RenderTarget::shader_program_2d_colored() {
+  ShaderProgram& program = default_programs().program_2d_colored;
+  if (!program.id()) {
+    BuildProgram(program,
+                 std::string("#define VERTEX_COLOR\n") + kVertexShader2D,
+                 std::string("#define VERTEX_COLOR\n") + kFragmentShader2D);
+  }
+  return program;
+}
+
+/// @brief Return the default predefined 2D shader program drawing the
+/// particles. It reads the position, the size and the color of every
+/// Particle2D instance.
+/// @see ParticleSystem
+ShaderProgram& RenderTarget::shader_program_2d_particles() {
+  ShaderProgram& program = default_programs().program_2d_particles;
+  if (!program.id()) {
+    BuildProgram(program, std::string("#define PARTICLES\n") + kVertexShader2D,
+                 std::string("#define INSTANCED\n") + kFragmentShader2D);
+  }
+  return program;
+}
+
 /// @brief Return the default predefined 3D shader program.
 ShaderProgram& RenderTarget::shader_program_3d() {
-  return shader_program_3d_;
+  ShaderProgram& program = default_programs().program_3d;
+  if (!program.id())
+    BuildProgram(program, kVertexShader3D, kFragmentShader3D);
+  return program;
 };
 
+/// @brief Return the default predefined 3D shader program for instanced
+/// drawing. It reads the transformation and the color of every instance.
+/// @see InstancedMesh
+ShaderProgram& RenderTarget::shader_program_3d_instanced() {
+  ShaderProgram& program = default_programs().program_3d_instanced;
+  if (!program.id()) {
+    BuildProgram(program, std::string("#define INSTANCED\n") + kVertexShader3D,
+                 std::string("#define INSTANCED\n") + kFragmentShader3D);
+  }
+  return program;
+}
+
 /// @brief Draw on the surface
 /// @param drawable: The object to be drawn on the surface.
 void RenderTarget::Draw(const Drawable& drawable) {
+  SMK_PROFILE_SCOPE("RenderTarget::Draw");
+  ContextScope context(recording_ ? nullptr : context_);
   Bind(this);
+  // The 2D program is used until an other one is set.
+  if (!shader_program_.id())
+    SetShaderProgram(shader_program_2d());
   RenderState state;
   state.shader_program = shader_program_;
   state.view = glm::mat4(1.0);
   state.color = smk::Color::White;
   state.blend_mode = smk::BlendMode::Alpha;
-  drawable.Draw(*this, state);
+  ApplyClip(state);
+  drawable.Draw(*this, std::move(state));
 }
 
 /// @brief Draw on the surface
 /// @param state: The RenderState to be usd for drawing.
 void RenderTarget::Draw(RenderState& state) {
+  if (deferred_) {
+    const float depth =
+        depth_sorting_ ? DepthKey(state, projection_matrix_) : 0.f;
+    queue_.push_back({state, projection_matrix_, layer_,
+                      state.blend_mode != BlendMode::Replace, SortKey(state),
+                      depth});
+    return;
+  }
+
+  if (recording_) {
+    RecordDraw(state, projection_matrix_);
+    return;
+  }
+
+  ContextScope context(context_);
+  Bind(this);
+  Submit(state, projection_matrix_);
+}
+
+/// @brief Draw without copying the resources. When the draw is deferred or
+/// recorded, they are copied.
+/// @param state: The resources and the parameters used for drawing.
+void RenderTarget::Draw(const RenderStateRef& state) {
+  if (!deferred_ && !recording_) {
+    ContextScope context(context_);
+    Bind(this);
+    Submit(state, projection_matrix_);
+    return;
+  }
+
+  RenderState copy;
+  copy.shader_program = *state.shader_program;
+  copy.texture = *state.texture;
+  for (int i = 0; i < RenderState::kExtraTextureUnits; ++i)
+    copy.textures[i] = *state.textures[i];
+  copy.vertex_array = *state.vertex_array;
+  copy.instances = *state.instances;
+  copy.view = state.view;
+  copy.color = state.color;
+  copy.texture_rectangle = state.texture_rectangle;
+  copy.blend_mode = state.blend_mode;
+  copy.clip = state.clip;
+  copy.clip_box = state.clip_box;
+  Draw(copy);
+}
+
+/// @brief Enable or disable the deferred drawing. When enabled, the draws are
+/// recorded instead of being executed. They are submitted by Flush(), sorted
+/// to minimize the changes of ShaderProgram, Texture, BlendMode and
+/// VertexArray.
+///
+/// Within a layer, the draws keep the order they were recorded in, whatever
+/// their BlendMode. A draw is only moved next to an earlier one using the same
+/// state when nothing drawn in between overlaps it on the screen. The draws
+/// whose bounds are unknown, for instance the instanced ones, are never moved.
+/// With SetDepthSorting(), the opaque draws (BlendMode::Replace) are submitted
+/// first instead, front-to-back, and the other ones back-to-front.
+/// See SetLayer().
+///
+/// The resources used by a recorded draw must stay unmodified until Flush().
+/// Window::Display() and Clear() call Flush() automatically.
+/// @param deferred: Whether the draws are deferred.
+void RenderTarget::SetDeferred(bool deferred) {
+  if (!deferred)
+    Flush();
+  deferred_ = deferred;
+}
+
+/// @brief Set the layer of the next deferred draws. Layers are submitted in
+/// increasing order. The default layer is 0.
+/// @param layer: The layer of the next draws.
+void RenderTarget::SetLayer(int layer) {
+  layer_ = layer;
+}
+
+/// @brief Submit the deferred draws, sorted to reduce the state changes.
+void RenderTarget::Flush() {
+  if (queue_.empty())
+    return;
+  SMK_PROFILE_SCOPE("RenderTarget::Flush");
+
+  if (depth_sorting_) {
+    std::stable_sort(queue_.begin(), queue_.end(),
+                     [](const QueuedDraw& a, const QueuedDraw& b) {
+                       if (a.layer != b.layer)
+                         return a.layer < b.layer;
+                       if (a.blended != b.blended)
+                         return b.blended;
+                       // Opaque: front-to-back. Others: back-to-front.
+                       if (a.depth != b.depth)
+                         return a.blended ? a.depth > b.depth
+                                          : a.depth < b.depth;
+                       if (a.blended)
+                         return false;
+                       return a.key < b.key;
+                     });
+  } else {
+    std::stable_sort(queue_.begin(), queue_.end(),
+                     [](const QueuedDraw& a, const QueuedDraw& b) {
+                       return a.layer < b.layer;
+                     });
+
+    // A draw joins an earlier batch with the same key when none of the
+    // batches recorded in between overlap it. Its order can't be observed.
+    struct Batch {
+      uint64_t key;
+      glm::vec4 area;
+      size_t first;
+      size_t last;
+    };
+    constexpr size_t kEnd = std::numeric_limits<size_t>::max();
+    std::vector<Batch> batches;
+    std::vector<size_t> next(queue_.size(), kEnd);
+    size_t layer_begin = 0;
+    for (size_t i = 0; i < queue_.size(); ++i) {
+      const QueuedDraw& draw = queue_[i];
+      if (i && draw.layer != queue_[i - 1].layer)
+        layer_begin = batches.size();
+      const glm::vec4 area = ScreenArea(draw.state, draw.projection_matrix);
+      const size_t limit =
+          batches.size() -
+          std::min(batches.size() - layer_begin, kBatchLookback);
+      Batch* batch = nullptr;
+      for (size_t j = batches.size(); j > limit; --j) {
+        if (batches[j - 1].key == draw.key) {
+          batch = &batches[j - 1];
+          break;
+        }
+        if (Overlap(batches[j - 1].area, area))
+          break;
+      }
+      if (!batch) {
+        batches.push_back({draw.key, area, i, i});
+        continue;
+      }
+      next[batch->last] = i;
+      batch->last = i;
+      batch->area.x = std::min(batch->area.x, area.x);
+      batch->area.y = std::min(batch->area.y, area.y);
+      batch->area.z = std::max(batch->area.z, area.z);
+      batch->area.w = std::max(batch->area.w, area.w);
+    }
+
+    std::vector<QueuedDraw> sorted;
+    sorted.reserve(queue_.size());
+    for (const Batch& batch : batches) {
+      for (size_t i = batch.first; i != kEnd; i = next[i])
+        sorted.push_back(std::move(queue_[i]));
+    }
+    queue_.swap(sorted);
+  }
+
+  ContextScope context(recording_ ? nullptr : context_);
+  if (!recording_)
+    Bind(this);
+  int depth_mode = kDepthOff;
+  auto set_depth_mode = [&](int mode) {
+    if (mode == depth_mode)
+      return;
+    depth_mode = mode;
+    if (recording_)
+      recording_->push_back({Command::Depth, mode});
+    else
+      SetDepthModeBound(mode);
+  };
+
+  for (QueuedDraw& draw : queue_) {
+    if (depth_sorting_)
+      set_depth_mode(draw.blended ? kDepthTest : kDepthWrite);
+    if (recording_)
+      RecordDraw(std::move(draw.state), draw.projection_matrix);
+    else
+      Submit(draw.state, draw.projection_matrix);
+  }
+  set_depth_mode(kDepthOff);
+
+  // Keep the capacity for the next frame.
+  queue_.clear();
+}
+
+/// @brief Draw the draws recorded by a CommandList, and empty it. The lists
+/// are drawn in the order they are appended. When this target is deferred,
+/// the draws are sorted by Flush() along with the others, using the layers
+/// they were recorded with.
+/// @param list The recorded draws. Its recording thread must be done with it.
+void RenderTarget::Append(CommandList& list) {
+  if (deferred_) {
+    for (QueuedDraw& draw : list.queue_)
+      queue_.push_back(std::move(draw));
+  } else if (recording_) {
+    for (QueuedDraw& draw : list.queue_)
+      RecordDraw(std::move(draw.state), draw.projection_matrix);
+  } else {
+    ContextScope context(context_);
+    Bind(this);
+    for (QueuedDraw& draw : list.queue_)
+      Submit(draw.state, draw.projection_matrix);
+  }
+
+  // Keep the capacity for the next frame.
+  list.queue_.clear();
+}
+
+/// @brief Copy the pixels drawn so far, without waiting for the GPU.
+/// The copy goes into a pixel buffer, protected by a fence.
+/// CompleteReadbacks() hands the pixels to |callback| once the GPU is done,
+/// usually one or two frames later.
+/// @param callback The function receiving the pixels.
+void RenderTarget::ReadPixelsAsync(ReadbackCallback callback) {
+  if (recording_) {
+    std::cerr << "SMK > ReadPixelsAsync() isn't supported by a window drawn "
+                 "by a render thread."
+              << std::endl;
+    return;
+  }
+  Flush();
+  ContextScope context(context_);
+  Bind(this);
+
+  Readback readback;
+  readback.width = width_;
+  readback.height = height_;
+  readback.callback = std::move(callback);
+  if (g_free_readback_buffers.empty()) {
+    glGenBuffers(1, &readback.buffer);
+    readback.capacity = 0;
+  } else {
+    readback.buffer = g_free_readback_buffers.back().first;
+    readback.capacity = g_free_readback_buffers.back().second;
+    g_free_readback_buffers.pop_back();
+  }
+
+  // Reuse the pooled storage when it is large enough for the pixels.
+  const size_t size = size_t(width_) * height_ * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+  if (readback.capacity < size) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    readback.capacity = size;
+    ++g_render_stats.buffer_allocations;
+  }
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  g_readbacks.push_back(std::move(readback));
+}
+
+/// @brief Deliver the completed readbacks to their callbacks.
+/// @param wait Whether to block until every pending readbacks are complete.
+// static
+void RenderTarget::CompleteReadbacks(bool wait) {
+  std::vector<Readback> completed;
+  for (auto it = g_readbacks.begin(); it != g_readbacks.end();) {
+    GLenum status = glClientWaitSync(it->fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                     wait ? GL_TIMEOUT_IGNORED : 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+      ++it;
+      continue;
+    }
+    completed.push_back(std::move(*it));
+    it = g_readbacks.erase(it);
+  }
+
+  for (Readback& readback : completed) {
+    glDeleteSync(readback.fence);
+
+    // OpenGL stores the rows from the bottom to the top.
+    const size_t row_size = readback.width * 4;
+    std::vector<uint8_t> rgba(row_size * readback.height);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+#ifdef __EMSCRIPTEN__
+    std::vector<uint8_t> rows(rgba.size());
+    glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, rows.size(), rows.data());
+    const uint8_t* mapped = rows.data();
+#else
+    const uint8_t* mapped = static_cast<const uint8_t*>(glMapBufferRange(
+        GL_PIXEL_PACK_BUFFER, 0, rgba.size(), GL_MAP_READ_BIT));
+#endif
+    if (mapped) {
+      for (int y = 0; y < readback.height; ++y) {
+        std::memcpy(rgba.data() + y * row_size,
+                    mapped + (readback.height - 1 - y) * row_size, row_size);
+      }
+    }
+#ifndef __EMSCRIPTEN__
+    if (mapped)
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+#endif
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    g_free_readback_buffers.emplace_back(readback.buffer, readback.capacity);
+
+    readback.callback(std::move(rgba), readback.width, readback.height);
+  }
+}
+
+/// @brief Execute a draw immediately.
+/// @param state The resources and the parameters used for drawing.
+/// @param projection_matrix The projection the draw was recorded with.
+/// @param uniforms The custom uniforms recorded with the draw, if replayed.
+void RenderTarget::Submit(const RenderStateRef& state,
+                          const glm::mat4& projection_matrix,
+                          const ShaderProgram::UniformValues* uniforms) {
+  ContextState& context = CurrentContextState();
+  RenderState& cached_render_state = context.cached_render_state;
+
   // Vertex Array
-  if (cached_render_state_.vertex_array != state.vertex_array) {
-    cached_render_state_.vertex_array = state.vertex_array;
-    state.vertex_array.Bind();
+  if (state.instances->size()) {
+    if (cached_render_state.instances != *state.instances ||
+        g_invalidate_vertex_array) {
+      cached_render_state.instances = *state.instances;
+      cached_render_state.vertex_array = VertexArray();
+      state.instances->Bind();
+      g_invalidate_vertex_array = false;
+      ++g_render_stats.vertex_array_changes;
+    }
+  } else if (cached_render_state.vertex_array != *state.vertex_array ||
+             g_invalidate_vertex_array) {
+    cached_render_state.vertex_array = *state.vertex_array;
+    cached_render_state.instances = InstanceArray();
+    state.vertex_array->Bind();
+    g_invalidate_vertex_array = false;
+    ++g_render_stats.vertex_array_changes;
   }
 
   // Shader
-  if (cached_render_state_.shader_program != state.shader_program) {
-    cached_render_state_.shader_program = state.shader_program;
-    cached_render_state_.shader_program.Use();
+  if (cached_render_state.shader_program != *state.shader_program ||
+      g_invalidate_shader_program) {
+    g_invalidate_shader_program = false;
+    cached_render_state.shader_program = *state.shader_program;
+    cached_render_state.shader_program.Use();
+    ++g_render_stats.shader_changes;
   }
 
-  // Color
-  if (cached_render_state_.color != state.color) {
-    cached_render_state_.color = state.color;
-    cached_render_state_.shader_program.SetUniform("color", state.color);
+  // The custom uniforms recorded while a render thread runs. They are set
+  // before the built-in ones, which take precedence.
+  if (uniforms)
+    state.shader_program->UploadUniforms(*uniforms);
+  else if (g_render_threads.load(std::memory_order_relaxed))
+    state.shader_program->UploadRecordedUniforms();
+
+  // Projection. It is shared using the FrameBlock, unless the program uses a
+  // "projection" uniform.
+  if (state.shader_program->UsesFrameBlock()) {
+    frame_block_.projection = projection_matrix;
+    UpdateFrameBlock(context);
+  } else {
+    state.shader_program->SetProjectionUniform(projection_matrix);
   }
 
-  // View (not cached)
-  state.shader_program.SetUniform("projection", projection_matrix_);
-  state.shader_program.SetUniform("view", state.view);
+  // Color, View and texture rectangle. They are cached by the program.
+  state.shader_program->SetColorUniform(state.color);
+  state.shader_program->SetViewUniform(state.view);
+  state.shader_program->SetTextureRectangleUniform(state.texture_rectangle);
 
-  // Texture
-  auto& texture = state.texture.id() ? state.texture : WhiteTexture();
-  if (cached_render_state_.texture != texture || g_invalidate_textures) {
-    cached_render_state_.texture = texture;
+  // Textures. Reloading an evicted texture binds it, so every texture is
+  // reloaded before binding any. The extra units are bound first, leaving the
+  // unit 0 active.
+  auto& texture = state.texture->id() ? *state.texture : WhiteTexture();
+  UseTexture(texture.id());
+  for (const Texture* extra : state.textures) {
+    if (extra->id())
+      UseTexture(extra->id());
+  }
+  bool extra_bound = false;
+  for (int i = 0; i < RenderState::kExtraTextureUnits; ++i) {
+    const Texture& extra = *state.textures[i];
+    if (cached_render_state.textures[i] != extra || g_invalidate_textures) {
+      cached_render_state.textures[i] = extra;
+      extra.Bind(GL_TEXTURE1 + i);
+      extra_bound = true;
+      ++g_render_stats.texture_changes;
+    }
+  }
+  if (cached_render_state.texture != texture || g_invalidate_textures) {
+    cached_render_state.texture = texture;
     texture.Bind();
-    g_invalidate_textures = false;
+    ++g_render_stats.texture_changes;
+  } else if (extra_bound) {
+    glActiveTexture(GL_TEXTURE0);
   }
+  g_invalidate_textures = false;
 
-  if (cached_render_state_.blend_mode != state.blend_mode) {
-    cached_render_state_.blend_mode = state.blend_mode;
+  // Clip
+  if (cached_render_state.clip != state.clip) {
+    cached_render_state.clip = state.clip;
+    if (state.clip)
+      glEnable(GL_SCISSOR_TEST);
+    else
+      glDisable(GL_SCISSOR_TEST);
+  }
+  if (state.clip && cached_render_state.clip_box != state.clip_box) {
+    cached_render_state.clip_box = state.clip_box;
+    glScissor(state.clip_box.x, state.clip_box.y, state.clip_box.z,
+              state.clip_box.w);
+  }
+
+  if (cached_render_state.blend_mode != state.blend_mode) {
+    cached_render_state.blend_mode = state.blend_mode;
     glEnable(GL_BLEND);
     glBlendEquationSeparate(state.blend_mode.equation_rgb,
                             state.blend_mode.equation_alpha);
     glBlendFuncSeparate(state.blend_mode.src_rgb, state.blend_mode.dst_rgb,
                         state.blend_mode.src_alpha, state.blend_mode.dst_alpha);
+    ++g_render_stats.blend_mode_changes;
   }
 
-  glDrawArrays(GL_TRIANGLES, 0, state.vertex_array.size());
+  ++g_render_stats.draw_calls;
+
+  if (state.instances->size()) {
+    const VertexArray& vertex_array = state.instances->vertex_array();
+    g_render_stats.vertices +=
+        (vertex_array.indexed() ? vertex_array.index_count()
+                                : vertex_array.size()) *
+        state.instances->size();
+    if (vertex_array.indexed()) {
+      glDrawElementsInstanced(GL_TRIANGLES, vertex_array.index_count(),
+                              vertex_array.index_type(), nullptr,
+                              state.instances->size());
+    } else {
+      glDrawArraysInstanced(GL_TRIANGLES, 0, vertex_array.size(),
+                            state.instances->size());
+    }
+    return;
+  }
+
+  if (state.vertex_array->indexed()) {
+    g_render_stats.vertices += state.vertex_array->index_count();
+    glDrawElements(GL_TRIANGLES, state.vertex_array->index_count(),
+                   state.vertex_array->index_type(), nullptr);
+    return;
+  }
+
+  g_render_stats.vertices += state.vertex_array->size();
+  glDrawArrays(GL_TRIANGLES, 0, state.vertex_array->size());
+}
+
+// Record a draw for the render thread, with the custom uniforms set so far.
+void RenderTarget::RecordDraw(RenderState state,
+                              const glm::mat4& projection_matrix) {
+  auto uniforms = state.shader_program.recorded_uniforms();
+  recording_->push_back({Command::Draw, 0, glm::vec4(), std::move(state),
+                         projection_matrix, std::move(uniforms)});
+}
+
+/// @brief Execute recorded commands. Called by the thread owning the OpenGL
+/// context of the target.
+/// @param commands The commands to execute.
+/// @param width The width of the surface when recorded.
+/// @param height The height of the surface when recorded.
+void RenderTarget::Replay(std::vector<Command>& commands,
+                          int width,
+                          int height) {
+  ContextState& context = CurrentContextState();
+  context.render_target = this;
+  glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
+  glViewport(0, 0, width, height);
+
+  for (Command& command : commands) {
+    switch (command.type) {
+      case Command::Clear:
+        ClearBound(command.color, command.attachments);
+        break;
+      case Command::Invalidate:
+        InvalidateBound(frame_buffer_, color_attachment_count_,
+                        command.attachments);
+        break;
+      case Command::Draw:
+        Submit(command.state, command.projection_matrix,
+               command.uniforms.get());
+        break;
+      case Command::Depth:
+        SetDepthModeBound(command.attachments);
+        break;
+    }
+  }
 }
 
 /// @brief the dimension (width, height) of the drawing area.
@@ -231,114 +1433,11 @@ int RenderTarget::height() const {
 }
 
 void RenderTarget::InitRenderTarget() {
+  context_ = glfwGetCurrentContext();
   View default_view;
   default_view.SetCenter(width_ / 2, height_ / 2);
   default_view.SetSize(width_, height_);
   SetView(default_view);
-
-  vertex_shader_2d_ = Shader::FromString(R"(
-    layout(location = 0) in vec2 space_position;
-    layout(location = 1) in vec2 texture_position;
-
-    uniform mat4 projection;
-    uniform mat4 view;
-
-    out vec2 f_texture_position;
-
-    void main() {
-      f_texture_position = texture_position;
-      gl_Position = projection * view * vec4(space_position, 0.0, 1.0);
-    }
-  )",
-                                         GL_VERTEX_SHADER);
-
-  fragment_shader_2d_ = Shader::FromString(R"(
-    in vec2 f_texture_position;
-    uniform sampler2D texture_0;
-    uniform vec4 color;
-    out vec4 out_color;
-
-    void main() {
-      out_color = texture(texture_0, f_texture_position) * color;
-    }
-  )",
-                                           GL_FRAGMENT_SHADER);
-
-  shader_program_2d_.AddShader(vertex_shader_2d_);
-  shader_program_2d_.AddShader(fragment_shader_2d_);
-  shader_program_2d_.Link();
-
-  vertex_shader_3d_ = Shader::FromString(R"(
-    layout(location = 0) in vec3 space_position;
-    layout(location = 1) in vec3 normal;
-    layout(location = 2) in vec2 texture_position;
-
-    uniform mat4 projection;
-    uniform mat4 view;
-
-    out vec4 fPosition;
-    out vec2 fTexture;
-    out vec3 fNormal;
-
-    void main() {
-      fTexture = texture_position;
-      fPosition = view * vec4(space_position,1.0);
-      fNormal = vec3(view * vec4(normal,0.0));
-
-      gl_Position = projection * fPosition;
-    }
-  )",
-                                         GL_VERTEX_SHADER);
-
-  fragment_shader_3d_ = Shader::FromString(R"(
-    uniform sampler2D texture_0;
-    uniform vec4 color;
-
-    uniform vec4 light_position;
-    uniform float ambient;
-    uniform float diffuse;
-    uniform float specular;
-    uniform float specular_power;
-
-    in vec4 fPosition;
-    in vec2 fTexture;
-    in vec3 fNormal;
-
-    out vec4 out_color;
-
-    void main(void)
-    {
-      vec3 object_dir =-normalize(fPosition.xyz);
-      vec3 normal_dir = normalize(fNormal);
-      vec3 light_dir = normalize(light_position.xyz-fPosition.xyz);
-      vec3 reflect_dir = -reflect(object_dir,normal_dir);
-
-      float diffuse_strength = max(0.0, dot(normal_dir, light_dir));
-      float specular_strength = pow(max(0.0, dot(reflect_dir, light_dir)),
-                                    specular_power);
-
-      out_color = texture(texture_0, fTexture);
-      out_color.rgb *= ambient +
-                       diffuse * diffuse_strength +
-                       specular * specular_strength;
-      out_color *= color;
-    }
-  )",
-                                           GL_FRAGMENT_SHADER);
-
-  shader_program_3d_.AddShader(vertex_shader_3d_);
-  shader_program_3d_.AddShader(fragment_shader_3d_);
-  shader_program_3d_.Link();
-
-  shader_program_3d_.Use();
-  shader_program_3d_.SetUniform("light_position",
-                                 glm::vec4(0.f, 5.f, 0.f, 1.f));
-  shader_program_3d_.SetUniform("ambient", 0.3f);
-  shader_program_3d_.SetUniform("diffuse", 0.5f);
-  shader_program_3d_.SetUniform("specular", 0.5f);
-  shader_program_3d_.SetUniform("specular_power", 4.0f);
-
-  SetShaderProgram(shader_program_2d_);
 }
 
 }  // namespace smk
@@ -0,0 +1,92 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <atomic>
+#include <smk/Profiler.hpp>
+#include <smk/RenderThread.hpp>
+
+namespace smk {
+
+extern thread_local RenderStats g_render_stats;
+
+// The number of RenderThreads running. While there is one, the resources
+// updated by the application thread may be used by a frame being rendered.
+std::atomic<int> g_render_threads{0};
+
+RenderThread::RenderThread(GLFWwindow* context)
+    : context_(context), thread_([this] { Run(); }) {
+  ++g_render_threads;
+}
+
+RenderThread::~RenderThread() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  condition_.notify_all();
+  thread_.join();
+  --g_render_threads;
+}
+
+void RenderThread::Submit() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this] { return !pending_; });
+  std::swap(recording_, rendering_);
+  pending_ = true;
+  lock.unlock();
+  condition_.notify_all();
+}
+
+void RenderThread::Finish() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this] { return !pending_; });
+}
+
+void RenderThread::Run() {
+  glfwMakeContextCurrent(context_);
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this] { return pending_ || quit_; });
+      if (!pending_)
+        break;
+    }
+
+    {
+      SMK_PROFILE_SCOPE("RenderThread::Frame");
+      RecordedFrame& frame = rendering_;
+
+      // Let the GPU wait for the uploads made by the application thread in
+      // its own context.
+      if (frame.fence) {
+        glWaitSync(frame.fence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(frame.fence);
+        frame.fence = nullptr;
+      }
+
+      if (frame.swap_interval != swap_interval_) {
+        swap_interval_ = frame.swap_interval;
+        glfwSwapInterval(swap_interval_);
+      }
+
+      if (frame.window)
+        frame.window->RenderFrame(frame);
+      glfwSwapBuffers(context_);
+
+      frame.stats = g_render_stats;
+      g_render_stats = RenderStats();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ = false;
+    }
+    condition_.notify_all();
+  }
+
+  glfwMakeContextCurrent(nullptr);
+}
+
+}  // namespace smk
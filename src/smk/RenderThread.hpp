@@ -0,0 +1,71 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_RENDER_THREAD_HPP
+#define SMK_RENDER_THREAD_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <smk/FrameBlock.hpp>
+#include <smk/OpenGL.hpp>
+#include <smk/RenderStats.hpp>
+#include <smk/Window.hpp>
+#include <thread>
+#include <vector>
+
+namespace smk {
+
+// A frame recorded by the application thread, for the render thread.
+struct RecordedFrame {
+  // Recorded by the application thread:
+  std::vector<RenderTarget::Command> commands;
+  Window* window = nullptr;
+  FrameBlock frame_block;
+  int width = 0;
+  int height = 0;
+  int swap_interval = -2;
+  GLsync fence = nullptr;  // Signaled once the resources are uploaded.
+
+  // Filled by the render thread:
+  RenderStats stats;
+  float gpu_time = -1.f;
+};
+
+// The thread owning the OpenGL context of a Window. It replays the commands
+// recorded by the application thread during the previous frame and swaps the
+// buffers. See Window::Option::render_thread.
+class RenderThread {
+ public:
+  explicit RenderThread(GLFWwindow* context);
+  ~RenderThread();
+
+  // The frame being recorded by the application thread.
+  RecordedFrame& recording() { return recording_; }
+
+  // Hand the recorded frame to the render thread, once it is done with the
+  // previous one. recording() then holds the previous frame, already rendered.
+  void Submit();
+
+  // Wait until the render thread is done with the submitted frame.
+  void Finish();
+
+ private:
+  void Run();
+
+  GLFWwindow* context_;
+  int swap_interval_ = -2;  // The interval applied to |context_|.
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool pending_ = false;  // Whether |rendering_| awaits to be rendered.
+  bool quit_ = false;
+  RecordedFrame recording_;
+  RecordedFrame rendering_;
+
+  std::thread thread_;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_RENDER_THREAD_HPP */
@@ -0,0 +1,299 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <smk/Residency.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "DecodedImage.hpp"
+#include "ResidencyTracker.hpp"
+
+namespace smk {
+extern thread_local bool g_invalidate_textures;
+
+namespace {
+
+struct TextureRecord {
+  size_t bytes = 0;
+  int levels = 1;
+  uint64_t last_use = 0;
+  bool resident = true;
+
+  // Where to reload the texture from. Empty when it can't be evicted.
+  std::string filename;
+  Texture::Option option;
+};
+
+// A texture name is only unique within its context. Each window owns its own
+// context, and may reuse the names of the other ones.
+using TextureKey = std::pair<GLFWwindow*, GLuint>;
+
+TextureKey CurrentTextureKey(GLuint id) {
+  return {glfwGetCurrentContext(), id};
+}
+
+// The textures can be created, drawn and deleted by the render thread, while
+// Window::Display() runs on the application one.
+std::mutex g_mutex;
+std::map<TextureKey, TextureRecord> g_textures;
+std::unordered_map<GLuint, size_t> g_buffers;
+std::unordered_map<GLuint, size_t> g_render_buffers;
+uint64_t g_frame = 2;
+
+std::atomic<size_t> g_budget(0);
+std::atomic<size_t> g_texture_bytes(0);
+std::atomic<size_t> g_buffer_bytes(0);
+std::atomic<size_t> g_render_buffer_bytes(0);
+std::atomic<size_t> g_evictions(0);
+std::atomic<size_t> g_reloads(0);
+
+void Track(std::unordered_map<GLuint, size_t>& objects,
+           std::atomic<size_t>& total,
+           GLuint id,
+           size_t bytes) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  size_t& tracked = objects[id];
+  total -= tracked;
+  total += bytes;
+  tracked = bytes;
+}
+
+void Untrack(std::unordered_map<GLuint, size_t>& objects,
+             std::atomic<size_t>& total,
+             GLuint id) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  auto it = objects.find(id);
+  if (it == objects.end())
+    return;
+  total -= it->second;
+  objects.erase(it);
+}
+
+size_t BytesPerPixel(GLenum internal_format) {
+  switch (internal_format) {
+    case GL_RED:
+    case GL_R8:
+      return 1;
+    case GL_RG8:
+      return 2;
+    case GL_RGB:
+    case GL_RGB8:
+      return 3;
+    case GL_RGBA16F:
+      return 8;
+    case GL_RGBA32F:
+      return 16;
+    default:
+      return 4;
+  }
+}
+
+// Release the storage of a texture, keeping its name. Every level is
+// respecified empty, except the first one which keeps a single texel.
+void Evict(GLuint id, TextureRecord& record) {
+  const uint8_t transparent[4] = {0, 0, 0, 0};
+  glBindTexture(GL_TEXTURE_2D, id);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               transparent);
+  for (int level = 1; level < record.levels; ++level) {
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  glBindTexture(GL_TEXTURE_2D, GL_NONE);
+  g_invalidate_textures = true;
+
+  g_texture_bytes -= record.bytes;
+  record.bytes = 0;
+  record.resident = false;
+  ++g_evictions;
+}
+
+}  // namespace
+
+void TrackTexture(GLuint id, size_t bytes, int levels) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  TextureRecord& record = g_textures[CurrentTextureKey(id)];
+  g_texture_bytes -= record.bytes;
+  g_texture_bytes += bytes;
+  record.bytes = bytes;
+  record.levels = levels;
+  record.resident = true;
+  record.last_use = g_frame;
+}
+
+void UntrackTexture(GLuint id) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  auto it = g_textures.find(CurrentTextureKey(id));
+  if (it == g_textures.end())
+    return;
+  g_texture_bytes -= it->second.bytes;
+  g_textures.erase(it);
+}
+
+void TrackBuffer(GLuint id, size_t bytes) {
+  Track(g_buffers, g_buffer_bytes, id, bytes);
+}
+
+void UntrackBuffer(GLuint id) {
+  Untrack(g_buffers, g_buffer_bytes, id);
+}
+
+void TrackRenderBuffer(GLuint id, size_t bytes) {
+  Track(g_render_buffers, g_render_buffer_bytes, id, bytes);
+}
+
+void UntrackRenderBuffer(GLuint id) {
+  Untrack(g_render_buffers, g_render_buffer_bytes, id);
+}
+
+void SetTextureSource(GLuint id,
+                      const std::string& filename,
+                      const Texture::Option& option) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  auto it = g_textures.find(CurrentTextureKey(id));
+  if (it == g_textures.end())
+    return;
+  it->second.filename = filename;
+  it->second.option = option;
+}
+
+void UseTexture(GLuint id) {
+  if (!g_budget)
+    return;
+
+  std::string filename;
+  Texture::Option option;
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_textures.find(CurrentTextureKey(id));
+    if (it == g_textures.end())
+      return;
+    it->second.last_use = g_frame;
+    if (it->second.resident)
+      return;
+    filename = it->second.filename;
+    option = it->second.option;
+  }
+
+  // Reloading tracks the texture again, as resident.
+  DecodedImage image;
+  if (image.Decode(filename, option) && image.Upload(id)) {
+    ++g_reloads;
+    return;
+  }
+
+  // Don't try again on every draw.
+  std::lock_guard<std::mutex> lock(g_mutex);
+  auto it = g_textures.find(CurrentTextureKey(id));
+  if (it != g_textures.end()) {
+    it->second.filename.clear();
+    it->second.resident = true;
+  }
+}
+
+size_t TextureBytes(GLenum internal_format, int width, int height, int levels) {
+  size_t bytes = 0;
+  for (int level = 0; level < levels; ++level) {
+    bytes += size_t(std::max(1, width >> level)) *
+             size_t(std::max(1, height >> level));
+  }
+  return bytes * BytesPerPixel(internal_format);
+}
+
+int MipmapLevelCount(int width, int height) {
+  int levels = 1;
+  for (int size = std::max(width, height); size > 1; size /= 2)
+    ++levels;
+  return levels;
+}
+
+/// @brief Set the GPU memory budget.
+/// @param bytes The budget. 0 disables the eviction.
+// static
+void Residency::SetBudget(size_t bytes) {
+  g_budget = bytes;
+}
+
+/// @brief The GPU memory budget, in bytes. 0 when disabled.
+// static
+size_t Residency::budget() {
+  return g_budget;
+}
+
+/// @brief The GPU memory in use, in bytes.
+// static
+size_t Residency::bytes() {
+  return g_texture_bytes + g_buffer_bytes + g_render_buffer_bytes;
+}
+
+/// @brief The GPU memory used by the textures, in bytes.
+// static
+size_t Residency::texture_bytes() {
+  return g_texture_bytes;
+}
+
+/// @brief The GPU memory used by the vertex and instance buffers, in bytes.
+// static
+size_t Residency::buffer_bytes() {
+  return g_buffer_bytes;
+}
+
+/// @brief The GPU memory used by the render buffers of the Framebuffers, in
+/// bytes. Their color textures are counted as textures.
+// static
+size_t Residency::render_buffer_bytes() {
+  return g_render_buffer_bytes;
+}
+
+/// @brief The number of textures evicted since the start.
+// static
+size_t Residency::evictions() {
+  return g_evictions;
+}
+
+/// @brief The number of evicted textures reloaded since the start.
+// static
+size_t Residency::reloads() {
+  return g_reloads;
+}
+
+/// @brief Evict the textures drawn least recently, until the memory in use
+/// fits the budget.
+// static
+void Residency::NewFrame() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  ++g_frame;
+
+  const size_t budget = g_budget;
+  if (!budget || bytes() <= budget)
+    return;
+
+  // Only the textures of the current context can be released from here.
+  GLFWwindow* context = glfwGetCurrentContext();
+  std::vector<std::pair<uint64_t, GLuint>> candidates;
+  for (const auto& it : g_textures) {
+    const TextureRecord& record = it.second;
+    if (it.first.first == context && record.resident &&
+        !record.filename.empty() && record.last_use + 2 < g_frame) {
+      candidates.emplace_back(record.last_use, it.first.second);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+
+  for (const auto& candidate : candidates) {
+    if (bytes() <= budget)
+      break;
+    Evict(candidate.second, g_textures[{context, candidate.second}]);
+  }
+}
+
+}  // namespace smk
@@ -0,0 +1,39 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_RESIDENCY_TRACKER_HPP
+#define SMK_RESIDENCY_TRACKER_HPP
+
+#include <cstddef>
+#include <smk/OpenGL.hpp>
+#include <smk/Texture.hpp>
+#include <string>
+
+namespace smk {
+
+// The accounting behind smk::Residency. The GPU objects are registered when
+// their storage is allocated, and unregistered when they are deleted. Tracking
+// an object already tracked replaces its size.
+
+void TrackTexture(GLuint id, size_t bytes, int levels);
+void UntrackTexture(GLuint id);
+void TrackBuffer(GLuint id, size_t bytes);
+void UntrackBuffer(GLuint id);
+void TrackRenderBuffer(GLuint id, size_t bytes);
+void UntrackRenderBuffer(GLuint id);
+
+// Allow a texture to be evicted. It will be reloaded from |filename|.
+void SetTextureSource(GLuint id,
+                      const std::string& filename,
+                      const Texture::Option& option);
+
+// Stamp a texture being drawn. It is reloaded first when it was evicted.
+void UseTexture(GLuint id);
+
+// The size of a texture, with |levels| mipmap levels.
+size_t TextureBytes(GLenum internal_format, int width, int height, int levels);
+int MipmapLevelCount(int width, int height);
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_RESIDENCY_TRACKER_HPP */
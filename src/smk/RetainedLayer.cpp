@@ -0,0 +1,311 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <cmath>
+#include <smk/RenderTarget.hpp>
+#include <smk/RetainedLayer.hpp>
+#include <smk/Scene2D.hpp>
+#include <smk/Shape.hpp>
+#include <smk/Text.hpp>
+
+namespace smk {
+
+namespace {
+
+// The antialiasing and the glyph overhangs reach slightly outside of the
+// bounds. They are extended by this many pixels.
+const float kMargin = 2.f;
+
+// Beyond this many areas, they are merged into a single one. A few larger
+// areas cost less than many draw passes.
+const size_t kMaxDirtyAreas = 8;
+
+bool Intersect(const glm::ivec4& a, const glm::ivec4& b) {
+  return a.x < b.z && b.x < a.z && a.y < b.w && b.y < a.w;
+}
+
+bool Adjacent(const glm::ivec4& a, const glm::ivec4& b) {
+  return a.x <= b.z && b.x <= a.z && a.y <= b.w && b.y <= a.w;
+}
+
+glm::ivec4 Union(const glm::ivec4& a, const glm::ivec4& b) {
+  return {std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.z, b.z),
+          std::max(a.w, b.w)};
+}
+
+// The pixels covered by |bounds|, rounded outward.
+glm::ivec4 Pixels(const Rectangle& bounds) {
+  if (!(bounds.left < bounds.right && bounds.top < bounds.bottom))
+    return glm::ivec4(0);
+  return {int(std::floor(bounds.left - kMargin)),
+          int(std::floor(bounds.top - kMargin)),
+          int(std::ceil(bounds.right + kMargin)),
+          int(std::ceil(bounds.bottom + kMargin))};
+}
+
+}  // namespace
+
+/// @brief Create a layer.
+/// @param width The width of the layer, in pixels.
+/// @param height The height of the layer, in pixels.
+RetainedLayer::RetainedLayer(int width, int height)
+    : width_(width), height_(height) {
+  Framebuffer::Option option;
+  option.depth_stencil = false;
+  framebuffer_ = std::make_unique<Framebuffer>(width, height, option);
+  sprite_ = Sprite(*framebuffer_);
+
+  // The areas are cleared by drawing the background over the whole layer,
+  // clipped.
+  clear_quad_ = Shape::Square();
+  clear_quad_.SetScale(float(width), float(height));
+  clear_quad_.SetColor(background_);
+  clear_quad_.SetBlendMode(BlendMode::Replace);
+  InvalidateAll();
+}
+
+/// @brief Add an object, rendered again whenever it is modified.
+/// @param object The object. It must outlive the layer or be removed.
+/// @return The identifier of the object in the layer.
+RetainedLayer::Id RetainedLayer::Add(const TransformableBase& object) {
+  Object entry;
+  entry.drawable = &object;
+  entry.transformable = &object;
+  return Insert(entry);
+}
+
+/// @brief Add a Text, rendered again whenever it is modified, or its Font
+/// receives new glyphs.
+/// @param text The Text. It must outlive the layer or be removed.
+/// @return The identifier of the Text in the layer.
+RetainedLayer::Id RetainedLayer::Add(const Text& text) {
+  Object entry;
+  entry.drawable = &text;
+  entry.transformable = &text;
+  entry.text = &text;
+  return Insert(entry);
+}
+
+/// @brief Add an object whose changes aren't detected.
+/// @param drawable The object. It must outlive the layer or be removed.
+/// @param bounds The area covered by the object, in the layer coordinates.
+/// @return The identifier of the object in the layer.
+/// @see Invalidate(), SetBounds().
+RetainedLayer::Id RetainedLayer::Add(const Drawable& drawable,
+                                     const Rectangle& bounds) {
+  Object entry;
+  entry.drawable = &drawable;
+  entry.bounds = bounds;
+  return Insert(entry);
+}
+
+RetainedLayer::Id RetainedLayer::Insert(const Object& entry) {
+  uint32_t index;
+  if (free_.empty()) {
+    index = uint32_t(objects_.size());
+    objects_.emplace_back();
+  } else {
+    index = free_.back();
+    free_.pop_back();
+  }
+
+  Object& object = objects_[index];
+  const uint32_t handle_generation = object.handle_generation;
+  object = entry;
+  object.handle_generation = handle_generation;
+  if (object.transformable) {
+    object.bounds = TrackedBounds(object);
+    object.generation = object.transformable->generation();
+    if (object.text && object.text->font_)
+      object.font_generation = object.text->font_->generation();
+  }
+  AddDirty(Pixels(object.bounds));
+  order_.push_back(index);
+  ++size_;
+
+  Id id;
+  id.index = index + 1;
+  id.generation = handle_generation;
+  return id;
+}
+
+/// @brief Remove an object. Its area is rendered again.
+void RetainedLayer::Remove(Id id) {
+  Object* object = Find(id);
+  if (!object)
+    return;
+
+  AddDirty(Pixels(object->bounds));
+  const uint32_t index = id.index - 1;
+  order_.erase(std::find(order_.begin(), order_.end(), index));
+  object->drawable = nullptr;
+  ++object->handle_generation;
+  free_.push_back(index);
+  --size_;
+}
+
+/// @brief Remove every objects.
+void RetainedLayer::Clear() {
+  for (uint32_t index : order_) {
+    Object& object = objects_[index];
+    object.drawable = nullptr;
+    ++object.handle_generation;
+    free_.push_back(index);
+  }
+  order_.clear();
+  size_ = 0;
+  InvalidateAll();
+}
+
+/// @brief Render an object again during the next Draw().
+void RetainedLayer::Invalidate(Id id) {
+  Object* object = Find(id);
+  if (object)
+    AddDirty(Pixels(object->bounds));
+}
+
+/// @brief Render an area again during the next Draw().
+/// @param area The area, in the layer coordinates.
+void RetainedLayer::Invalidate(const Rectangle& area) {
+  AddDirty(Pixels(area));
+}
+
+/// @brief Render the whole layer again during the next Draw().
+void RetainedLayer::InvalidateAll() {
+  dirty_.clear();
+  AddDirty({0, 0, width_, height_});
+}
+
+/// @brief Move an object whose changes aren't detected.
+/// @param id The object.
+/// @param bounds The new area covered by the object.
+void RetainedLayer::SetBounds(Id id, const Rectangle& bounds) {
+  Object* object = Find(id);
+  if (!object)
+    return;
+  AddDirty(Pixels(object->bounds));
+  object->bounds = bounds;
+  AddDirty(Pixels(bounds));
+}
+
+/// @brief Set the color the layer is cleared with.
+void RetainedLayer::SetBackground(const glm::vec4& color) {
+  background_ = color;
+  clear_quad_.SetColor(color);
+  InvalidateAll();
+}
+
+/// @brief Set where the layer is drawn.
+/// @param position The position of its top-left corner, in the coordinates of
+///                 the View.
+void RetainedLayer::SetPosition(const glm::vec2& position) {
+  sprite_.SetPosition(position);
+}
+
+/// @brief Render again the areas that changed, then draw the layer using a
+/// single draw call.
+void RetainedLayer::Draw(RenderTarget& target, RenderState state) const {
+  if (!framebuffer_)
+    return;
+  Track();
+  Redraw();
+  sprite_.Draw(target, std::move(state));
+}
+
+// The bounds of a tracked object, computed from its shape.
+// static
+Rectangle RetainedLayer::TrackedBounds(const Object& object) {
+  Rectangle local = {0.f, 0.f, 0.f, 0.f};
+  if (object.text) {
+    const glm::vec2 dimensions = object.text->ComputeDimensions();
+    local = {0.f, 0.f, dimensions.x, dimensions.y};
+  } else {
+    const BoundingBox& box = object.transformable->vertex_array().bounds();
+    if (box.empty())
+      return local;
+    local = {box.min.x, box.min.y, box.max.x, box.max.y};
+  }
+  return Scene2D::Bounds(*object.transformable, local);
+}
+
+// Find the tracked objects modified since they were rendered.
+void RetainedLayer::Track() const {
+  for (uint32_t index : order_) {
+    const Object& object = objects_[index];
+    if (!object.transformable)
+      continue;
+
+    const size_t generation = object.transformable->generation();
+    size_t font_generation = 0;
+    if (object.text && object.text->font_)
+      font_generation = object.text->font_->generation();
+    if (generation == object.generation &&
+        font_generation == object.font_generation) {
+      continue;
+    }
+
+    AddDirty(Pixels(object.bounds));
+    object.bounds = TrackedBounds(object);
+    object.generation = generation;
+    object.font_generation = font_generation;
+    AddDirty(Pixels(object.bounds));
+  }
+}
+
+// Clear the dirty areas, and draw the objects intersecting them, clipped.
+void RetainedLayer::Redraw() const {
+  redrawn_ = 0;
+  for (const glm::ivec4& area : dirty_) {
+    framebuffer_->PushClip(area);
+    framebuffer_->Draw(clear_quad_);
+    for (uint32_t index : order_) {
+      const Object& object = objects_[index];
+      if (!Intersect(area, Pixels(object.bounds)))
+        continue;
+      framebuffer_->Draw(*object.drawable);
+      ++redrawn_;
+    }
+    framebuffer_->PopClip();
+  }
+  dirty_.clear();
+}
+
+// Add an area to render again, merged with the ones it touches.
+void RetainedLayer::AddDirty(glm::ivec4 area) const {
+  area = {std::max(area.x, 0), std::max(area.y, 0), std::min(area.z, width_),
+          std::min(area.w, height_)};
+  if (area.x >= area.z || area.y >= area.w)
+    return;
+
+  for (size_t i = 0; i < dirty_.size();) {
+    if (Adjacent(dirty_[i], area)) {
+      area = Union(area, dirty_[i]);
+      dirty_[i] = dirty_.back();
+      dirty_.pop_back();
+      i = 0;  // The union may touch the areas already visited.
+    } else {
+      ++i;
+    }
+  }
+  dirty_.push_back(area);
+
+  if (dirty_.size() > kMaxDirtyAreas) {
+    glm::ivec4 all = dirty_[0];
+    for (const glm::ivec4& it : dirty_)
+      all = Union(all, it);
+    dirty_.assign(1, all);
+  }
+}
+
+RetainedLayer::Object* RetainedLayer::Find(Id id) {
+  if (id.index == 0 || id.index > objects_.size())
+    return nullptr;
+  Object& object = objects_[id.index - 1];
+  if (!object.drawable || object.handle_generation != id.generation)
+    return nullptr;
+  return &object;
+}
+
+}  // namespace smk
@@ -0,0 +1,51 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <AL/al.h>
+
+#include <algorithm>
+#include <smk/Audio.hpp>
+
+#include "SampleConversion.hpp"
+
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
+namespace smk {
+
+void FloatToInt16(const float* source, int16_t* destination, size_t count) {
+  const float scale = float((1 << 15) - 1);
+  size_t i = 0;
+#if defined(__SSE2__)
+  // 8 samples per iteration. The values are clamped before the conversion,
+  // like below: out of range, _mm_cvttps_epi32 returns INT_MIN.
+  const __m128 factor = _mm_set1_ps(scale);
+  const __m128 low = _mm_set1_ps(-1.f);
+  const __m128 high = _mm_set1_ps(+1.f);
+  auto clamp = [&](__m128 value) {
+    return _mm_max_ps(_mm_min_ps(value, high), low);
+  };
+  for (; i + 8 <= count; i += 8) {
+    __m128 a = _mm_mul_ps(clamp(_mm_loadu_ps(source + i)), factor);
+    __m128 b = _mm_mul_ps(clamp(_mm_loadu_ps(source + i + 4)), factor);
+    __m128i samples =
+        _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+    _mm_storeu_si128((__m128i*)(destination + i), samples);
+  }
+#endif
+  for (; i < count; ++i) {
+    const float value = std::max(-1.f, std::min(source[i], +1.f));
+    destination[i] = int16_t(value * scale);
+  }
+}
+
+bool Float32SamplesSupported() {
+  if (!Audio::Initialized())
+    return false;
+  static const bool supported = alIsExtensionPresent("AL_EXT_float32");
+  return supported;
+}
+
+}  // namespace smk
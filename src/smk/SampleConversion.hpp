@@ -0,0 +1,22 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_SAMPLE_CONVERSION_HPP
+#define SMK_SAMPLE_CONVERSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace smk {
+
+// Convert |count| samples in [-1, 1] of |source| into 16 bits samples in
+// |destination|. The values outside [-1, 1] are clamped.
+void FloatToInt16(const float* source, int16_t* destination, size_t count);
+
+// Whether OpenAL accepts 32 bits float samples (AL_EXT_float32). This requires
+// smk::Audio to be initialized.
+bool Float32SamplesSupported();
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_SAMPLE_CONVERSION_HPP */
@@ -0,0 +1,262 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <cmath>
+#include <smk/RenderTarget.hpp>
+#include <smk/Scene2D.hpp>
+#include <smk/Sprite.hpp>
+#include <smk/Transformable.hpp>
+
+namespace smk {
+
+static bool Intersect(const Rectangle& a, const Rectangle& b) {
+  return a.left <= b.right && b.left <= a.right && a.top <= b.bottom &&
+         b.top <= a.bottom;
+}
+
+/// @brief Constructor.
+/// @param cell_size The size of the grid cells. It should be of the order of
+///                  the size of the objects.
+Scene2D::Scene2D(float cell_size) : cell_size_(cell_size) {}
+
+/// @brief Add an object.
+/// @param drawable The object. It must outlive the scene or be removed.
+/// @param bounds The area covered by the object, in the View coordinates.
+/// @return The identifier of the object in the scene.
+Scene2D::Id Scene2D::Add(const Drawable& drawable, const Rectangle& bounds) {
+  uint32_t index;
+  if (free_.empty()) {
+    index = uint32_t(objects_.size());
+    objects_.emplace_back();
+  } else {
+    index = free_.back();
+    free_.pop_back();
+  }
+
+  Object& object = objects_[index];
+  object.drawable = &drawable;
+  object.bounds = bounds;
+  object.order = next_order_++;
+  Insert(index, CellSpan(bounds));
+  ++size_;
+
+  Id id;
+  id.index = index + 1;
+  id.generation = object.generation;
+  return id;
+}
+
+/// @brief Move an object. Only the cells it leaves or enters are modified.
+/// @param id The object.
+/// @param bounds Its new bounds.
+void Scene2D::Update(Id id, const Rectangle& bounds) {
+  Object* object = Find(id);
+  if (!object)
+    return;
+
+  Span before = CellSpan(object->bounds);
+  Span after = CellSpan(bounds);
+  object->bounds = bounds;
+  if (before.left == after.left && before.top == after.top &&
+      before.right == after.right && before.bottom == after.bottom) {
+    return;
+  }
+
+  const uint32_t index = id.index - 1;
+  Erase(index, before);
+  Insert(index, after);
+}
+
+/// @brief Remove an object. Its identifier becomes invalid.
+void Scene2D::Remove(Id id) {
+  Object* object = Find(id);
+  if (!object)
+    return;
+
+  const uint32_t index = id.index - 1;
+  Erase(index, CellSpan(object->bounds));
+  object->drawable = nullptr;
+  ++object->generation;
+  free_.push_back(index);
+  --size_;
+}
+
+/// @brief Remove every objects.
+void Scene2D::Clear() {
+  for (uint32_t index = 0; index < objects_.size(); ++index) {
+    Object& object = objects_[index];
+    if (!object.drawable)
+      continue;
+    object.drawable = nullptr;
+    ++object.generation;
+    free_.push_back(index);
+  }
+  cells_.clear();
+  size_ = 0;
+}
+
+/// @brief The bounds of a Sprite, taking its transformation into account.
+// static
+Rectangle Scene2D::Bounds(const Sprite& sprite) {
+  return Bounds(sprite, {0.f, 0.f, sprite.size().x, sprite.size().y});
+}
+
+/// @brief The bounds of an object, taking its transformation into account.
+/// @param object The object.
+/// @param local The area covered by the object, in its own coordinates.
+// static
+Rectangle Scene2D::Bounds(const TransformableBase& object,
+                          const Rectangle& local) {
+  const glm::mat4 m = object.transformation();
+  const glm::vec2 corners[] = {
+      {local.left, local.top},
+      {local.right, local.top},
+      {local.left, local.bottom},
+      {local.right, local.bottom},
+  };
+  Rectangle bounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+  for (const glm::vec2& corner : corners) {
+    glm::vec4 p = m * glm::vec4(corner.x, corner.y, 0.f, 1.f);
+    bounds.left = std::min(bounds.left, p.x);
+    bounds.top = std::min(bounds.top, p.y);
+    bounds.right = std::max(bounds.right, p.x);
+    bounds.bottom = std::max(bounds.bottom, p.y);
+  }
+  return bounds;
+}
+
+/// @brief Collect the objects intersecting an area.
+/// @param area The area, in the View coordinates.
+/// @param out The objects found, in the order they were added.
+void Scene2D::Query(const Rectangle& area,
+                    std::vector<const Drawable*>* out) const {
+  // An object spanning several cells is found once: it is marked with the
+  // identifier of the query.
+  if (++query_ == 0) {
+    for (const Object& object : objects_)
+      object.query = 0;
+    query_ = 1;
+  }
+
+  visible_.clear();
+  auto visit = [&](const std::vector<uint32_t>& cell) {
+    for (uint32_t index : cell) {
+      const Object& object = objects_[index];
+      if (object.query == query_ || !Intersect(object.bounds, area))
+        continue;
+      object.query = query_;
+      visible_.push_back(index);
+    }
+  };
+
+  // When the area covers more cells than the non-empty ones, visit the latter.
+  Span span = CellSpan(area);
+  double cell_count =
+      double(span.right - span.left + 1) * double(span.bottom - span.top + 1);
+  if (cell_count > double(cells_.size())) {
+    for (const auto& cell : cells_)
+      visit(cell.second);
+  } else {
+    for (int y = span.top; y <= span.bottom; ++y) {
+      for (int x = span.left; x <= span.right; ++x) {
+        auto it = cells_.find(CellKey(x, y));
+        if (it != cells_.end())
+          visit(it->second);
+      }
+    }
+  }
+
+  std::sort(visible_.begin(), visible_.end(), [&](uint32_t a, uint32_t b) {
+    return objects_[a].order < objects_[b].order;
+  });
+  for (uint32_t index : visible_)
+    out->push_back(objects_[index].drawable);
+}
+
+/// @brief Draw the objects intersecting the View of |target|. The scene is
+/// drawn through the transformation of |state|, so the View is brought back
+/// into the scene coordinates first.
+void Scene2D::Draw(RenderTarget& target, RenderState state) const {
+  // A degenerated transformation shows nothing.
+  if (glm::determinant(state.view) == 0.f) {
+    drawn_ = 0;
+    return;
+  }
+  const glm::mat4 to_scene = glm::inverse(state.view);
+
+  const View& view = target.view();
+  const glm::vec2 corners[] = {
+      {view.Left(), view.Top()},
+      {view.Right(), view.Top()},
+      {view.Left(), view.Bottom()},
+      {view.Right(), view.Bottom()},
+  };
+  // The bounding box of the corners. The View can be flipped, and the
+  // transformation rotated.
+  Rectangle area = {+INFINITY, +INFINITY, -INFINITY, -INFINITY};
+  for (const glm::vec2& corner : corners) {
+    const glm::vec4 point = to_scene * glm::vec4(corner, 0.f, 1.f);
+    area.left = std::min(area.left, point.x);
+    area.top = std::min(area.top, point.y);
+    area.right = std::max(area.right, point.x);
+    area.bottom = std::max(area.bottom, point.y);
+  }
+
+  std::vector<const Drawable*> drawables;
+  Query(area, &drawables);
+  drawn_ = drawables.size();
+  for (const Drawable* drawable : drawables)
+    drawable->Draw(target, state);
+}
+
+Scene2D::Object* Scene2D::Find(Id id) {
+  if (id.index == 0 || id.index > objects_.size())
+    return nullptr;
+  Object& object = objects_[id.index - 1];
+  if (!object.drawable || object.generation != id.generation)
+    return nullptr;
+  return &object;
+}
+
+Scene2D::Span Scene2D::CellSpan(const Rectangle& bounds) const {
+  return {
+      int(std::floor(bounds.left / cell_size_)),
+      int(std::floor(bounds.top / cell_size_)),
+      int(std::floor(bounds.right / cell_size_)),
+      int(std::floor(bounds.bottom / cell_size_)),
+  };
+}
+
+void Scene2D::Insert(uint32_t index, const Span& span) {
+  for (int y = span.top; y <= span.bottom; ++y) {
+    for (int x = span.left; x <= span.right; ++x)
+      cells_[CellKey(x, y)].push_back(index);
+  }
+}
+
+void Scene2D::Erase(uint32_t index, const Span& span) {
+  for (int y = span.top; y <= span.bottom; ++y) {
+    for (int x = span.left; x <= span.right; ++x) {
+      auto it = cells_.find(CellKey(x, y));
+      if (it == cells_.end())
+        continue;
+      std::vector<uint32_t>& cell = it->second;
+      auto position = std::find(cell.begin(), cell.end(), index);
+      if (position != cell.end()) {
+        *position = cell.back();
+        cell.pop_back();
+      }
+      if (cell.empty())
+        cells_.erase(it);
+    }
+  }
+}
+
+// static
+uint64_t Scene2D::CellKey(int x, int y) {
+  return uint64_t(uint32_t(x)) << 32 | uint32_t(y);
+}
+
+}  // namespace smk
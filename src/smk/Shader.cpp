@@ -2,11 +2,19 @@
 // Use of this source code is governed by the MIT license that can be found in
 // the LICENSE file.
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <mutex>
+#include <smk/FrameBlock.hpp>
+#include <smk/RenderStats.hpp>
+#include <smk/RenderTarget.hpp>
 #include <smk/Shader.hpp>
+#include <set>
 #include <stdexcept>
 #include <streambuf>
 #include <string>
@@ -15,9 +23,118 @@
 namespace smk {
 
 extern bool g_khr_parallel_shader;
+extern thread_local bool g_invalidate_shader_program;
+extern thread_local RenderStats g_render_stats;
+extern std::atomic<int> g_render_threads;
 
 using namespace glm;
 
+namespace {
+
+// Where the program binaries are stored. Empty when disabled.
+std::string g_binary_cache_directory;
+
+// The shaders whose compilation is delayed until a program using them isn't
+// found in the binary cache.
+std::set<GLuint> g_uncompiled_shaders;
+
+bool UseBinaryCache() {
+#ifdef __EMSCRIPTEN__
+  return false;
+#else
+  if (g_binary_cache_directory.empty())
+    return false;
+  static const bool supported = [] {
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+      return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+  }();
+  return supported;
+#endif
+}
+
+void CompileIfDelayed(GLuint shader) {
+  auto it = g_uncompiled_shaders.find(shader);
+  if (it == g_uncompiled_shaders.end())
+    return;
+  g_uncompiled_shaders.erase(it);
+  glCompileShader(shader);
+}
+
+// FNV-1a.
+uint64_t Hash(uint64_t hash, const std::string& data) {
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+std::string GLString(GLenum name) {
+  const GLubyte* value = glGetString(name);
+  return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+// The name of the file storing |program|. It depends on the sources of its
+// shaders and on the driver, whose binaries are not portable.
+std::string BinaryCachePath(GLuint program) {
+  GLint count = 0;
+  glGetProgramiv(program, GL_ATTACHED_SHADERS, &count);
+  std::vector<GLuint> shaders(count);
+  glGetAttachedShaders(program, count, nullptr, shaders.data());
+
+  std::vector<std::string> sources;
+  for (GLuint shader : shaders) {
+    GLint type = 0;
+    GLint length = 0;
+    glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+    glGetShaderiv(shader, GL_SHADER_SOURCE_LENGTH, &length);
+    std::string source(std::max(length, 1), '\0');
+    glGetShaderSource(shader, length, nullptr, &source[0]);
+    sources.push_back(std::to_string(type) + ":" + source);
+  }
+  // The order of the attached shaders is unspecified.
+  std::sort(sources.begin(), sources.end());
+
+  uint64_t hash = 14695981039346656037ull;
+  hash = Hash(hash, GLString(GL_VENDOR));
+  hash = Hash(hash, GLString(GL_RENDERER));
+  hash = Hash(hash, GLString(GL_VERSION));
+  for (const std::string& source : sources)
+    hash = Hash(hash, source);
+
+  char name[17];
+  snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+  return g_binary_cache_directory + "/" + name + ".bin";
+}
+
+// Load |program| from |path|. Return false when it isn't in the cache, or when
+// the driver rejects it.
+bool LoadBinary(GLuint program, const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    return false;
+  GLenum format = 0;
+  file.read(reinterpret_cast<char*>(&format), sizeof(format));
+  if (!file)
+    return false;
+  // Reading through the stream buffer never sets eofbit, only badbit on
+  // errors.
+  std::vector<char> binary((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+  if (file.bad() || binary.empty())
+    return false;
+
+  glProgramBinary(program, format, binary.data(), binary.size());
+  GLint status = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &status);
+  return status == GL_TRUE;
+}
+
+}  // namespace
+
 const std::string kShaderHeader =
 #ifdef __EMSCRIPTEN__
     "#version 300 es\n"
@@ -58,11 +175,24 @@ Shader Shader::FromFile(const std::string& filename, GLenum type) {
 /// @see Shader::FromString
 /// @see Shader::FromFile
 Shader Shader::FromString(const std::string& content, GLenum type) {
+  return FromMemory(content.data(), content.size(), type);
+}
+
+// static
+/// @brief Load a shader from a memory area, for instance an entry of an
+/// smk::AssetArchive.
+/// @param data The source of the shader. It doesn't need to be null-terminated.
+/// @param size The size of |data|, in bytes.
+/// @param type Either GL_VERTEX_SHADER or GL_FRAGMENT_SHADER. It can also be
+///             any other shader type defined by OpenGL.
+//
+/// @see Shader::FromString
+/// @see Shader::FromFile
+Shader Shader::FromMemory(const char* data, size_t size, GLenum type) {
   std::vector<char> buffer;
-  for (const auto& c : kShaderHeader)
-    buffer.push_back(c);
-  for (const auto& c : content)
-    buffer.push_back(c);
+  buffer.reserve(kShaderHeader.size() + size + 1);
+  buffer.insert(buffer.end(), kShaderHeader.begin(), kShaderHeader.end());
+  buffer.insert(buffer.end(), data, data + size);
   buffer.push_back('\0');
   return Shader(std::move(buffer), type);
 }
@@ -81,13 +211,17 @@ Shader::Shader(const std::vector<char>& content, GLenum type) {
     std::cerr << "[Error] Impossible to create a new Shader" << std::endl;
     throw std::runtime_error("[Error] Impossible to create a new Shader");
   }
+  ref_count_ = new std::atomic<int>(1);
 
   // code source assignation
   const char* shaderText(&content[0]);
   glShaderSource(id_, 1, (const GLchar**)&shaderText, NULL);
 
-  // compilation
-  glCompileShader(id_);
+  // compilation. With the binary cache, it happens only when needed.
+  if (UseBinaryCache())
+    g_uncompiled_shaders.insert(id_);
+  else
+    glCompileShader(id_);
 }
 
 /// @brief Check the status of a Shader.
@@ -96,6 +230,7 @@ Shader::Shader(const std::vector<char>& content, GLenum type) {
 /// completion, you can use this function and use the Shader only after it
 /// becomes ready.
 bool Shader::IsReady() {
+  CompileIfDelayed(id_);
   if (g_khr_parallel_shader) {
     GLint completion_status;
     glGetShaderiv(id_, GL_COMPLETION_STATUS_KHR, &completion_status);
@@ -109,6 +244,7 @@ bool Shader::IsReady() {
 /// @brief Wait until the Shader to be ready.
 /// @return True if it suceeded, false otherwise.
 bool Shader::CompileStatus() {
+  CompileIfDelayed(id_);
   GLint compile_status;
   glGetShaderiv(id_, GL_COMPILE_STATUS, &compile_status);
   if (compile_status == GL_TRUE)
@@ -139,13 +275,12 @@ Shader::Shader(Shader&& other) noexcept {
 }
 
 Shader& Shader::operator=(const Shader& other) noexcept {
+  if (this == &other)
+    return *this;
   Release();
   if (!other.id_)
     return *this;
 
-  if (!other.ref_count_)
-    other.ref_count_ = new int(1);
-
   id_ = other.id_;
   ref_count_ = other.ref_count_;
 
@@ -166,28 +301,112 @@ void Shader::Release() {
 
   // Transfert state to local:
   GLuint id = 0;
-  int* ref_count = nullptr;
+  std::atomic<int>* ref_count = nullptr;
   std::swap(id_, id);
   std::swap(ref_count_, ref_count);
 
   // Early return without releasing the resource if it is still hold by copy of
   // this class.
   if (ref_count) {
-    --(*ref_count);
-    if (*ref_count)
+    if (--(*ref_count))
       return;
     delete ref_count;
-    ref_count = nullptr;
   }
 
   // Release the OpenGL objects.
+  g_uncompiled_shaders.erase(id);
   glDeleteShader(id);
 }
 
+namespace {
+// The location of a uniform not looked up yet.
+constexpr GLint kUnresolvedUniform = -2;
+
+// The lighting parameters used to be plain uniforms of the default 3D program.
+// They now live in the FrameBlock. Setting them by name on a program reading
+// the block updates the block instead, so the existing callers keep working.
+float* FrameBlockFloat(const ShaderProgram& program, const std::string& name) {
+  FrameBlock& block = RenderTarget::frame_block();
+  float* member = name == "ambient"          ? &block.ambient
+                  : name == "diffuse"        ? &block.diffuse
+                  : name == "specular"       ? &block.specular
+                  : name == "specular_power" ? &block.specular_power
+                                             : nullptr;
+  return member && program.UsesFrameBlock() ? member : nullptr;
+}
+
+glm::vec4* FrameBlockLightPosition(const ShaderProgram& program,
+                                   const std::string& name) {
+  if (name != "light_position" || !program.UsesFrameBlock())
+    return nullptr;
+  return &RenderTarget::frame_block().light_position;
+}
+}  // namespace
+
+struct ShaderProgram::UniformValues {
+  struct Value {
+    GLint uniform;
+    GLenum type;
+    glm::mat4 value;  // The vectors and the floats use the first column.
+    int integer;
+  };
+  std::vector<Value> values;
+  uint64_t version = 0;  // Zero when empty.
+};
+
 struct ShaderProgram::Impl {
+  // Guards |uniforms| and |recorded|. A render thread may draw with the
+  // program while the application thread uses it.
+  std::mutex mutex;
   std::map<std::string, GLint> uniforms;
   GLuint id = 0;
 
+  // Built-in uniforms, used on every draw.
+  std::atomic<GLint> projection_uniform{kUnresolvedUniform};
+  std::atomic<GLint> view_uniform{kUnresolvedUniform};
+  std::atomic<GLint> color_uniform{kUnresolvedUniform};
+  std::atomic<GLint> texture_rectangle_uniform{kUnresolvedUniform};
+
+  // The values given to SetUniform() while a render thread runs, and the
+  // version of the ones uploaded to the program.
+  std::shared_ptr<const UniformValues> recorded;
+  uint64_t recorded_version = 0;
+  std::atomic<uint64_t> uploaded_version{0};
+
+  // The last values uploaded to the built-in uniforms. Uniforms are part of
+  // the program state, so they survive switching programs or RenderTarget.
+  glm::mat4 projection;
+  glm::mat4 view;
+  glm::vec4 color;
+  glm::vec4 texture_rectangle;
+  bool projection_uploaded = false;
+  bool view_uploaded = false;
+  bool color_uploaded = false;
+  bool texture_rectangle_uploaded = false;
+
+  // Whether the "smk_frame" block is declared. -1 when not looked up yet.
+  std::atomic<int> frame_block{-1};
+
+  // The file the binary must be stored into once linked. Empty otherwise.
+  std::string binary_cache_path;
+
+  // The recorded values are dropped too: the locations may have moved.
+  void ResetUniforms() {
+    std::lock_guard<std::mutex> lock(mutex);
+    frame_block = -1;
+    uniforms.clear();
+    recorded = nullptr;
+    uploaded_version = 0;
+    projection_uniform = kUnresolvedUniform;
+    view_uniform = kUnresolvedUniform;
+    color_uniform = kUnresolvedUniform;
+    texture_rectangle_uniform = kUnresolvedUniform;
+    projection_uploaded = false;
+    view_uploaded = false;
+    color_uploaded = false;
+    texture_rectangle_uploaded = false;
+  }
+
   ~Impl() {
     if (!id)
       return;
@@ -202,7 +421,9 @@ ShaderProgram::ShaderProgram() : impl_(new Impl()) {}
 
 /// @brief Add a Shader to the program list. This must called multiple time for
 /// each shader components before calling @ref Link.
-/// @param shader The Shader to be added to the program list.
+/// @param shader The Shader to be added to the program list. It must be kept
+///               until @ref Link is called: with the binary cache, it is
+///               compiled only then.
 void ShaderProgram::AddShader(const Shader& shader) {
   if (!impl_->id) {
     impl_->id = glCreateProgram();
@@ -213,9 +434,70 @@ void ShaderProgram::AddShader(const Shader& shader) {
   glAttachShader(id(), shader.id());
 }
 
-/// @brief Add a Shader to the program list.
+/// @brief Link the shaders of the program list. When the binary cache is
+/// enabled and holds this program, it is loaded instead and the shaders are
+/// never compiled.
+/// @see SetBinaryCacheDirectory
 void ShaderProgram::Link() {
+  impl_->binary_cache_path.clear();
+  if (UseBinaryCache()) {
+    std::string path = BinaryCachePath(id());
+    if (LoadBinary(id(), path)) {
+      impl_->ResetUniforms();
+      return;
+    }
+    impl_->binary_cache_path = path;
+    glProgramParameteri(id(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+
+  GLint count = 0;
+  glGetProgramiv(id(), GL_ATTACHED_SHADERS, &count);
+  std::vector<GLuint> shaders(count);
+  glGetAttachedShaders(id(), count, nullptr, shaders.data());
+  for (GLuint shader : shaders)
+    CompileIfDelayed(shader);
+
   glLinkProgram(id());
+  // Linking resets the uniforms and may move them.
+  impl_->ResetUniforms();
+}
+
+// static
+/// @brief Enable the cache of linked programs. The programs linked later are
+/// stored in |directory| and loaded back on the next launches, skipping the
+/// compilation of their shaders. The cache entries depend on the shader
+/// sources and on the driver. This must be called before creating the Window,
+/// so that its default programs are cached too.
+/// @param directory An existing directory. Empty disables the cache.
+void ShaderProgram::SetBinaryCacheDirectory(const std::string& directory) {
+  g_binary_cache_directory = directory;
+}
+
+// Write the linked program into the binary cache, if it was missing.
+void ShaderProgram::StoreBinary() const {
+  std::string path;
+  std::swap(path, impl_->binary_cache_path);
+
+  GLint status = GL_FALSE;
+  glGetProgramiv(id(), GL_LINK_STATUS, &status);
+  if (status != GL_TRUE)
+    return;
+
+  GLint length = 0;
+  glGetProgramiv(id(), GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(id(), length, &length, &format, binary.data());
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    std::cerr << "SMK > Can't write the program binary " << path << std::endl;
+    return;
+  }
+  file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+  file.write(binary.data(), length);
 }
 
 // Linking shader is an asynchronous process. Using the shader can causes the
@@ -225,8 +507,6 @@ void ShaderProgram::Link() {
 bool ShaderProgram::IsReady() {
   if (g_khr_parallel_shader) {
     GLint completion_status;
-    std::cerr << GL_COMPLETION_STATUS_KHR << std::endl;
-    std::cerr << id() << std::endl;
     glGetProgramiv(id(), GL_COMPLETION_STATUS_KHR, &completion_status);
     return completion_status == GL_TRUE;
   }
@@ -237,8 +517,11 @@ bool ShaderProgram::IsReady() {
 bool ShaderProgram::LinkStatus() {
   GLint result;
   glGetProgramiv(id(), GL_LINK_STATUS, &result);
-  if (result == GL_TRUE)
+  if (result == GL_TRUE) {
+    if (!impl_->binary_cache_path.empty())
+      StoreBinary();
     return true;
+  }
 
   std::cout << "[Error] linkage error" << std::endl;
 
@@ -256,6 +539,7 @@ bool ShaderProgram::LinkStatus() {
 /// @param name The uniform name in the Shader.
 /// @return The GPU uniform ID. Return 0 and display an error if not found.
 GLint ShaderProgram::Uniform(const std::string& name) {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
   auto it = impl_->uniforms.find(name);
   if (it == impl_->uniforms.end()) {
     // impl_->uniforms that is not referenced
@@ -277,6 +561,104 @@ GLint ShaderProgram::operator[](const std::string& name) {
   return Uniform(name);
 }
 
+/// @brief Return the location of the "projection" uniform. It is looked up
+/// only once.
+GLint ShaderProgram::projection_uniform() const {
+  if (impl_->projection_uniform == kUnresolvedUniform)
+    impl_->projection_uniform = glGetUniformLocation(id(), "projection");
+  return impl_->projection_uniform;
+}
+
+/// @brief Return the location of the "view" uniform. It is looked up only
+/// once.
+GLint ShaderProgram::view_uniform() const {
+  if (impl_->view_uniform == kUnresolvedUniform)
+    impl_->view_uniform = glGetUniformLocation(id(), "view");
+  return impl_->view_uniform;
+}
+
+/// @brief Return the location of the "color" uniform. It is looked up only
+/// once.
+GLint ShaderProgram::color_uniform() const {
+  if (impl_->color_uniform == kUnresolvedUniform)
+    impl_->color_uniform = glGetUniformLocation(id(), "color");
+  return impl_->color_uniform;
+}
+
+/// @brief Return the location of the "texture_rectangle" uniform. It is looked
+/// up only once.
+GLint ShaderProgram::texture_rectangle_uniform() const {
+  if (impl_->texture_rectangle_uniform == kUnresolvedUniform) {
+    impl_->texture_rectangle_uniform =
+        glGetUniformLocation(id(), "texture_rectangle");
+  }
+  return impl_->texture_rectangle_uniform;
+}
+
+/// @brief Return whether the program declares the "smk_frame" uniform block.
+/// The first call binds the block to the FrameBlock buffer.
+/// @see FrameBlock
+bool ShaderProgram::UsesFrameBlock() const {
+  if (impl_->frame_block == -1) {
+    GLuint index = glGetUniformBlockIndex(id(), "smk_frame");
+    impl_->frame_block = (index != GL_INVALID_INDEX);
+    if (impl_->frame_block)
+      glUniformBlockBinding(id(), index, FrameBlock::kBinding);
+  }
+  return impl_->frame_block;
+}
+
+/// @brief Assign the "projection" uniform. Nothing is uploaded when it already
+/// holds this value. The program must be in use.
+void ShaderProgram::SetProjectionUniform(const mat4& projection) const {
+  if (impl_->projection_uploaded && impl_->projection == projection)
+    return;
+  glUniformMatrix4fv(projection_uniform(), 1, GL_FALSE, value_ptr(projection));
+  ++g_render_stats.uniform_uploads;
+  impl_->projection = projection;
+  impl_->projection_uploaded = true;
+}
+
+/// @brief Assign the "view" uniform. Nothing is uploaded when it already holds
+/// this value. The program must be in use.
+void ShaderProgram::SetViewUniform(const mat4& view) const {
+  if (impl_->view_uploaded && impl_->view == view)
+    return;
+  glUniformMatrix4fv(view_uniform(), 1, GL_FALSE, value_ptr(view));
+  ++g_render_stats.uniform_uploads;
+  impl_->view = view;
+  impl_->view_uploaded = true;
+}
+
+/// @brief Assign the "color" uniform. Nothing is uploaded when it already holds
+/// this value. The program must be in use.
+void ShaderProgram::SetColorUniform(const vec4& color) const {
+  if (impl_->color_uploaded && impl_->color == color)
+    return;
+  glUniform4fv(color_uniform(), 1, value_ptr(color));
+  ++g_render_stats.uniform_uploads;
+  impl_->color = color;
+  impl_->color_uploaded = true;
+}
+
+/// @brief Assign the "texture_rectangle" uniform. Nothing is uploaded when it
+/// already holds this value, or when the program doesn't use it. The program
+/// must be in use.
+void ShaderProgram::SetTextureRectangleUniform(
+    const vec4& texture_rectangle) const {
+  if (impl_->texture_rectangle_uploaded &&
+      impl_->texture_rectangle == texture_rectangle) {
+    return;
+  }
+  impl_->texture_rectangle = texture_rectangle;
+  impl_->texture_rectangle_uploaded = true;
+  if (texture_rectangle_uniform() >= 0) {
+    glUniform4fv(texture_rectangle_uniform(), 1,
+                 value_ptr(texture_rectangle));
+    ++g_render_stats.uniform_uploads;
+  }
+}
+
 /// @brief Return the GPU attribute id.
 /// @param name The attribute name in the Shader.
 /// @return The GPU attribute ID. Return 0 and display an error if not found.
@@ -356,55 +738,245 @@ void ShaderProgram::SetUniform(const std::string& name,
                                float x,
                                float y,
                                float z) {
-  glUniform3f(Uniform(name), x, y, z);
+  if (vec4* light_position = FrameBlockLightPosition(*this, name)) {
+    *light_position = vec4(x, y, z, 1.f);
+    return;
+  }
+  SetUniform(Uniform(name), x, y, z);
 }
 
 /// @brief Assign shader vec3 uniform
 /// @param v vec3 value
 /// @overload
 void ShaderProgram::SetUniform(const std::string& name, const vec3& v) {
-  glUniform3fv(Uniform(name), 1, value_ptr(v));
+  if (vec4* light_position = FrameBlockLightPosition(*this, name)) {
+    *light_position = vec4(v, 1.f);
+    return;
+  }
+  SetUniform(Uniform(name), v);
 }
 
 /// @brief Assign shader vec4 uniform
 /// @param v vec4 value
 /// @overload
 void ShaderProgram::SetUniform(const std::string& name, const vec4& v) {
-  glUniform4fv(Uniform(name), 1, value_ptr(v));
+  if (vec4* light_position = FrameBlockLightPosition(*this, name)) {
+    *light_position = v;
+    return;
+  }
+  SetUniform(Uniform(name), v);
 }
 
 /// @brief Assign shader mat4 uniform
 /// @param m mat4 value
 /// @overload
 void ShaderProgram::SetUniform(const std::string& name, const mat4& m) {
-  glUniformMatrix4fv(Uniform(name), 1, GL_FALSE, value_ptr(m));
+  SetUniform(Uniform(name), m);
 }
 
 /// @brief Assign shader mat3 uniform
 /// @param m mat3 value
 /// @overload
 void ShaderProgram::SetUniform(const std::string& name, const mat3& m) {
-  glUniformMatrix3fv(Uniform(name), 1, GL_FALSE, value_ptr(m));
+  SetUniform(Uniform(name), m);
 }
 
 /// @brief Assign shader float uniform
 /// @param val float value
 /// @overload
 void ShaderProgram::SetUniform(const std::string& name, float val) {
-  glUniform1f(Uniform(name), val);
+  if (float* member = FrameBlockFloat(*this, name)) {
+    *member = val;
+    return;
+  }
+  SetUniform(Uniform(name), val);
 }
 
 /// @brief Assign shader int uniform
 /// @param val int value
 /// @overload
 void ShaderProgram::SetUniform(const std::string& name, int val) {
-  glUniform1i(Uniform(name), val);
+  SetUniform(Uniform(name), val);
+}
+
+/// @brief Assign shader vec3 uniform
+/// @param uniform The uniform location, as returned by @ref Uniform.
+/// @param x First vec3 component.
+/// @param y Second vec3 component.
+/// @param y Third vec3 component
+/// @overload
+void ShaderProgram::SetUniform(GLint uniform, float x, float y, float z) {
+  if (RecordUniform(uniform, GL_FLOAT_VEC3, mat4(vec4(x, y, z, 0.f), vec4(),
+                                                 vec4(), vec4()))) {
+    return;
+  }
+  glUniform3f(uniform, x, y, z);
+  ++g_render_stats.uniform_uploads;
+}
+
+/// @brief Assign shader vec3 uniform
+/// @param uniform The uniform location, as returned by @ref Uniform.
+/// @param v vec3 value
+/// @overload
+void ShaderProgram::SetUniform(GLint uniform, const vec3& v) {
+  if (RecordUniform(uniform, GL_FLOAT_VEC3,
+                    mat4(vec4(v, 0.f), vec4(), vec4(), vec4()))) {
+    return;
+  }
+  glUniform3fv(uniform, 1, value_ptr(v));
+  ++g_render_stats.uniform_uploads;
+}
+
+/// @brief Assign shader vec4 uniform
+/// @param uniform The uniform location, as returned by @ref Uniform.
+/// @param v vec4 value
+/// @overload
+void ShaderProgram::SetUniform(GLint uniform, const vec4& v) {
+  if (RecordUniform(uniform, GL_FLOAT_VEC4, mat4(v, vec4(), vec4(), vec4())))
+    return;
+  if (uniform == impl_->color_uniform)
+    impl_->color_uploaded = false;
+  if (uniform == impl_->texture_rectangle_uniform)
+    impl_->texture_rectangle_uploaded = false;
+  glUniform4fv(uniform, 1, value_ptr(v));
+  ++g_render_stats.uniform_uploads;
+}
+
+/// @brief Assign shader mat4 uniform
+/// @param uniform The uniform location, as returned by @ref Uniform.
+/// @param m mat4 value
+/// @overload
+void ShaderProgram::SetUniform(GLint uniform, const mat4& m) {
+  if (RecordUniform(uniform, GL_FLOAT_MAT4, m))
+    return;
+  if (uniform == impl_->projection_uniform)
+    impl_->projection_uploaded = false;
+  if (uniform == impl_->view_uniform)
+    impl_->view_uploaded = false;
+  glUniformMatrix4fv(uniform, 1, GL_FALSE, value_ptr(m));
+  ++g_render_stats.uniform_uploads;
+}
+
+/// @brief Assign shader mat3 uniform
+/// @param uniform The uniform location, as returned by @ref Uniform.
+/// @param m mat3 value
+/// @overload
+void ShaderProgram::SetUniform(GLint uniform, const mat3& m) {
+  if (RecordUniform(uniform, GL_FLOAT_MAT3, mat4(m)))
+    return;
+  glUniformMatrix3fv(uniform, 1, GL_FALSE, value_ptr(m));
+  ++g_render_stats.uniform_uploads;
+}
+
+/// @brief Assign shader float uniform
+/// @param uniform The uniform location, as returned by @ref Uniform.
+/// @param val float value
+/// @overload
+void ShaderProgram::SetUniform(GLint uniform, float val) {
+  if (RecordUniform(uniform, GL_FLOAT, mat4(vec4(val, 0.f, 0.f, 0.f), vec4(),
+                                            vec4(), vec4()))) {
+    return;
+  }
+  glUniform1f(uniform, val);
+  ++g_render_stats.uniform_uploads;
+}
+
+/// @brief Assign shader int uniform
+/// @param uniform The uniform location, as returned by @ref Uniform.
+/// @param val int value
+/// @overload
+void ShaderProgram::SetUniform(GLint uniform, int val) {
+  if (RecordUniform(uniform, GL_INT, mat4(), val))
+    return;
+  glUniform1i(uniform, val);
+  ++g_render_stats.uniform_uploads;
+}
+
+// Record the value of a uniform instead of uploading it, while a render thread
+// runs. Return whether it was recorded. The recorded draws keep the values set
+// before them, so a new set of values is made on every change.
+bool ShaderProgram::RecordUniform(GLint uniform,
+                                  GLenum type,
+                                  const mat4& value,
+                                  int integer) {
+  if (!g_render_threads.load(std::memory_order_relaxed))
+    return false;
+
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  auto values = std::make_shared<UniformValues>();
+  if (impl_->recorded)
+    *values = *impl_->recorded;
+  values->version = ++impl_->recorded_version;
+  auto it = std::find_if(
+      values->values.begin(), values->values.end(),
+      [&](const UniformValues::Value& v) { return v.uniform == uniform; });
+  if (it == values->values.end())
+    it = values->values.insert(it, UniformValues::Value());
+  *it = {uniform, type, value, integer};
+  impl_->recorded = std::move(values);
+  return true;
 }
 
+// The values recorded by SetUniform() so far. Never null.
+std::shared_ptr<const ShaderProgram::UniformValues>
+ShaderProgram::recorded_uniforms() const {
+  static const auto empty = std::make_shared<const UniformValues>();
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  return impl_->recorded ? impl_->recorded : empty;
+}
+
+// Upload recorded |values|, unless the program already holds them. The
+// program must be in use.
+void ShaderProgram::UploadUniforms(const UniformValues& values) const {
+  if (impl_->uploaded_version == values.version)
+    return;
+  impl_->uploaded_version = values.version;
+  for (const UniformValues::Value& v : values.values) {
+    switch (v.type) {
+      case GL_FLOAT_VEC3:
+        glUniform3fv(v.uniform, 1, value_ptr(v.value[0]));
+        break;
+      case GL_FLOAT_VEC4:
+        if (v.uniform == impl_->color_uniform)
+          impl_->color_uploaded = false;
+        if (v.uniform == impl_->texture_rectangle_uniform)
+          impl_->texture_rectangle_uploaded = false;
+        glUniform4fv(v.uniform, 1, value_ptr(v.value[0]));
+        break;
+      case GL_FLOAT_MAT4:
+        if (v.uniform == impl_->projection_uniform)
+          impl_->projection_uploaded = false;
+        if (v.uniform == impl_->view_uniform)
+          impl_->view_uploaded = false;
+        glUniformMatrix4fv(v.uniform, 1, GL_FALSE, value_ptr(v.value));
+        break;
+      case GL_FLOAT_MAT3:
+        glUniformMatrix3fv(v.uniform, 1, GL_FALSE, value_ptr(mat3(v.value)));
+        break;
+      case GL_FLOAT:
+        glUniform1f(v.uniform, v.value[0][0]);
+        break;
+      case GL_INT:
+        glUniform1i(v.uniform, v.integer);
+        break;
+    }
+    ++g_render_stats.uniform_uploads;
+  }
+}
+
+/// @brief Upload the values recorded by SetUniform() while a render thread
+/// runs. This is only needed before drawing with direct OpenGL calls. The
+/// program must be in use.
+void ShaderProgram::UploadRecordedUniforms() const {
+  UploadUniforms(*recorded_uniforms());
+}
 
 /// @brief Bind the ShaderProgram. Future draw will use it. This unbind any
 /// previously bound ShaderProgram.
 void ShaderProgram::Use() const {
+  // Once used, the program is linked. Storing it doesn't wait anymore.
+  if (!impl_->binary_cache_path.empty())
+    StoreBinary();
   glUseProgram(id());
 }
 
@@ -419,6 +991,33 @@ GLuint ShaderProgram::id() const {
   return impl_->id;
 }
 
+// Exchange the OpenGL programs of |this| and |other|. Every copies of this
+// ShaderProgram start using the new program.
+void ShaderProgram::SwapProgram(ShaderProgram& other) {
+  std::swap(impl_->id, other.impl_->id);
+  std::swap(impl_->binary_cache_path, other.impl_->binary_cache_path);
+  impl_->ResetUniforms();
+  other.impl_->ResetUniforms();
+  g_invalidate_shader_program = true;
+
+  // The new program must sample the units RenderTarget::SetShaderProgram()
+  // assigned to the previous one.
+  Use();
+  AssignTextureUnits();
+}
+
+// Make the sampler "texture_i" read the texture unit i. Must be in use.
+void ShaderProgram::AssignTextureUnits() {
+  SetUniform("texture_0", 0);
+  for (int i = 1; i <= RenderState::kExtraTextureUnits; ++i) {
+    // Most programs sample a single texture. Don't report the others missing.
+    const std::string name = "texture_" + std::to_string(i);
+    GLint location = glGetUniformLocation(id(), name.c_str());
+    if (location >= 0)
+      SetUniform(location, i);
+  }
+}
+
 bool ShaderProgram::operator==(const ShaderProgram& rhs) const {
   return impl_ == rhs.impl_;
 }
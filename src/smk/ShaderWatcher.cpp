@@ -0,0 +1,87 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <filesystem>
+#include <iostream>
+#include <smk/ShaderWatcher.hpp>
+
+namespace smk {
+
+/// @brief The empty ShaderWatcher.
+ShaderWatcher::ShaderWatcher() = default;
+
+/// @brief Build a ShaderProgram from two files, and watch them.
+/// @param vertex_shader_file The file containing the vertex shader.
+/// @param fragment_shader_file The file containing the fragment shader.
+ShaderWatcher::ShaderWatcher(const std::string& vertex_shader_file,
+                             const std::string& fragment_shader_file) {
+  files_.push_back({vertex_shader_file, GL_VERTEX_SHADER, 0});
+  files_.push_back({fragment_shader_file, GL_FRAGMENT_SHADER, 0});
+  Modified();
+
+  // The first version is needed to draw anything. It is built synchronously.
+  Build(program_);
+  pending_shaders_.clear();
+  if (!program_.LinkStatus())
+    std::cerr << "SMK > Can't link " << vertex_shader_file << " and "
+              << fragment_shader_file << std::endl;
+}
+
+/// @brief Check whether the files were modified. If so start building the new
+/// version. Replace the program once the new version is linked.
+/// @return True when the program was replaced.
+bool ShaderWatcher::Update() {
+  if (!pending_) {
+    if (Modified()) {
+      Build(pending_program_);
+      pending_ = true;
+    }
+    return false;
+  }
+
+  if (!pending_program_.IsReady())
+    return false;
+
+  pending_ = false;
+  bool linked = pending_program_.LinkStatus();
+  if (linked) {
+    program_.SwapProgram(pending_program_);
+  } else {
+    // Report the compilation errors.
+    for (Shader& shader : pending_shaders_)
+      shader.CompileStatus();
+    std::cerr << "SMK > Shader reload failed. Keeping the previous version."
+              << std::endl;
+  }
+  pending_program_ = ShaderProgram();
+  pending_shaders_.clear();
+  return linked;
+}
+
+// Update the modification times. Return true when one of them changed.
+bool ShaderWatcher::Modified() {
+  bool modified = false;
+  for (File& file : files_) {
+    std::error_code error;
+    int64_t time = std::filesystem::last_write_time(file.filename, error)
+                       .time_since_epoch()
+                       .count();
+    if (error || time == file.time)
+      continue;
+    file.time = time;
+    modified = true;
+  }
+  return modified;
+}
+
+// Compile and link the files into |program|, without waiting for the result.
+void ShaderWatcher::Build(ShaderProgram& program) {
+  for (const File& file : files_) {
+    pending_shaders_.push_back(Shader::FromFile(file.filename, file.type));
+    program.AddShader(pending_shaders_.back());
+  }
+  program.Link();
+}
+
+}  // namespace smk
@@ -4,7 +4,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
 #include <smk/Shape.hpp>
+#include <tuple>
 
 #ifndef M_PI
   #define M_PI 3.14159265358979323846
@@ -12,6 +17,93 @@
 
 namespace smk {
 
+namespace {
+
+// Prefer 16 bits indices, whenever the vertices can be addressed with them.
+template <typename VertexType>
+VertexArray IndexedVertexArray(const std::vector<VertexType>& vertices,
+                               const std::vector<uint32_t>& indices) {
+  if (vertices.size() > 0x10000)
+    return VertexArray(vertices, indices);
+  return VertexArray(vertices,
+                     std::vector<uint16_t>(indices.begin(), indices.end()));
+}
+
+// Merge the identical vertices of a list of triangles and index them.
+template <typename VertexType>
+VertexArray IndexedVertexArray(const std::vector<VertexType>& triangles) {
+  struct Compare {
+    bool operator()(const VertexType& a, const VertexType& b) const {
+      return std::memcmp(&a, &b, sizeof(VertexType)) < 0;
+    }
+  };
+  std::map<VertexType, uint32_t, Compare> index_of;
+  std::vector<VertexType> vertices;
+  std::vector<uint32_t> indices;
+  indices.reserve(triangles.size());
+  for (const auto& vertex : triangles) {
+    auto it = index_of.find(vertex);
+    if (it == index_of.end()) {
+      it = index_of.emplace(vertex, uint32_t(vertices.size())).first;
+      vertices.push_back(vertex);
+    }
+    indices.push_back(it->second);
+  }
+  return IndexedVertexArray(vertices, indices);
+}
+
+// The shapes already built. Identical shapes share their VertexArray. They
+// are keyed by the shape and its parameters.
+enum class CachedShape {
+  Square,
+  Circle,
+  Cube,
+  IcoSphere,
+  Plane,
+  RoundedRectangle,
+};
+using CacheKey = std::tuple<CachedShape, float, float, float>;
+struct CacheEntry {
+  VertexArray vertex_array;
+  uint64_t last_use = 0;
+};
+std::map<CacheKey, CacheEntry> g_cache;
+uint64_t g_cache_clock = 0;
+std::mutex g_cache_mutex;
+
+// Beyond this many shapes, the least recently used one is dropped. Otherwise,
+// the shapes built from animated parameters, like the radius of a
+// RoundedRectangle, would accumulate forever.
+const size_t kCacheCapacity = 64;
+
+template <typename Build>
+VertexArray Cached(const CacheKey& key, Build build) {
+  std::lock_guard<std::mutex> lock(g_cache_mutex);
+  auto it = g_cache.find(key);
+  if (it == g_cache.end()) {
+    if (g_cache.size() >= kCacheCapacity) {
+      g_cache.erase(std::min_element(
+          g_cache.begin(), g_cache.end(), [](const auto& a, const auto& b) {
+            return a.second.last_use < b.second.last_use;
+          }));
+    }
+    it = g_cache.emplace(key, CacheEntry()).first;
+    it->second.vertex_array = build();
+  }
+  it->second.last_use = ++g_cache_clock;
+  return it->second.vertex_array;
+}
+
+}  // namespace
+
+/// @brief Release the VertexArrays shared by the shapes built so far. The
+/// shapes keep their own reference. The next shapes are built again.
+// static
+void Shape::ReleaseCache() {
+  std::lock_guard<std::mutex> lock(g_cache_mutex);
+  g_cache.clear();
+}
+
 Transformable Shape::FromVertexArray(VertexArray vertex_array) {
   Transformable drawable;
   drawable.SetVertexArray(std::move(vertex_array));
@@ -28,32 +120,28 @@ Transformable Shape::Line(const glm::vec2& a,
   glm::vec2 dt =
       glm::normalize(glm::vec2(b.y - a.y, -b.x + a.x)) * thickness * 0.5f;
 
-  return FromVertexArray(VertexArray({
-      {a + dt, {0.f, 0.f}},
-      {b + dt, {1.f, 0.f}},
-      {b - dt, {1.f, 1.f}},
-      {a + dt, {0.f, 0.f}},
-      {b - dt, {1.f, 1.f}},
-      {a - dt, {0.f, 1.f}},
-  }));
+  return FromVertexArray(IndexedVertexArray<Vertex2D>(
+      {
+          {a + dt, {0.f, 0.f}},
+          {b + dt, {1.f, 0.f}},
+          {b - dt, {1.f, 1.f}},
+          {a - dt, {0.f, 1.f}},
+      },
+      {0, 1, 2, 0, 2, 3}));
 }
 
 /// @brief Return the square [0,1]x[0,1]
 Transformable Shape::Square() {
-  static VertexArray vertex_array;
-
-  if (!vertex_array.size()) {
-    vertex_array = VertexArray({
-        {{0.f, 0.f}, {0.f, 0.f}},
-        {{1.f, 0.f}, {1.f, 0.f}},
-        {{1.f, 1.f}, {1.f, 1.f}},
-        {{0.f, 0.f}, {0.f, 0.f}},
-        {{1.f, 1.f}, {1.f, 1.f}},
-        {{0.f, 1.f}, {0.f, 1.f}},
-    });
-  }
-
-  return FromVertexArray(vertex_array);
+  return FromVertexArray(Cached({CachedShape::Square, 0.f, 0.f, 0.f}, [] {
+    return IndexedVertexArray<Vertex2D>(
+        {
+            {{0.f, 0.f}, {0.f, 0.f}},
+            {{1.f, 0.f}, {1.f, 0.f}},
+            {{1.f, 1.f}, {1.f, 1.f}},
+            {{0.f, 1.f}, {0.f, 1.f}},
+        },
+        {0, 1, 2, 0, 2, 3});
+  }));
 }
 
 /// @brief Return a circle.
@@ -66,33 +154,66 @@ Transformable Shape::Circle(float radius) {
 /// @param radius The circle'radius.
 /// @param subdivisions The number of triangles used for drawing the circle.
 Transformable Shape::Circle(float radius, int subdivisions) {
+  return FromVertexArray(
+      Cached({CachedShape::Circle, radius, float(subdivisions), 0.f},
+             [&] { return CircleVertexArray(radius, subdivisions); }));
+}
+
+/// @brief Return a circle, drawn with more triangles when it is bigger on the
+/// screen. The shapes are shared by the circles of the same radius.
+/// @param radius The circle'radius.
+Transformable Shape::CircleLod(float radius) {
+  // The approximation error of a circle of n segments and a radius of r pixels
+  // is about r * pi^2 / (2 * n^2). It stays below one pixel with n = r.
+  std::vector<Transformable::LevelOfDetail> levels;
+  for (int subdivisions = 8; subdivisions <= 256; subdivisions *= 2) {
+    VertexArray vertex_array =
+        Cached({CachedShape::Circle, radius, float(subdivisions), 0.f},
+               [&] { return CircleVertexArray(radius, subdivisions); });
+    float min_size = subdivisions == 8 ? 0.f : 2.f * subdivisions;
+    levels.push_back({vertex_array, min_size});
+  }
+  Transformable transformable;
+  transformable.SetLevelsOfDetail(std::move(levels));
+  return transformable;
+}
+
+// static
+VertexArray Shape::CircleVertexArray(float radius, int subdivisions) {
+  // The center, followed by the points on the circle.
   std::vector<Vertex> v;
-  glm::vec2 p1 = glm::vec2(1.0f, 0.0f);
-  glm::vec2 t1 = glm::vec2(0.5f, 0.5f) + 0.5f * p1;
-  glm::vec2 zero(0.f, 0.f);
-  for (int i = 1; i <= subdivisions; ++i) {
+  std::vector<uint32_t> indices;
+  v.push_back({{0.f, 0.f}, {0.f, 0.f}});
+  for (int i = 0; i < subdivisions; ++i) {
     float a = (2.0 * M_PI * i) / subdivisions;
-    glm::vec2 p2 = glm::vec2(cos(a), sin(a));
-    glm::vec2 t2 = glm::vec2(0.5, 0.5) + 0.5f * p2;
+    glm::vec2 p = glm::vec2(cos(a), sin(a));
+    glm::vec2 t = glm::vec2(0.5, 0.5) + 0.5f * p;
+    v.push_back({radius * p, t});
 
-    v.push_back({zero, zero});
-    v.push_back({radius * p1, t1});
-    v.push_back({radius * p2, t2});
-    p1 = p2;
-    t1 = t2;
+    indices.push_back(0);
+    indices.push_back(1 + i);
+    indices.push_back(1 + (i + 1) % subdivisions);
   }
 
-  return FromVertexArray(VertexArray(std::move(v)));
+  return IndexedVertexArray(v, indices);
 }
 
 /// @brief Return a centered 1x1x1 3D cube
 Transformable3D Shape::Cube() {
+  Transformable3D transformable;
+  transformable.SetVertexArray(
+      Cached({CachedShape::Cube, 0.f, 0.f, 0.f}, &CubeVertexArray));
+  return transformable;
+}
+
+// static
+VertexArray Shape::CubeVertexArray() {
   constexpr float m = -0.5f;
   constexpr float z = +0.f;
   constexpr float p = +0.5f;
   constexpr float l = 0.f;
   constexpr float r = 1.f;
-  auto vertex_array = smk::VertexArray({
+  auto vertex_array = IndexedVertexArray<Vertex3D>({
       {{m, m, p}, {z, z, p}, {l, l}}, {{p, m, p}, {z, z, p}, {r, l}},
       {{p, p, p}, {z, z, p}, {r, r}}, {{m, m, p}, {z, z, p}, {l, l}},
       {{p, p, p}, {z, z, p}, {r, r}}, {{m, p, p}, {z, z, p}, {l, r}},
@@ -117,10 +238,7 @@ Transformable3D Shape::Cube() {
       {{m, p, m}, {m, z, z}, {r, l}}, {{m, m, m}, {m, z, z}, {l, l}},
       {{m, m, p}, {m, z, z}, {l, r}}, {{m, p, p}, {m, z, z}, {r, r}},
   });
-
-  Transformable3D transformable;
-  transformable.SetVertexArray(std::move(vertex_array));
-  return transformable;
+  return vertex_array;
 }
 
 /// @brief A centered sphere
@@ -128,6 +246,34 @@ Transformable3D Shape::Cube() {
 ///   Control the number of triangle used to make the sphere. It will contain
 ///   \f$ 8 \time 3^iteration\f$ triangles.
 Transformable3D Shape::IcoSphere(int iteration) {
+  Transformable3D transformable;
+  transformable.SetVertexArray(
+      Cached({CachedShape::IcoSphere, float(iteration), 0.f, 0.f},
+             [&] { return IcoSphereVertexArray(iteration); }));
+  return transformable;
+}
+
+/// @brief A centered sphere, drawn with more triangles when it is bigger on the
+/// screen. The shapes are shared by every spheres.
+/// @param max_iteration The iteration of the finest shape. See IcoSphere().
+Transformable3D Shape::IcoSphereLod(int max_iteration) {
+  std::vector<Transformable3D::LevelOfDetail> levels;
+  float min_size = 0.f;
+  for (int iteration = 0; iteration <= max_iteration; ++iteration) {
+    VertexArray vertex_array =
+        Cached({CachedShape::IcoSphere, float(iteration), 0.f, 0.f},
+               [&] { return IcoSphereVertexArray(iteration); });
+    levels.push_back({vertex_array, min_size});
+    // Every iteration multiplies the number of triangles by 3.
+    min_size = min_size ? min_size * 3.f : 16.f;
+  }
+  Transformable3D transformable;
+  transformable.SetLevelsOfDetail(std::move(levels));
+  return transformable;
+}
+
+// static
+VertexArray Shape::IcoSphereVertexArray(int iteration) {
   std::vector<glm::vec3> out = {
       {+1.f, +0.f, +0.f}, {+0.f, +1.f, +0.f}, {+0.f, +0.f, +1.f},
       {-1.f, +0.f, +0.f}, {+0.f, +0.f, -1.f}, {+0.f, -1.f, +0.f},
@@ -158,30 +304,33 @@ Transformable3D Shape::IcoSphere(int iteration) {
         {it * 0.5f, it, {it.x * 0.5f + 0.5f, it.y * 0.5f + 0.5f}});
   }
 
-  Transformable3D transformable;
-  transformable.SetVertexArray(std::move(vertex_array));
-  return transformable;
+  return IndexedVertexArray(vertex_array);
 }
 
 /// @brief Return a centered 1x1 square in a 3D space.
 Transformable3D Shape::Plane() {
+  Transformable3D transformable;
+  transformable.SetVertexArray(
+      Cached({CachedShape::Plane, 0.f, 0.f, 0.f}, &PlaneVertexArray));
+  return transformable;
+}
+
+// static
+VertexArray Shape::PlaneVertexArray() {
   constexpr float m = -0.5f;
   constexpr float z = +0.f;
   constexpr float p = +0.5f;
   constexpr float l = 0.f;
   constexpr float r = 1.f;
-  auto vertex_array = smk::VertexArray({
-      {{m, m, z}, {z, z, p}, {l, l}},
-      {{p, m, z}, {z, z, p}, {r, l}},
-      {{p, p, z}, {z, z, p}, {r, r}},
-      {{m, m, z}, {z, z, p}, {l, l}},
-      {{p, p, z}, {z, z, p}, {r, r}},
-      {{m, p, z}, {z, z, p}, {l, r}},
-  });
-
-  Transformable3D transformable;
-  transformable.SetVertexArray(std::move(vertex_array));
-  return transformable;
+  auto vertex_array = IndexedVertexArray<Vertex3D>(
+      {
+          {{m, m, z}, {z, z, p}, {l, l}},
+          {{p, m, z}, {z, z, p}, {r, l}},
+          {{p, p, z}, {z, z, p}, {r, r}},
+          {{m, p, z}, {z, z, p}, {l, r}},
+      },
+      {0, 1, 2, 0, 2, 3});
+  return vertex_array;
 }
 
 /// @brief Return a bezier curve.
@@ -193,13 +342,20 @@ Transformable3D Shape::Plane() {
 std::vector<glm::vec2> Shape::Bezier(const std::vector<glm::vec2>& points,
                                      size_t subdivision) {
   std::vector<glm::vec2> path;
+  if (points.empty())
+    return path;
+  path.reserve(subdivision + 1);
+
+  // De Casteljau's algorithm. It only interpolates, so it stays stable at
+  // any degree, unlike the binomial coefficients of the Bernstein form. A
+  // single buffer is reused by every sample.
+  std::vector<glm::vec2> data(points.size());
   for (size_t index = 0; index < subdivision + 1; ++index) {
-    std::vector<glm::vec2> data = points;
-    float x = float(index) / subdivision;
-    while (data.size() >= 2) {
-      for (size_t i = 0; i < data.size() - 1; ++i)
-        data[i] = glm::mix(data[i], data[i + 1], x);
-      data.resize(data.size() - 1);
+    const float t = subdivision ? float(index) / subdivision : 0.f;
+    std::copy(points.begin(), points.end(), data.begin());
+    for (size_t size = data.size(); size >= 2; --size) {
+      for (size_t i = 0; i < size - 1; ++i)
+        data[i] = glm::mix(data[i], data[i + 1], t);
     }
     path.push_back(data[0]);
   }
@@ -275,27 +431,26 @@ smk::Transformable Shape::Path(const std::vector<glm::vec2>& points,
   }
 
   std::vector<smk::Vertex> v;
+  for (size_t i = 0; i < points_left.size(); ++i) {
+    v.push_back({points_left[i], {0.0, 0.0}});
+    v.push_back({points_right[i], {0.0, 0.0}});
+  }
 
   // Fill using rectangles.
   // ...-A--C-...  A = points_left[i]
   //     |\ | ...  B = points_right[i]
   //     | \| ...  C = points_left[i + 1]
   // ...-B--D-...  D = points_right[i + 1];
-  for (size_t i = 1; i < points_left.size(); ++i) {
-    glm::vec2& A = points_left[i - 1];
-    glm::vec2& B = points_right[i - 1];
-    glm::vec2& C = points_left[i];
-    glm::vec2& D = points_right[i];
-
-    v.push_back({A, {0.0, 0.0}});
-    v.push_back({B, {0.0, 0.0}});
-    v.push_back({D, {0.0, 0.0}});
-    v.push_back({A, {0.0, 0.0}});
-    v.push_back({D, {0.0, 0.0}});
-    v.push_back({C, {0.0, 0.0}});
+  std::vector<uint32_t> indices;
+  for (uint32_t i = 1; i < points_left.size(); ++i) {
+    const uint32_t A = 2 * (i - 1);
+    const uint32_t B = 2 * (i - 1) + 1;
+    const uint32_t C = 2 * i;
+    const uint32_t D = 2 * i + 1;
+    indices.insert(indices.end(), {A, B, D, A, D, C});
   }
 
-  return smk::Shape::FromVertexArray(smk::VertexArray(std::move(v)));
+  return smk::Shape::FromVertexArray(IndexedVertexArray(v, indices));
 }
 
 /// @brief Return a rounded centered rectangle.
@@ -305,6 +460,16 @@ smk::Transformable Shape::Path(const std::vector<glm::vec2>& points,
 smk::Transformable Shape::RoundedRectangle(float width,
                                            float height,
                                            float radius) {
+  return FromVertexArray(
+      Cached({CachedShape::RoundedRectangle, width, height, radius}, [&] {
+        return RoundedRectangleVertexArray(width, height, radius);
+      }));
+}
+
+// static
+VertexArray Shape::RoundedRectangleVertexArray(float width,
+                                               float height,
+                                               float radius) {
   radius = std::max(radius, 0.f);
   radius = std::min(radius, width * 0.5f);
   radius = std::min(radius, height * 0.5f);
@@ -347,7 +512,7 @@ smk::Transformable Shape::RoundedRectangle(float width,
   v.push_back(p1);
   v.push_back(p2);
 
-  return smk::Shape::FromVertexArray(smk::VertexArray(std::move(v)));
+  return IndexedVertexArray(v);
 }
 
 }  // namespace smk
@@ -0,0 +1,78 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include "SkylinePacker.hpp"
+
+#include <algorithm>
+
+namespace smk {
+
+SkylinePacker::SkylinePacker(int width, int height)
+    : width_(width), height_(height) {
+  skyline_.push_back({0, 0, width});
+}
+
+bool SkylinePacker::Insert(int width, int height, glm::ivec2* position) {
+  if (width <= 0 || height <= 0 || width > width_ || height > height_)
+    return false;
+
+  // Find the lowest position, then the leftmost one.
+  int best_index = -1;
+  int best_x = 0;
+  int best_y = height_;
+  for (size_t i = 0; i < skyline_.size(); ++i) {
+    const int x = skyline_[i].x;
+    if (x + width > width_)
+      break;
+
+    // The rectangle rests on the highest segment below it.
+    int y = 0;
+    int remaining = width;
+    for (size_t j = i; remaining > 0; ++j) {
+      y = std::max(y, skyline_[j].y);
+      remaining -= skyline_[j].width;
+    }
+
+    if (y + height > height_ || y >= best_y)
+      continue;
+
+    best_index = i;
+    best_x = x;
+    best_y = y;
+  }
+
+  if (best_index < 0)
+    return false;
+
+  // Raise the skyline over the new rectangle.
+  skyline_.insert(skyline_.begin() + best_index,
+                  {best_x, best_y + height, width});
+  const int end = best_x + width;
+  for (size_t i = best_index + 1; i < skyline_.size();) {
+    Segment& segment = skyline_[i];
+    if (segment.x >= end)
+      break;
+    const int shrink = end - segment.x;
+    segment.x += shrink;
+    segment.width -= shrink;
+    if (segment.width > 0)
+      break;
+    skyline_.erase(skyline_.begin() + i);
+  }
+
+  // Merge the neighbor segments at the same height.
+  for (size_t i = 0; i + 1 < skyline_.size();) {
+    if (skyline_[i].y == skyline_[i + 1].y) {
+      skyline_[i].width += skyline_[i + 1].width;
+      skyline_.erase(skyline_.begin() + i + 1);
+    } else {
+      ++i;
+    }
+  }
+
+  *position = {best_x, best_y};
+  return true;
+}
+
+}  // namespace smk
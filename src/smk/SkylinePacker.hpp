@@ -0,0 +1,39 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_SKYLINE_PACKER_HPP
+#define SMK_SKYLINE_PACKER_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace smk {
+
+// Pack rectangles into a fixed size area, using the "skyline bottom-left"
+// heuristic. Used to build texture atlases.
+class SkylinePacker {
+ public:
+  SkylinePacker() = default;
+  SkylinePacker(int width, int height);
+
+  // Find some room for a |width| x |height| rectangle. Returns false when the
+  // area is full.
+  bool Insert(int width, int height, glm::ivec2* position);
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+ private:
+  struct Segment {
+    int x;
+    int y;
+    int width;
+  };
+  std::vector<Segment> skyline_;
+  int width_ = 0;
+  int height_ = 0;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_SKYLINE_PACKER_HPP */
@@ -9,11 +9,28 @@
 #include <smk/Audio.hpp>
 #include <smk/Sound.hpp>
 
+#include "SourcePool.hpp"
+
 namespace smk {
 
-void Sound::EnsureSourceIsCreated() {
-  if (source_)
+/// @brief Create an null Sound.
+Sound::Sound() {}
+
+/// @brief Create a sound reading data from a SoundBuffer
+/// @param buffer The SoundBuffer to read the data from.
+Sound::Sound(const SoundBuffer& buffer) : buffer_(&buffer) {}
+
+Sound::~Sound() {
+  Stop();
+}
+
+/// @brief Start playing the sound. A source is taken from the pool of
+/// smk::Audio. Nothing is played when every sources are used by sounds of
+/// higher priority.
+void Sound::Play() {
+  if (!buffer_ || !buffer_->buffer())
     return;
+  Stop();
 
   if (!Audio::Initialized()) {
     static bool once = true;
@@ -25,58 +42,45 @@ void Sound::EnsureSourceIsCreated() {
           << std::endl;
       once = false;
     }
+    return;
   }
 
-  alGenSources(1, &source_);
-}
-
-/// @brief Create an null Sound.
-Sound::Sound() {}
-
-/// @brief Create a sound reading data from a SoundBuffer
-/// @param buffer The SoundBuffer to read the data from.
-Sound::Sound(const SoundBuffer& buffer) : buffer_(&buffer) {}
-
-Sound::~Sound() {
-  Stop();
-  if (source_)
-    alDeleteSources(1, &source_);
-}
-
-/// @brief Start playing the sound.
-void Sound::Play() {
-  if (!buffer_ || !buffer_->buffer())
+  SourcePool& pool = SourcePool::Get();
+  voice_ = pool.Acquire(priority_);
+  const unsigned int source = pool.source(voice_);
+  if (!source)
     return;
-  if (is_playing_)
-    Stop();
-  EnsureSourceIsCreated();
-  alSourcei(source_, AL_BUFFER, buffer_->buffer());
-  alSourcePlay(source_);
-  is_playing_ = true;
+  alSourcei(source, AL_BUFFER, buffer_->buffer());
+  alSourcei(source, AL_LOOPING, looping_);
+  alSourcef(source, AL_GAIN, volume_);
+  alSourcefv(source, AL_POSITION, &position_.x);
+  alSourcefv(source, AL_VELOCITY, &velocity_.x);
+  alSourcePlay(source);
 }
 
-/// @brief Stop playing the sound.
+/// @brief Stop playing the sound. Its source returns to the pool.
 void Sound::Stop() {
-  if (!source_ || !buffer_ || !is_playing_)
+  if (!voice_)
     return;
-  alSourceStop(source_);
-  alSourcei(source_, AL_BUFFER, 0);
-  is_playing_ = false;
+  SourcePool::Get().Free(voice_);
+  voice_ = {};
 }
 
 /// @brief Specify whether the sound must restart when it has reached the end.
 /// @param looping whether the sound must restart when it has reached the end.
 void Sound::SetLoop(bool looping) {
-  EnsureSourceIsCreated();
-  alSourcei(source_, AL_LOOPING, looping);
+  looping_ = looping;
+  if (unsigned int source = SourcePool::Get().source(voice_))
+    alSourcei(source, AL_LOOPING, looping);
 }
 
 /// @return return whether the sound is currently playing something or not.
 bool Sound::IsPlaying() {
-  if (!source_)
+  const unsigned int source = SourcePool::Get().source(voice_);
+  if (!source)
     return false;
   ALint state;
-  alGetSourcei(source_, AL_SOURCE_STATE, &state);
+  alGetSourcei(source, AL_SOURCE_STATE, &state);
   return (state == AL_PLAYING);
 }
 
@@ -86,15 +90,40 @@ Sound::Sound(Sound&& o) noexcept {
 
 void Sound::operator=(Sound&& o) noexcept {
   std::swap(buffer_, o.buffer_);
-  std::swap(source_, o.source_);
-  std::swap(is_playing_, o.is_playing_);
+  std::swap(voice_, o.voice_);
+  std::swap(looping_, o.looping_);
+  std::swap(volume_, o.volume_);
+  std::swap(priority_, o.priority_);
+  std::swap(position_, o.position_);
+  std::swap(velocity_, o.velocity_);
 }
 
+/// @brief Set the gain applied to the source.
 void Sound::SetVolume(float volume) {
-  if (!source_)
-    return;
-  EnsureSourceIsCreated();
-  alSourcef(source_, AL_GAIN, volume);
+  volume_ = volume;
+  if (unsigned int source = SourcePool::Get().source(voice_))
+    alSourcef(source, AL_GAIN, volume);
+}
+
+/// @brief Set the priority used to share the sources of the pool.
+/// @param priority The sounds of higher priority steal the sources of the
+///                 lower ones.
+void Sound::SetPriority(int priority) {
+  priority_ = priority;
+}
+
+/// @brief Set the position of the source. It is applied by the next
+/// Audio::Update().
+void Sound::SetPosition(const glm::vec3& position) {
+  position_ = position;
+  SourcePool::Get().SetPosition(voice_, position);
+}
+
+/// @brief Set the velocity of the source, used for the Doppler effect. It is
+/// applied by the next Audio::Update().
+void Sound::SetVelocity(const glm::vec3& velocity) {
+  velocity_ = velocity;
+  SourcePool::Get().SetVelocity(voice_, velocity);
 }
 
 }  // namespace smk
@@ -7,17 +7,117 @@
 #include <libnyquist/Decoders.h>
 
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <smk/Audio.hpp>
 #include <smk/SoundBuffer.hpp>
 #include <vector>
 
+#include "DecodedSound.hpp"
+#include "SampleConversion.hpp"
+
 namespace smk {
 
+namespace {
+
+// Where the decoded samples are stored. Empty when disabled.
+std::string g_cache_directory;
+
+// The header of the cached files. The samples follow it.
+struct CacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t sample_rate;
+  uint16_t channels;
+  uint16_t bits;   // 16 for int16_t samples, 32 for float samples.
+  uint64_t count;  // The number of samples.
+};
+const char kCacheMagic[4] = {'S', 'M', 'K', 'A'};
+const uint32_t kCacheVersion = 1;
+
+// FNV-1a.
+uint64_t Hash(uint64_t hash, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// The name of the file caching |filename|. Empty when the cache is disabled.
+std::string CachePath(const std::string& filename) {
+  if (g_cache_directory.empty())
+    return "";
+  std::error_code error;
+  const uint64_t size = std::filesystem::file_size(filename, error);
+  if (error)
+    return "";
+  const auto modification = std::filesystem::last_write_time(filename, error);
+  if (error)
+    return "";
+  const int64_t time = int64_t(modification.time_since_epoch().count());
+
+  uint64_t hash = 14695981039346656037ull;
+  hash = Hash(hash, filename.data(), filename.size());
+  hash = Hash(hash, &size, sizeof(size));
+  hash = Hash(hash, &time, sizeof(time));
+  char name[17];
+  snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+  return g_cache_directory + "/" + name + ".pcm";
+}
+
+}  // namespace
+
 SoundBuffer::SoundBuffer() {}
 
+// static
+/// @brief Enable the cache of decoded samples. The files decoded later are
+/// stored in |directory| and mapped back on the next launches, skipping their
+/// decoding. This suits the short sound effects loaded at startup.
+/// @param directory An existing directory. Empty disables the cache.
+void SoundBuffer::SetCacheDirectory(const std::string& directory) {
+  g_cache_directory = directory;
+}
+
 /// @brief Load a sound resource into memory from a file.
 SoundBuffer::SoundBuffer(const std::string& filename) : SoundBuffer() {
+  DecodedSound sound;
+  if (sound.Decode(filename))
+    *this = sound.Upload();
+}
+
+// static
+/// @brief Load a sound resource from a file held in memory, for instance an
+/// entry of an smk::AssetArchive.
+/// @param data The content of the file.
+/// @param size The size of |data|, in bytes.
+/// @param extension The extension of the file, telling its format. For
+///                  instance "wav" or "ogg".
+SoundBuffer SoundBuffer::FromMemory(const uint8_t* data,
+                                    size_t size,
+                                    const std::string& extension) {
+  DecodedSound sound;
+  if (sound.Decode(data, size, extension))
+    return sound.Upload();
+  return SoundBuffer();
+}
+
+/// @brief Create a sound resource from 16 bits samples.
+/// @param samples The samples. They are interleaved when there are several
+///                channels.
+/// @param count The number of samples.
+/// @param channels The number of channels. Either 1 (mono) or 2 (stereo).
+/// @param sample_rate The number of samples per second, per channel.
+SoundBuffer::SoundBuffer(const int16_t* samples,
+                         size_t count,
+                         int channels,
+                         int sample_rate)
+    : SoundBuffer() {
   if (!Audio::Initialized()) {
     static bool once = true;
     if (once) {
@@ -30,31 +130,55 @@ SoundBuffer::SoundBuffer(const std::string& filename) : SoundBuffer() {
     }
   }
 
-  nqr::AudioData fileData;
-  nqr::NyquistIO loader;
-  loader.Load(&fileData, filename);
+  // clang-format off
+  ALenum format;
+  switch (channels) {
+    case 1: format = AL_FORMAT_MONO16; break;
+    case 2: format = AL_FORMAT_STEREO16; break;
+    default: std::cerr << "SoundBuffer: Unsupported channel count " << channels << std::endl;
+      return;
+  }
+  // clang-format on.
 
-  ALsizei sample_rate = static_cast<ALsizei>(fileData.sampleRate);
+  alGenBuffers(1, &buffer_);
+  alBufferData(buffer_, format, samples, count * sizeof(ALshort), sample_rate);
 
-  std::vector<ALshort> data;
-  for (auto& it : fileData.samples) {
-    it = std::min(it, +1.f);
-    it = std::max(it, -1.f);
-    data.push_back(it * ((1 << 15) - 1));
+  if (alGetError() != AL_NO_ERROR) {
+    std::cerr << "SoundBuffer: OpenAL error" << std::endl;
+    return;
+  }
+}
+
+/// @brief Create a sound resource from 32 bits float samples.
+/// @param samples The samples, in [-1, 1]. They are interleaved when there are
+///                several channels.
+/// @param count The number of samples.
+/// @param channels The number of channels. Either 1 (mono) or 2 (stereo).
+/// @param sample_rate The number of samples per second, per channel.
+SoundBuffer::SoundBuffer(const float* samples,
+                         size_t count,
+                         int channels,
+                         int sample_rate)
+    : SoundBuffer() {
+  if (!Float32SamplesSupported()) {
+    std::vector<int16_t> converted(count);
+    FloatToInt16(samples, converted.data(), count);
+    *this = SoundBuffer(converted.data(), count, channels, sample_rate);
+    return;
   }
 
   // clang-format off
   ALenum format;
-  switch (fileData.channelCount) {
-    case 1: format = AL_FORMAT_MONO16; break;
-    case 2: format = AL_FORMAT_STEREO16; break;
-    default: std::cerr << "SoundBuffer: Unsupported format file " + filename << std::endl;
+  switch (channels) {
+    case 1: format = alGetEnumValue("AL_FORMAT_MONO_FLOAT32"); break;
+    case 2: format = alGetEnumValue("AL_FORMAT_STEREO_FLOAT32"); break;
+    default: std::cerr << "SoundBuffer: Unsupported channel count " << channels << std::endl;
       return;
   }
   // clang-format on.
 
   alGenBuffers(1, &buffer_);
-  alBufferData(buffer_, format, data.data(), data.size() * sizeof(ALshort), sample_rate);
+  alBufferData(buffer_, format, samples, count * sizeof(float), sample_rate);
 
   if (alGetError() != AL_NO_ERROR) {
     std::cerr << "SoundBuffer: OpenAL error" << std::endl;
@@ -62,6 +186,141 @@ SoundBuffer::SoundBuffer(const std::string& filename) : SoundBuffer() {
   }
 }
 
+bool DecodedSound::Decode(const std::string& filename) {
+  const std::string cache_path = CachePath(filename);
+  if (!cache_path.empty() && LoadCache(cache_path))
+    return true;
+
+  // libnyquist throws on missing and corrupted files.
+  nqr::AudioData fileData;
+  try {
+    nqr::NyquistIO loader;
+    loader.Load(&fileData, filename);
+  } catch (const std::exception& error) {
+    std::cerr << "SMK > SoundBuffer: Can't decode " << filename << ": "
+              << error.what() << std::endl;
+    return false;
+  }
+  if (!Assign(&fileData, filename))
+    return false;
+
+  if (!cache_path.empty())
+    StoreCache(cache_path);
+  return true;
+}
+
+bool DecodedSound::Decode(const uint8_t* data,
+                          size_t size,
+                          const std::string& extension) {
+  nqr::AudioData fileData;
+  try {
+    nqr::NyquistIO loader;
+    loader.Load(&fileData, extension, std::vector<uint8_t>(data, data + size));
+  } catch (const std::exception& error) {
+    std::cerr << "SMK > SoundBuffer: Can't decode a file in memory: "
+              << error.what() << std::endl;
+    return false;
+  }
+  return Assign(&fileData, "in memory");
+}
+
+// Take the samples decoded by libnyquist.
+bool DecodedSound::Assign(nqr::AudioData* fileData, const std::string& name) {
+  if (fileData->channelCount != 1 && fileData->channelCount != 2) {
+    std::cerr << "SoundBuffer: Unsupported format file " + name << std::endl;
+    return false;
+  }
+
+  channels_ = fileData->channelCount;
+  sample_rate_ = fileData->sampleRate;
+  if (Float32SamplesSupported()) {
+    float_samples_ = std::move(fileData->samples);
+  } else {
+    samples_.resize(fileData->samples.size());
+    FloatToInt16(fileData->samples.data(), samples_.data(), samples_.size());
+  }
+  return true;
+}
+
+// Map a file written by StoreCache(). Return false when it is missing or
+// invalid.
+bool DecodedSound::LoadCache(const std::string& path) {
+  if (!cache_.Open(path))
+    return false;
+
+  CacheHeader header;
+  if (cache_.size() < sizeof(header)) {
+    cache_.Close();
+    return false;
+  }
+  std::memcpy(&header, cache_.data(), sizeof(header));
+  const size_t sample_size = header.bits / 8;
+  if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) ||
+      header.version != kCacheVersion ||
+      (header.channels != 1 && header.channels != 2) ||
+      (header.bits != 16 && header.bits != 32) ||
+      cache_.size() != sizeof(header) + header.count * sample_size) {
+    cache_.Close();
+    return false;
+  }
+
+  channels_ = header.channels;
+  sample_rate_ = int(header.sample_rate);
+  cached_samples_ = cache_.data() + sizeof(header);
+  cached_count_ = size_t(header.count);
+  cached_bits_ = header.bits;
+  return true;
+}
+
+// Write the decoded samples into the cache. A temporary file is renamed, so
+// that concurrent loads never map a partial file.
+void DecodedSound::StoreCache(const std::string& path) const {
+  const bool floats = !float_samples_.empty();
+  CacheHeader header;
+  std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version = kCacheVersion;
+  header.sample_rate = uint32_t(sample_rate_);
+  header.channels = uint16_t(channels_);
+  header.bits = floats ? 32 : 16;
+  header.count = floats ? float_samples_.size() : samples_.size();
+
+  const std::string temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (floats) {
+      file.write(reinterpret_cast<const char*>(float_samples_.data()),
+                 float_samples_.size() * sizeof(float));
+    } else {
+      file.write(reinterpret_cast<const char*>(samples_.data()),
+                 samples_.size() * sizeof(int16_t));
+    }
+    if (!file)
+      return;
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  if (error)
+    std::filesystem::remove(temporary, error);
+}
+
+SoundBuffer DecodedSound::Upload() const {
+  if (cached_bits_ == 16) {
+    return SoundBuffer(reinterpret_cast<const int16_t*>(cached_samples_),
+                       cached_count_, channels_, sample_rate_);
+  }
+  if (cached_bits_ == 32) {
+    return SoundBuffer(reinterpret_cast<const float*>(cached_samples_),
+                       cached_count_, channels_, sample_rate_);
+  }
+  if (!float_samples_.empty()) {
+    return SoundBuffer(float_samples_.data(), float_samples_.size(), channels_,
+                       sample_rate_);
+  }
+  return SoundBuffer(samples_.data(), samples_.size(), channels_,
+                     sample_rate_);
+}
+
 SoundBuffer::~SoundBuffer() {
   if (buffer_)
     alDeleteBuffers(1, &buffer_);
@@ -0,0 +1,199 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <libnyquist/Decoders.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <vector>
+
+#include "SampleConversion.hpp"
+#include "SoundStream.hpp"
+
+namespace smk {
+
+namespace {
+
+const uint16_t kFormatPCM = 1;
+const uint16_t kFormatFloat = 3;
+const uint16_t kFormatExtensible = 0xFFFE;
+
+uint16_t ReadU16(const uint8_t* data) {
+  return uint16_t(data[0] | data[1] << 8);
+}
+
+uint32_t ReadU32(const uint8_t* data) {
+  return uint32_t(data[0]) | uint32_t(data[1]) << 8 |
+         uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24;
+}
+
+bool IsWav(const std::string& filename) {
+  const size_t dot = filename.rfind('.');
+  if (dot == std::string::npos)
+    return false;
+  std::string extension = filename.substr(dot + 1);
+  for (char& c : extension)
+    c = char(std::tolower(c));
+  return extension == "wav";
+}
+
+// A WAV file with 8 or 16 bits integer, or 32 bits float samples, read from the
+// disk chunk by chunk.
+class WavStream : public SoundStream {
+ public:
+  ~WavStream() override {
+    if (file_)
+      fclose(file_);
+  }
+
+  bool Open(const std::string& filename) {
+    file_ = fopen(filename.c_str(), "rb");
+    if (!file_)
+      return false;
+
+    uint8_t header[12];
+    if (fread(header, 1, 12, file_) != 12 || std::memcmp(header, "RIFF", 4) ||
+        std::memcmp(header + 8, "WAVE", 4)) {
+      return false;
+    }
+
+    bool has_format = false;
+    uint8_t chunk[8];
+    while (fread(chunk, 1, 8, file_) == 8) {
+      const uint32_t size = ReadU32(chunk + 4);
+      if (!std::memcmp(chunk, "fmt ", 4)) {
+        uint8_t format[40] = {};
+        const size_t read = std::min<size_t>(size, sizeof(format));
+        if (read < 16 || fread(format, 1, read, file_) != read)
+          return false;
+        format_ = ReadU16(format);
+        channels_ = ReadU16(format + 2);
+        sample_rate_ = int(ReadU32(format + 4));
+        bits_ = ReadU16(format + 14);
+        if (format_ == kFormatExtensible && read >= 26)
+          format_ = ReadU16(format + 24);
+        has_format = true;
+        fseek(file_, long(size - read + (size & 1)), SEEK_CUR);
+        continue;
+      }
+
+      if (!std::memcmp(chunk, "data", 4)) {
+        data_begin_ = ftell(file_);
+        data_size_ = size;
+        break;
+      }
+      fseek(file_, long(size + (size & 1)), SEEK_CUR);
+    }
+
+    const bool supported =
+        (format_ == kFormatPCM && (bits_ == 8 || bits_ == 16)) ||
+        (format_ == kFormatFloat && bits_ == 32);
+    return has_format && supported && data_begin_ >= 0;
+  }
+
+  size_t Read(int16_t* samples, size_t count) override {
+    const size_t sample_size = bits_ / 8;
+    count = std::min<size_t>(count, (data_size_ - data_read_) / sample_size);
+
+    if (bits_ == 32) {
+      floats_.resize(count);
+      count = fread(floats_.data(), sample_size, count, file_);
+      data_read_ += count * sample_size;
+      FloatToInt16(floats_.data(), samples, count);
+      return count;
+    }
+
+    buffer_.resize(count * sample_size);
+    count = fread(buffer_.data(), sample_size, count, file_);
+    data_read_ += count * sample_size;
+    const uint8_t* data = buffer_.data();
+    for (size_t i = 0; i < count; ++i) {
+      if (bits_ == 8)
+        samples[i] = int16_t((int(data[i]) - 128) << 8);
+      else
+        samples[i] = int16_t(ReadU16(data + 2 * i));
+    }
+    return count;
+  }
+
+  void Rewind() override {
+    fseek(file_, data_begin_, SEEK_SET);
+    data_read_ = 0;
+  }
+
+ private:
+  FILE* file_ = nullptr;
+  uint16_t format_ = 0;
+  uint16_t bits_ = 0;
+  long data_begin_ = -1;
+  uint32_t data_size_ = 0;
+  uint32_t data_read_ = 0;
+  std::vector<uint8_t> buffer_;
+  std::vector<float> floats_;
+};
+
+// A file decoded entirely by libnyquist. The samples are converted to 16 bits
+// only as they are read.
+class DecodedStream : public SoundStream {
+ public:
+  bool Open(const std::string& filename) {
+    // libnyquist throws on missing and corrupted files. This runs on the
+    // thread of the Music decoder, where nothing else would catch it.
+    try {
+      nqr::NyquistIO loader;
+      loader.Load(&data_, filename);
+    } catch (const std::exception& error) {
+      std::cerr << "SMK > SoundStream: Can't decode " << filename << ": "
+                << error.what() << std::endl;
+      return false;
+    }
+    channels_ = data_.channelCount;
+    sample_rate_ = data_.sampleRate;
+    return true;
+  }
+
+  size_t Read(int16_t* samples, size_t count) override {
+    count = std::min(count, data_.samples.size() - position_);
+    FloatToInt16(data_.samples.data() + position_, samples, count);
+    position_ += count;
+    return count;
+  }
+
+  void Rewind() override { position_ = 0; }
+
+ private:
+  nqr::AudioData data_;
+  size_t position_ = 0;
+};
+
+}  // namespace
+
+// static
+std::unique_ptr<SoundStream> SoundStream::Open(const std::string& filename) {
+  std::unique_ptr<SoundStream> stream;
+  if (IsWav(filename)) {
+    auto wav = std::make_unique<WavStream>();
+    if (wav->Open(filename))
+      stream = std::move(wav);
+  }
+
+  if (!stream) {
+    auto decoded = std::make_unique<DecodedStream>();
+    if (decoded->Open(filename))
+      stream = std::move(decoded);
+  }
+
+  if (!stream || (stream->channels() != 1 && stream->channels() != 2)) {
+    std::cerr << "SMK > SoundStream: Unsupported format file " + filename
+              << std::endl;
+    return nullptr;
+  }
+  return stream;
+}
+
+}  // namespace smk
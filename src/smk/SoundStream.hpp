@@ -0,0 +1,42 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_SOUND_STREAM_HPP
+#define SMK_SOUND_STREAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace smk {
+
+// A sound file read progressively, as 16 bits samples. It isn't thread-safe,
+// but can be used from any thread.
+class SoundStream {
+ public:
+  // WAV files are read from the disk as needed. The other formats are decoded
+  // entirely first, because libnyquist has no incremental decoder. Return
+  // nullptr and display an error on failure.
+  static std::unique_ptr<SoundStream> Open(const std::string& filename);
+
+  virtual ~SoundStream() = default;
+
+  // Read up to |count| interleaved samples. Return the number read, 0 at the
+  // end of the stream.
+  virtual size_t Read(int16_t* samples, size_t count) = 0;
+
+  // Restart from the beginning.
+  virtual void Rewind() = 0;
+
+  int channels() const { return channels_; }
+  int sample_rate() const { return sample_rate_; }
+
+ protected:
+  int channels_ = 0;
+  int sample_rate_ = 0;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_SOUND_STREAM_HPP */
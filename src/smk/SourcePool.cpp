@@ -0,0 +1,147 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <AL/al.h>
+
+#include "SourcePool.hpp"
+
+namespace smk {
+
+// static
+SourcePool& SourcePool::Get() {
+  static SourcePool pool;
+  return pool;
+}
+
+// Create up to |size| sources. The OpenAL implementation can provide less.
+void SourcePool::Init(size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (slots_.size() < size) {
+    Slot slot;
+    alGetError();
+    alGenSources(1, &slot.source);
+    if (alGetError() != AL_NO_ERROR)
+      break;
+    slots_.push_back(slot);
+  }
+}
+
+void SourcePool::Release() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Slot& slot : slots_) {
+    alSourceStop(slot.source);
+    alDeleteSources(1, &slot.source);
+  }
+  slots_.clear();
+  dirty_.clear();
+}
+
+SourcePool::Voice SourcePool::Acquire(int priority) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Slot* chosen = nullptr;
+  for (Slot& slot : slots_) {
+    ALint state = AL_STOPPED;
+    alGetSourcei(slot.source, AL_SOURCE_STATE, &state);
+    if (state != AL_PLAYING && state != AL_PAUSED) {
+      chosen = &slot;
+      break;
+    }
+
+    // Voice stealing: the lowest priority, then the oldest.
+    if (slot.priority > priority)
+      continue;
+    if (!chosen || slot.priority < chosen->priority ||
+        (slot.priority == chosen->priority && slot.start < chosen->start)) {
+      chosen = &slot;
+    }
+  }
+
+  Voice voice;
+  if (!chosen)
+    return voice;
+
+  Reset(*chosen);
+  chosen->priority = priority;
+  chosen->start = next_start_++;
+  voice.index = uint32_t(chosen - slots_.data()) + 1;
+  voice.generation = chosen->generation;
+  return voice;
+}
+
+void SourcePool::Free(Voice voice) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Slot* slot = Find(voice);
+  if (slot)
+    Reset(*slot);
+}
+
+unsigned int SourcePool::source(Voice voice) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Slot* slot = Find(voice);
+  return slot ? slot->source : 0;
+}
+
+void SourcePool::SetPosition(Voice voice, const glm::vec3& position) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Slot* slot = Find(voice);
+  if (!slot)
+    return;
+  slot->position = position;
+  if (!slot->dirty) {
+    slot->dirty = true;
+    dirty_.push_back(voice.index - 1);
+  }
+}
+
+void SourcePool::SetVelocity(Voice voice, const glm::vec3& velocity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Slot* slot = Find(voice);
+  if (!slot)
+    return;
+  slot->velocity = velocity;
+  if (!slot->dirty) {
+    slot->dirty = true;
+    dirty_.push_back(voice.index - 1);
+  }
+}
+
+// The caller is expected to defer the OpenAL updates around this call.
+void SourcePool::Apply() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (uint32_t index : dirty_) {
+    Slot& slot = slots_[index];
+    if (!slot.dirty)
+      continue;
+    slot.dirty = false;
+    alSourcefv(slot.source, AL_POSITION, &slot.position.x);
+    alSourcefv(slot.source, AL_VELOCITY, &slot.velocity.x);
+  }
+  dirty_.clear();
+}
+
+SourcePool::Slot* SourcePool::Find(Voice voice) {
+  if (voice.index == 0 || voice.index > slots_.size())
+    return nullptr;
+  Slot& slot = slots_[voice.index - 1];
+  return slot.generation == voice.generation ? &slot : nullptr;
+}
+
+// Stop the source, restore its default parameters and invalidate its voices.
+// static
+void SourcePool::Reset(Slot& slot) {
+  alSourceStop(slot.source);
+  alSourcei(slot.source, AL_BUFFER, 0);
+  alSourcei(slot.source, AL_LOOPING, AL_FALSE);
+  alSourcef(slot.source, AL_GAIN, 1.f);
+  alSourcef(slot.source, AL_PITCH, 1.f);
+  alSource3f(slot.source, AL_POSITION, 0.f, 0.f, 0.f);
+  alSource3f(slot.source, AL_VELOCITY, 0.f, 0.f, 0.f);
+  ++slot.generation;
+  slot.priority = 0;
+  slot.position = {0.f, 0.f, 0.f};
+  slot.velocity = {0.f, 0.f, 0.f};
+  slot.dirty = false;
+}
+
+}  // namespace smk
@@ -0,0 +1,71 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_SOURCE_POOL_HPP
+#define SMK_SOURCE_POOL_HPP
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <mutex>
+#include <smk/Handle.hpp>
+#include <vector>
+
+namespace smk {
+
+// A fixed set of OpenAL sources, created with the Audio context and lent to
+// the sounds being played. Playing a sound never creates OpenAL objects.
+//
+// A source is free once it isn't playing anymore. When every sources are busy,
+// the oldest source of the lowest priority, not above the requested one, is
+// stolen. The Voice handles of the previous user are then invalid.
+//
+// The spatial parameters are collected, and sent to OpenAL all at once by
+// Apply(), so that moving many sources costs a single batch per frame.
+class SourcePool {
+ public:
+  using Voice = Handle<SourcePool>;
+
+  static SourcePool& Get();
+
+  void Init(size_t size);
+  void Release();
+  size_t size() const { return slots_.size(); }
+
+  // Return a stopped source with the default parameters, or a null Voice when
+  // every sources are busy with a higher priority.
+  Voice Acquire(int priority);
+  // Stop the source. |voice| becomes invalid.
+  void Free(Voice voice);
+
+  // The OpenAL source, or 0 when |voice| has been stolen or freed.
+  unsigned int source(Voice voice);
+
+  // Record the spatial parameters of a source. They are sent by Apply().
+  void SetPosition(Voice voice, const glm::vec3& position);
+  void SetVelocity(Voice voice, const glm::vec3& velocity);
+  // Send the spatial parameters modified since the last call.
+  void Apply();
+
+ private:
+  struct Slot {
+    unsigned int source = 0;
+    uint32_t generation = 1;
+    int priority = 0;
+    uint64_t start = 0;
+    glm::vec3 position = {0.f, 0.f, 0.f};
+    glm::vec3 velocity = {0.f, 0.f, 0.f};
+    bool dirty = false;
+  };
+
+  Slot* Find(Voice voice);
+  static void Reset(Slot& slot);
+
+  std::mutex mutex_;
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> dirty_;  // The slots to be sent by Apply().
+  uint64_t next_start_ = 0;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_SOURCE_POOL_HPP */
@@ -2,9 +2,12 @@
 // Use of this source code is governed by the MIT license that can be found in
 // the LICENSE file.
 
+#include <glm/gtc/matrix_transform.hpp>
 #include <smk/Framebuffer.hpp>
 #include <smk/OpenGL.hpp>
+#include <smk/RenderTarget.hpp>
 #include <smk/Shader.hpp>
+#include <smk/Shape.hpp>
 #include <smk/Sprite.hpp>
 #include <smk/VertexArray.hpp>
 #include <vector>
@@ -29,20 +32,11 @@ Sprite::Sprite(const Texture& texture, const Rectangle rectangle) {
 /// @param framebuffer The framebuffer to be used.
 Sprite::Sprite(Framebuffer& framebuffer) {
   Transformable::SetTexture(framebuffer.color_texture());
-  float l = 0.f;
-  float r = 1.f;
-  float t = 0.f;
-  float b = 1.f;
-  float www = framebuffer.color_texture().width();
-  float hhh = framebuffer.color_texture().height();
-  SetVertexArray(VertexArray(std::vector<Vertex>({
-      {{0.f, 0.f}, {l, b}},
-      {{0.f, hhh}, {l, t}},
-      {{www, hhh}, {r, t}},
-      {{0.f, 0.f}, {l, b}},
-      {{www, hhh}, {r, t}},
-      {{www, 0.f}, {r, b}},
-  })));
+  // The framebuffer is stored upside down. The texture area is flipped
+  // vertically: its top is the bottom row.
+  SetQuad({framebuffer.color_texture().width(),
+           framebuffer.color_texture().height()},
+          {0.f, 1.f, 1.f, 0.f});
 }
 
 /// @brief Update the sprite's texture.
@@ -61,16 +55,57 @@ void Sprite::SetTextureRectangle(const Rectangle& rectangle) {
   float r = (rectangle.right - 0.5) / texture().width();
   float t = (rectangle.top + 0.5) / texture().height();
   float b = (rectangle.bottom - 0.5) / texture().height();
-  float www = rectangle.width();
-  float hhh = rectangle.height();
-  SetVertexArray(VertexArray(std::vector<Vertex>({
-      {{0.f, 0.f}, {l, t}},
-      {{0.f, hhh}, {l, b}},
-      {{www, hhh}, {r, b}},
-      {{0.f, 0.f}, {l, t}},
-      {{www, hhh}, {r, b}},
-      {{www, 0.f}, {r, t}},
-  })));
+  SetQuad({rectangle.width(), rectangle.height()}, {l, t, r, b});
+}
+
+void Sprite::SetQuad(const glm::vec2& size,
+                     const Rectangle& texture_coordinates) {
+  size_ = size;
+  texture_coordinates_ = texture_coordinates;
+  quad_ = VertexArray();
+  if (!vertex_array().size())
+    SetVertexArray(Shape::Square().vertex_array());
+}
+
+/// @brief Draw the sprite. The shared unit square is scaled to the sprite's
+/// size and mapped onto its texture area. When the ShaderProgram has no
+/// "texture_rectangle" uniform, a unit square holding the texture coordinates
+/// of this sprite is built and drawn instead.
+void Sprite::Draw(RenderTarget& target, RenderState state) const {
+  RenderStateRef ref(state);
+  ref.color *= color();
+  ref.texture = &texture();
+  ref.view *= transformation();
+  ref.view *= glm::scale(glm::mat4(1.f), glm::vec3(size_, 1.f));
+  if (!target.IsVisible(vertex_array().bounds(), ref.view))
+    return;
+  if (state.shader_program.texture_rectangle_uniform() >= 0) {
+    ref.texture_rectangle = {
+        texture_coordinates_.left,
+        texture_coordinates_.top,
+        texture_coordinates_.right,
+        texture_coordinates_.bottom,
+    };
+    ref.vertex_array = &vertex_array();
+  } else {
+    if (!quad_.size()) {
+      const float l = texture_coordinates_.left;
+      const float r = texture_coordinates_.right;
+      const float t = texture_coordinates_.top;
+      const float b = texture_coordinates_.bottom;
+      quad_ = VertexArray(std::vector<Vertex>({
+          {{0.f, 0.f}, {l, t}},
+          {{0.f, 1.f}, {l, b}},
+          {{1.f, 1.f}, {r, b}},
+          {{0.f, 0.f}, {l, t}},
+          {{1.f, 1.f}, {r, b}},
+          {{1.f, 0.f}, {r, t}},
+      }));
+    }
+    ref.vertex_array = &quad_;
+  }
+  ref.blend_mode = blend_mode();
+  target.Draw(ref);
 }
 
 }  // namespace smk
@@ -0,0 +1,178 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <iterator>
+#include <smk/RenderTarget.hpp>
+#include <smk/Sprite.hpp>
+#include <smk/SpriteBatch.hpp>
+
+namespace smk {
+
+SpriteBatch::SpriteBatch(const SpriteBatch& other) {
+  operator=(other);
+}
+
+SpriteBatch& SpriteBatch::operator=(const SpriteBatch& other) {
+  batches_ = other.batches_;
+  size_ = other.size_;
+  merged_batches_ = other.merged_batches_;
+  groups_.clear();
+  vertex_arrays_.clear();
+  dirty_ = true;
+  return *this;
+}
+
+/// @brief Remove every sprites from the batch.
+void SpriteBatch::Clear() {
+  batches_.clear();
+  size_ = 0;
+  merged_batches_ = 0;
+  dirty_ = true;
+}
+
+/// @brief Append a sprite to the batch. Its current transformation, texture,
+/// color and blend mode are captured. Modifying the sprite afterward has no
+/// effect on the batch.
+/// @param sprite The sprite to be added.
+void SpriteBatch::Add(const Sprite& sprite) {
+  Add(sprite, 0);
+}
+
+/// @brief Append a sprite to the batch, drawing one layer of its texture array.
+/// @param sprite The sprite to be added.
+/// @param layer The layer of the sprite's texture. Ignored unless the texture
+///              is a texture array.
+void SpriteBatch::Add(const Sprite& sprite, int layer) {
+  if (batches_.empty() || batches_.back().texture != sprite.texture() ||
+      batches_.back().blend_mode != sprite.blend_mode() ||
+      batches_.back().color != sprite.color()) {
+    batches_.emplace_back();
+    Batch& batch = batches_.back();
+    batch.texture = sprite.texture();
+    batch.blend_mode = sprite.blend_mode();
+    batch.color = sprite.color();
+    if (batches_.size() == 1 ||
+        !Mergeable(batches_[batches_.size() - 2], batch)) {
+      ++merged_batches_;
+    }
+  }
+
+  const glm::mat4 transformation = sprite.transformation();
+  auto transform = [&](float x, float y) {
+    return glm::vec2(transformation * glm::vec4(x, y, 0.f, 1.f));
+  };
+
+  const float w = sprite.size().x;
+  const float h = sprite.size().y;
+  const Rectangle& uv = sprite.texture_coordinates();
+  const Vertex2D top_left = {transform(0.f, 0.f), {uv.left, uv.top}};
+  const Vertex2D bottom_left = {transform(0.f, h), {uv.left, uv.bottom}};
+  const Vertex2D bottom_right = {transform(w, h), {uv.right, uv.bottom}};
+  const Vertex2D top_right = {transform(w, 0.f), {uv.right, uv.top}};
+
+  const Vertex2D quad[] = {
+      top_left, bottom_left, bottom_right, top_left, bottom_right, top_right,
+  };
+  Batch& batch = batches_.back();
+  if (batch.texture.target() == GL_TEXTURE_2D_ARRAY) {
+    for (const Vertex2D& vertex : quad) {
+      batch.layered_vertices.push_back(
+          {vertex.space_position, vertex.texture_position, float(layer)});
+    }
+  } else {
+    batch.vertices.insert(batch.vertices.end(), std::begin(quad),
+                          std::end(quad));
+  }
+
+  size_++;
+  dirty_ = true;
+}
+
+// Whether two batches can be drawn at once, storing their color in the
+// vertices.
+// static
+bool SpriteBatch::Mergeable(const Batch& a, const Batch& b) {
+  auto normalized = [](const glm::vec4& color) {
+    for (int i = 0; i < 4; ++i) {
+      if (color[i] < 0.f || color[i] > 1.f)
+        return false;
+    }
+    return true;
+  };
+  return a.texture == b.texture && a.blend_mode == b.blend_mode &&
+         a.texture.target() != GL_TEXTURE_2D_ARRAY && normalized(a.color) &&
+         normalized(b.color);
+}
+
+// Update the GPU vertex arrays.
+// @param vertex_colors Whether the consecutive batches can be merged.
+void SpriteBatch::Upload(bool vertex_colors) const {
+  groups_.clear();
+  for (size_t i = 0; i < batches_.size(); ++i) {
+    if (vertex_colors && !groups_.empty() &&
+        Mergeable(batches_[groups_.back().first], batches_[i])) {
+      ++groups_.back().count;
+    } else {
+      groups_.push_back({i, 1});
+    }
+  }
+
+  vertex_arrays_.resize(std::max(vertex_arrays_.size(), groups_.size()));
+  std::vector<Vertex2DColored> colored_vertices;
+  for (size_t i = 0; i < groups_.size(); ++i) {
+    const Group& group = groups_[i];
+    const Batch& first = batches_[group.first];
+    if (first.texture.target() == GL_TEXTURE_2D_ARRAY) {
+      vertex_arrays_[i].Update(first.layered_vertices);
+      continue;
+    }
+    if (group.count == 1) {
+      vertex_arrays_[i].Update(first.vertices);
+      continue;
+    }
+
+    colored_vertices.clear();
+    for (size_t j = group.first; j < group.first + group.count; ++j) {
+      const Color8 color(batches_[j].color);
+      for (const Vertex2D& vertex : batches_[j].vertices) {
+        colored_vertices.push_back(
+            {vertex.space_position, vertex.texture_position, color});
+      }
+    }
+    vertex_arrays_[i].Update(colored_vertices);
+  }
+
+  dirty_ = false;
+  vertex_colors_ = vertex_colors;
+}
+
+/// @brief Draw every sprites of the batch. One draw call is issued per group
+/// of consecutive sprites sharing the same states.
+void SpriteBatch::Draw(RenderTarget& target, RenderState state) const {
+  RenderStateRef ref(state);
+  const bool default_program =
+      *ref.shader_program == target.shader_program_2d();
+  if (dirty_ || vertex_colors_ != default_program)
+    Upload(default_program);
+
+  for (size_t i = 0; i < groups_.size(); ++i) {
+    const Group& group = groups_[i];
+    const Batch& batch = batches_[group.first];
+    ref.shader_program = &state.shader_program;
+    ref.color = state.color * batch.color;
+    if (default_program && batch.texture.target() == GL_TEXTURE_2D_ARRAY)
+      ref.shader_program = &target.shader_program_2d_array();
+    if (group.count > 1) {
+      ref.shader_program = &target.shader_program_2d_colored();
+      ref.color = state.color;
+    }
+    ref.texture = &batch.texture;
+    ref.blend_mode = batch.blend_mode;
+    ref.vertex_array = &vertex_arrays_[i];
+    target.Draw(ref);
+  }
+}
+
+}  // namespace smk
@@ -0,0 +1,229 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <smk/RenderStats.hpp>
+#include <smk/StreamingTexture.hpp>
+
+#include "ResidencyTracker.hpp"
+#include "StbImage.hpp"
+
+namespace smk {
+extern thread_local bool g_invalidate_textures;
+extern thread_local RenderStats g_render_stats;
+
+namespace {
+
+// The levels up to this size are uploaded when the texture is created.
+const int kInitialSize = 64;
+
+std::vector<StreamingTexture*>& Registry() {
+  static std::vector<StreamingTexture*> registry;
+  return registry;
+}
+
+}  // namespace
+
+/// @brief The null StreamingTexture.
+StreamingTexture::StreamingTexture() {
+  Registry().push_back(this);
+}
+
+/// @brief Load a streaming texture from a file.
+/// @param filename The file name of the image to be loaded.
+StreamingTexture::StreamingTexture(const std::string& filename)
+    : StreamingTexture(filename, Texture::Option()) {}
+
+/// @brief Load a streaming texture from a file.
+/// @param filename The file name of the image to be loaded.
+/// @param option The filtering and wrapping options. The mipmaps are always
+///               used.
+StreamingTexture::StreamingTexture(const std::string& filename,
+                                   const Texture::Option& option)
+    : StreamingTexture() {
+  FILE* file = fopen(filename.c_str(), "rb");
+  if (!file) {
+    std::cerr << "File " << filename << " not found" << std::endl;
+    return;
+  }
+  int width = 0;
+  int height = 0;
+  int comp = 0;
+  uint8_t* data = stbi_load_from_file(file, &width, &height, &comp, 4);
+  fclose(file);
+  if (!data) {
+    std::cerr << "SMK > Can't decode the image " << filename << std::endl;
+    return;
+  }
+
+  levels_.push_back({width, height, std::vector<uint8_t>(
+                                        data, data + width * height * 4)});
+  stbi_image_free(data);
+
+  // Build the mipmap chain, using a 2x2 box filter.
+  while (levels_.back().width > 1 || levels_.back().height > 1) {
+    const Level& previous = levels_.back();
+    Level level;
+    level.width = std::max(1, previous.width / 2);
+    level.height = std::max(1, previous.height / 2);
+    level.rgba.resize(level.width * level.height * 4);
+    for (int y = 0; y < level.height; ++y) {
+      const int y0 = std::min(2 * y, previous.height - 1);
+      const int y1 = std::min(2 * y + 1, previous.height - 1);
+      for (int x = 0; x < level.width; ++x) {
+        const int x0 = std::min(2 * x, previous.width - 1);
+        const int x1 = std::min(2 * x + 1, previous.width - 1);
+        for (int c = 0; c < 4; ++c) {
+          int sum = previous.rgba[(y0 * previous.width + x0) * 4 + c] +
+                    previous.rgba[(y0 * previous.width + x1) * 4 + c] +
+                    previous.rgba[(y1 * previous.width + x0) * 4 + c] +
+                    previous.rgba[(y1 * previous.width + x1) * 4 + c];
+          level.rgba[(y * level.width + x) * 4 + c] = (sum + 2) / 4;
+        }
+      }
+    }
+    levels_.push_back(std::move(level));
+  }
+
+  GLuint id = 0;
+  glGenTextures(1, &id);
+  glBindTexture(GL_TEXTURE_2D, id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, option.min_filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, option.mag_filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, option.wrap_s);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, option.wrap_t);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level_count() - 1);
+  texture_ = Texture::Adopt(id, width, height);
+
+  resident_level_ = level_count();
+  while (resident_level_ > 0) {
+    const Level& level = levels_[resident_level_ - 1];
+    if (level.width > kInitialSize || level.height > kInitialSize)
+      break;
+    UploadLevel(resident_level_ - 1);
+  }
+}
+
+StreamingTexture::~StreamingTexture() {
+  auto& registry = Registry();
+  registry.erase(std::find(registry.begin(), registry.end(), this));
+}
+
+StreamingTexture::StreamingTexture(StreamingTexture&& other) noexcept
+    : StreamingTexture() {
+  operator=(std::move(other));
+}
+
+StreamingTexture& StreamingTexture::operator=(
+    StreamingTexture&& other) noexcept {
+  std::swap(texture_, other.texture_);
+  std::swap(levels_, other.levels_);
+  std::swap(resident_level_, other.resident_level_);
+  std::swap(needed_level_, other.needed_level_);
+  std::swap(display_size_, other.display_size_);
+  return *this;
+}
+
+/// @brief Set the size in pixels the texture is drawn at. The resolution
+/// uploaded is the smallest one providing at least one texel per pixel.
+/// @param size The size on screen in pixels.
+void StreamingTexture::SetDisplaySize(const glm::vec2& size) {
+  display_size_ = size;
+  if (levels_.empty())
+    return;
+  const float ratio =
+      std::min(levels_[0].width / std::max(size.x, 1.f),
+               levels_[0].height / std::max(size.y, 1.f));
+  const int level = ratio > 1.f ? int(std::floor(std::log2(ratio))) : 0;
+  needed_level_ = std::min(level, level_count() - 1);
+}
+
+// How much this texture would benefit from its next level: the number of
+// levels missing, weighted by its area on screen.
+float StreamingTexture::Priority() const {
+  if (resident_level_ <= needed_level_)
+    return 0.f;
+  const glm::vec2 size =
+      display_size_.x > 0.f
+          ? display_size_
+          : glm::vec2(levels_[0].width, levels_[0].height);
+  return (resident_level_ - needed_level_) * size.x * size.y;
+}
+
+/// @brief Upload the levels needed by the StreamingTextures and release the
+/// ones no longer needed.
+/// @param budget The number of bytes after which no more levels are uploaded.
+/// At least one level is uploaded when one is missing.
+// static
+void StreamingTexture::Update(size_t budget) {
+  auto& registry = Registry();
+
+  // Release every levels finer than needed, once at least two of them are
+  // resident. Tolerating a single extra level avoids releasing and uploading
+  // it again when the display size oscillates.
+  for (StreamingTexture* texture : registry) {
+    if (texture->resident_level_ + 1 < texture->needed_level_) {
+      while (texture->resident_level_ < texture->needed_level_)
+        texture->ReleaseLevel(texture->resident_level_);
+    }
+  }
+
+  size_t uploaded = 0;
+  while (uploaded < budget) {
+    StreamingTexture* best = nullptr;
+    float best_priority = 0.f;
+    for (StreamingTexture* texture : registry) {
+      float priority = texture->Priority();
+      if (priority > best_priority) {
+        best = texture;
+        best_priority = priority;
+      }
+    }
+    if (!best)
+      return;
+
+    best->UploadLevel(best->resident_level_ - 1);
+    uploaded += best->levels_[best->resident_level_].rgba.size();
+  }
+}
+
+// Upload |level|, which must be just finer than the resident ones.
+void StreamingTexture::UploadLevel(int level) {
+  const Level& data = levels_[level];
+  glBindTexture(GL_TEXTURE_2D, texture_.id());
+  glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, data.width, data.height, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, data.rgba.data());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+  glBindTexture(GL_TEXTURE_2D, GL_NONE);
+  g_invalidate_textures = true;
+  ++g_render_stats.texture_uploads;
+  resident_level_ = level;
+  TrackResidentLevels();
+}
+
+// Release the finest resident |level|. Its storage is replaced by an empty
+// image, outside of the levels sampled.
+void StreamingTexture::ReleaseLevel(int level) {
+  glBindTexture(GL_TEXTURE_2D, texture_.id());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+  glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  glBindTexture(GL_TEXTURE_2D, GL_NONE);
+  g_invalidate_textures = true;
+  resident_level_ = level + 1;
+  TrackResidentLevels();
+}
+
+// Account the GPU memory used by the resident levels.
+void StreamingTexture::TrackResidentLevels() const {
+  size_t bytes = 0;
+  for (int level = resident_level_; level < level_count(); ++level)
+    bytes += levels_[level].rgba.size();
+  TrackTexture(texture_.id(), bytes, level_count());
+}
+
+}  // namespace smk
@@ -7,6 +7,7 @@
 #include <iostream>
 #include <locale>
 #include <smk/Font.hpp>
+#include <smk/FrameArena.hpp>
 #include <smk/RenderTarget.hpp>
 #include <smk/Text.hpp>
 #include <smk/VertexArray.hpp>
@@ -45,38 +46,77 @@ Text::Text(Font& font, const std::wstring& text) : Text(font) {
 /// Update the text to be drawn.
 void Text::SetString(const std::wstring& wide_string) {
   string_ = wide_string;
+  layout_dirty_ = true;
+  Touch();
 }
 
 /// Update the text to be drawn.
 void Text::SetString(const std::string& string) {
   string_ = to_wstring(string);
+  layout_dirty_ = true;
+  Touch();
 }
 
 /// Update the Font to be used.
 void Text::SetFont(Font& font) {
   font_ = &font;
+  layout_dirty_ = true;
+  Touch();
 }
 
 /// Draw the Text to the screen.
 void Text::Draw(RenderTarget& target, RenderState state) const {
-  state.color *= color();
-  glm::mat4 transformation = state.view * this->transformation();
-  float advance_x = 0.f;
-  float advance_y = font_->baseline_position();
+  if (!font_)
+    return;
+
+  font_->Update();
+  UpdateLayout();
+  if (geometry_dirty_)
+    UpdateGeometry();
+
+  RenderStateRef ref(state);
+  ref.color *= color();
+  ref.view *= transformation();
+  // The glyphs have a single channel. Only the default program is replaced.
+  if (*ref.shader_program == target.shader_program_2d()) {
+    ref.shader_program =
+        font_->rendering() == Font::Rendering::DistanceField
+            ? &target.shader_program_2d_distance_field()
+            : &target.shader_program_2d_glyph();
+  }
+  for (const auto& batch : batches_) {
+    ref.texture = &batch.texture;
+    ref.vertex_array = &batch.vertex_array;
+    target.Draw(ref);
+  }
+}
+
+// Place every glyphs of the string. This is skipped when nothing changed since
+// the last call.
+void Text::UpdateLayout() const {
+  if (!layout_dirty_ && layout_line_height_ == font_->line_height() &&
+      layout_font_generation_ == font_->generation()) {
+    return;
+  }
+  layout_dirty_ = false;
+  layout_line_height_ = font_->line_height();
+  layout_font_generation_ = font_->generation();
+  geometry_dirty_ = true;
 
-  state.vertex_array = VertexArray(std::vector<Vertex>({
-      {{0.f, 0.f}, {0.f, 0.f}},
-      {{0.f, 1.f}, {0.f, 1.f}},
-      {{1.f, 1.f}, {1.f, 1.f}},
-      {{0.f, 0.f}, {0.f, 0.f}},
-      {{1.f, 1.f}, {1.f, 1.f}},
-      {{1.f, 0.f}, {1.f, 0.f}},
-  }));
+  placements_.clear();
+  lines_.clear();
+  dimensions_ = {0.f, font_->line_height()};
 
+  float advance_x = 0.f;
+  float advance_y = font_->baseline_position();
+  size_t line_begin = 0;
   for (const auto& it : string_) {
     if (it == U'\n') {
+      lines_.push_back({line_begin, placements_.size(), advance_x});
+      line_begin = placements_.size();
       advance_x = 0.f;
       advance_y += font_->line_height();
+      dimensions_.y += font_->line_height();
       continue;
     }
 
@@ -85,43 +125,69 @@ void Text::Draw(RenderTarget& target, RenderState state) const {
       continue;
 
     if (character->texture.id()) {
-      const float x = advance_x + character->bearing.x;
-      const float y = advance_y + character->bearing.y;
-      const float w = character->texture.width();
-      const float h = character->texture.height();
-      state.texture = character->texture;
-      state.view = transformation * glm::mat4(w, 0.f, 0.f, 0.f,    //
-                                              0.f, h, 0.f, 0.f,    //
-                                              0.f, 0.f, 1.f, 0.f,  //
-                                              x, y, 0.f, 1.f       //
-                                    );
-
-      target.Draw(state);
+      placements_.push_back({
+          character,
+          {advance_x + character->bearing.x, advance_y + character->bearing.y},
+      });
     }
     advance_x += character->advance;
+    dimensions_.x = std::max(dimensions_.x, advance_x);
   }
+  lines_.push_back({line_begin, placements_.size(), advance_x});
 }
 
-/// Compute the dimension of the text when drawn to the screen.
-/// @return a tuple (width,height).
-glm::vec2 Text::ComputeDimensions() const {
-  glm::vec2 dimension(0.f, 0.f);
-  float advance_x = 0.f;
-  dimension.y += font_->line_height();
-  for (const auto& it : string_) {
-    if (it == U'\n') {
-      advance_x = 0.f;
-      dimension.y += font_->line_height();
-      continue;
+// Build one vertex array per atlas page, containing every glyphs of the string
+// read from this page.
+void Text::UpdateGeometry() const {
+  geometry_dirty_ = false;
+
+  // The vertices are only needed until they are uploaded. They are built in
+  // the FrameArena.
+  std::vector<Texture> textures;
+  FrameVector<FrameVector<Vertex>> vertices;
+
+  for (const auto& placement : placements_) {
+    const Font::Glyph* character = placement.glyph;
+    size_t index = 0;
+    while (index < textures.size() && textures[index] != character->texture)
+      ++index;
+    if (index == textures.size()) {
+      textures.push_back(character->texture);
+      vertices.emplace_back();
     }
-    auto character = font_->FetchGlyph(it);
-    if (!character)
-      continue;
-    advance_x += character->advance;
 
-    dimension.x = std::max(dimension.x, advance_x);
+    const float x = placement.position.x;
+    const float y = placement.position.y;
+    const float w = character->size.x;
+    const float h = character->size.y;
+    const float l = character->texture_rectangle.left;
+    const float t = character->texture_rectangle.top;
+    const float r = character->texture_rectangle.right;
+    const float b = character->texture_rectangle.bottom;
+    auto& v = vertices[index];
+    v.push_back({{x, y}, {l, t}});
+    v.push_back({{x, y + h}, {l, b}});
+    v.push_back({{x + w, y + h}, {r, b}});
+    v.push_back({{x, y}, {l, t}});
+    v.push_back({{x + w, y + h}, {r, b}});
+    v.push_back({{x + w, y}, {r, t}});
   }
-  return dimension;
+
+  batches_.clear();
+  for (size_t i = 0; i < textures.size(); ++i) {
+    VertexArray vertex_array;
+    vertex_array.Update(vertices[i].data(), vertices[i].size());
+    batches_.push_back({std::move(textures[i]), std::move(vertex_array)});
+  }
+}
+
+/// Compute the dimension of the text when drawn to the screen.
+/// @return a tuple (width,height).
+glm::vec2 Text::ComputeDimensions() const {
+  if (!font_)
+    return {0.f, 0.f};
+  UpdateLayout();
+  return dimensions_;
 }
 
 }  // namespace smk
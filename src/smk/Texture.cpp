@@ -2,26 +2,76 @@
 // Use of this source code is governed by the MIT license that can be found in
 // the LICENSE file.
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <smk/Profiler.hpp>
+#include <smk/RenderStats.hpp>
 #include <smk/Texture.hpp>
 #include <vector>
 
-#include "StbImage.hpp"
+#include "DecodedImage.hpp"
+#include "ResidencyTracker.hpp"
+#include "TextureUpload.hpp"
+#include "UnpackAlignment.hpp"
 
 namespace smk {
-extern bool g_invalidate_textures;
+extern thread_local bool g_invalidate_textures;
+extern thread_local RenderStats g_render_stats;
 
-int next_power_of_2(int v) {
-  return v;
-  v--;
-  v |= v >> 1;
-  v |= v >> 2;
-  v |= v >> 4;
-  v |= v >> 8;
-  v |= v >> 16;
-  v++;
-  return v;
+namespace {
+
+#ifndef __EMSCRIPTEN__
+// The pixel buffers used by Texture::Update(). The updates cycle through them,
+// so that the CPU fills one while the GPU transfers the previous ones. Buffer
+// objects are shared between the contexts, but fences aren't: every context
+// uses its own ring.
+struct UploadBuffer {
+  GLuint buffer = 0;
+  size_t capacity = 0;
+  GLsync fence = nullptr;
+};
+const int kUploadBufferCount = 3;
+struct UploadRing {
+  UploadBuffer buffers[kUploadBufferCount];
+  int index = 0;
+};
+std::map<GLFWwindow*, UploadRing> g_upload_rings;
+std::mutex g_upload_rings_mutex;
+
+UploadBuffer& NextUploadBuffer() {
+  std::lock_guard<std::mutex> lock(g_upload_rings_mutex);
+  UploadRing& ring = g_upload_rings[glfwGetCurrentContext()];
+  UploadBuffer& upload = ring.buffers[ring.index];
+  ring.index = (ring.index + 1) % kUploadBufferCount;
+  return upload;
+}
+#endif
+
+// Texture::Update() binds the texture on this unit, leaving the one used for
+// drawing untouched. This avoids invalidating the texture bound by the
+// RenderTarget.
+const GLenum kUploadTextureUnit = GL_TEXTURE31;
+
+}  // namespace
+
+void ReleaseUploadBuffers(GLFWwindow* context) {
+#ifndef __EMSCRIPTEN__
+  std::lock_guard<std::mutex> lock(g_upload_rings_mutex);
+  auto it = g_upload_rings.find(context);
+  if (it == g_upload_rings.end())
+    return;
+  for (UploadBuffer& upload : it->second.buffers) {
+    if (upload.fence)
+      glDeleteSync(upload.fence);
+    if (upload.buffer)
+      glDeleteBuffers(1, &upload.buffer);
+  }
+  g_upload_rings.erase(it);
+#endif
 }
 
 /// @brief Load a texture from a file.
@@ -32,30 +82,13 @@ Texture::Texture(const std::string& filename) : Texture(filename, Option()) {}
 /// @param filename The file name of the image to be loaded.
 /// @param option Additionnal option (texture wrap, min filter, mag filter, ...)
 Texture::Texture(const std::string& filename, const Option& option) {
-  FILE* file = fopen(filename.c_str(), "rb");
-  if (!file) {
-    std::cerr << "File " << filename << " not found" << std::endl;
+  SMK_PROFILE_SCOPE("Texture::Load");
+  DecodedImage image;
+  if (!image.Decode(filename, option))
     return;
-  }
-
-  int comp = -1;
-  unsigned char* data = stbi_load_from_file(file, &width_, &height_, &comp, 0);
-  fclose(file);
-
-  // Canonicalize the image to RGBA(8,8,8,8) and maybe on power_of_2 texture.
-  int width_b = next_power_of_2(width_);
-  int height_b = next_power_of_2(height_);
-  std::vector<uint8_t> transformed(width_b * height_b * 4, 0);
-  for (int y = 0; y < height_; ++y) {
-    for (int x = 0; x < width_; ++x) {
-      for (int c = 0; c < 4; ++c) {
-        transformed[c + 4 * (x + width_b * y)] =
-            (c == 3 && comp != 4) ? 255 : data[c + comp * (x + width_ * y)];
-      }
-    }
-  }
-  Load(transformed.data(), width_b, height_b, option);
-  stbi_image_free(data);
+  *this = image.Upload();
+  // The texture can be evicted, and reloaded from the file.
+  SetTextureSource(id_, filename, option);
 }
 
 /// @brief Load a texture from memory (RAM)
@@ -80,16 +113,155 @@ Texture::Texture(const uint8_t* data,
   Load(data, width_, height_, option);
 }
 
+// static
+/// @brief Load a texture from an image file held in memory.
+/// @param data The content of the file.
+/// @param size The size of |data|, in bytes.
+Texture Texture::FromMemory(const uint8_t* data, size_t size) {
+  return FromMemory(data, size, Option());
+}
+
+// static
+/// @brief Load a texture from an image file held in memory.
+/// @param data The content of the file.
+/// @param size The size of |data|, in bytes.
+/// @param option Additionnal option (texture wrap, min filter, mag filter, ...)
+Texture Texture::FromMemory(const uint8_t* data,
+                            size_t size,
+                            const Option& option) {
+  SMK_PROFILE_SCOPE("Texture::Load");
+  DecodedImage image;
+  if (image.Decode(data, size, option))
+    return image.Upload();
+  std::cerr << "SMK > Can't decode the image from memory" << std::endl;
+  return Texture();
+}
+
+// static
+/// @brief Load a texture array. Every file is a layer.
+/// @param filenames The images. They must have the same dimensions.
+Texture Texture::Array(const std::vector<std::string>& filenames) {
+  return Array(filenames, Option());
+}
+
+// static
+/// @brief Load a texture array. Every file is a layer.
+/// @param filenames The images. They must have the same dimensions.
+/// @param option Additionnal option (texture wrap, min filter, mag filter, ...)
+Texture Texture::Array(const std::vector<std::string>& filenames,
+                       const Option& option) {
+  SMK_PROFILE_SCOPE("Texture::Load");
+  Option rgba = option;
+  rgba.convert_to_rgba = true;
+  rgba.format = GL_RGBA;
+  rgba.type = GL_UNSIGNED_BYTE;
+
+  Texture texture;
+  for (size_t layer = 0; layer < filenames.size(); ++layer) {
+    DecodedImage image;
+    if (!image.Decode(filenames[layer], rgba) || !image.pixels()) {
+      std::cerr << "SMK > Can't load the layer " << filenames[layer]
+                << std::endl;
+      return Texture();
+    }
+
+    // The storage is allocated for every layers with the first one.
+    if (layer == 0) {
+      texture = Array(nullptr, image.width(), image.height(),
+                      int(filenames.size()), rgba);
+      if (!texture)
+        return texture;
+    } else if (image.width() != texture.width() ||
+               image.height() != texture.height()) {
+      std::cerr << "SMK > The layers of a texture array must have the same "
+                   "dimensions: "
+                << filenames[layer] << std::endl;
+      return Texture();
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture.id());
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, GLint(layer), image.width(),
+                    image.height(), 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                    image.pixels());
+    ++g_render_stats.texture_uploads;
+  }
+
+  if (option.generate_mipmap && texture.id())
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, GL_NONE);
+  return texture;
+}
+
+// static
+/// @brief Create a texture array from memory (RAM).
+/// @param data The layers, one after the other. Null leaves them undefined.
+/// @param width The width of the layers.
+/// @param height The height of the layers.
+/// @param layers The number of layers.
+/// @param option Additionnal option (texture wrap, min filter, mag filter, ...)
+Texture Texture::Array(const uint8_t* data,
+                       int width,
+                       int height,
+                       int layers,
+                       const Option& option) {
+  Texture texture;
+  if (width <= 0 || height <= 0 || layers <= 0)
+    return texture;
+  texture.width_ = width;
+  texture.height_ = height;
+  texture.target_ = GL_TEXTURE_2D_ARRAY;
+  texture.layers_ = layers;
+  texture.ref_count_ = new std::atomic<int>(1);
+
+  glGenTextures(1, &texture.id_);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, texture.id_);
+  {
+    UnpackAlignment alignment(1);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, option.internal_format, width,
+                 height, layers, 0, option.format, option.type, data);
+  }
+  if (data)
+    ++g_render_stats.texture_uploads;
+  int levels = 1;
+  if (option.generate_mipmap) {
+    if (data)
+      glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    levels = MipmapLevelCount(width, height);
+  }
+  const GLenum target = GL_TEXTURE_2D_ARRAY;
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, option.min_filter);
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, option.mag_filter);
+  glTexParameteri(target, GL_TEXTURE_WRAP_S, option.wrap_s);
+  glTexParameteri(target, GL_TEXTURE_WRAP_T, option.wrap_t);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, GL_NONE);
+  g_invalidate_textures = true;
+  TrackTexture(texture.id_,
+               TextureBytes(option.internal_format, width, height, levels) *
+                   size_t(layers),
+               levels);
+  return texture;
+}
+
 void Texture::Load(const uint8_t* data,
                    int width,
                    int height,
                    const Option& option) {
   glGenTextures(1, &id_);
+  ref_count_ = new std::atomic<int>(1);
   glBindTexture(GL_TEXTURE_2D, id_);
-  glTexImage2D(GL_TEXTURE_2D, 0, option.internal_format, width, height, 0,
-               option.format, option.type, data);
-  if (option.generate_mipmap)
+  {
+    UnpackAlignment alignment(1);
+    glTexImage2D(GL_TEXTURE_2D, 0, option.internal_format, width, height, 0,
+                 option.format, option.type, data);
+  }
+  ++g_render_stats.texture_uploads;
+  int levels = 1;
+  if (option.generate_mipmap) {
     glGenerateMipmap(GL_TEXTURE_2D);
+    levels = MipmapLevelCount(width, height);
+  }
+  TrackTexture(id_, TextureBytes(option.internal_format, width, height, levels),
+               levels);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, option.min_filter);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, option.mag_filter);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, option.wrap_s);
@@ -98,33 +270,61 @@ void Texture::Load(const uint8_t* data,
   g_invalidate_textures = true;
 }
 
-/// @brief Import an already loaded texture. Useful
+/// @brief Import an already loaded texture. The caller keeps its ownership:
+/// it isn't deleted when the last copy is released.
 /// @param id The OpenGL identifier of the loaded texture.
 /// @param width the image's with.
 /// @param height the image's height.
+/// @see Adopt
 Texture::Texture(GLuint id, int width, int height)
-    : id_(id), width_(width), height_(height) {}
+    : id_(id), width_(width), height_(height), owned_(false) {
+  if (id_)
+    ref_count_ = new std::atomic<int>(1);
+}
+
+/// @brief Take the ownership of an already loaded texture. It is deleted when
+/// the last copy is released.
+/// @param id The OpenGL identifier of the loaded texture.
+/// @param width the image's with.
+/// @param height the image's height.
+// static
+Texture Texture::Adopt(GLuint id, int width, int height) {
+  Texture texture(id, width, height);
+  texture.owned_ = true;
+  return texture;
+}
 
 /// @brief The null texture.
 Texture::Texture() = default;
 Texture::~Texture() {
-  int* ref_count = ref_count_;
+  Release();
+}
+
+void Texture::Release() {
+  std::atomic<int>* ref_count = ref_count_;
+  GLuint id = id_;
+  const bool owned = owned_;
   id_ = 0;
   width_ = -1;
   height_ = -1;
+  target_ = GL_TEXTURE_2D;
+  layers_ = 1;
+  owned_ = true;
+  ref_count_ = nullptr;
 
-  if (!id_)
+  if (!id)
     return;
 
   if (ref_count) {
-    --(*ref_count);
-    if (*ref_count)
+    if (--(*ref_count))
       return;
     delete ref_count;
-    ref_count = nullptr;
   }
 
-  glDeleteTextures(1, &id_);
+  if (!owned)
+    return;
+  UntrackTexture(id);
+  glDeleteTextures(1, &id);
 }
 
 Texture::Texture(Texture&& other) noexcept {
@@ -136,40 +336,120 @@ Texture::Texture(const Texture& other) {
 }
 
 void Texture::operator=(Texture&& other) noexcept {
-  this->~Texture();
+  Release();
   std::swap(id_, other.id_);
   std::swap(width_, other.width_);
   std::swap(height_, other.height_);
+  std::swap(target_, other.target_);
+  std::swap(layers_, other.layers_);
+  std::swap(owned_, other.owned_);
   std::swap(ref_count_, other.ref_count_);
 }
 
 Texture& Texture::operator=(const Texture& other) {
-  this->~Texture();
+  if (this == &other)
+    return *this;
+  Release();
   id_ = other.id_;
   width_ = other.width_;
   height_ = other.height_;
+  target_ = other.target_;
+  layers_ = other.layers_;
+  owned_ = other.owned_;
 
   if (!other.id_)
     return *this;
 
-  if (!other.ref_count_)
-    other.ref_count_ = new int(1);
-
   ref_count_ = other.ref_count_;
   (*ref_count_)++;
   return *this;
 }
 
+/// @brief Replace the whole texture content.
+/// @param rgba The new pixels. RGBA(8,8,8,8), with the texture dimensions.
+void Texture::Update(const uint8_t* rgba) {
+  Update({0.f, 0.f, float(width_), float(height_)}, rgba);
+}
+
+/// @brief Replace a part of the texture content.
+/// @param rectangle The area to replace, in pixels.
+/// @param rgba The new pixels. RGBA(8,8,8,8), with the rectangle dimensions.
+void Texture::Update(const Rectangle& rectangle, const uint8_t* rgba) {
+  if (!id_ || target_ != GL_TEXTURE_2D)
+    return;
+
+  const int x = int(rectangle.left);
+  const int y = int(rectangle.top);
+  const int width = int(rectangle.width());
+  const int height = int(rectangle.height());
+  const size_t size = size_t(width) * size_t(height) * 4;
+
+  glActiveTexture(kUploadTextureUnit);
+  glBindTexture(GL_TEXTURE_2D, id_);
+  UnpackAlignment alignment(4);
+
+#ifdef __EMSCRIPTEN__
+  // WebGL can't map buffers, and copies the pixels synchronously anyway.
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA,
+                  GL_UNSIGNED_BYTE, rgba);
+#else
+  UploadBuffer& upload = NextUploadBuffer();
+  if (!upload.buffer)
+    glGenBuffers(1, &upload.buffer);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.buffer);
+
+  // Wait for the GPU to consume this buffer. It was used two updates ago, so
+  // this rarely blocks.
+  bool consumed = true;
+  if (upload.fence) {
+    const GLenum status =
+        glClientWaitSync(upload.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    consumed =
+        status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+    glDeleteSync(upload.fence);
+    upload.fence = nullptr;
+  }
+
+  // The GPU may still read the buffer after a timeout. Orphan its storage
+  // instead of overwriting it.
+  if (upload.capacity < size || !consumed) {
+    upload.capacity = std::max(upload.capacity, size);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, upload.capacity, nullptr,
+                 GL_STREAM_DRAW);
+    ++g_render_stats.buffer_allocations;
+  }
+
+  void* mapped = glMapBufferRange(
+      GL_PIXEL_UNPACK_BUFFER, 0, size,
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+  if (mapped) {
+    std::memcpy(mapped, rgba, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  } else {
+    // Some drivers can't map this buffer. Let them copy the pixels.
+    glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, rgba);
+  }
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA,
+                  GL_UNSIGNED_BYTE, nullptr);
+  upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+#endif
+
+  glBindTexture(GL_TEXTURE_2D, GL_NONE);
+  glActiveTexture(GL_TEXTURE0);
+  ++g_render_stats.texture_uploads;
+}
+
 void Texture::Bind(GLuint activetexture) const {
   glActiveTexture(activetexture);
-  glBindTexture(GL_TEXTURE_2D, id_);
+  glBindTexture(target_, id_);
 }
 
-bool Texture::operator==(const Texture& other) {
+bool Texture::operator==(const Texture& other) const {
   return id_ == other.id_;
 }
 
-bool Texture::operator!=(const Texture& other) {
+bool Texture::operator!=(const Texture& other) const {
   return id_ != other.id_;
 }
 
@@ -0,0 +1,177 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <smk/RenderStats.hpp>
+#include <smk/TextureAtlas.hpp>
+#include <vector>
+
+#include "SkylinePacker.hpp"
+#include "StbImage.hpp"
+#include "UnpackAlignment.hpp"
+
+namespace smk {
+extern thread_local bool g_invalidate_textures;
+extern thread_local RenderStats g_render_stats;
+
+// A texture shared by many images.
+struct TextureAtlas::Page {
+  Texture texture;
+  SkylinePacker packer;
+};
+
+namespace {
+
+// Empty pixels kept around every images, to avoid sampling the neighbors.
+constexpr int kPadding = 1;
+
+Texture::Option DefaultOption() {
+  // Mipmaps would mix the neighboring images together.
+  Texture::Option option;
+  option.generate_mipmap = false;
+  option.min_filter = GL_LINEAR;
+  option.mag_filter = GL_LINEAR;
+  return option;
+}
+
+int BytesPerPixel(GLenum format) {
+  switch (format) {
+    case GL_RED:
+      return 1;
+    case GL_RG:
+      return 2;
+    case GL_RGB:
+      return 3;
+    default:
+      return 4;
+  }
+}
+
+}  // namespace
+
+TextureAtlas::TextureAtlas() : TextureAtlas(1024, 1024) {}
+
+/// @brief An empty atlas.
+/// @param page_width The width of the pages. Larger images get their own page.
+/// @param page_height The height of the pages.
+TextureAtlas::TextureAtlas(int page_width, int page_height)
+    : TextureAtlas(page_width, page_height, DefaultOption()) {}
+
+/// @brief An empty atlas.
+/// @param page_width The width of the pages. Larger images get their own page.
+/// @param page_height The height of the pages.
+/// @param option The option used to create the pages' texture.
+TextureAtlas::TextureAtlas(int page_width,
+                           int page_height,
+                           const Texture::Option& option)
+    : page_width_(page_width), page_height_(page_height), option_(option) {}
+
+TextureAtlas::~TextureAtlas() = default;
+TextureAtlas::TextureAtlas(TextureAtlas&&) noexcept = default;
+TextureAtlas& TextureAtlas::operator=(TextureAtlas&&) noexcept = default;
+
+/// @brief Load an image from a file and add it into the atlas.
+/// @param filename The file name of the image to be loaded.
+TextureAtlas::Region TextureAtlas::Add(const std::string& filename) {
+  FILE* file = fopen(filename.c_str(), "rb");
+  if (!file) {
+    std::cerr << "File " << filename << " not found" << std::endl;
+    return {};
+  }
+
+  int width = 0;
+  int height = 0;
+  int comp = -1;
+  unsigned char* data = stbi_load_from_file(file, &width, &height, &comp, 4);
+  fclose(file);
+  if (!data) {
+    std::cerr << "SMK > TextureAtlas: Failed to decode " << filename
+              << std::endl;
+    return {};
+  }
+
+  // The pixels must be in the format of the pages.
+  const int channels = BytesPerPixel(option_.format);
+  if (channels != 4) {
+    for (int i = 0; i < width * height; ++i)
+      std::copy(data + 4 * i, data + 4 * i + channels, data + channels * i);
+  }
+
+  Region region = Add(data, width, height);
+  stbi_image_free(data);
+  return region;
+}
+
+/// @brief Add an image from memory (RAM) into the atlas.
+/// @param pixels The image, in the format of the pages. This is RGBA(8,8,8,8)
+///               by default.
+/// @param width The image's width.
+/// @param height The image's height.
+TextureAtlas::Region TextureAtlas::Add(const uint8_t* pixels,
+                                       int width,
+                                       int height) {
+  if (width <= 0 || height <= 0) {
+    std::cerr << "SMK > TextureAtlas: Failed to add a " << width << "x"
+              << height << " image" << std::endl;
+    return {};
+  }
+
+  const int padded_width = width + 2 * kPadding;
+  const int padded_height = height + 2 * kPadding;
+
+  glm::ivec2 position;
+  Page* page = nullptr;
+  for (auto& it : pages_) {
+    if (it->packer.Insert(padded_width, padded_height, &position)) {
+      page = it.get();
+      break;
+    }
+  }
+
+  if (!page) {
+    const int page_width = std::max(page_width_, padded_width);
+    const int page_height = std::max(page_height_, padded_height);
+    const std::vector<uint8_t> transparent(
+        page_width * page_height * BytesPerPixel(option_.format), 0);
+    auto new_page = std::make_unique<Page>();
+    new_page->texture =
+        Texture(transparent.data(), page_width, page_height, option_);
+    new_page->packer = SkylinePacker(page_width, page_height);
+    if (!new_page->packer.Insert(padded_width, padded_height, &position)) {
+      std::cerr << "SMK > TextureAtlas: Failed to add a " << width << "x"
+                << height << " image" << std::endl;
+      return {};
+    }
+    page = new_page.get();
+    pages_.push_back(std::move(new_page));
+  }
+
+  position += glm::ivec2(kPadding, kPadding);
+  glBindTexture(GL_TEXTURE_2D, page->texture.id());
+  {
+    // The rows of the single channel images aren't aligned on 4 bytes.
+    UnpackAlignment alignment(1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, position.x, position.y, width, height,
+                    option_.format, option_.type, pixels);
+  }
+  ++g_render_stats.texture_uploads;
+  if (option_.generate_mipmap)
+    glGenerateMipmap(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, GL_NONE);
+  g_invalidate_textures = true;
+
+  Region region;
+  region.texture = page->texture;
+  region.rectangle = {
+      float(position.x),
+      float(position.y),
+      float(position.x + width),
+      float(position.y + height),
+  };
+  return region;
+}
+
+}  // namespace smk
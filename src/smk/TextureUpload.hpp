@@ -0,0 +1,18 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_TEXTURE_UPLOAD_HPP
+#define SMK_TEXTURE_UPLOAD_HPP
+
+#include <smk/OpenGL.hpp>
+
+namespace smk {
+
+// Texture::Update() copies the pixels through a ring of pixel buffers owned
+// by the current context. Delete the ones of |context|, which must be current,
+// before it is destroyed.
+void ReleaseUploadBuffers(GLFWwindow* context);
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_TEXTURE_UPLOAD_HPP */
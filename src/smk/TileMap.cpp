@@ -0,0 +1,151 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <smk/FrameArena.hpp>
+#include <smk/RenderTarget.hpp>
+#include <smk/Scene2D.hpp>
+#include <smk/TileMap.hpp>
+
+namespace smk {
+
+/// @brief Constructor. Every tiles are empty.
+/// @param tileset The texture containing the tiles.
+/// @param tile_width The width of the tiles, in pixels of the tileset.
+/// @param tile_height The height of the tiles, in pixels of the tileset.
+/// @param width The number of columns of tiles.
+/// @param height The number of rows of tiles.
+TileMap::TileMap(const Texture& tileset,
+                 int tile_width,
+                 int tile_height,
+                 int width,
+                 int height)
+    : tile_width_(tile_width),
+      tile_height_(tile_height),
+      width_(width),
+      height_(height),
+      tiles_(width * height, -1) {
+  SetTexture(tileset);
+  tileset_columns_ = tile_width_ ? tileset.width() / tile_width_ : 0;
+  tileset_rows_ = tile_height_ ? tileset.height() / tile_height_ : 0;
+  chunk_columns_ = (width_ + kChunkSize - 1) / kChunkSize;
+  chunk_rows_ = (height_ + kChunkSize - 1) / kChunkSize;
+  chunks_.resize(chunk_columns_ * chunk_rows_);
+}
+
+/// @brief Modify a tile. Its chunk is rebuilt on the next draw.
+/// @param x The column of the tile.
+/// @param y The row of the tile.
+/// @param tile The index of the tile in the tileset, or -1 for none.
+void TileMap::SetTile(int x, int y, int tile) {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_)
+    return;
+  int& value = tiles_[x + y * width_];
+  if (value == tile)
+    return;
+  value = tile;
+  chunks_[x / kChunkSize + (y / kChunkSize) * chunk_columns_].dirty = true;
+}
+
+/// @brief The tile at a given position, or -1 for none.
+/// @param x The column of the tile.
+/// @param y The row of the tile.
+int TileMap::tile(int x, int y) const {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_)
+    return -1;
+  return tiles_[x + y * width_];
+}
+
+// Bake the tiles of a chunk into its VertexArray. The buffer is reused.
+void TileMap::Rebuild(int chunk_x, int chunk_y) const {
+  Chunk& chunk = chunks_[chunk_x + chunk_y * chunk_columns_];
+  chunk.dirty = false;
+
+  const int tile_count = tileset_columns_ * tileset_rows_;
+  const float w = float(tile_width_);
+  const float h = float(tile_height_);
+  const float texture_w = 1.f / tileset_columns_;
+  const float texture_h = 1.f / tileset_rows_;
+
+  FrameVector<Vertex2D> vertices;
+  vertices.reserve(kChunkSize * kChunkSize * 6);
+  for (int dy = 0; dy < kChunkSize; ++dy) {
+    const int y = chunk_y * kChunkSize + dy;
+    if (y >= height_)
+      break;
+    for (int dx = 0; dx < kChunkSize; ++dx) {
+      const int x = chunk_x * kChunkSize + dx;
+      if (x >= width_)
+        break;
+      const int tile = tiles_[x + y * width_];
+      if (tile < 0 || tile >= tile_count)
+        continue;
+
+      const float l = (tile % tileset_columns_) * texture_w;
+      const float t = (tile / tileset_columns_) * texture_h;
+      const float r = l + texture_w;
+      const float b = t + texture_h;
+      const float x0 = x * w;
+      const float y0 = y * h;
+      const float x1 = x0 + w;
+      const float y1 = y0 + h;
+      vertices.push_back({{x0, y0}, {l, t}});
+      vertices.push_back({{x0, y1}, {l, b}});
+      vertices.push_back({{x1, y1}, {r, b}});
+      vertices.push_back({{x0, y0}, {l, t}});
+      vertices.push_back({{x1, y1}, {r, b}});
+      vertices.push_back({{x1, y0}, {r, t}});
+    }
+  }
+
+  if (vertices.empty() && !chunk.vertex_array.vbo())
+    return;
+  chunk.vertex_array.Update(vertices.data(), vertices.size());
+}
+
+/// @brief Draw the visible chunks, rebuilding the modified ones first.
+void TileMap::Draw(RenderTarget& target, RenderState state) const {
+  drawn_chunks_ = 0;
+  if (!tileset_columns_ || !tileset_rows_)
+    return;
+
+  const View& view = target.view();
+  Rectangle area = {view.Left(), view.Top(), view.Right(), view.Bottom()};
+  // The View can be flipped.
+  if (area.left > area.right)
+    std::swap(area.left, area.right);
+  if (area.top > area.bottom)
+    std::swap(area.top, area.bottom);
+
+  RenderStateRef ref(state);
+  ref.color *= color();
+  ref.texture = &texture();
+  ref.view *= transformation();
+  ref.blend_mode = blend_mode();
+
+  const float chunk_w = float(kChunkSize * tile_width_);
+  const float chunk_h = float(kChunkSize * tile_height_);
+  for (int chunk_y = 0; chunk_y < chunk_rows_; ++chunk_y) {
+    for (int chunk_x = 0; chunk_x < chunk_columns_; ++chunk_x) {
+      Rectangle bounds = Scene2D::Bounds(
+          *this, {chunk_x * chunk_w, chunk_y * chunk_h,
+                  (chunk_x + 1) * chunk_w, (chunk_y + 1) * chunk_h});
+      if (bounds.left > area.right || bounds.right < area.left ||
+          bounds.top > area.bottom || bounds.bottom < area.top) {
+        continue;
+      }
+
+      const Chunk& chunk = chunks_[chunk_x + chunk_y * chunk_columns_];
+      if (chunk.dirty)
+        Rebuild(chunk_x, chunk_y);
+      if (!chunk.vertex_array.size())
+        continue;
+
+      ref.vertex_array = &chunk.vertex_array;
+      target.Draw(ref);
+      ++drawn_chunks_;
+    }
+  }
+}
+
+}  // namespace smk
@@ -2,12 +2,98 @@
 // Use of this source code is governed by the MIT license that can be found in
 // the LICENSE file.
 
+#include <algorithm>
 #include <smk/Touch.hpp>
 
 namespace smk {
 
+namespace {
+size_t g_history_capacity = 64;
+}  // namespace
+
+TouchHistory::TouchHistory() : points_(Touch::history_capacity()) {}
+
+/// @brief Append a point. The oldest one is dropped when the history is full.
+void TouchHistory::push_back(const TouchDataPoint& point) {
+  if (size_ == 0)
+    start_ = point;
+  if (size_ < points_.size()) {
+    ++size_;
+  } else {
+    first_ = (first_ + 1) % points_.size();
+  }
+  points_[(first_ + size_ - 1) % points_.size()] = point;
+}
+
+/// @brief Remove every points. The capacity is kept.
+void TouchHistory::clear() {
+  first_ = 0;
+  size_ = 0;
+  start_ = TouchDataPoint();
+}
+
 glm::vec2 Touch::position() const {
   return data_points.back().position;
 }
 
+/// @brief The movement since the first position of the touch, even when it
+/// is no longer in the history.
+glm::vec2 Touch::displacement() const {
+  if (data_points.empty())
+    return {0.f, 0.f};
+  return data_points.back().position - data_points.start().position;
+}
+
+/// @brief The average velocity over the last |duration| seconds.
+/// @param duration The duration in seconds the velocity is averaged over.
+/// @return The velocity in pixels per second. Zero when it can't be computed.
+glm::vec2 Touch::velocity(float duration) const {
+  if (data_points.size() < 2)
+    return {0.f, 0.f};
+  const TouchDataPoint& last = data_points.back();
+  size_t i = data_points.size() - 1;
+  while (i > 0 && last.time - data_points[i - 1].time <= duration)
+    --i;
+  if (i == data_points.size() - 1)
+    --i;
+  const TouchDataPoint& first = data_points[i];
+  float elapsed = last.time - first.time;
+  if (elapsed <= 0.f)
+    return {0.f, 0.f};
+  return (last.position - first.position) / elapsed;
+}
+
+/// @brief The position at a given time, linearly interpolated in between the
+/// two closest points of the history.
+/// @param time The time in seconds, see glfwGetTime().
+glm::vec2 Touch::Sample(float time) const {
+  if (data_points.empty())
+    return {0.f, 0.f};
+  if (time <= data_points.front().time)
+    return data_points.front().position;
+  for (size_t i = 1; i < data_points.size(); ++i) {
+    const TouchDataPoint& a = data_points[i - 1];
+    const TouchDataPoint& b = data_points[i];
+    if (time > b.time)
+      continue;
+    float t = b.time > a.time ? (time - a.time) / (b.time - a.time) : 1.f;
+    return glm::mix(a.position, b.position, t);
+  }
+  return data_points.back().position;
+}
+
+/// @brief Set the number of positions kept in the history of the touches
+/// created later.
+/// @param capacity The number of positions. At least one is kept.
+// static
+void Touch::SetHistoryCapacity(size_t capacity) {
+  g_history_capacity = std::max(capacity, size_t(1));
+}
+
+/// @brief The number of positions kept in the history of a new touch.
+// static
+size_t Touch::history_capacity() {
+  return g_history_capacity;
+}
+
 }  // namespace smk
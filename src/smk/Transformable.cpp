@@ -14,6 +14,8 @@ namespace smk {
 /// @param rotation The angle in radian.
 void Transformable::SetRotation(float rotation) {
   rotation_ = rotation;
+  transformation_dirty_ = true;
+  Touch();
 }
 
 /// @brief Increase the rotation of the object to apply before drawing it.
@@ -21,6 +23,8 @@ void Transformable::SetRotation(float rotation) {
 /// @param rotation The delta of rotation to be added.
 void Transformable::Rotate(float rotation) {
   rotation_ += rotation;
+  transformation_dirty_ = true;
+  Touch();
 }
 
 /// @brief Set the position of the object to be drawn.
@@ -28,6 +32,8 @@ void Transformable::Rotate(float rotation) {
 /// @param position the position (x,y) of the object.
 void Transformable::SetPosition(const glm::vec2& position) {
   position_ = position;
+  transformation_dirty_ = true;
+  Touch();
 }
 
 /// @brief Set the position of the object to be drawn.
@@ -36,6 +42,8 @@ void Transformable::SetPosition(const glm::vec2& position) {
 /// @param y The position along the vertical axis.
 void Transformable::SetPosition(float x, float y) {
   position_ = {x, y};
+  transformation_dirty_ = true;
+  Touch();
 }
 
 /// Increase the position of the object being drawn.
@@ -43,6 +51,8 @@ void Transformable::SetPosition(float x, float y) {
 /// @param move The increment of position (x,y)
 void Transformable::Move(const glm::vec2& move) {
   position_ += move;
+  transformation_dirty_ = true;
+  Touch();
 }
 
 /// Increase the position of the object being drawn.
@@ -59,6 +69,8 @@ void Transformable::Move(float x, float y) {
 /// @param center The center position (x,y) in the object.
 void Transformable::SetCenter(const glm::vec2& center) {
   center_ = center;
+  transformation_dirty_ = true;
+  Touch();
 }
 
 /// @brief Set the center of the object. It is used as the rotation center. The
@@ -80,6 +92,8 @@ void Transformable::SetScale(float scale) {
 /// @param scale The ratio of magnification.
 void Transformable::SetScale(const glm::vec2& scale) {
   scale_ = scale;
+  transformation_dirty_ = true;
+  Touch();
 }
 
 /// @brief Increase or decrease the size of the object being drawn.
@@ -88,18 +102,24 @@ void Transformable::SetScale(const glm::vec2& scale) {
 void Transformable::SetScale(float scale_x, float scale_y) {
   scale_.x = scale_x;
   scale_.y = scale_y;
+  transformation_dirty_ = true;
+  Touch();
 }
 
 /// @brief Increase or decrease the size of the object being drawn.
 /// @param scale_x The ratio of magnification along the horizontal axis.
 void Transformable::SetScaleX(float scale_x) {
   scale_.x = scale_x;
+  transformation_dirty_ = true;
+  Touch();
 }
 
 /// @brief Increase or decrease the size of the object being drawn.
 /// @param scale_y The ratio of magnification along the vertical axis.
 void Transformable::SetScaleY(float scale_y) {
   scale_.y = scale_y;
+  transformation_dirty_ = true;
+  Touch();
 }
 
 /// @brief Increase or decrease the size of the object being drawn.
@@ -107,7 +127,12 @@ void Transformable::SetScaleY(float scale_y) {
 ///         applying the translation, rotation, center and scaling to the the
 ///         object.
 glm::mat4 Transformable::transformation() const {
-  glm::mat4 ret = glm::mat4(1.0);
+  if (!transformation_dirty_)
+    return transformation_;
+  transformation_dirty_ = false;
+
+  glm::mat4& ret = transformation_;
+  ret = glm::mat4(1.0);
   ret = glm::translate(ret, {position_.x, position_.y, 0.0});
   if (rotation_ != 0.f)
     ret =
@@ -124,31 +149,60 @@ glm::mat4 Transformable::transformation() const {
 /// @param color The color.
 void TransformableBase::SetColor(const glm::vec4& color) {
   color_ = color;
+  Touch();
 }
 
 /// @brief Set the blending mode to be used for drawing the object.
 /// @param blend_mode the BlendMode to be used.
 void TransformableBase::SetBlendMode(const BlendMode& blend_mode) {
   blend_mode_ = blend_mode;
+  Touch();
 }
 
 /// Set the object's texture.
 void TransformableBase::SetTexture(Texture texture) {
   texture_ = std::move(texture);
+  Touch();
 }
 
-/// Set the object's shape.
+/// Set the object's shape. This removes the levels of detail.
 void TransformableBase::SetVertexArray(VertexArray vertex_array) {
   vertex_array_ = std::move(vertex_array);
+  levels_of_detail_.clear();
+  Touch();
+}
+
+/// @brief Set the shapes of the object, from the coarsest to the finest. The
+/// one drawn is chosen depending on the size of the object on the screen.
+/// @param levels The shapes, sorted by increasing |min_size|.
+void TransformableBase::SetLevelsOfDetail(std::vector<LevelOfDetail> levels) {
+  vertex_array_ = levels.empty() ? VertexArray() : levels.back().vertex_array;
+  levels_of_detail_ = std::move(levels);
+  Touch();
 }
 
 void TransformableBase::Draw(RenderTarget& target, RenderState state) const {
-  state.color *= color();
-  state.texture = texture();
-  state.view *= transformation();
-  state.vertex_array = vertex_array();
-  state.blend_mode = blend_mode();
-  target.Draw(state);
+  RenderStateRef ref(state);
+  ref.color *= color();
+  ref.texture = &texture();
+  ref.view *= transformation();
+
+  const VertexArray* shape = &vertex_array();
+  if (levels_of_detail_.size() > 1 && !state.instances.size()) {
+    float size = target.ProjectedSize(shape->bounds(), ref.view);
+    for (const LevelOfDetail& level : levels_of_detail_) {
+      if (level.min_size > size)
+        break;
+      shape = &level.vertex_array;
+    }
+  }
+
+  // The instances have their own transformations. They aren't culled.
+  if (!state.instances.size() && !target.IsVisible(shape->bounds(), ref.view))
+    return;
+  ref.vertex_array = shape;
+  ref.blend_mode = blend_mode();
+  target.Draw(ref);
 }
 
 /// @brief set the transformation to use for drawing this object, represented as
@@ -157,6 +211,7 @@ void TransformableBase::Draw(RenderTarget& target, RenderState state) const {
 /// @param transformation The 4x4 matrix defining the transformation.
 void Transformable3D::SetTransformation(const glm::mat4& transformation) {
   transformation_ = transformation;
+  Touch();
 }
 
 glm::mat4 Transformable3D::transformation() const {
@@ -0,0 +1,39 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+#ifndef SMK_UNPACK_ALIGNMENT_HPP
+#define SMK_UNPACK_ALIGNMENT_HPP
+
+#include <smk/OpenGL.hpp>
+
+namespace smk {
+
+// Set GL_UNPACK_ALIGNMENT while uploading pixels, and restore the previous
+// value when going out of scope. The rows of the GL_RED and GL_RGB images
+// usually aren't aligned on 4 bytes, and must be uploaded with an alignment of
+// 1.
+class UnpackAlignment {
+ public:
+  explicit UnpackAlignment(GLint alignment) {
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous_);
+    if (alignment != previous_)
+      glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    current_ = alignment;
+  }
+
+  ~UnpackAlignment() {
+    if (current_ != previous_)
+      glPixelStorei(GL_UNPACK_ALIGNMENT, previous_);
+  }
+
+  UnpackAlignment(const UnpackAlignment&) = delete;
+  UnpackAlignment& operator=(const UnpackAlignment&) = delete;
+
+ private:
+  GLint previous_ = 4;
+  GLint current_ = 4;
+};
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_UNPACK_ALIGNMENT_HPP */
@@ -20,6 +20,27 @@ void Vertex2D::Bind() {
                         (void*)offsetof(Vertex, texture_position));
 }
 
+// static
+void Vertex2DLayered::Bind() {
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, false, sizeof(Vertex2DLayered),
+                        (void*)offsetof(Vertex2DLayered, space_position));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 2, GL_FLOAT, false, sizeof(Vertex2DLayered),
+                        (void*)offsetof(Vertex2DLayered, texture_position));
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 1, GL_FLOAT, false, sizeof(Vertex2DLayered),
+                        (void*)offsetof(Vertex2DLayered, layer));
+}
+
+// static
+void Vertex2DColored::Bind() {
+  VertexLayout<Vertex2DColored,
+               SMK_VERTEX_ATTRIBUTE(0, Vertex2DColored, space_position),
+               SMK_VERTEX_ATTRIBUTE(1, Vertex2DColored, texture_position),
+               SMK_VERTEX_ATTRIBUTE(2, Vertex2DColored, color)>::Bind();
+}
+
 // static
 void Vertex3D::Bind() {
   glVertexAttribPointer(0, sizeof(Vertex3D::space_position) / sizeof(GL_FLOAT),
@@ -35,4 +56,60 @@ void Vertex3D::Bind() {
       sizeof(Vertex3D), (void*)offsetof(Vertex3D, texture_position));
 }
 
+void Instance3D::Bind() {
+  // A mat4 attribute uses 4 consecutive locations, one per column.
+  for (int i = 0; i < 4; ++i) {
+    glEnableVertexAttribArray(3 + i);
+    glVertexAttribPointer(
+        3 + i, 4, GL_FLOAT, false, sizeof(Instance3D),
+        (void*)(offsetof(Instance3D, transformation) + i * sizeof(glm::vec4)));
+    glVertexAttribDivisor(3 + i, 1);
+  }
+  glEnableVertexAttribArray(7);
+  glVertexAttribPointer(7, sizeof(Instance3D::color) / sizeof(GL_FLOAT),
+                        GL_FLOAT, false, sizeof(Instance3D),
+                        (void*)offsetof(Instance3D, color));
+  glVertexAttribDivisor(7, 1);
+}
+
+// static
+void Instance2D::Bind() {
+  glEnableVertexAttribArray(3);
+  glVertexAttribPointer(3, sizeof(Instance2D::row_x) / sizeof(GL_FLOAT),
+                        GL_FLOAT, false, sizeof(Instance2D),
+                        (void*)offsetof(Instance2D, row_x));
+  glVertexAttribDivisor(3, 1);
+  glEnableVertexAttribArray(4);
+  glVertexAttribPointer(4, sizeof(Instance2D::row_y) / sizeof(GL_FLOAT),
+                        GL_FLOAT, false, sizeof(Instance2D),
+                        (void*)offsetof(Instance2D, row_y));
+  glVertexAttribDivisor(4, 1);
+  glEnableVertexAttribArray(7);
+  glVertexAttribPointer(7, sizeof(Instance2D::color) / sizeof(GL_FLOAT),
+                        GL_FLOAT, false, sizeof(Instance2D),
+                        (void*)offsetof(Instance2D, color));
+  glVertexAttribDivisor(7, 1);
+}
+
+// static
+void Particle2D::Bind() {
+  glEnableVertexAttribArray(3);
+  glVertexAttribPointer(3, 2, GL_FLOAT, false, sizeof(Particle2D),
+                        (void*)offsetof(Particle2D, position));
+  glVertexAttribDivisor(3, 1);
+  glEnableVertexAttribArray(4);
+  glVertexAttribPointer(4, 2, GL_FLOAT, false, sizeof(Particle2D),
+                        (void*)offsetof(Particle2D, velocity));
+  glVertexAttribDivisor(4, 1);
+  // The age, the lifetime and the size.
+  glEnableVertexAttribArray(5);
+  glVertexAttribPointer(5, 3, GL_FLOAT, false, sizeof(Particle2D),
+                        (void*)offsetof(Particle2D, age));
+  glVertexAttribDivisor(5, 1);
+  glEnableVertexAttribArray(7);
+  glVertexAttribPointer(7, 4, GL_FLOAT, false, sizeof(Particle2D),
+                        (void*)offsetof(Particle2D, color));
+  glVertexAttribDivisor(7, 1);
+}
+
 }  // namespace smk.
@@ -2,29 +2,297 @@
 // Use of this source code is governed by the MIT license that can be found in
 // the LICENSE file.
 
+#include <algorithm>
+#include <smk/RenderStats.hpp>
 #include <smk/VertexArray.hpp>
+#include <smk/VertexArrayObject.hpp>
+
+#include "ResidencyTracker.hpp"
 
 namespace smk {
+thread_local bool g_invalidate_vertex_array = false;
+extern thread_local RenderStats g_render_stats;
+extern std::atomic<int> g_render_threads;
+
+namespace {
+
+// Whether the buffers may be drawn by a frame the render thread hasn't
+// rendered yet: the recorded frames hold copies of the VertexArrays. They must
+// be replaced rather than rewritten, or the pending frame would draw the new
+// content.
+bool Pending(const std::atomic<int>& ref_count) {
+  return g_render_threads.load(std::memory_order_relaxed) &&
+         ref_count.load() > 1;
+}
+
+// Replace the content of the |buffer| bound to |target|. The previous storage
+// is orphaned, so that the pending draw calls using it don't stall the CPU.
+void RewriteBuffer(GLenum target,
+                   GLuint buffer,
+                   size_t size,
+                   const void* data) {
+  glBufferData(target, size, nullptr, GL_DYNAMIC_DRAW);
+  glBufferSubData(target, 0, size, data);
+  ++g_render_stats.buffer_allocations;
+  TrackBuffer(buffer, size);
+}
+
+size_t IndexSize(GLenum type) {
+  return type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+}  // namespace
 
 VertexArray::VertexArray() = default;
 
-void VertexArray::Allocate(int element_size, void* data) {
+void VertexArray::Allocate(size_t size, int element_size, void* data) {
+  shared_ = new Shared;
+  shared_->size = size;
+  shared_->capacity = size;
+  context_ = glfwGetCurrentContext();
   glGenVertexArrays(1, &vao_);
   glBindVertexArray(vao_);
+  g_invalidate_vertex_array = true;
 
   glGenBuffers(1, &vbo_);
   glBindBuffer(GL_ARRAY_BUFFER, vbo_);
 
-  glBufferData(GL_ARRAY_BUFFER, size_ * element_size, data, GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, size * element_size, data, GL_STATIC_DRAW);
+  ++g_render_stats.buffer_allocations;
+  TrackBuffer(vbo_, size * element_size);
   glEnableVertexAttribArray(0);
 }
 
+// Must be called after Allocate, while the vertex array object is bound.
+void VertexArray::AllocateIndices(size_t count, GLenum type, const void* data) {
+  shared_->index_count = count;
+  shared_->index_type = type;
+
+  glGenBuffers(1, &shared_->ebo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shared_->ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * IndexSize(type), data,
+               GL_STATIC_DRAW);
+  ++g_render_stats.buffer_allocations;
+  TrackBuffer(shared_->ebo, count * IndexSize(type));
+}
+
+template <typename VertexType>
+void VertexArray::UpdateVertices(const VertexType* data, size_t size) {
+  UpdateVertices(data, size, sizeof(VertexType), &VertexType::Bind,
+                 Bounds(data, size));
+}
+
+// The vertex type is erased, so that the custom ones can be used from the
+// header.
+void VertexArray::UpdateVertices(const void* data,
+                                 size_t size,
+                                 size_t element_size,
+                                 void (*layout)(),
+                                 const BoundingBox& bounds) {
+  // A new vertex type needs a new vertex array object.
+  if (!vbo_ || layout_ != layout || Pending(shared_->ref_count)) {
+    VertexArray vertex_array;
+    vertex_array.Allocate(size, element_size, (void*)data);
+    vertex_array.layout_ = layout;
+    vertex_array.layout_();
+    vertex_array.shared_->bounds = bounds;
+    *this = std::move(vertex_array);
+    return;
+  }
+
+  shared_->size = size;
+  shared_->capacity = size;
+  shared_->bounds = bounds;
+  shared_->index_count = 0;
+  shared_->index_type = GL_NONE;
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  RewriteBuffer(GL_ARRAY_BUFFER, vbo_, size * element_size, data);
+}
+
+template <typename VertexType>
+void VertexArray::UpdateVerticesRange(const VertexType* data,
+                                      size_t size,
+                                      size_t first) {
+  const bool new_buffers = !vbo_ || layout_ != &VertexType::Bind ||
+                           Pending(shared_->ref_count);
+  const size_t current_capacity = shared_ ? shared_->capacity : 0u;
+  if (new_buffers || indexed() || size > current_capacity || first > size) {
+    const size_t capacity = std::max(size, 2 * current_capacity);
+    const size_t element_size = sizeof(VertexType);
+    if (new_buffers) {
+      VertexArray vertex_array;
+      vertex_array.Allocate(capacity, element_size, nullptr);
+      vertex_array.layout_ = &VertexType::Bind;
+      vertex_array.layout_();
+      *this = std::move(vertex_array);
+    } else {
+      shared_->index_count = 0;
+      shared_->index_type = GL_NONE;
+      glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+      glBufferData(GL_ARRAY_BUFFER, capacity * element_size, nullptr,
+                   GL_DYNAMIC_DRAW);
+      ++g_render_stats.buffer_allocations;
+      TrackBuffer(vbo_, capacity * element_size);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size * element_size, data);
+    shared_->size = size;
+    shared_->capacity = capacity;
+    shared_->bounds = Bounds(data, size);
+    return;
+  }
+
+  // The vertices past the current size were never uploaded, even before
+  // |first|.
+  first = std::min(first, shared_->size);
+
+  // Past the first vertex, the bounds only grow: they stay valid, if not
+  // tight, when vertices move inward.
+  BoundingBox bounds = Bounds(data + first, size - first);
+  if (first == 0) {
+    shared_->bounds = bounds;
+  } else if (!bounds.empty()) {
+    shared_->bounds.Extend(bounds.min);
+    shared_->bounds.Extend(bounds.max);
+  }
+  shared_->size = size;
+  if (first == size)
+    return;
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(VertexType),
+                  (size - first) * sizeof(VertexType), data + first);
+}
+
+// Must be called after UpdateVertices.
+void VertexArray::UpdateIndices(size_t count, GLenum type, const void* data) {
+  // The element buffer binding is part of the vertex array object state.
+  Bind();
+  g_invalidate_vertex_array = true;
+
+  if (!shared_->ebo) {
+    AllocateIndices(count, type, data);
+    // The other contexts must bind the new element buffer too.
+    ReleaseSharedVertexArrayObjects(context_, vao_);
+    return;
+  }
+
+  shared_->index_count = count;
+  shared_->index_type = type;
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shared_->ebo);
+  RewriteBuffer(GL_ELEMENT_ARRAY_BUFFER, shared_->ebo,
+                count * IndexSize(type), data);
+}
+
+/// @brief Replace the vertices.
+/// @param array A set of 2D triangles.
+void VertexArray::Update(const std::vector<Vertex2D>& array) {
+  UpdateVertices(array.data(), array.size());
+}
+
+/// @brief Replace the vertices.
+/// @param array A set of 3D triangles.
+void VertexArray::Update(const std::vector<Vertex3D>& array) {
+  UpdateVertices(array.data(), array.size());
+}
+
+/// @brief Replace the vertices.
+/// @param array A set of 2D triangles, sampling the layers of a texture array.
+void VertexArray::Update(const std::vector<Vertex2DLayered>& array) {
+  UpdateVertices(array.data(), array.size());
+}
+
+/// @brief Replace the vertices. The data is copied, it can be released once
+/// this returns. This suits vertices built in a FrameArena.
+/// @param data A set of 2D triangles.
+/// @param size The number of vertices.
+void VertexArray::Update(const Vertex2D* data, size_t size) {
+  UpdateVertices(data, size);
+}
+
+/// @brief Replace the vertices. The data is copied, it can be released once
+/// this returns. This suits vertices built in a FrameArena.
+/// @param data A set of 3D triangles.
+/// @param size The number of vertices.
+void VertexArray::Update(const Vertex3D* data, size_t size) {
+  UpdateVertices(data, size);
+}
+
+/// @brief Replace the vertices. The data is copied, it can be released once
+/// this returns.
+/// @param data A set of 2D triangles, sampling the layers of a texture array.
+/// @param size The number of vertices.
+void VertexArray::Update(const Vertex2DLayered* data, size_t size) {
+  UpdateVertices(data, size);
+}
+
+/// @brief Replace the vertices, uploading only the ones modified.
+/// @param data A set of 2D triangles.
+/// @param size The number of vertices.
+/// @param first The vertices before |first| are the same as the previous ones.
+void VertexArray::UpdateRange(const Vertex2D* data, size_t size, size_t first) {
+  UpdateVerticesRange(data, size, first);
+}
+
+/// @brief Replace the vertices, uploading only the ones modified.
+/// @param data A set of 3D triangles.
+/// @param size The number of vertices.
+/// @param first The vertices before |first| are the same as the previous ones.
+void VertexArray::UpdateRange(const Vertex3D* data, size_t size, size_t first) {
+  UpdateVerticesRange(data, size, first);
+}
+
+/// @brief Replace the vertices and the indices.
+/// @param array The vertices.
+/// @param indices Every 3 consecutive indices in |array| form a triangle.
+void VertexArray::Update(const std::vector<Vertex2D>& array,
+                         const std::vector<uint16_t>& indices) {
+  UpdateVertices(array.data(), array.size());
+  UpdateIndices(indices.size(), GL_UNSIGNED_SHORT, indices.data());
+}
+
+/// @brief Replace the vertices and the indices.
+/// @param array The vertices.
+/// @param indices Every 3 consecutive indices in |array| form a triangle.
+void VertexArray::Update(const std::vector<Vertex2D>& array,
+                         const std::vector<uint32_t>& indices) {
+  UpdateVertices(array.data(), array.size());
+  UpdateIndices(indices.size(), GL_UNSIGNED_INT, indices.data());
+}
+
+/// @brief Replace the vertices and the indices.
+/// @param array The vertices.
+/// @param indices Every 3 consecutive indices in |array| form a triangle.
+void VertexArray::Update(const std::vector<Vertex3D>& array,
+                         const std::vector<uint16_t>& indices) {
+  UpdateVertices(array.data(), array.size());
+  UpdateIndices(indices.size(), GL_UNSIGNED_SHORT, indices.data());
+}
+
+/// @brief Replace the vertices and the indices.
+/// @param array The vertices.
+/// @param indices Every 3 consecutive indices in |array| form a triangle.
+void VertexArray::Update(const std::vector<Vertex3D>& array,
+                         const std::vector<uint32_t>& indices) {
+  UpdateVertices(array.data(), array.size());
+  UpdateIndices(indices.size(), GL_UNSIGNED_INT, indices.data());
+}
+
 VertexArray::~VertexArray() {
   Release();
 }
 
 void VertexArray::Bind() const {
-  glBindVertexArray(vao_);
+  BindVertexArrayObject(context_, vao_, &VertexArray::Setup, this);
+}
+
+// Bind the buffers and the attributes into the vertex array object of an
+// other context.
+void VertexArray::Setup(const void* data) {
+  auto* self = static_cast<const VertexArray*>(data);
+  glBindBuffer(GL_ARRAY_BUFFER, self->vbo_);
+  glEnableVertexAttribArray(0);
+  self->layout_();
+  if (self->shared_->ebo)
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, self->shared_->ebo);
 }
 
 void VertexArray::UnBind() const {
@@ -40,50 +308,105 @@ VertexArray::VertexArray(VertexArray&& other) noexcept {
 }
 
 VertexArray& VertexArray::operator=(const VertexArray& other) {
-  this->~VertexArray();
+  if (this == &other)
+    return *this;
+  Release();
   if (!other.vbo_)
     return *this;
 
-  if (!other.ref_count_)
-    other.ref_count_ = new int(1);
-
+  context_ = other.context_;
+  layout_ = other.layout_;
   vbo_ = other.vbo_;
   vao_ = other.vao_;
-  ref_count_ = other.ref_count_;
-  size_ = other.size_;
+  shared_ = other.shared_;
 
-  (*ref_count_)++;
+  shared_->ref_count++;
   return *this;
 }
 
 VertexArray& VertexArray::operator=(VertexArray&& other) noexcept {
+  std::swap(context_, other.context_);
+  std::swap(layout_, other.layout_);
   std::swap(vbo_, other.vbo_);
   std::swap(vao_, other.vao_);
-  std::swap(size_, other.size_);
-  std::swap(ref_count_, other.ref_count_);
+  std::swap(shared_, other.shared_);
   return *this;
 }
 
 /// Constructor for a vector of 2D vertices.
 /// @param array A set of 2D triangles.
 VertexArray::VertexArray(const std::vector<Vertex2D>& array) {
-  size_ = array.size();
-  Allocate(sizeof(Vertex2D), (void*)array.data());
-  Vertex2D::Bind();
+  Allocate(array.size(), sizeof(Vertex2D), (void*)array.data());
+  layout_ = &Vertex2D::Bind;
+  layout_();
+  shared_->bounds = Bounds(array.data(), array.size());
 }
 
 /// Constructor for a vector of 3D vertices.
 /// @param array A set of 3D triangles.
 VertexArray::VertexArray(const std::vector<Vertex3D>& array) {
-  size_ = array.size();
-  Allocate(sizeof(Vertex3D), (void*)array.data());
-  Vertex3D::Bind();
+  Allocate(array.size(), sizeof(Vertex3D), (void*)array.data());
+  layout_ = &Vertex3D::Bind;
+  layout_();
+  shared_->bounds = Bounds(array.data(), array.size());
+}
+
+/// Constructor for a vector of 2D vertices sampling a texture array.
+/// @param array A set of 2D triangles.
+VertexArray::VertexArray(const std::vector<Vertex2DLayered>& array) {
+  Allocate(array.size(), sizeof(Vertex2DLayered), (void*)array.data());
+  layout_ = &Vertex2DLayered::Bind;
+  layout_();
+  shared_->bounds = Bounds(array.data(), array.size());
+}
+
+/// Constructor for indexed 2D vertices.
+/// @param array The vertices.
+/// @param indices Every 3 consecutive indices in |array| form a triangle.
+VertexArray::VertexArray(const std::vector<Vertex2D>& array,
+                         const std::vector<uint16_t>& indices)
+    : VertexArray(array) {
+  AllocateIndices(indices.size(), GL_UNSIGNED_SHORT, indices.data());
+}
+
+/// Constructor for indexed 2D vertices.
+/// @param array The vertices.
+/// @param indices Every 3 consecutive indices in |array| form a triangle.
+VertexArray::VertexArray(const std::vector<Vertex2D>& array,
+                         const std::vector<uint32_t>& indices)
+    : VertexArray(array) {
+  AllocateIndices(indices.size(), GL_UNSIGNED_INT, indices.data());
+}
+
+/// Constructor for indexed 3D vertices.
+/// @param array The vertices.
+/// @param indices Every 3 consecutive indices in |array| form a triangle.
+VertexArray::VertexArray(const std::vector<Vertex3D>& array,
+                         const std::vector<uint16_t>& indices)
+    : VertexArray(array) {
+  AllocateIndices(indices.size(), GL_UNSIGNED_SHORT, indices.data());
+}
+
+/// Constructor for indexed 3D vertices.
+/// @param array The vertices.
+/// @param indices Every 3 consecutive indices in |array| form a triangle.
+VertexArray::VertexArray(const std::vector<Vertex3D>& array,
+                         const std::vector<uint32_t>& indices)
+    : VertexArray(array) {
+  AllocateIndices(indices.size(), GL_UNSIGNED_INT, indices.data());
 }
 
 /// @brief The size of the GPU array.
 /// @return the number of vertices in the GPU array.
 size_t VertexArray::size() const {
-  return size_;
+  return shared_ ? shared_->size : 0u;
+}
+
+/// @brief The box containing the vertices, computed when they are uploaded.
+/// The 2D vertices have z = 0.
+const BoundingBox& VertexArray::bounds() const {
+  static const BoundingBox empty;
+  return shared_ ? shared_->bounds : empty;
 }
 
 bool VertexArray::operator==(const smk::VertexArray& other) const {
@@ -100,26 +423,30 @@ void VertexArray::Release() {
     return;
 
   // Transfert state to local.
+  GLFWwindow* context = nullptr;
   GLuint vbo = 0;
   GLuint vao = 0;
-  int* ref_count = nullptr;
+  Shared* shared = nullptr;
+  std::swap(context, context_);
   std::swap(vbo, vbo_);
   std::swap(vao, vao_);
-  std::swap(ref_count, ref_count_);
+  std::swap(shared, shared_);
 
   // Early return without releasing the resource if it is still hold by copy of
   // this class.
-  if (ref_count) {
-    --(*ref_count);
-    if (*ref_count)
-      return;
-    delete ref_count;
-    ref_count = nullptr;
-  }
+  if (--shared->ref_count)
+    return;
+  const GLuint ebo = shared->ebo;
+  delete shared;
 
   // Release the OpenGL objects.
+  UntrackBuffer(vbo);
   glDeleteBuffers(1, &vbo);
-  glDeleteVertexArrays(1, &vao);
+  if (ebo) {
+    UntrackBuffer(ebo);
+    glDeleteBuffers(1, &ebo);
+  }
+  DeleteVertexArrayObject(context, vao);
 }
 
 }  // namespace smk.
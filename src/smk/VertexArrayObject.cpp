@@ -0,0 +1,92 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <map>
+#include <mutex>
+#include <smk/VertexArrayObject.hpp>
+#include <tuple>
+#include <vector>
+
+namespace smk {
+
+namespace {
+
+// The vertex array objects created in an other context than their owner's,
+// indexed by {context, owner, vao}.
+using SharedKey = std::tuple<GLFWwindow*, GLFWwindow*, GLuint>;
+std::map<SharedKey, GLuint> g_shared_vertex_arrays;
+
+// The vertex array objects to be deleted by their context.
+std::map<GLFWwindow*, std::vector<GLuint>> g_released_vertex_arrays;
+
+// The contexts can be used by different threads. See
+// Window::Option::render_thread.
+std::mutex g_mutex;
+
+void Delete(GLFWwindow* context, GLuint vao) {
+  if (context == glfwGetCurrentContext())
+    glDeleteVertexArrays(1, &vao);
+  else
+    g_released_vertex_arrays[context].push_back(vao);
+}
+
+void DeleteReleased(GLFWwindow* context) {
+  auto it = g_released_vertex_arrays.find(context);
+  if (it == g_released_vertex_arrays.end())
+    return;
+  glDeleteVertexArrays(it->second.size(), it->second.data());
+  g_released_vertex_arrays.erase(it);
+}
+
+// Must be called with |g_mutex| locked.
+void ReleaseShared(GLFWwindow* owner, GLuint vao) {
+  for (auto it = g_shared_vertex_arrays.begin();
+       it != g_shared_vertex_arrays.end();) {
+    if (std::get<1>(it->first) == owner && std::get<2>(it->first) == vao) {
+      Delete(std::get<0>(it->first), it->second);
+      it = g_shared_vertex_arrays.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}  // namespace
+
+void BindVertexArrayObject(GLFWwindow* owner,
+                           GLuint vao,
+                           VertexArraySetup setup,
+                           const void* data) {
+  GLFWwindow* context = glfwGetCurrentContext();
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if (!g_released_vertex_arrays.empty())
+    DeleteReleased(context);
+
+  if (context == owner) {
+    glBindVertexArray(vao);
+    return;
+  }
+
+  GLuint& shared = g_shared_vertex_arrays[SharedKey(context, owner, vao)];
+  if (shared) {
+    glBindVertexArray(shared);
+    return;
+  }
+  glGenVertexArrays(1, &shared);
+  glBindVertexArray(shared);
+  setup(data);
+}
+
+void ReleaseSharedVertexArrayObjects(GLFWwindow* owner, GLuint vao) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  ReleaseShared(owner, vao);
+}
+
+void DeleteVertexArrayObject(GLFWwindow* owner, GLuint vao) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  ReleaseShared(owner, vao);
+  Delete(owner, vao);
+}
+
+}  // namespace smk
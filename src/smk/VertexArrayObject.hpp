@@ -0,0 +1,36 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_VERTEX_ARRAY_OBJECT_HPP
+#define SMK_VERTEX_ARRAY_OBJECT_HPP
+
+#include <smk/OpenGL.hpp>
+
+namespace smk {
+
+// Vertex array objects are not shared between OpenGL contexts, unlike the
+// buffers they refer to. The windows sharing their objects use an equivalent
+// vertex array object, created the first time it is bound in their context.
+
+// Bind the attributes of |data| in the current context.
+using VertexArraySetup = void (*)(const void* data);
+
+// Bind |vao|, owned by |context|. In an other context, bind the equivalent
+// vertex array object, created using |setup| the first time.
+void BindVertexArrayObject(GLFWwindow* context,
+                           GLuint vao,
+                           VertexArraySetup setup,
+                           const void* data);
+
+// Delete the equivalents of |vao| in the other contexts. They are built again
+// the next time they are bound.
+void ReleaseSharedVertexArrayObjects(GLFWwindow* context, GLuint vao);
+
+// Delete |vao| and its equivalents. The ones of a context not current are
+// deleted the next time it binds a vertex array.
+void DeleteVertexArrayObject(GLFWwindow* context, GLuint vao);
+
+}  // namespace smk
+
+#endif /* end of include guard: SMK_VERTEX_ARRAY_OBJECT_HPP */
@@ -9,14 +9,21 @@
 #include <iostream>
 #include <smk/Color.hpp>
 #include <smk/Drawable.hpp>
+#include <smk/FrameArena.hpp>
 #include <smk/Input.hpp>
 #include <smk/InputImpl.hpp>
 #include <smk/OpenGL.hpp>
+#include <smk/Profiler.hpp>
+#include <smk/RenderThread.hpp>
+#include <smk/Residency.hpp>
 #include <smk/View.hpp>
 #include <smk/Window.hpp>
 #include <thread>
 #include <vector>
 
+#include "ContextScope.hpp"
+#include "TextureUpload.hpp"
+
 #ifdef __EMSCRIPTEN__
   #include <emscripten.h>
   #include <emscripten/html5.h>
@@ -25,22 +32,37 @@
 namespace smk {
 
 bool g_khr_parallel_shader = false;
+extern thread_local RenderStats g_render_stats;
 
 namespace {
 
 int g_next_id = 0;
 std::map<int, Window*> window_by_id;
-std::map<GLFWwindow*, Window*> window_by_glfw_window;
+
+// The callbacks find their Window using the GLFW user pointer.
+Window* WindowFromGLFW(GLFWwindow* glfw_window) {
+  return static_cast<Window*>(glfwGetWindowUserPointer(glfw_window));
+}
+
+// A window whose context the new windows share their objects with.
+GLFWwindow* SharedContext() {
+  for (auto& it : window_by_id) {
+    if (it.second->window())
+      return it.second->window();
+  }
+  return nullptr;
+}
 
 void GLFWScrollCallback(GLFWwindow* glfw_window,
                         double xoffset,
                         double yoffset) {
-  Window* window = window_by_glfw_window[glfw_window];
+  Window* window = WindowFromGLFW(glfw_window);
   if (!window)
     return;
 
   static_cast<InputImpl*>(&(window->input()))
       ->OnScrollEvent({xoffset, yoffset});
+  window->RequestRedraw();
 }
 
 void GLFWErrorCallback(int error, const char* description) {
@@ -62,6 +84,7 @@ EM_BOOL OnTouchEvent(int eventType,
     return false;
   static_cast<InputImpl*>(&(window->input()))
       ->OnTouchEvent(eventType, keyEvent);
+  window->RequestRedraw();
   return true;
 }
 
@@ -97,12 +120,57 @@ void OpenGLDebugMessageCallback(GLenum /*source*/,
 }
 #endif
 
+void GLFWKeyCallback(GLFWwindow* glfw_window,
+                     int key,
+                     int /* scancode */,
+                     int action,
+                     int /* mods */) {
+  Window* window = WindowFromGLFW(glfw_window);
+  if (!window)
+    return;
+  static_cast<InputImpl*>(&(window->input()))
+      ->OnButtonEvent(Input::Device::Keyboard, key, action, glfwGetTime());
+  window->RequestRedraw();
+}
+
+void GLFWMouseButtonCallback(GLFWwindow* glfw_window,
+                             int button,
+                             int action,
+                             int /* mods */) {
+  Window* window = WindowFromGLFW(glfw_window);
+  if (!window)
+    return;
+  static_cast<InputImpl*>(&(window->input()))
+      ->OnButtonEvent(Input::Device::Mouse, button, action, glfwGetTime());
+  window->RequestRedraw();
+}
+
+// The window must be drawn again after these events.
+void GLFWCursorPosCallback(GLFWwindow* glfw_window, double, double) {
+  Window* window = WindowFromGLFW(glfw_window);
+  if (window)
+    window->RequestRedraw();
+}
+
+void GLFWWindowSizeCallback(GLFWwindow* glfw_window, int, int) {
+  Window* window = WindowFromGLFW(glfw_window);
+  if (window)
+    window->RequestRedraw();
+}
+
+void GLFWWindowRefreshCallback(GLFWwindow* glfw_window) {
+  Window* window = WindowFromGLFW(glfw_window);
+  if (window)
+    window->RequestRedraw();
+}
+
 void GLFWCharCallback(GLFWwindow* glfw_window, unsigned int codepoint) {
-  Window* window = window_by_glfw_window[glfw_window];
+  Window* window = WindowFromGLFW(glfw_window);
   if (!window)
     return;
   static_cast<InputImpl*>(&(window->input()))
       ->OnCharacterTyped((wchar_t)codepoint);
+  window->RequestRedraw();
 }
 
 }  // namespace
@@ -117,7 +185,18 @@ Window::Window() {
 /// @param width The desired width of the window.
 /// @param height The desired height of the window.
 /// @param title The window's title.
-Window::Window(int width, int height, const std::string& title) {
+Window::Window(int width, int height, const std::string& title)
+    : Window(width, height, title, Option()) {}
+
+/// @brief The window construtor.
+/// @param width The desired width of the window.
+/// @param height The desired height of the window.
+/// @param title The window's title.
+/// @param option Additionnal option (multisampling, ...)
+Window::Window(int width,
+               int height,
+               const std::string& title,
+               const Option& option) {
   input_ = std::make_unique<InputImpl>();
   id_ = ++g_next_id;
   window_by_id[id_] = this;
@@ -125,6 +204,14 @@ Window::Window(int width, int height, const std::string& title) {
   height_ = height;
 
   glfwSetErrorCallback(GLFWErrorCallback);
+
+#if !defined __EMSCRIPTEN__ && defined GLFW_PLATFORM_NULL
+  // Since GLFW 3.4, the null platform doesn't need a display server. Only the
+  // first glfwInit() takes it into account.
+  if (option.headless)
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+
   // initialize the GLFW library
   if (!glfwInit()) {
     throw std::runtime_error("Couldn't init GLFW");
@@ -142,15 +229,28 @@ Window::Window(int width, int height, const std::string& title) {
 #endif
 
   glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
-  glfwWindowHint(GLFW_SAMPLES, 4);
+  glfwWindowHint(GLFW_SAMPLES, option.samples);
 
   // create the window_
-  window_ = glfwCreateWindow(width_, height_, title.c_str(), NULL, NULL);
+  GLFWwindow* share = option.share_context ? SharedContext() : nullptr;
+#ifndef __EMSCRIPTEN__
+  if (option.headless) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    // EGL doesn't need a display server. Fall back to the native API when the
+    // driver doesn't support it.
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    window_ = glfwCreateWindow(width_, height_, title.c_str(), NULL, share);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_NATIVE_CONTEXT_API);
+  }
+#endif
+  if (!window_)
+    window_ = glfwCreateWindow(width_, height_, title.c_str(), NULL, share);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
   if (!window_) {
     glfwTerminate();
     throw std::runtime_error("Couldn't create a window_");
   }
-  window_by_glfw_window[window_] = this;
+  glfwSetWindowUserPointer(window_, this);
 
   glfwMakeContextCurrent(window_);
 
@@ -158,6 +258,13 @@ Window::Window(int width, int height, const std::string& title) {
   glewExperimental = GL_TRUE;
   GLenum err = glewInit();
 
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+  // A GLEW built for GLX fails to load the GLX functions without an X
+  // display. The OpenGL ones are loaded nonetheless.
+  if (err == GLEW_ERROR_NO_GLX_DISPLAY && option.headless)
+    err = GLEW_OK;
+#endif
+
   if (err != GLEW_OK) {
     glfwTerminate();
     throw std::runtime_error(std::string("Could initialize GLEW, error = ") +
@@ -171,10 +278,12 @@ Window::Window(int width, int height, const std::string& title) {
 #endif
 
   // get version info
-  const GLubyte* renderer = glGetString(GL_RENDERER);
-  const GLubyte* version = glGetString(GL_VERSION);
-  std::cout << "Renderer: " << renderer << std::endl;
-  std::cout << "OpenGL version supported " << version << std::endl;
+  if (!option.headless) {
+    const GLubyte* renderer = glGetString(GL_RENDERER);
+    const GLubyte* version = glGetString(GL_VERSION);
+    std::cout << "Renderer: " << renderer << std::endl;
+    std::cout << "OpenGL version supported " << version << std::endl;
+  }
 
   // Alpha transparency.
   glEnable(GL_BLEND);
@@ -206,6 +315,14 @@ Window::Window(int width, int height, const std::string& title) {
 #endif
   glfwSetScrollCallback(window_, GLFWScrollCallback);
   glfwSetCharCallback(window_, GLFWCharCallback);
+  glfwSetKeyCallback(window_, GLFWKeyCallback);
+  glfwSetMouseButtonCallback(window_, GLFWMouseButtonCallback);
+  glfwSetCursorPosCallback(window_, GLFWCursorPosCallback);
+  glfwSetWindowSizeCallback(window_, GLFWWindowSizeCallback);
+  glfwSetWindowRefreshCallback(window_, GLFWWindowRefreshCallback);
+
+  if (option.render_thread)
+    StartRenderThread();
 }
 
 Window::Window(Window&& window) noexcept {
@@ -213,36 +330,227 @@ Window::Window(Window&& window) noexcept {
 }
 
 void Window::operator=(Window&& other) noexcept {
+  // The render threads refer to the windows of the frames in flight.
+  if (render_thread_)
+    render_thread_->Finish();
+  if (other.render_thread_)
+    other.render_thread_->Finish();
+
   RenderTarget::operator=(std::move(other));
   std::swap(window_, other.window_);
   std::swap(time_, other.time_);
-  std::swap(time_last_sleep_, other.time_last_sleep_);
+  std::swap(frame_deadline_, other.frame_deadline_);
+  std::swap(frame_pacing_, other.frame_pacing_);
+  std::swap(frame_rate_, other.frame_rate_);
+  bool redraw_requested = redraw_requested_;
+  redraw_requested_ = other.redraw_requested_.load();
+  other.redraw_requested_ = redraw_requested;
+  std::swap(redraw_deadline_, other.redraw_deadline_);
   std::swap(input_, other.input_);
   std::swap(id_, other.id_);
   std::swap(module_canvas_selector_, other.module_canvas_selector_);
+  std::swap(frame_stats_, other.frame_stats_);
+  std::swap(gpu_time_, other.gpu_time_);
+  std::swap(gpu_query_, other.gpu_query_);
+  std::swap(gpu_queries_pending_, other.gpu_queries_pending_);
+  std::swap(gpu_queries_free_, other.gpu_queries_free_);
+  std::swap(render_thread_, other.render_thread_);
+  std::swap(upload_context_, other.upload_context_);
+  std::swap(swap_interval_, other.swap_interval_);
   window_by_id[id_] = this;
-  window_by_glfw_window[window_] = this;
+  if (window_)
+    glfwSetWindowUserPointer(window_, this);
+  if (other.window_) {
+    window_by_id[other.id_] = &other;
+    glfwSetWindowUserPointer(other.window_, &other);
+  }
 }
 
 /// @brief Handle all the new input events. This update the input() object.
 void Window::PoolEvents() {
+  SMK_PROFILE_SCOPE("Window::PoolEvents");
   glfwPollEvents();
   input_->Update(window_);
 }
 
 /// @brief Present what has been draw to the screen.
+/// The statistics of the frame are moved to frame_stats().
 void Window::Display() {
-  // Swap Front and Back buffers (double buffering)
-  glfwSwapBuffers(window_);
+  {
+    SMK_PROFILE_SCOPE("Window::Display");
+    if (render_thread_) {
+      SubmitFrame();
+    } else {
+      // With several windows, the context of this one must be current.
+      ContextScope context(window_);
+      Bind(this);
+      Flush();
+      MeasureGpuTime();
+      CompleteReadbacks();
+
+      // The depth and stencil buffers are not presented. Don't store them.
+      Invalidate(Depth | Stencil);
+
+      // Swap Front and Back buffers (double buffering)
+      glfwSwapBuffers(window_);
+
+      frame_stats_ = g_render_stats;
+      frame_stats_.gpu_time = gpu_time_;
+    }
+  }
+  Profiler::NewFrame(frame_stats_.gpu_time);
+  FrameArena::NewFrame();
+  // With a render thread, the eviction is done by the render thread instead.
+  // It owns the context drawing the textures, and its binding cache.
+  if (!render_thread_)
+    Residency::NewFrame();
 
   // Detect window_ related changes
   UpdateDimensions();
 
   time_ = glfwGetTime();
+  frame_block().time = time_;
+
+  g_render_stats = RenderStats();
+}
+
+// Create the context used by the application thread and move the window's
+// one to the render thread.
+void Window::StartRenderThread() {
+#ifdef __EMSCRIPTEN__
+  std::cerr << "SMK > The render thread isn't supported by WebGL." << std::endl;
+#else
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  upload_context_ = glfwCreateWindow(1, 1, "", NULL, window_);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+  if (!upload_context_) {
+    std::cerr << "SMK > Couldn't create the context of the application "
+                 "thread. The window is drawn by the main thread."
+              << std::endl;
+    return;
+  }
+
+  glfwMakeContextCurrent(upload_context_);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  render_thread_ = std::make_unique<RenderThread>(window_);
+  recording_ = &render_thread_->recording().commands;
+#endif
+}
+
+// Hand the recorded frame to the render thread.
+void Window::SubmitFrame() {
+  Flush();
+  // The depth and stencil buffers are not presented. Don't store them.
+  Invalidate(Depth | Stencil);
+
+  RecordedFrame& frame = render_thread_->recording();
+  frame.window = this;
+  frame.frame_block = frame_block();
+  frame.width = width_;
+  frame.height = height_;
+  frame.swap_interval = swap_interval_;
+
+  // The render thread starts only once the resources used by the frame are
+  // uploaded.
+  frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+
+  render_thread_->Submit();
+
+  // |frame| now holds the previous frame, rendered while the current one was
+  // recorded. Its resources are released by this thread.
+  frame_stats_ = g_render_stats;
+  frame_stats_.draw_calls += frame.stats.draw_calls;
+  frame_stats_.vertices += frame.stats.vertices;
+  frame_stats_.culled_draws += frame.stats.culled_draws;
+  frame_stats_.shader_changes += frame.stats.shader_changes;
+  frame_stats_.texture_changes += frame.stats.texture_changes;
+  frame_stats_.vertex_array_changes += frame.stats.vertex_array_changes;
+  frame_stats_.blend_mode_changes += frame.stats.blend_mode_changes;
+  frame_stats_.uniform_uploads += frame.stats.uniform_uploads;
+  frame_stats_.texture_uploads += frame.stats.texture_uploads;
+  frame_stats_.buffer_allocations += frame.stats.buffer_allocations;
+  frame_stats_.gpu_time = frame.gpu_time;
+  frame.commands.clear();
+
+  CompleteReadbacks();
+}
+
+// Called by the render thread.
+void Window::RenderFrame(RecordedFrame& frame) {
+  frame_block() = frame.frame_block;
+  Replay(frame.commands, frame.width, frame.height);
+  MeasureGpuTime();
+  frame.gpu_time = gpu_time_;
+  Residency::NewFrame();
+}
+
+// Close the GL_TIME_ELAPSED query of the current frame and start the next one.
+// The results are read only once available, so the CPU never waits for the
+// GPU.
+void Window::MeasureGpuTime() {
+#ifndef __EMSCRIPTEN__
+  if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query)
+    return;
+
+  if (gpu_query_) {
+    glEndQuery(GL_TIME_ELAPSED);
+    gpu_queries_pending_.push_back(gpu_query_);
+  }
+
+  while (!gpu_queries_pending_.empty()) {
+    GLuint query = gpu_queries_pending_.front();
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      break;
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+    gpu_time_ = elapsed * 1e-6f;
+    gpu_queries_pending_.pop_front();
+    gpu_queries_free_.push_back(query);
+  }
+
+  if (gpu_queries_free_.empty()) {
+    glGenQueries(1, &gpu_query_);
+  } else {
+    gpu_query_ = gpu_queries_free_.back();
+    gpu_queries_free_.pop_back();
+  }
+  glBeginQuery(GL_TIME_ELAPSED, gpu_query_);
+#endif
 }
 
 Window::~Window() {
+  // The GPU queries belong to the context of the render thread.
+  if (render_thread_) {
+    render_thread_.reset();
+    glfwMakeContextCurrent(window_);
+  }
+
   window_by_id.erase(id_);
+  if (window_)
+    glfwSetWindowUserPointer(window_, nullptr);
+  if (gpu_query_) {
+    // The query of the current frame is still active.
+    glEndQuery(GL_TIME_ELAPSED);
+    glDeleteQueries(1, &gpu_query_);
+  }
+  for (GLuint query : gpu_queries_pending_)
+    glDeleteQueries(1, &query);
+  for (GLuint query : gpu_queries_free_)
+    glDeleteQueries(1, &query);
+
+  // The pixel buffers used by Texture::Update() in the contexts of this
+  // window.
+  for (GLFWwindow* context : {window_, upload_context_}) {
+    if (!context)
+      continue;
+    ContextScope scope(context);
+    ReleaseUploadBuffers(context);
+  }
   // glfwTerminate(); // Needed? What about multiple windows?
 }
 
@@ -269,11 +577,21 @@ Input& Window::input() {
 /// @param loop The function to be called for each new frame.
 void Window::ExecuteMainLoopUntil(std::function<bool(void)> loop) {
 #ifdef __EMSCRIPTEN__
-  main_loop = [my_loop = loop] { (void)my_loop(); };
+  main_loop = [this, my_loop = loop] {
+    // The browser keeps calling, the frames not needed are skipped.
+    if (frame_pacing_ == FramePacing::OnDemand && !WaitForRedraw())
+      return;
+    (void)my_loop();
+  };
   emscripten_set_main_loop(&MainLoop, 0, 1);
 #else
-  while (loop())
-    LimitFrameRate(60.0f);
+  while (true) {
+    if (frame_pacing_ == FramePacing::OnDemand && !WaitForRedraw())
+      continue;
+    if (!loop())
+      break;
+    PaceFrame();
+  }
 #endif
 }
 
@@ -285,16 +603,151 @@ void Window::ExecuteMainLoopUntil(std::function<bool(void)> loop) {
 /// @param loop The function to be called for each new frame.
 void Window::ExecuteMainLoop(std::function<void(void)> loop) {
 #ifdef __EMSCRIPTEN__
-  main_loop = loop;
+  main_loop = [this, loop] {
+    // The browser keeps calling, the frames not needed are skipped.
+    if (frame_pacing_ == FramePacing::OnDemand && !WaitForRedraw())
+      return;
+    loop();
+  };
   emscripten_set_main_loop(&MainLoop, 0, 1);
 #else
   while (!input().IsKeyPressed(GLFW_KEY_ESCAPE) && !ShouldClose()) {
+    if (frame_pacing_ == FramePacing::OnDemand && !WaitForRedraw())
+      continue;
     loop();
-    LimitFrameRate(60.0f);
+    PaceFrame();
   };
 #endif
 }
 
+/// @brief Helper function. Execute the main loop of the application, with a
+/// fixed timestep simulation.
+/// @param timestep The simulated time in seconds in between two updates.
+/// @param update The function updating the simulation. It is called as many
+///               times as needed to catch up with the current time.
+/// @param draw The function drawing a frame. It receives the interpolation
+///             factor in between the last update and the next one.
+void Window::ExecuteMainLoop(float timestep,
+                             std::function<void(float timestep)> update,
+                             std::function<void(float interpolation)> draw) {
+  // Also rejects NaN.
+  if (!(timestep > 0.f)) {
+    std::cerr << "SMK > ExecuteMainLoop: the timestep must be positive, got "
+              << timestep << std::endl;
+    return;
+  }
+
+  // When the updates are slower than the time they simulate, catching up
+  // would take longer every frame.
+  const int max_updates = 16;
+
+  double previous_time = glfwGetTime();
+  double accumulator = 0.0;
+  ExecuteMainLoop([=]() mutable {
+    double now = glfwGetTime();
+    // Don't try to catch up after a long pause, for instance in a debugger.
+    accumulator += std::min(now - previous_time, 0.25);
+    previous_time = now;
+    for (int i = 0; accumulator >= timestep; ++i) {
+      if (i == max_updates) {
+        accumulator = std::fmod(accumulator, double(timestep));
+        break;
+      }
+      update(timestep);
+      accumulator -= timestep;
+    }
+    draw(float(accumulator / timestep));
+  });
+}
+
+/// @brief Choose how ExecuteMainLoop() paces the frames.
+/// @param pacing The pacing mode.
+/// @see SetFrameRate.
+void Window::SetFramePacing(FramePacing pacing) {
+  frame_pacing_ = pacing;
+  frame_deadline_ = 0.0;
+#ifndef __EMSCRIPTEN__
+  int interval = 0;
+  switch (pacing) {
+    case FramePacing::VSync:
+    case FramePacing::OnDemand:
+      interval = 1;
+      break;
+    case FramePacing::AdaptiveSync:
+      // A negative interval lets late frames tear instead of waiting for the
+      // next refresh.
+      interval = glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+                         glfwExtensionSupported("GLX_EXT_swap_control_tear")
+                     ? -1
+                     : 1;
+      break;
+    case FramePacing::Capped:
+    case FramePacing::Uncapped:
+      interval = 0;
+      break;
+  }
+  swap_interval_ = interval;
+  // Otherwise, the render thread applies it.
+  if (!render_thread_) {
+    ContextScope context(window_);
+    glfwSwapInterval(interval);
+  }
+#endif
+}
+
+/// @brief Set the frame rate used by FramePacing::Capped.
+/// @param fps The number of frames per second.
+void Window::SetFrameRate(float fps) {
+  frame_rate_ = fps;
+}
+
+/// @brief Draw the next frame, when using FramePacing::OnDemand.
+void Window::RequestRedraw() {
+  if (redraw_requested_.exchange(true))
+    return;
+#ifndef __EMSCRIPTEN__
+  // Wake up glfwWaitEvents.
+  glfwPostEmptyEvent();
+#endif
+}
+
+/// @brief Draw a frame after some delay, when using FramePacing::OnDemand.
+/// This must be called from the thread of the main loop.
+/// @param delay The delay, in seconds.
+void Window::RequestRedraw(float delay) {
+  double deadline = glfwGetTime() + delay;
+  if (redraw_deadline_ < 0.0 || deadline < redraw_deadline_)
+    redraw_deadline_ = deadline;
+}
+
+// Block until an event arrives, a redraw is requested, or the redraw deadline
+// is reached. Return whether a frame must be drawn. The events received are
+// processed, and applied by the next PoolEvents().
+bool Window::WaitForRedraw() {
+#ifndef __EMSCRIPTEN__
+  if (!redraw_requested_) {
+    if (redraw_deadline_ < 0.0)
+      glfwWaitEvents();
+    else
+      glfwWaitEventsTimeout(std::max(0.0, redraw_deadline_ - glfwGetTime()));
+  }
+#endif
+  if (redraw_deadline_ >= 0.0 && glfwGetTime() >= redraw_deadline_) {
+    redraw_deadline_ = -1.0;
+    redraw_requested_ = true;
+  }
+
+  // A window asked to close must run the loop to notice it.
+  if (ShouldClose())
+    redraw_requested_ = true;
+  return redraw_requested_.exchange(false);
+}
+
+void Window::PaceFrame() {
+  if (frame_pacing_ == FramePacing::Capped)
+    LimitFrameRate(frame_rate_);
+}
+
 void Window::UpdateDimensions() {
   int width = width_;
   int height = height_;
@@ -306,7 +759,9 @@ void Window::UpdateDimensions() {
 #endif
 
   if (width != width_ || height != height_) {
-    glViewport(0, 0, width_, height_);
+    // The render thread sets the viewport of the frames it replays.
+    if (!render_thread_)
+      glViewport(0, 0, width_, height_);
     SetView(view_);
   }
 }
@@ -314,15 +769,25 @@ void Window::UpdateDimensions() {
 /// If needed, insert pause in the execution to maintain a given framerate.
 /// @param fps the desired frame rate.
 void Window::LimitFrameRate(float fps) {
-  const float delta = glfwGetTime() - time_last_sleep_;
-  const float target = 1.f / fps;
-  float sleep_duration = target - delta;
-  sleep_duration = std::min(target, sleep_duration);
-  if (sleep_duration > 0.f) {
+  const double period = 1.0 / fps;
+  double now = glfwGetTime();
+
+  // The deadlines are spaced by |period|, so the errors don't accumulate. They
+  // are reset when the frames are too late to catch up.
+  frame_deadline_ += period;
+  if (frame_deadline_ < now - period || frame_deadline_ > now + period)
+    frame_deadline_ = now + period;
+
+  // The sleep precision is often a millisecond or worse. Sleep until close to
+  // the deadline, then spin.
+  const double spin_duration = 0.002;
+  double sleep_duration = frame_deadline_ - now - spin_duration;
+  if (sleep_duration > 0.0) {
     std::this_thread::sleep_for(
         std::chrono::microseconds(int(sleep_duration * 1'000'000)));
   }
-  time_last_sleep_ = glfwGetTime();
+  while (glfwGetTime() < frame_deadline_)
+    std::this_thread::yield();
 }
 
 /// Returns true when the user wants to close the window.
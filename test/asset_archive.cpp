@@ -0,0 +1,144 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <smk/AssetArchive.hpp>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+std::vector<uint8_t> ReadFile(const fs::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+
+void WriteFile(const fs::path& path, const std::vector<uint8_t>& content) {
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(content.data()), content.size());
+}
+
+bool Equal(smk::AssetArchive::Span span, const std::vector<uint8_t>& content) {
+  return span && span.size == content.size() &&
+         !std::memcmp(span.data, content.data(), content.size());
+}
+
+}  // namespace
+
+int main() {
+  const fs::path directory = fs::temp_directory_path() / "smk_test_archive";
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+
+  // Some text, compressing well, and some noise, not compressing.
+  std::vector<uint8_t> text;
+  const std::string line = "The quick brown fox jumps over the lazy dog. ";
+  for (int i = 0; text.size() < 100000; ++i) {
+    text.insert(text.end(), line.begin(), line.end());
+    text.push_back(uint8_t('0' + i % 10));
+  }
+  std::vector<uint8_t> noise(5000);
+  uint32_t seed = 1;
+  for (uint8_t& byte : noise) {
+    seed = seed * 1103515245u + 12345u;
+    byte = uint8_t(seed >> 24);
+  }
+  const std::vector<uint8_t> small = {1, 2, 3};
+  WriteFile(directory / "text.txt", text);
+  WriteFile(directory / "noise.bin", noise);
+  WriteFile(directory / "small.bin", small);
+
+  const fs::path archive_path = directory / "assets.smk";
+  EXPECT(smk::AssetArchive::Write(
+      archive_path.string(),
+      {
+          {"text", (directory / "text.txt").string(), true},
+          {"noise", (directory / "noise.bin").string(), true},
+          {"small", (directory / "small.bin").string(), false},
+      }));
+  const std::vector<uint8_t> archive_data = ReadFile(archive_path);
+  EXPECT(archive_data.size() < text.size());
+
+  // The entries round trip, compressed or not.
+  {
+    smk::AssetArchive archive(archive_path.string());
+    EXPECT(archive.names() ==
+           std::vector<std::string>({"text", "noise", "small"}));
+    EXPECT(Equal(archive.Get("text"), text));
+    EXPECT(Equal(archive.Get("text"), text));
+    EXPECT(Equal(archive.Get("noise"), noise));
+    EXPECT(Equal(archive.Get("small"), small));
+    EXPECT(!archive.Contains("missing"));
+    EXPECT(!archive.Get("missing"));
+  }
+
+  // Two entries can't have the same name.
+  EXPECT(!smk::AssetArchive::Write(
+      (directory / "duplicate.smk").string(),
+      {
+          {"small", (directory / "small.bin").string()},
+          {"small", (directory / "small.bin").string()},
+      }));
+
+  // The corrupted indices are rejected.
+  const fs::path corrupted_path = directory / "corrupted.smk";
+  auto open_corrupted = [&](const std::vector<uint8_t>& content) {
+    WriteFile(corrupted_path, content);
+    smk::AssetArchive archive;
+    const bool opened = archive.Open(corrupted_path.string());
+    EXPECT(archive.names().empty());
+    return opened;
+  };
+  {
+    std::vector<uint8_t> content = archive_data;
+    content[0] = 'X';  // The magic.
+    EXPECT(!open_corrupted(content));
+  }
+  {
+    // Truncated in the middle of the index.
+    std::vector<uint8_t> content(archive_data.begin(),
+                                 archive_data.begin() + 40);
+    EXPECT(!open_corrupted(content));
+  }
+  {
+    // The first entry starts past the end of the file. Its offset follows
+    // the 16 bytes header.
+    std::vector<uint8_t> content = archive_data;
+    const uint64_t offset = uint64_t(content.size()) + 1;
+    std::memcpy(content.data() + 16, &offset, sizeof(offset));
+    EXPECT(!open_corrupted(content));
+  }
+  {
+    // The first entry overflows the file when added to its offset.
+    std::vector<uint8_t> content = archive_data;
+    const uint64_t stored_size = ~uint64_t(0);
+    std::memcpy(content.data() + 32, &stored_size, sizeof(stored_size));
+    EXPECT(!open_corrupted(content));
+  }
+
+  // A corrupted compressed entry is reported missing.
+  {
+    std::vector<uint8_t> content = archive_data;
+    uint64_t offset = 0;
+    std::memcpy(&offset, content.data() + 16, sizeof(offset));
+    content[offset] = 0xFF;
+    content[offset + 1] = 0xFF;
+    WriteFile(corrupted_path, content);
+    smk::AssetArchive archive(corrupted_path.string());
+    EXPECT(archive.Contains("text"));
+    EXPECT(!archive.Get("text"));
+    EXPECT(Equal(archive.Get("small"), small));
+  }
+
+  fs::remove_all(directory);
+  return test::Result();
+}
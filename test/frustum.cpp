@@ -0,0 +1,58 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <smk/BoundingBox.hpp>
+#include <smk/Frustum.hpp>
+
+#include "test.hpp"
+
+namespace {
+
+smk::BoundingBox Box(const glm::vec3& min, const glm::vec3& max) {
+  smk::BoundingBox box;
+  box.Extend(min);
+  box.Extend(max);
+  return box;
+}
+
+}  // namespace
+
+int main() {
+  // The default frustum contains everything, but the empty boxes.
+  {
+    smk::Frustum frustum;
+    EXPECT(frustum.Intersects(Box({1e6f, 1e6f, 1e6f}, {1e6f, 1e6f, 1e6f})));
+    EXPECT(!frustum.Intersects(smk::BoundingBox()));
+  }
+
+  // An orthographic projection, like the 2D views.
+  {
+    smk::Frustum frustum(glm::ortho(0.f, 100.f, 0.f, 100.f, -1.f, 1.f));
+    EXPECT(frustum.Intersects(Box({10.f, 10.f, 0.f}, {20.f, 20.f, 0.f})));
+    EXPECT(frustum.Intersects(Box({90.f, 40.f, 0.f}, {110.f, 60.f, 0.f})));
+    EXPECT(frustum.Intersects(Box({-50.f, -50.f, 0.f}, {150.f, 150.f, 0.f})));
+    EXPECT(!frustum.Intersects(Box({150.f, 10.f, 0.f}, {160.f, 20.f, 0.f})));
+    EXPECT(!frustum.Intersects(Box({10.f, -20.f, 0.f}, {20.f, -10.f, 0.f})));
+    EXPECT(!frustum.Intersects(Box({10.f, 10.f, 2.f}, {20.f, 20.f, 3.f})));
+    EXPECT(!frustum.Intersects(smk::BoundingBox()));
+  }
+
+  // A perspective projection looking toward -z, seeing 90 degrees.
+  {
+    smk::Frustum frustum(
+        glm::perspective(glm::radians(90.f), 1.f, 0.1f, 100.f));
+    EXPECT(frustum.Intersects(Box({-1.f, -1.f, -11.f}, {1.f, 1.f, -9.f})));
+    EXPECT(!frustum.Intersects(Box({-1.f, -1.f, 9.f}, {1.f, 1.f, 11.f})));
+    EXPECT(!frustum.Intersects(Box({-1.f, -1.f, -201.f}, {1.f, 1.f, -199.f})));
+    EXPECT(!frustum.Intersects(Box({20.f, -1.f, -11.f}, {22.f, 1.f, -9.f})));
+
+    EXPECT(frustum.Intersects({0.f, 0.f, -10.f}, 1.f));
+    EXPECT(!frustum.Intersects({50.f, 0.f, -10.f}, 1.f));
+    EXPECT(frustum.Intersects({50.f, 0.f, -10.f}, 45.f));
+    EXPECT(!frustum.Intersects({0.f, 0.f, 10.f}, 1.f));
+  }
+
+  return test::Result();
+}
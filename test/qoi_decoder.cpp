@@ -0,0 +1,114 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <cstdint>
+#include <vector>
+
+#include "QoiDecoder.hpp"
+#include "test.hpp"
+
+namespace {
+
+std::vector<uint8_t> Header(uint32_t width, uint32_t height, int channels) {
+  return {
+      'q',
+      'o',
+      'i',
+      'f',
+      uint8_t(width >> 24),
+      uint8_t(width >> 16),
+      uint8_t(width >> 8),
+      uint8_t(width),
+      uint8_t(height >> 24),
+      uint8_t(height >> 16),
+      uint8_t(height >> 8),
+      uint8_t(height),
+      uint8_t(channels),
+      0,  // sRGB.
+  };
+}
+
+std::vector<uint8_t> File(std::vector<uint8_t> header,
+                          const std::vector<uint8_t>& chunks) {
+  header.insert(header.end(), chunks.begin(), chunks.end());
+  const std::vector<uint8_t> end_marker = {0, 0, 0, 0, 0, 0, 0, 1};
+  header.insert(header.end(), end_marker.begin(), end_marker.end());
+  return header;
+}
+
+// A 4x2 image using every operation.
+const std::vector<uint8_t> kChunks = {
+    0xFE, 100, 150, 200,  // RGB: (100, 150, 200, 255).
+    0x76,                 // DIFF (+1, -1, 0): (101, 149, 200, 255).
+    0xA5, 0x5A,           // LUMA (dg=+5, dr-dg=-3, db-dg=+2): (103, 154, 207).
+    0xC1,                 // RUN of 2.
+    0xFF, 1, 2, 3, 4,     // RGBA: (1, 2, 3, 4).
+    0x07,                 // INDEX of (100, 150, 200, 255).
+    0xC0,                 // RUN of 1.
+};
+
+const std::vector<uint8_t> kExpected = {
+    100, 150, 200, 255,  //
+    101, 149, 200, 255,  //
+    103, 154, 207, 255,  //
+    103, 154, 207, 255,  //
+    103, 154, 207, 255,  //
+    1,   2,   3,   4,    //
+    100, 150, 200, 255,  //
+    100, 150, 200, 255,  //
+};
+
+}  // namespace
+
+int main() {
+  smk::QoiDecoder decoder;
+  const std::vector<uint8_t> file = File(Header(4, 2, 4), kChunks);
+  EXPECT(decoder.Accept(file.data(), file.size()));
+
+  // RGBA.
+  {
+    smk::ImageDecoder::Image image;
+    EXPECT(decoder.Decode(file.data(), file.size(), &image));
+    EXPECT(image.width == 4);
+    EXPECT(image.height == 2);
+    EXPECT(image.channels == 4);
+    EXPECT(image.pixels == kExpected);
+  }
+
+  // RGB: the alpha channel is dropped.
+  {
+    const std::vector<uint8_t> rgb_file = File(Header(4, 2, 3), kChunks);
+    smk::ImageDecoder::Image image;
+    EXPECT(decoder.Decode(rgb_file.data(), rgb_file.size(), &image));
+    EXPECT(image.channels == 3);
+    std::vector<uint8_t> expected;
+    for (size_t i = 0; i < kExpected.size(); i += 4)
+      expected.insert(expected.end(), &kExpected[i], &kExpected[i + 3]);
+    EXPECT(image.pixels == expected);
+  }
+
+  // The invalid files are rejected.
+  {
+    const uint8_t png[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n',
+                           0,    0,   0,   0,   0,    0,    0,    0};
+    EXPECT(!decoder.Accept(png, sizeof(png)));
+    EXPECT(!decoder.Accept(file.data(), 10));
+
+    smk::ImageDecoder::Image image;
+    EXPECT(!decoder.Decode(file.data(), file.size() - 12, &image));
+    const std::vector<uint8_t> no_width = File(Header(0, 2, 4), kChunks);
+    EXPECT(!decoder.Decode(no_width.data(), no_width.size(), &image));
+    const std::vector<uint8_t> grey = File(Header(4, 2, 1), kChunks);
+    EXPECT(!decoder.Decode(grey.data(), grey.size(), &image));
+    const std::vector<uint8_t> huge =
+        File(Header(0xFFFFFFFF, 0xFFFFFFFF, 4), kChunks);
+    EXPECT(!decoder.Decode(huge.data(), huge.size(), &image));
+    // An RGB chunk cut by the end marker.
+    const std::vector<uint8_t> truncated =
+        File(Header(4, 2, 4), {0xFE, 100});
+    EXPECT(!decoder.Decode(truncated.data(), truncated.size(), &image));
+  }
+
+  return test::Result();
+}
@@ -0,0 +1,64 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <memory>
+#include <smk/Handle.hpp>
+#include <string>
+
+#include "test.hpp"
+
+int main() {
+  smk::ResourceRegistry<std::string> registry;
+  EXPECT(registry.size() == 0);
+
+  // The null handle never resolves.
+  smk::Handle<std::string> null;
+  EXPECT(!null);
+  EXPECT(!registry.Get(null));
+
+  smk::Handle<std::string> a = registry.Add("a");
+  smk::Handle<std::string> b = registry.Add("b");
+  EXPECT(a && b);
+  EXPECT(a != b);
+  EXPECT(registry.size() == 2);
+  EXPECT(registry.Get(a) && *registry.Get(a) == "a");
+  EXPECT(registry.Get(b) && *registry.Get(b) == "b");
+
+  // A removed resource isn't resolved anymore. Removing it twice does
+  // nothing.
+  registry.Remove(a);
+  EXPECT(!registry.Contains(a));
+  EXPECT(!registry.Get(a));
+  EXPECT(registry.size() == 1);
+  registry.Remove(a);
+  EXPECT(registry.size() == 1);
+  EXPECT(registry.Contains(b));
+
+  // The freed slot is reused with a new generation: the stale handle doesn't
+  // resolve to the new resource.
+  smk::Handle<std::string> c = registry.Add("c");
+  EXPECT(c.index == a.index);
+  EXPECT(c.generation != a.generation);
+  EXPECT(c != a);
+  EXPECT(!registry.Get(a));
+  EXPECT(registry.Get(c) && *registry.Get(c) == "c");
+  registry.Remove(a);
+  EXPECT(registry.Contains(c));
+  EXPECT(registry.size() == 2);
+
+  // The handles from other slots or registries are rejected.
+  smk::Handle<std::string> out_of_range = c;
+  out_of_range.index = 100;
+  EXPECT(!registry.Get(out_of_range));
+
+  // Removing a resource releases it.
+  smk::ResourceRegistry<std::shared_ptr<int>> pointers;
+  auto pointer = std::make_shared<int>(1);
+  smk::Handle<std::shared_ptr<int>> handle = pointers.Add(pointer);
+  EXPECT(pointer.use_count() == 2);
+  pointers.Remove(handle);
+  EXPECT(pointer.use_count() == 1);
+
+  return test::Result();
+}
@@ -0,0 +1,40 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "SampleConversion.hpp"
+#include "test.hpp"
+
+int main() {
+  const float infinity = std::numeric_limits<float>::infinity();
+  const std::vector<float> values = {
+      0.f, 0.5f, -0.5f, 1.f, -1.f, 1.5f, -1.5f, 1e30f, -1e30f, infinity,
+      -infinity,
+  };
+  const std::vector<int16_t> expected = {
+      0, 16383, -16383, 32767, -32767, 32767, -32767, 32767, -32767, 32767,
+      -32767,
+  };
+
+  // Long enough to use both the vectorized loop and the remaining samples.
+  const size_t count = 4 * values.size() + 3;
+  std::vector<float> source(count);
+  for (size_t i = 0; i < count; ++i)
+    source[i] = values[i % values.size()];
+  std::vector<int16_t> destination(count, 1);
+  smk::FloatToInt16(source.data(), destination.data(), count);
+  for (size_t i = 0; i < count; ++i)
+    EXPECT(destination[i] == expected[i % values.size()]);
+
+  // Nothing is written past |count|.
+  std::vector<int16_t> guarded(12, 7);
+  smk::FloatToInt16(source.data(), guarded.data(), 9);
+  for (size_t i = 9; i < guarded.size(); ++i)
+    EXPECT(guarded[i] == 7);
+
+  return test::Result();
+}
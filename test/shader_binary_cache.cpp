@@ -0,0 +1,68 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <filesystem>
+#include <smk/OpenGL.hpp>
+#include <smk/Shader.hpp>
+
+#include "test.hpp"
+
+namespace {
+
+const char* kVertexShader = R"(
+  layout(location = 0) in vec2 space_position;
+  void main() {
+    gl_Position = vec4(space_position, 0.0, 1.0);
+  }
+)";
+
+const char* kFragmentShader = R"(
+  out vec4 out_color;
+  void main() {
+    out_color = vec4(1.0);
+  }
+)";
+
+// Link the program, and report whether its shaders had to be compiled.
+bool Link(smk::ShaderProgram& program) {
+  auto vertex = smk::Shader::FromString(kVertexShader, GL_VERTEX_SHADER);
+  auto fragment = smk::Shader::FromString(kFragmentShader, GL_FRAGMENT_SHADER);
+  program.AddShader(vertex);
+  program.AddShader(fragment);
+  program.Link();
+  EXPECT(program.LinkStatus());
+
+  GLint compiled = GL_FALSE;
+  glGetShaderiv(vertex.id(), GL_COMPILE_STATUS, &compiled);
+  return compiled == GL_TRUE;
+}
+
+}  // namespace
+
+int main() {
+  namespace fs = std::filesystem;
+  const fs::path directory = fs::temp_directory_path() / "smk_test_binaries";
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+  smk::ShaderProgram::SetBinaryCacheDirectory(directory.string());
+
+  auto window = test::HeadlessWindow();
+
+  // The first link compiles the shaders, and stores the program.
+  smk::ShaderProgram first;
+  EXPECT(Link(first));
+  if (fs::is_empty(directory)) {
+    std::fprintf(stderr, "Program binaries unsupported. Skipped.\n");
+    fs::remove_all(directory);
+    return test::Result();
+  }
+
+  // The second is loaded back from the cache, without compiling them.
+  smk::ShaderProgram second;
+  EXPECT(!Link(second));
+
+  smk::ShaderProgram::SetBinaryCacheDirectory("");
+  fs::remove_all(directory);
+  return test::Result();
+}
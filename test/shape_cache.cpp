@@ -0,0 +1,57 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <smk/Shape.hpp>
+#include <smk/VertexArray.hpp>
+#include <vector>
+
+#include "test.hpp"
+
+namespace {
+
+// The shared cache holds up to 64 shapes.
+const int kCapacity = 64;
+
+smk::VertexArray Rectangle(int i) {
+  return smk::Shape::RoundedRectangle(100.f, 50.f, 0.25f * (i + 1)).vertex_array();
+}
+
+}  // namespace
+
+int main() {
+  auto window = test::HeadlessWindow();
+  smk::Shape::ReleaseCache();
+
+  // Identical shapes share their VertexArray.
+  EXPECT(smk::Shape::Circle(10.f).vertex_array() ==
+         smk::Shape::Circle(10.f).vertex_array());
+  EXPECT(smk::Shape::Circle(10.f).vertex_array() !=
+         smk::Shape::Circle(11.f).vertex_array());
+  smk::Shape::ReleaseCache();
+
+  // Fill the cache.
+  std::vector<smk::VertexArray> built;
+  for (int i = 0; i < kCapacity; ++i)
+    built.push_back(Rectangle(i));
+  for (int i = 0; i < kCapacity; ++i)
+    EXPECT(Rectangle(i) == built[i]);
+
+  // Use the first one again, then add a new shape: the least recently used
+  // one, the second, is dropped.
+  EXPECT(Rectangle(0) == built[0]);
+  smk::VertexArray added = Rectangle(kCapacity);
+  EXPECT(Rectangle(kCapacity) == added);
+  EXPECT(Rectangle(0) == built[0]);
+  EXPECT(Rectangle(2) == built[2]);
+  EXPECT(Rectangle(1) != built[1]);
+
+  // Their users keep the dropped shapes alive.
+  EXPECT(built[1].size() != 0);
+
+  // Releasing the cache rebuilds every shape.
+  smk::Shape::ReleaseCache();
+  EXPECT(Rectangle(0) != built[0]);
+
+  return test::Result();
+}
@@ -0,0 +1,88 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <vector>
+
+#include "SkylinePacker.hpp"
+#include "test.hpp"
+
+namespace {
+
+struct Placed {
+  glm::ivec2 position;
+  int width;
+  int height;
+};
+
+bool Overlap(const Placed& a, const Placed& b) {
+  return a.position.x < b.position.x + b.width &&
+         b.position.x < a.position.x + a.width &&
+         a.position.y < b.position.y + b.height &&
+         b.position.y < a.position.y + a.height;
+}
+
+}  // namespace
+
+int main() {
+  // Four squares fill the area exactly. There is no room for a fifth.
+  {
+    smk::SkylinePacker packer(32, 32);
+    glm::ivec2 position;
+    for (int i = 0; i < 4; ++i)
+      EXPECT(packer.Insert(16, 16, &position));
+    EXPECT(!packer.Insert(1, 1, &position));
+  }
+
+  // The rectangles rest at the lowest position, then the leftmost one.
+  {
+    smk::SkylinePacker packer(32, 32);
+    glm::ivec2 position;
+    EXPECT(packer.Insert(8, 16, &position));
+    EXPECT(position.x == 0 && position.y == 0);
+    EXPECT(packer.Insert(8, 4, &position));
+    EXPECT(position.x == 8 && position.y == 0);
+    EXPECT(packer.Insert(16, 4, &position));
+    EXPECT(position.x == 16 && position.y == 0);
+    EXPECT(packer.Insert(24, 4, &position));
+    EXPECT(position.x == 8 && position.y == 4);
+  }
+
+  // The empty and the oversized rectangles are rejected.
+  {
+    smk::SkylinePacker packer(32, 32);
+    glm::ivec2 position;
+    EXPECT(!packer.Insert(0, 8, &position));
+    EXPECT(!packer.Insert(8, -1, &position));
+    EXPECT(!packer.Insert(33, 8, &position));
+    EXPECT(!packer.Insert(8, 33, &position));
+    EXPECT(packer.Insert(32, 32, &position));
+  }
+
+  // Many rectangles of various sizes stay inside the area, without
+  // overlapping.
+  {
+    smk::SkylinePacker packer(128, 128);
+    std::vector<Placed> placed;
+    unsigned int seed = 1;
+    for (int i = 0; i < 200; ++i) {
+      seed = seed * 1103515245u + 12345u;
+      const int width = 1 + (seed >> 16) % 24;
+      seed = seed * 1103515245u + 12345u;
+      const int height = 1 + (seed >> 16) % 24;
+      glm::ivec2 position;
+      if (packer.Insert(width, height, &position))
+        placed.push_back({position, width, height});
+    }
+    EXPECT(placed.size() > 20);
+    for (size_t i = 0; i < placed.size(); ++i) {
+      const Placed& a = placed[i];
+      EXPECT(a.position.x >= 0 && a.position.x + a.width <= 128);
+      EXPECT(a.position.y >= 0 && a.position.y + a.height <= 128);
+      for (size_t j = 0; j < i; ++j)
+        EXPECT(!Overlap(a, placed[j]));
+    }
+  }
+
+  return test::Result();
+}
@@ -0,0 +1,44 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <cstdint>
+#include <smk/Color.hpp>
+#include <smk/Sprite.hpp>
+#include <smk/SpriteBatch.hpp>
+#include <smk/Texture.hpp>
+
+#include "test.hpp"
+
+int main() {
+  auto window = test::HeadlessWindow();
+
+  const uint8_t red[] = {255, 0, 0, 255};
+  const uint8_t blue[] = {0, 0, 255, 255};
+  smk::Texture texture_a(red, 1, 1);
+  smk::Texture texture_b(blue, 1, 1);
+  EXPECT(texture_a == texture_a);
+  EXPECT(texture_a != texture_b);
+
+  // Distinct textures are never drawn together.
+  {
+    smk::SpriteBatch batch;
+    batch.Add(smk::Sprite(texture_a));
+    batch.Add(smk::Sprite(texture_b));
+    batch.Add(smk::Sprite(texture_a));
+    EXPECT(batch.draw_calls() == 3);
+  }
+
+  // The sprites sharing a texture are merged, their colors stored in the
+  // vertices.
+  {
+    smk::SpriteBatch batch;
+    smk::Sprite sprite(texture_a);
+    batch.Add(sprite);
+    sprite.SetColor(smk::Color::Red);
+    batch.Add(sprite);
+    EXPECT(batch.draw_calls() == 1);
+  }
+
+  return test::Result();
+}
@@ -0,0 +1,45 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#ifndef SMK_TEST_HPP
+#define SMK_TEST_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <smk/Window.hpp>
+
+namespace test {
+
+// A window providing the OpenGL context, without a display server when
+// possible.
+inline smk::Window HeadlessWindow() {
+  smk::Window::Option option;
+  option.headless = true;
+  option.samples = 0;
+  return smk::Window(64, 64, "smk test", option);
+}
+
+inline int& Failures() {
+  static int failures = 0;
+  return failures;
+}
+
+// The status to return from main().
+inline int Result() {
+  return Failures() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}  // namespace test
+
+// Report a failure when |condition| is false, and continue.
+#define EXPECT(condition)                                                 \
+  do {                                                                    \
+    if (!(condition)) {                                                   \
+      std::fprintf(stderr, "%s:%d: Failure: %s\n", __FILE__, __LINE__,    \
+                   #condition);                                           \
+      ++test::Failures();                                                 \
+    }                                                                     \
+  } while (0)
+
+#endif /* end of include guard: SMK_TEST_HPP */
@@ -0,0 +1,58 @@
+// Copyright 2020 Arthur Sonzogni. All rights reserved.
+// Use of this source code is governed by the MIT license that can be found in
+// the LICENSE file.
+
+#include <cmath>
+#include <smk/Touch.hpp>
+
+#include "test.hpp"
+
+namespace {
+
+bool Near(const glm::vec2& a, const glm::vec2& b) {
+  return std::abs(a.x - b.x) < 1e-3f && std::abs(a.y - b.y) < 1e-3f;
+}
+
+}  // namespace
+
+int main() {
+  smk::Touch::SetHistoryCapacity(4);
+
+  // A touch moving 10 pixels to the right every 0.1 second.
+  smk::Touch touch;
+  EXPECT(touch.data_points.capacity() == 4);
+  EXPECT(touch.data_points.empty());
+  EXPECT(Near(touch.displacement(), {0.f, 0.f}));
+  for (int i = 0; i < 6; ++i)
+    touch.data_points.push_back({{10.f * i, 5.f}, 0.1f * i});
+
+  // Once full, the oldest points are dropped.
+  EXPECT(touch.data_points.size() == 4);
+  EXPECT(Near(touch.data_points.front().position, {20.f, 5.f}));
+  EXPECT(Near(touch.data_points.back().position, {50.f, 5.f}));
+  EXPECT(Near(touch.data_points[1].position, {30.f, 5.f}));
+  EXPECT(Near(touch.position(), {50.f, 5.f}));
+
+  // The displacement is measured from the start, even once dropped.
+  EXPECT(Near(touch.data_points.start().position, {0.f, 5.f}));
+  EXPECT(Near(touch.displacement(), {50.f, 0.f}));
+
+  EXPECT(Near(touch.velocity(), {100.f, 0.f}));
+  EXPECT(Near(touch.velocity(0.25f), {100.f, 0.f}));
+
+  // The positions are interpolated, and clamped to the history.
+  EXPECT(Near(touch.Sample(0.35f), {35.f, 5.f}));
+  EXPECT(Near(touch.Sample(0.f), {20.f, 5.f}));
+  EXPECT(Near(touch.Sample(1.f), {50.f, 5.f}));
+
+  // Clearing keeps the capacity, and restarts the touch.
+  touch.data_points.clear();
+  EXPECT(touch.data_points.empty());
+  EXPECT(touch.data_points.capacity() == 4);
+  touch.data_points.push_back({{1.f, 2.f}, 1.f});
+  touch.data_points.push_back({{4.f, 6.f}, 1.1f});
+  EXPECT(Near(touch.displacement(), {3.f, 4.f}));
+
+  smk::Touch::SetHistoryCapacity(64);
+  return test::Result();
+}